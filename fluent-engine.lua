@@ -163,6 +163,8 @@ project "fluent-engine"
 		"sources/window/mouse_codes.h",
 		-- thread
 		"sources/thread/thread.h",
+		"sources/thread/thread_pool.h",
+		"sources/thread/thread_pool.c",
 		"sources/thread/unix/unix_thread.c",
 		"sources/thread/windows/windows_thread.c",
 		-- time
@@ -201,7 +203,39 @@ project "fluent-engine"
 		"sources/renderer/nuklear/shaders/shader_nuklear_vert_spirv.c",
 		"sources/renderer/nuklear/shaders/shader_nuklear_frag_spirv.c",
 		"sources/renderer/scene/model_loader.h",
-		"sources/renderer/scene/model_loader.c"
+		"sources/renderer/scene/model_loader.c",
+		"sources/renderer/scene/vertex_packing.h",
+		"sources/renderer/scene/vertex_packing.c",
+		"sources/renderer/scene/mesh_optimizer.h",
+		"sources/renderer/scene/mesh_optimizer.c",
+		"sources/renderer/scene/meshlet.h",
+		"sources/renderer/scene/meshlet.c",
+		"sources/renderer/scene/mesh_simplifier.h",
+		"sources/renderer/scene/mesh_simplifier.c",
+		"sources/renderer/scene/baked_model.h",
+		"sources/renderer/scene/baked_model.c",
+		"sources/renderer/scene/texture_compression.h",
+		"sources/renderer/scene/texture_compression.c",
+		"sources/renderer/scene/mip_generator.h",
+		"sources/renderer/scene/mip_generator.c",
+		"sources/renderer/scene/tangent_generator.h",
+		"sources/renderer/scene/tangent_generator.c",
+		"sources/renderer/scene/scene_graph.h",
+		"sources/renderer/scene/scene_graph.c",
+		"sources/renderer/scene/ktx2_loader.h",
+		"sources/renderer/scene/ktx2_loader.c",
+		"sources/renderer/scene/zstd_decoder.h",
+		"sources/renderer/scene/zstd_decoder.c",
+		"sources/renderer/scene/meshopt_decoder.h",
+		"sources/renderer/scene/meshopt_decoder.c",
+		"sources/renderer/scene/geometry_packer.h",
+		"sources/renderer/scene/geometry_packer.c",
+		"sources/renderer/scene/skinning.h",
+		"sources/renderer/scene/skinning.c",
+		"sources/renderer/scene/animation.h",
+		"sources/renderer/scene/animation.c",
+		"sources/renderer/scene/animation_lod.h",
+		"sources/renderer/scene/animation_lod.c"
 	}
 
 	filter { "system:macosx" }
@@ -266,3 +300,43 @@ fluent_engine.link = function()
 		}
 	end
 end
+
+project "fluent-bake"
+	kind "ConsoleApp"
+	language "C"
+
+	filter { "configurations:debug" }
+		symbols "On"
+		optimize "Off"
+		defines {
+			"FT_DEBUG=1" 
+		}
+	filter { "configurations:release" }
+		symbols "Off"
+		optimize "Speed"
+		defines {
+			"FT_DEBUG=0" 
+		}
+	filter { "system:windows" }
+		defines {
+			"NOMINMAX",
+			"_CRT_SECURE_NO_WARNINGS"
+		}
+	filter {}
+
+	declare_backend_defines()
+
+	includedirs {
+		"sources",
+	}
+
+	sysincludedirs {
+		"third_party",
+		vulkan_include_directory
+	}
+
+	files {
+		"tools/fluent_bake/fluent_bake.c"
+	}
+
+	fluent_engine.link()
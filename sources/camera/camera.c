@@ -128,6 +128,68 @@ ft_camera_on_resize( struct ft_camera* camera, uint32_t width, uint32_t height )
 	recalculate_projection_matrix( camera );
 }
 
+void
+ft_camera_get_frustum( const struct ft_camera* camera,
+                       struct ft_frustum*      frustum )
+{
+	float4x4 view_projection;
+	float4x4_mul( view_projection, camera->projection, camera->view );
+
+	float4 rows[ 4 ];
+	for ( uint32_t r = 0; r < 4; ++r )
+	{
+		float4x4_row( rows[ r ], view_projection, r );
+	}
+
+	float4_add( frustum->planes[ 0 ], rows[ 3 ], rows[ 0 ] );
+	float4_sub( frustum->planes[ 1 ], rows[ 3 ], rows[ 0 ] );
+	float4_add( frustum->planes[ 2 ], rows[ 3 ], rows[ 1 ] );
+	float4_sub( frustum->planes[ 3 ], rows[ 3 ], rows[ 1 ] );
+	float4_add( frustum->planes[ 4 ], rows[ 3 ], rows[ 2 ] );
+	float4_sub( frustum->planes[ 5 ], rows[ 3 ], rows[ 2 ] );
+
+	for ( uint32_t p = 0; p < 6; ++p )
+	{
+		float len = float3_len( frustum->planes[ p ] );
+		float4_inv_scale( frustum->planes[ p ], frustum->planes[ p ], len );
+	}
+}
+
+bool
+ft_frustum_test_sphere( const struct ft_frustum* frustum,
+                        const float3             center,
+                        float                    radius )
+{
+	for ( uint32_t p = 0; p < 6; ++p )
+	{
+		const float* plane = frustum->planes[ p ];
+
+		if ( float3_mul_inner( plane, center ) + plane[ 3 ] < -radius )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+float
+ft_camera_get_screen_size( const struct ft_camera* camera,
+                           const float3            center,
+                           float                   radius )
+{
+	float3 d;
+	float3_sub( d, center, camera->position );
+	float distance = float3_len( d );
+
+	if ( distance <= radius )
+	{
+		return 1.0f;
+	}
+
+	return radius * camera->projection[ 1 ][ 1 ] / distance;
+}
+
 void
 ft_camera_controller_init( struct ft_camera_controller* c,
                            struct ft_camera*            camera )
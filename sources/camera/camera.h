@@ -45,6 +45,11 @@ struct ft_camera
 	float mouse_sensitivity;
 };
 
+struct ft_frustum
+{
+	float4 planes[ 6 ];
+};
+
 FT_API void
 ft_camera_init( struct ft_camera*, const struct ft_camera_info* info );
 
@@ -59,6 +64,20 @@ ft_camera_on_rotate( struct ft_camera*, float x_offset, float y_offset );
 FT_API void
 ft_camera_on_resize( struct ft_camera*, uint32_t width, uint32_t height );
 
+FT_API void
+ft_camera_get_frustum( const struct ft_camera*, struct ft_frustum* frustum );
+
+FT_API bool
+ft_frustum_test_sphere( const struct ft_frustum* frustum,
+                        const float3             center,
+                        float                    radius );
+
+// fraction of screen height covered by sphere
+FT_API float
+ft_camera_get_screen_size( const struct ft_camera*,
+                           const float3 center,
+                           float        radius );
+
 struct ft_camera_controller
 {
 	struct ft_camera* camera;
@@ -18,6 +18,19 @@
 #include "renderer/backend/render_graph.h"
 #include "renderer/nuklear/ft_nuklear.h"
 #include "renderer/scene/model_loader.h"
+#include "renderer/scene/meshlet.h"
+#include "renderer/scene/mesh_simplifier.h"
+#include "renderer/scene/baked_model.h"
+#include "renderer/scene/texture_compression.h"
+#include "renderer/scene/mip_generator.h"
+#include "renderer/scene/tangent_generator.h"
+#include "renderer/scene/scene_graph.h"
+#include "renderer/scene/ktx2_loader.h"
+#include "renderer/scene/zstd_decoder.h"
+#include "renderer/scene/meshopt_decoder.h"
+#include "renderer/scene/geometry_packer.h"
+#include "renderer/scene/skinning.h"
 #include "renderer/scene/animation.h"
+#include "renderer/scene/animation_lod.h"
 
 #include "math/linear.h"
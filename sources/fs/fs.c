@@ -1,6 +1,15 @@
 #include <stb/stb_image.h>
 #include "fs.h"
 
+#if FT_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 void*
 ft_read_file_binary( const char* filename, uint64_t* size )
 {
@@ -28,24 +37,147 @@ ft_free_file_data( void* data )
 	free( data );
 }
 
-void*
-ft_read_image_from_file( const char* filename,
-                         uint32_t*   width,
-                         uint32_t*   height )
+#if FT_PLATFORM_WINDOWS
+bool
+ft_map_file( const char* filename, struct ft_mapped_file* file )
 {
-	FILE* file = fopen( filename, "rb" );
-	if ( !file )
+	memset( file, 0, sizeof( struct ft_mapped_file ) );
+
+	HANDLE handle = CreateFileA( filename,
+	                             GENERIC_READ,
+	                             FILE_SHARE_READ,
+	                             NULL,
+	                             OPEN_EXISTING,
+	                             FILE_ATTRIBUTE_NORMAL,
+	                             NULL );
+
+	if ( handle == INVALID_HANDLE_VALUE )
 	{
 		FT_WARN( "failed to open file %s", filename );
-		return NULL;
+		return false;
 	}
 
-	int32_t w;
-	int32_t h;
-	int32_t ch;
+	LARGE_INTEGER size;
+	GetFileSizeEx( handle, &size );
 
-	void* image = stbi_loadf_from_file( file, &w, &h, &ch, 4 );
-	FT_ASSERT( image );
+	HANDLE mapping =
+	    CreateFileMappingA( handle, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+	CloseHandle( handle );
+
+	if ( mapping == NULL )
+	{
+		FT_WARN( "failed to map file %s", filename );
+		return false;
+	}
+
+	file->data = MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 );
+
+	if ( file->data == NULL )
+	{
+		FT_WARN( "failed to map file %s", filename );
+		CloseHandle( mapping );
+		return false;
+	}
+
+	file->size   = size.QuadPart;
+	file->handle = mapping;
+
+	return true;
+}
+
+void
+ft_unmap_file( struct ft_mapped_file* file )
+{
+	UnmapViewOfFile( file->data );
+	CloseHandle( file->handle );
+	memset( file, 0, sizeof( struct ft_mapped_file ) );
+}
+#else
+bool
+ft_map_file( const char* filename, struct ft_mapped_file* file )
+{
+	memset( file, 0, sizeof( struct ft_mapped_file ) );
+
+	int fd = open( filename, O_RDONLY );
+
+	if ( fd < 0 )
+	{
+		FT_WARN( "failed to open file %s", filename );
+		return false;
+	}
+
+	struct stat st;
+
+	if ( fstat( fd, &st ) != 0 || st.st_size == 0 )
+	{
+		close( fd );
+		return false;
+	}
+
+	void* data = mmap( NULL,
+	                   st.st_size,
+	                   PROT_READ | PROT_WRITE,
+	                   MAP_PRIVATE,
+	                   fd,
+	                   0 );
+	close( fd );
+
+	if ( data == MAP_FAILED )
+	{
+		FT_WARN( "failed to map file %s", filename );
+		return false;
+	}
+
+	file->data = data;
+	file->size = st.st_size;
+
+	return true;
+}
+
+void
+ft_unmap_file( struct ft_mapped_file* file )
+{
+	munmap( file->data, file->size );
+	memset( file, 0, sizeof( struct ft_mapped_file ) );
+}
+#endif
+
+void*
+ft_decode_image( const void*     data,
+                 uint64_t        size,
+                 bool            srgb,
+                 uint32_t*       width,
+                 uint32_t*       height,
+                 enum ft_format* format )
+{
+	const stbi_uc* bytes  = data;
+	int32_t        length = ( int32_t ) size;
+	int32_t        w      = 0;
+	int32_t        h      = 0;
+	int32_t        ch;
+	void*          image;
+
+	if ( stbi_is_hdr_from_memory( bytes, length ) )
+	{
+		image   = stbi_loadf_from_memory( bytes, length, &w, &h, &ch, 4 );
+		*format = FT_FORMAT_R32G32B32A32_SFLOAT;
+	}
+	else if ( stbi_is_16_bit_from_memory( bytes, length ) )
+	{
+		image   = stbi_load_16_from_memory( bytes, length, &w, &h, &ch, 4 );
+		*format = FT_FORMAT_R16G16B16A16_UNORM;
+	}
+	else
+	{
+		image   = stbi_load_from_memory( bytes, length, &w, &h, &ch, 4 );
+		*format = srgb ? FT_FORMAT_R8G8B8A8_SRGB : FT_FORMAT_R8G8B8A8_UNORM;
+	}
+
+	if ( image == NULL )
+	{
+		FT_WARN( "failed to decode image %s", stbi_failure_reason() );
+		*format = FT_FORMAT_UNDEFINED;
+	}
 
 	*width  = w;
 	*height = h;
@@ -53,8 +185,139 @@ ft_read_image_from_file( const char* filename,
 	return image;
 }
 
+void*
+ft_read_image_from_file( const char*     filename,
+                         bool            srgb,
+                         uint32_t*       width,
+                         uint32_t*       height,
+                         enum ft_format* format )
+{
+	uint64_t size = 0;
+	void*    data = ft_read_file_binary( filename, &size );
+
+	if ( data == NULL )
+	{
+		return NULL;
+	}
+
+	void* image = ft_decode_image( data, size, srgb, width, height, format );
+	ft_free_file_data( data );
+
+	return image;
+}
+
 void
 ft_free_image_data( void* data )
 {
 	stbi_image_free( data );
 }
+
+// alphabet value of every character, 0xff outside of alphabet
+static const uint8_t BASE64_VALUES[ 256 ] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b,
+	0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+	0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+	0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+	0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20,
+	0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30,
+	0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+uint64_t
+ft_base64_decoded_size( const char* src, uint64_t length )
+{
+	while ( length > 0 && src[ length - 1 ] == '=' )
+	{
+		length--;
+	}
+
+	return length / 4 * 3 + ( length % 4 > 1 ? length % 4 - 1 : 0 );
+}
+
+bool
+ft_decode_base64( void* dst, const char* src, uint64_t length )
+{
+	const uint8_t* in  = ( const uint8_t* ) src;
+	uint8_t*       out = dst;
+
+	while ( length > 0 && src[ length - 1 ] == '=' )
+	{
+		length--;
+	}
+
+	if ( length % 4 == 1 )
+	{
+		return false;
+	}
+
+	// invalid characters are collected in one mask instead of branching on
+	// every quad
+	uint32_t invalid = 0;
+	uint64_t end     = length / 4 * 4;
+
+	for ( uint64_t i = 0; i < end; i += 4 )
+	{
+		uint32_t a = BASE64_VALUES[ in[ i + 0 ] ];
+		uint32_t b = BASE64_VALUES[ in[ i + 1 ] ];
+		uint32_t c = BASE64_VALUES[ in[ i + 2 ] ];
+		uint32_t d = BASE64_VALUES[ in[ i + 3 ] ];
+
+		invalid |= a | b | c | d;
+
+		uint32_t v = a << 18 | b << 12 | c << 6 | d;
+
+		out[ 0 ] = ( uint8_t ) ( v >> 16 );
+		out[ 1 ] = ( uint8_t ) ( v >> 8 );
+		out[ 2 ] = ( uint8_t ) v;
+		out += 3;
+	}
+
+	// last two or three characters without padding
+	if ( end < length )
+	{
+		uint32_t v = 0;
+
+		for ( uint64_t i = end; i < length; ++i )
+		{
+			uint32_t value = BASE64_VALUES[ in[ i ] ];
+			invalid |= value;
+			v = v << 6 | value;
+		}
+
+		v <<= 6 * ( 4 - ( length - end ) );
+
+		out[ 0 ] = ( uint8_t ) ( v >> 16 );
+
+		if ( length - end == 3 )
+		{
+			out[ 1 ] = ( uint8_t ) ( v >> 8 );
+		}
+	}
+
+	return ( invalid & 0x80 ) == 0;
+}
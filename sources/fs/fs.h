@@ -1,6 +1,14 @@
 #pragma once
 
 #include "base/base.h"
+#include "renderer/backend/renderer_enums.h"
+
+struct ft_mapped_file
+{
+	void*    data;
+	uint64_t size;
+	void*    handle;
+};
 
 FT_API void*
 ft_read_file_binary( const char* filename, uint64_t* size );
@@ -8,10 +16,38 @@ ft_read_file_binary( const char* filename, uint64_t* size );
 FT_API void
 ft_free_file_data( void* data );
 
+// maps whole file copy on write, writes to mapping never reach the file
+FT_API bool
+ft_map_file( const char* filename, struct ft_mapped_file* file );
+
+FT_API void
+ft_unmap_file( struct ft_mapped_file* file );
+
+// decodes to rgba with 8 bits per channel for ldr images, 16 bits for 16 bit
+// pngs and float for hdr, srgb selects srgb format for 8 bit images
 FT_API void*
-ft_read_image_from_file( const char* filename,
-                         uint32_t*   width,
-                         uint32_t*   height );
+ft_decode_image( const void*     data,
+                 uint64_t        size,
+                 bool            srgb,
+                 uint32_t*       width,
+                 uint32_t*       height,
+                 enum ft_format* format );
+
+FT_API void*
+ft_read_image_from_file( const char*     filename,
+                         bool            srgb,
+                         uint32_t*       width,
+                         uint32_t*       height,
+                         enum ft_format* format );
 
 FT_API void
 ft_free_image_data( void* );
+
+// size of data encoded by base64 string, trailing padding is not counted
+FT_API uint64_t
+ft_base64_decoded_size( const char* src, uint64_t length );
+
+// decodes standard alphabet base64 into ft_base64_decoded_size bytes of
+// dst, returns false on characters outside of alphabet
+FT_API bool
+ft_decode_base64( void* dst, const char* src, uint64_t length );
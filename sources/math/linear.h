@@ -697,34 +697,45 @@ float4x4o_mul_quat( float4x4 R, float4x4 const M, quat const q )
 FT_INLINE void
 quat_from_float4x4( quat q, float4x4 const M )
 {
-	float r = 0.f;
-	int   i;
-
-	int  perm[] = { 0, 1, 2, 0, 1 };
-	int *p      = perm;
-
-	for ( i = 0; i < 3; i++ )
+	// M is column major, largest of w, x, y, z is solved first for precision
+	float m00   = M[ 0 ][ 0 ];
+	float m11   = M[ 1 ][ 1 ];
+	float m22   = M[ 2 ][ 2 ];
+	float trace = m00 + m11 + m22;
+	float s;
+
+	if ( trace > 0.f )
 	{
-		float m = M[ i ][ i ];
-		if ( m < r )
-			continue;
-		p = &perm[ i ];
+		s      = sqrtf( trace + 1.f ) * 2.f;
+		q[ 3 ] = 0.25f * s;
+		q[ 0 ] = ( M[ 1 ][ 2 ] - M[ 2 ][ 1 ] ) / s;
+		q[ 1 ] = ( M[ 2 ][ 0 ] - M[ 0 ][ 2 ] ) / s;
+		q[ 2 ] = ( M[ 0 ][ 1 ] - M[ 1 ][ 0 ] ) / s;
 	}
-
-	r = sqrtf( 1.f + M[ p[ 0 ] ][ p[ 0 ] ] - M[ p[ 1 ] ][ p[ 1 ] ] -
-	           M[ p[ 2 ] ][ p[ 2 ] ] );
-
-	if ( r < 1e-6 )
+	else if ( m00 > m11 && m00 > m22 )
 	{
-		q[ 0 ] = 1.f;
-		q[ 1 ] = q[ 2 ] = q[ 3 ] = 0.f;
-		return;
+		s      = sqrtf( 1.f + m00 - m11 - m22 ) * 2.f;
+		q[ 3 ] = ( M[ 1 ][ 2 ] - M[ 2 ][ 1 ] ) / s;
+		q[ 0 ] = 0.25f * s;
+		q[ 1 ] = ( M[ 1 ][ 0 ] + M[ 0 ][ 1 ] ) / s;
+		q[ 2 ] = ( M[ 2 ][ 0 ] + M[ 0 ][ 2 ] ) / s;
+	}
+	else if ( m11 > m22 )
+	{
+		s      = sqrtf( 1.f + m11 - m00 - m22 ) * 2.f;
+		q[ 3 ] = ( M[ 2 ][ 0 ] - M[ 0 ][ 2 ] ) / s;
+		q[ 0 ] = ( M[ 1 ][ 0 ] + M[ 0 ][ 1 ] ) / s;
+		q[ 1 ] = 0.25f * s;
+		q[ 2 ] = ( M[ 2 ][ 1 ] + M[ 1 ][ 2 ] ) / s;
+	}
+	else
+	{
+		s      = sqrtf( 1.f + m22 - m00 - m11 ) * 2.f;
+		q[ 3 ] = ( M[ 0 ][ 1 ] - M[ 1 ][ 0 ] ) / s;
+		q[ 0 ] = ( M[ 2 ][ 0 ] + M[ 0 ][ 2 ] ) / s;
+		q[ 1 ] = ( M[ 2 ][ 1 ] + M[ 1 ][ 2 ] ) / s;
+		q[ 2 ] = 0.25f * s;
 	}
-
-	q[ 0 ] = r / 2.f;
-	q[ 1 ] = ( M[ p[ 0 ] ][ p[ 1 ] ] - M[ p[ 1 ] ][ p[ 0 ] ] ) / ( 2.f * r );
-	q[ 2 ] = ( M[ p[ 2 ] ][ p[ 0 ] ] - M[ p[ 0 ] ][ p[ 2 ] ] ) / ( 2.f * r );
-	q[ 3 ] = ( M[ p[ 2 ] ][ p[ 1 ] ] - M[ p[ 1 ] ][ p[ 2 ] ] ) / ( 2.f * r );
 }
 
 FT_INLINE void
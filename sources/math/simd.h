@@ -0,0 +1,190 @@
+#pragma once
+
+#include "base/base.h"
+
+// four float lanes mapped to sse2 or neon, plain arrays elsewhere. loads and
+// stores do not need alignment
+#if defined( __SSE2__ ) || defined( _M_X64 ) ||                               \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define FT_SIMD_SSE2 1
+#define FT_SIMD_NEON 0
+#include <emmintrin.h>
+typedef __m128 ft_simd4;
+#elif defined( __ARM_NEON ) || defined( _M_ARM64 )
+#define FT_SIMD_SSE2 0
+#define FT_SIMD_NEON 1
+#include <arm_neon.h>
+typedef float32x4_t ft_simd4;
+#else
+#define FT_SIMD_SSE2 0
+#define FT_SIMD_NEON 0
+typedef struct
+{
+	float v[ 4 ];
+} ft_simd4;
+#endif
+
+FT_INLINE ft_simd4
+ft_simd4_load( const float* p )
+{
+#if FT_SIMD_SSE2
+	return _mm_loadu_ps( p );
+#elif FT_SIMD_NEON
+	return vld1q_f32( p );
+#else
+	ft_simd4 r;
+	memcpy( r.v, p, sizeof( r.v ) );
+	return r;
+#endif
+}
+
+FT_INLINE void
+ft_simd4_store( float* p, ft_simd4 a )
+{
+#if FT_SIMD_SSE2
+	_mm_storeu_ps( p, a );
+#elif FT_SIMD_NEON
+	vst1q_f32( p, a );
+#else
+	memcpy( p, a.v, sizeof( a.v ) );
+#endif
+}
+
+FT_INLINE ft_simd4
+ft_simd4_splat( float s )
+{
+#if FT_SIMD_SSE2
+	return _mm_set1_ps( s );
+#elif FT_SIMD_NEON
+	return vdupq_n_f32( s );
+#else
+	return ( ft_simd4 ) { { s, s, s, s } };
+#endif
+}
+
+FT_INLINE ft_simd4
+ft_simd4_zero( void )
+{
+	return ft_simd4_splat( 0.0f );
+}
+
+FT_INLINE ft_simd4
+ft_simd4_add( ft_simd4 a, ft_simd4 b )
+{
+#if FT_SIMD_SSE2
+	return _mm_add_ps( a, b );
+#elif FT_SIMD_NEON
+	return vaddq_f32( a, b );
+#else
+	ft_simd4 r;
+	for ( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] + b.v[ i ];
+	return r;
+#endif
+}
+
+FT_INLINE ft_simd4
+ft_simd4_sub( ft_simd4 a, ft_simd4 b )
+{
+#if FT_SIMD_SSE2
+	return _mm_sub_ps( a, b );
+#elif FT_SIMD_NEON
+	return vsubq_f32( a, b );
+#else
+	ft_simd4 r;
+	for ( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] - b.v[ i ];
+	return r;
+#endif
+}
+
+FT_INLINE ft_simd4
+ft_simd4_mul( ft_simd4 a, ft_simd4 b )
+{
+#if FT_SIMD_SSE2
+	return _mm_mul_ps( a, b );
+#elif FT_SIMD_NEON
+	return vmulq_f32( a, b );
+#else
+	ft_simd4 r;
+	for ( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] * b.v[ i ];
+	return r;
+#endif
+}
+
+// a * b + c, not fused so results match on every target
+FT_INLINE ft_simd4
+ft_simd4_madd( ft_simd4 a, ft_simd4 b, ft_simd4 c )
+{
+	return ft_simd4_add( ft_simd4_mul( a, b ), c );
+}
+
+FT_INLINE ft_simd4
+ft_simd4_min( ft_simd4 a, ft_simd4 b )
+{
+#if FT_SIMD_SSE2
+	return _mm_min_ps( a, b );
+#elif FT_SIMD_NEON
+	return vminq_f32( a, b );
+#else
+	ft_simd4 r;
+	for ( int i = 0; i < 4; ++i ) r.v[ i ] = FT_MIN( a.v[ i ], b.v[ i ] );
+	return r;
+#endif
+}
+
+FT_INLINE ft_simd4
+ft_simd4_max( ft_simd4 a, ft_simd4 b )
+{
+#if FT_SIMD_SSE2
+	return _mm_max_ps( a, b );
+#elif FT_SIMD_NEON
+	return vmaxq_f32( a, b );
+#else
+	ft_simd4 r;
+	for ( int i = 0; i < 4; ++i ) r.v[ i ] = FT_MAX( a.v[ i ], b.v[ i ] );
+	return r;
+#endif
+}
+
+// lanes of mask are all ones where a < b, use it with ft_simd4_select only
+FT_INLINE ft_simd4
+ft_simd4_less( ft_simd4 a, ft_simd4 b )
+{
+#if FT_SIMD_SSE2
+	return _mm_cmplt_ps( a, b );
+#elif FT_SIMD_NEON
+	return vreinterpretq_f32_u32( vcltq_f32( a, b ) );
+#else
+	ft_simd4 r;
+	for ( int i = 0; i < 4; ++i ) r.v[ i ] = a.v[ i ] < b.v[ i ] ? 1.0f : 0.0f;
+	return r;
+#endif
+}
+
+// b where mask is set, a elsewhere
+FT_INLINE ft_simd4
+ft_simd4_select( ft_simd4 mask, ft_simd4 a, ft_simd4 b )
+{
+#if FT_SIMD_SSE2
+	return _mm_or_ps( _mm_and_ps( mask, b ), _mm_andnot_ps( mask, a ) );
+#elif FT_SIMD_NEON
+	return vbslq_f32( vreinterpretq_u32_f32( mask ), b, a );
+#else
+	ft_simd4 r;
+	for ( int i = 0; i < 4; ++i ) r.v[ i ] = mask.v[ i ] ? b.v[ i ] : a.v[ i ];
+	return r;
+#endif
+}
+
+FT_INLINE ft_simd4
+ft_simd4_abs( ft_simd4 a )
+{
+#if FT_SIMD_SSE2
+	return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a );
+#elif FT_SIMD_NEON
+	return vabsq_f32( a );
+#else
+	ft_simd4 r;
+	for ( int i = 0; i < 4; ++i ) r.v[ i ] = FT_MAX( a.v[ i ], -a.v[ i ] );
+	return r;
+#endif
+}
@@ -1485,7 +1485,8 @@ mtl_cmd_copy_buffer_to_image( const struct ft_command_buffer* icmd,
 	    { 0, 0, 0 },
 	    { dst->interface.width, dst->interface.height, dst->interface.depth } };
 
-	NSUInteger bytesPerRow = 4 * dst->interface.width;
+	NSUInteger bytesPerRow =
+	    ft_format_row_pitch( dst->interface.format, dst->interface.width );
 	[dst->texture replaceRegion:region
 	                mipmapLevel:0
 	                  withBytes:src_ptr + src_offset
@@ -10,7 +10,7 @@
 #define FT_MAX_VERTEX_ATTRIBUTE_COUNT          15
 #define FT_MAX_DESCRIPTOR_BINDING_COUNT        15
 #define FT_MAX_SET_COUNT                       10
-#define FT_RESOURCE_LOADER_STAGING_BUFFER_SIZE 25 * 1024 * 1024 * 8
+#define FT_RESOURCE_LOADER_STAGING_BUFFER_SIZE ( 25 * 1024 * 1024 * 8 )
 #define FT_MAX_BINDING_NAME_LENGTH             20
 
 struct ft_wsi_info;
@@ -357,6 +357,29 @@ ft_format_size_bytes( enum ft_format const format )
 	return TinyImageFormat_BitSizeOfBlock( ( TinyImageFormat ) format ) / 8;
 }
 
+// block compressed formats store rows of 4x4 blocks
+FT_INLINE uint64_t
+ft_format_row_pitch( enum ft_format const format, uint32_t width )
+{
+	uint32_t block_width =
+	    TinyImageFormat_WidthOfBlock( ( TinyImageFormat ) format );
+
+	return ( uint64_t ) ( ( width + block_width - 1 ) / block_width ) *
+	       ft_format_size_bytes( format );
+}
+
+FT_INLINE uint64_t
+ft_format_image_size( enum ft_format const format,
+                      uint32_t             width,
+                      uint32_t             height )
+{
+	uint32_t block_height =
+	    TinyImageFormat_HeightOfBlock( ( TinyImageFormat ) format );
+
+	return ft_format_row_pitch( format, width ) *
+	       ( ( height + block_height - 1 ) / block_height );
+}
+
 FT_API void
 ft_create_instance( const struct ft_instance_info* info,
                     struct ft_instance**           instance );
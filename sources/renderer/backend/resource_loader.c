@@ -8,6 +8,11 @@
 #include "renderer_backend.h"
 #include "resource_loader.h"
 
+// satisfies buffer to image copy offsets on every backend
+#define STAGING_ALIGNMENT 512
+// submissions in flight before loader waits for oldest one
+#define LOADER_BATCH_COUNT 3
+
 enum ft_loader_job_type
 {
 	FT_LOADER_JOB_TYPE_BUFFER_UPLOAD,
@@ -20,6 +25,11 @@ struct ft_loader_job
 	enum ft_loader_job_type type;
 	struct ft_loader_job*   next;
 	struct ft_buffer*       staging_buffer;
+	uint64_t                staging_offset;
+	ft_upload_token         token;
+	ft_upload_callback      callback;
+	void*                   user_data;
+	struct ft_semaphore*    signal_semaphore;
 	union
 	{
 		struct ft_buffer_upload_job    buffer_upload_job;
@@ -28,18 +38,64 @@ struct ft_loader_job
 	};
 };
 
-struct ft_loader
+// persistently mapped buffer sub allocated front to back, positions grow
+// monotonically and wrap by buffer size
+struct ft_staging_ring
+{
+	struct ft_buffer*            buffer;
+	uint64_t                     size;
+	uint64_t                     head;
+	// everything before tail is consumed by completed submissions
+	uint64_t                     tail;
+	// ranges are copied outside loader mutex and published in reservation
+	// order, published end never covers range still being copied
+	uint64_t                     published_end;
+	uint64_t                     reserve_ticket;
+	uint64_t                     publish_ticket;
+	struct ft_condition_variable published;
+};
+
+// copies run on transfer queue, graphics queue acquires ownership and
+// generates mips. without dedicated transfer family only graphics is used
+struct ft_loader_batch
 {
-	const struct ft_device*   device;
-	struct ft_queue*          queue;
-	struct ft_command_pool*   command_pool;
-	struct ft_command_buffer* cmd;
+	struct ft_command_buffer* transfer_cmd;
+	struct ft_command_buffer* graphics_cmd;
+	struct ft_semaphore*      semaphore;
+	struct ft_fence*          fence;
+	bool                      pending;
 	uint32_t                  job_count;
-	struct ft_loader_job*     head;
-	struct ft_loader_job*     tail;
-	struct ft_thread          thread;
-	struct ft_mutex           mutex;
-	bool                      alive;
+	struct ft_loader_job*     jobs;
+	// published staging end when batch was recorded
+	uint64_t                  staging_end;
+	ft_upload_token           last_token;
+};
+
+struct ft_loader
+{
+	const struct ft_device*      device;
+	struct ft_queue*             queue;
+	struct ft_queue*             graphics_queue;
+	struct ft_command_pool*      command_pool;
+	struct ft_command_pool*      graphics_command_pool;
+	bool                         dedicated_transfer;
+	// queued and in flight jobs
+	uint32_t                     job_count;
+	ft_upload_token              last_token;
+	// every job up to this token is complete on gpu
+	ft_upload_token              completed_token;
+	struct ft_condition_variable completed;
+	// signaled when job is queued or loader shuts down
+	struct ft_condition_variable jobs_available;
+	struct ft_loader_job*        head;
+	struct ft_loader_job*        tail;
+	struct ft_staging_ring       staging;
+	// batches are reused round robin, next one is oldest
+	uint32_t                     batch_index;
+	struct ft_loader_batch       batches[ LOADER_BATCH_COUNT ];
+	struct ft_thread             thread;
+	struct ft_mutex              mutex;
+	bool                         alive;
 };
 
 static struct ft_loader loader;
@@ -195,43 +251,123 @@ ft_resource_loader_init( const struct ft_device* device )
 	struct ft_queue_info queue_info = {
 	    .queue_type = FT_QUEUE_TYPE_GRAPHICS,
 	};
+	ft_create_queue( device, &queue_info, &loader.graphics_queue );
+
+	queue_info.queue_type = FT_QUEUE_TYPE_TRANSFER;
 	ft_create_queue( device, &queue_info, &loader.queue );
 
+	loader.dedicated_transfer =
+	    loader.queue->family_index != loader.graphics_queue->family_index;
+
+	if ( !loader.dedicated_transfer )
+	{
+		ft_destroy_queue( loader.queue );
+		loader.queue = loader.graphics_queue;
+	}
+
 	struct ft_command_pool_info cmd_pool_info = {
 	    .queue = loader.queue,
 	};
 	ft_create_command_pool( device, &cmd_pool_info, &loader.command_pool );
 
-	ft_create_command_buffers( device, loader.command_pool, 1, &loader.cmd );
+	if ( loader.dedicated_transfer )
+	{
+		cmd_pool_info.queue = loader.graphics_queue;
+		ft_create_command_pool( device,
+		                        &cmd_pool_info,
+		                        &loader.graphics_command_pool );
+	}
+
+	for ( uint32_t b = 0; b < LOADER_BATCH_COUNT; ++b )
+	{
+		struct ft_loader_batch* batch = &loader.batches[ b ];
+
+		ft_create_command_buffers( device,
+		                           loader.command_pool,
+		                           1,
+		                           &batch->transfer_cmd );
+		ft_create_fence( device, &batch->fence );
+
+		if ( loader.dedicated_transfer )
+		{
+			ft_create_command_buffers( device,
+			                           loader.graphics_command_pool,
+			                           1,
+			                           &batch->graphics_cmd );
+			ft_create_semaphore( device, &batch->semaphore );
+		}
+	}
+
+	loader.staging.size   = FT_RESOURCE_LOADER_STAGING_BUFFER_SIZE -
+	                      FT_RESOURCE_LOADER_STAGING_BUFFER_SIZE %
+	                          STAGING_ALIGNMENT;
+	loader.staging.buffer = create_staging_buffer( loader.staging.size );
+	ft_map_memory( device, loader.staging.buffer );
 
 	loader.alive = true;
 
 	ft_mutex_create( &loader.mutex );
+	ft_condition_variable_create( &loader.completed );
+	ft_condition_variable_create( &loader.jobs_available );
+	ft_condition_variable_create( &loader.staging.published );
 	ft_thread_create( &loader.thread, loader_thread_fun, NULL );
 }
 
 void
 ft_resource_loader_shutdown()
 {
+	ft_mutex_lock( &loader.mutex );
 	loader.alive = false;
+	ft_condition_variable_notify_all( &loader.jobs_available );
+	ft_mutex_unlock( &loader.mutex );
+
 	ft_thread_join( &loader.thread );
 	ft_thread_destroy( &loader.thread );
+	ft_condition_variable_destroy( &loader.completed );
+	ft_condition_variable_destroy( &loader.jobs_available );
+	ft_condition_variable_destroy( &loader.staging.published );
 	ft_mutex_destroy( &loader.mutex );
-	ft_destroy_command_buffers( loader.device,
-	                            loader.command_pool,
-	                            1,
-	                            &loader.cmd );
+	ft_unmap_memory( loader.device, loader.staging.buffer );
+	ft_destroy_buffer( loader.device, loader.staging.buffer );
+
+	for ( uint32_t b = 0; b < LOADER_BATCH_COUNT; ++b )
+	{
+		struct ft_loader_batch* batch = &loader.batches[ b ];
+
+		ft_destroy_command_buffers( loader.device,
+		                            loader.command_pool,
+		                            1,
+		                            &batch->transfer_cmd );
+		ft_destroy_fence( loader.device, batch->fence );
+
+		if ( loader.dedicated_transfer )
+		{
+			ft_destroy_command_buffers( loader.device,
+			                            loader.graphics_command_pool,
+			                            1,
+			                            &batch->graphics_cmd );
+			ft_destroy_semaphore( loader.device, batch->semaphore );
+		}
+	}
+
 	ft_destroy_command_pool( loader.device, loader.command_pool );
-	ft_destroy_queue( loader.queue );
+
+	if ( loader.dedicated_transfer )
+	{
+		ft_destroy_command_pool( loader.device, loader.graphics_command_pool );
+		ft_destroy_queue( loader.queue );
+	}
+
+	ft_destroy_queue( loader.graphics_queue );
 }
 
-FT_INLINE void
-add_job( const struct ft_loader_job* job )
+// caller holds loader mutex
+FT_INLINE ft_upload_token
+push_job( const struct ft_loader_job* job )
 {
 	struct ft_loader_job* tmp = malloc( sizeof( struct ft_loader_job ) );
 	memcpy( tmp, job, sizeof( struct ft_loader_job ) );
-
-	while ( !ft_mutex_try_lock( &loader.mutex ) ) {}
+	tmp->token = ++loader.last_token;
 
 	if ( loader.head == NULL )
 	{
@@ -245,12 +381,156 @@ add_job( const struct ft_loader_job* job )
 	}
 
 	loader.job_count++;
+	ft_condition_variable_notify_one( &loader.jobs_available );
+
+	return tmp->token;
+}
 
+FT_INLINE ft_upload_token
+add_job( const struct ft_loader_job* job )
+{
+	while ( !ft_mutex_try_lock( &loader.mutex ) ) {}
+	ft_upload_token token = push_job( job );
 	ft_mutex_unlock( &loader.mutex );
+
+	return token;
 }
 
+// caller holds loader mutex, fails while consumed part of ring is too small
+static bool
+allocate_staging( struct ft_staging_ring* ring,
+                  uint64_t                size,
+                  uint64_t*               offset )
+{
+	// empty ring starts over at offset zero so any upload up to ring size
+	// fits, positions stay monotonic for batches recorded before
+	if ( ring->head == ring->tail )
+	{
+		ring->head += ( ring->size - ring->head % ring->size ) % ring->size;
+		ring->tail  = ring->head;
+	}
+
+	uint64_t start = ring->head + STAGING_ALIGNMENT - 1;
+	start -= start % STAGING_ALIGNMENT;
+
+	// allocations never straddle end of buffer
+	if ( start % ring->size + size > ring->size )
+	{
+		start += ring->size - start % ring->size;
+	}
+
+	if ( start + size - ring->tail > ring->size )
+	{
+		return false;
+	}
+
+	ring->head = start + size;
+	*offset    = start % ring->size;
+
+	return true;
+}
+
+// copies data into staging ring and queues job reading it, blocks while ring
+// is full. uploads larger than ring get dedicated staging buffer
+static ft_upload_token
+add_staged_job( struct ft_loader_job* job, const void* data, uint64_t size )
+{
+	struct ft_staging_ring* ring = &loader.staging;
+
+	if ( size > ring->size )
+	{
+		job->staging_buffer = create_staging_buffer( size );
+		job->staging_offset = 0;
+		ft_map_memory( loader.device, job->staging_buffer );
+		memcpy( job->staging_buffer->mapped_memory, data, size );
+		ft_unmap_memory( loader.device, job->staging_buffer );
+		return add_job( job );
+	}
+
+	ft_mutex_lock( &loader.mutex );
+
+	// retired batches release space
+	while ( !allocate_staging( ring, size, &job->staging_offset ) )
+	{
+		ft_condition_variable_wait( &loader.completed, &loader.mutex );
+	}
+
+	uint64_t ticket = ring->reserve_ticket++;
+	uint64_t end    = ring->head;
+
+	ft_mutex_unlock( &loader.mutex );
+
+	job->staging_buffer = ring->buffer;
+	memcpy( ( uint8_t* ) ring->buffer->mapped_memory + job->staging_offset,
+	        data,
+	        size );
+
+	ft_mutex_lock( &loader.mutex );
+
+	while ( ring->publish_ticket != ticket )
+	{
+		ft_condition_variable_wait( &ring->published, &loader.mutex );
+	}
+
+	ft_upload_token token = push_job( job );
+	ring->published_end   = end;
+	ring->publish_ticket++;
+	ft_condition_variable_notify_all( &ring->published );
+
+	ft_mutex_unlock( &loader.mutex );
+
+	return token;
+}
+
+// queues of ownership transfer, null when loader has single queue
 FT_INLINE void
-complete_job( struct ft_command_buffer* cmd, const struct ft_loader_job* j )
+set_barrier_queues( struct ft_queue** src_queue, struct ft_queue** dst_queue )
+{
+	*src_queue = loader.dedicated_transfer ? loader.queue : NULL;
+	*dst_queue = loader.dedicated_transfer ? loader.graphics_queue : NULL;
+}
+
+// buffers are handed over in general state, images ready for sampling
+static void
+record_ownership_barrier( struct ft_command_buffer*   cmd,
+                          const struct ft_loader_job* j )
+{
+	struct ft_queue* src_queue;
+	struct ft_queue* dst_queue;
+	set_barrier_queues( &src_queue, &dst_queue );
+
+	if ( j->type == FT_LOADER_JOB_TYPE_BUFFER_UPLOAD )
+	{
+		const struct ft_buffer_upload_job* job = &j->buffer_upload_job;
+
+		struct ft_buffer_barrier barrier = {
+		    .old_state = FT_RESOURCE_STATE_TRANSFER_DST,
+		    .new_state = FT_RESOURCE_STATE_GENERAL,
+		    .buffer    = job->buffer,
+		    .src_queue = src_queue,
+		    .dst_queue = dst_queue,
+		    .size      = ( uint32_t ) job->size,
+		    .offset    = ( uint32_t ) job->offset,
+		};
+		ft_cmd_barrier( cmd, 0, NULL, 1, &barrier, 0, NULL );
+	}
+	else if ( j->type == FT_LOADER_JOB_TYPE_IMAGE_UPLOAD )
+	{
+		struct ft_image_barrier barrier = {
+		    .old_state = FT_RESOURCE_STATE_TRANSFER_DST,
+		    .new_state = FT_RESOURCE_STATE_SHADER_READ_ONLY,
+		    .image     = j->image_upload_job.image,
+		    .src_queue = src_queue,
+		    .dst_queue = dst_queue,
+		};
+		ft_cmd_barrier( cmd, 0, NULL, 0, NULL, 1, &barrier );
+	}
+}
+
+// copies and release half of ownership transfer
+static void
+record_transfer_job( struct ft_command_buffer*   cmd,
+                     const struct ft_loader_job* j )
 {
 	switch ( j->type )
 	{
@@ -260,7 +540,7 @@ complete_job( struct ft_command_buffer* cmd, const struct ft_loader_job* j )
 
 		ft_cmd_copy_buffer( cmd,
 		                    j->staging_buffer,
-		                    0,
+		                    j->staging_offset,
 		                    job->buffer,
 		                    job->offset,
 		                    job->size );
@@ -275,46 +555,223 @@ complete_job( struct ft_command_buffer* cmd, const struct ft_loader_job* j )
 		barrier.image     = job->image;
 		barrier.old_state = FT_RESOURCE_STATE_UNDEFINED;
 		barrier.new_state = FT_RESOURCE_STATE_TRANSFER_DST;
-		ft_cmd_barrier( loader.cmd, 0, NULL, 0, NULL, 1, &barrier );
-
-		struct ft_buffer_image_copy copy = {
-		    .buffer_offset = 0,
-		    .width         = job->width,
-		    .height        = job->height,
-		    .mip_level     = job->mip_level,
-		};
+		ft_cmd_barrier( cmd, 0, NULL, 0, NULL, 1, &barrier );
 
-		ft_cmd_copy_buffer_to_image( cmd,
-		                             j->staging_buffer,
-		                             job->image,
-		                             &copy );
+		uint64_t offset = j->staging_offset;
 
-		barrier.old_state = FT_RESOURCE_STATE_TRANSFER_DST;
-		barrier.new_state = FT_RESOURCE_STATE_SHADER_READ_ONLY;
-		ft_cmd_barrier( cmd, 0, NULL, 0, NULL, 1, &barrier );
+		for ( uint32_t mip = 0; mip < FT_MAX( job->mip_count, 1 ); ++mip )
+		{
+			struct ft_buffer_image_copy copy = {
+			    .buffer_offset = offset,
+			    .width         = FT_MAX( job->width >> mip, 1 ),
+			    .height        = FT_MAX( job->height >> mip, 1 ),
+			    .mip_level     = job->mip_level + mip,
+			};
+
+			ft_cmd_copy_buffer_to_image( cmd,
+			                             j->staging_buffer,
+			                             job->image,
+			                             &copy );
+
+			offset += ft_format_image_size( job->image->format,
+			                                copy.width,
+			                                copy.height );
+		}
 		break;
 	}
-	case FT_LOADER_JOB_TYPE_GENERATE_MIPMAPS:
-	{
-		const struct ft_generate_mipmaps_job* job = &j->generate_mipmaps_job;
+	default: return;
+	}
+
+	record_ownership_barrier( cmd, j );
+}
 
-		switch ( loader.device->api )
+// acquire half of ownership transfer and graphics only work
+static void
+record_graphics_job( struct ft_command_buffer*   cmd,
+                     const struct ft_loader_job* j )
+{
+	if ( j->type != FT_LOADER_JOB_TYPE_GENERATE_MIPMAPS )
+	{
+		if ( loader.dedicated_transfer )
 		{
+			record_ownership_barrier( cmd, j );
+		}
+		return;
+	}
+
+	const struct ft_generate_mipmaps_job* job = &j->generate_mipmaps_job;
+
+	switch ( loader.device->api )
+	{
 #if FT_VULKAN_BACKEND
-		case FT_RENDERER_API_VULKAN:
-			vk_generate_mipmaps( cmd, job->image, job->state );
-			break;
+	case FT_RENDERER_API_VULKAN:
+		vk_generate_mipmaps( cmd, job->image, job->state );
+		break;
 #endif
-		default:
-			FT_WARN( "mipmap generation not implemented for %s",
-			         ft_renderer_api_to_string( loader.device->api ) );
-			break;
-		}
+	default:
+		FT_WARN( "mipmap generation not implemented for %s",
+		         ft_renderer_api_to_string( loader.device->api ) );
 		break;
 	}
+}
+
+// waits for batch submission and releases its staging space and jobs
+static void
+retire_batch( struct ft_loader_batch* batch )
+{
+	if ( !batch->pending )
+	{
+		return;
+	}
+
+	ft_wait_for_fences( loader.device, 1, &batch->fence );
+
+	ft_mutex_lock( &loader.mutex );
+	loader.staging.tail    = FT_MAX( loader.staging.tail, batch->staging_end );
+	loader.completed_token = batch->last_token;
+	loader.job_count      -= batch->job_count;
+	ft_condition_variable_notify_all( &loader.completed );
+	ft_mutex_unlock( &loader.mutex );
+
+	struct ft_loader_job* job = batch->jobs;
+
+	while ( job )
+	{
+		if ( job->callback )
+		{
+			job->callback( job->token, job->user_data );
+		}
+
+		if ( job->staging_buffer &&
+		     job->staging_buffer != loader.staging.buffer )
+		{
+			ft_destroy_buffer( loader.device, job->staging_buffer );
+		}
+
+		struct ft_loader_job* tmp = job;
+		job                       = job->next;
+		free( tmp );
+	}
+
+	batch->pending   = false;
+	batch->job_count = 0;
+	batch->jobs      = NULL;
+}
+
+FT_INLINE bool
+has_pending_batch( void )
+{
+	for ( uint32_t b = 0; b < LOADER_BATCH_COUNT; ++b )
+	{
+		if ( loader.batches[ b ].pending )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// oldest batch is next one to be reused
+static void
+retire_oldest_batch( void )
+{
+	for ( uint32_t b = 0; b < LOADER_BATCH_COUNT; ++b )
+	{
+		uint32_t index = ( loader.batch_index + b ) % LOADER_BATCH_COUNT;
+
+		if ( loader.batches[ index ].pending )
+		{
+			retire_batch( &loader.batches[ index ] );
+			return;
+		}
+	}
+}
+
+// in submission order
+static void
+retire_batches( void )
+{
+	for ( uint32_t b = 0; b < LOADER_BATCH_COUNT; ++b )
+	{
+		uint32_t index = ( loader.batch_index + b ) % LOADER_BATCH_COUNT;
+		retire_batch( &loader.batches[ index ] );
 	}
 }
 
+static void
+submit_batch( struct ft_loader_batch* batch )
+{
+	struct ft_command_buffer* transfer_cmd = batch->transfer_cmd;
+	struct ft_command_buffer* graphics_cmd =
+	    loader.dedicated_transfer ? batch->graphics_cmd : transfer_cmd;
+
+	ft_begin_command_buffer( transfer_cmd );
+
+	for ( struct ft_loader_job* job = batch->jobs; job; job = job->next )
+	{
+		record_transfer_job( transfer_cmd, job );
+	}
+
+	if ( loader.dedicated_transfer )
+	{
+		ft_end_command_buffer( transfer_cmd );
+		ft_begin_command_buffer( graphics_cmd );
+	}
+
+	for ( struct ft_loader_job* job = batch->jobs; job; job = job->next )
+	{
+		record_graphics_job( graphics_cmd, job );
+	}
+
+	ft_end_command_buffer( graphics_cmd );
+
+	// last submission signals semaphores jobs asked for
+	uint32_t              signal_count = 0;
+	struct ft_semaphore** signal_semaphores =
+	    malloc( batch->job_count * sizeof( struct ft_semaphore* ) );
+
+	for ( struct ft_loader_job* job = batch->jobs; job; job = job->next )
+	{
+		if ( job->signal_semaphore )
+		{
+			signal_semaphores[ signal_count++ ] = job->signal_semaphore;
+		}
+	}
+
+	ft_reset_fences( loader.device, 1, &batch->fence );
+
+	struct ft_queue_submit_info submit_info = {
+	    .command_buffer_count = 1,
+	    .command_buffers      = &transfer_cmd,
+	    .signal_fence         = batch->fence,
+	};
+
+	if ( loader.dedicated_transfer )
+	{
+		submit_info.signal_semaphore_count = 1;
+		submit_info.signal_semaphores      = &batch->semaphore;
+		submit_info.signal_fence           = NULL;
+		ft_queue_submit( loader.queue, &submit_info );
+
+		submit_info = ( struct ft_queue_submit_info ) {
+		    .wait_semaphore_count = 1,
+		    .wait_semaphores      = &batch->semaphore,
+		    .command_buffer_count = 1,
+		    .command_buffers      = &graphics_cmd,
+		    .signal_fence         = batch->fence,
+		};
+	}
+
+	submit_info.signal_semaphore_count = signal_count;
+	submit_info.signal_semaphores      = signal_semaphores;
+	ft_queue_submit( loader.graphics_queue, &submit_info );
+
+	free( signal_semaphores );
+
+	batch->pending = true;
+}
+
 uint32_t
 loader_thread_fun( void* arg )
 {
@@ -322,106 +779,142 @@ loader_thread_fun( void* arg )
 
 	while ( loader.alive )
 	{
-		if ( loader.job_count == 0 )
+		ft_mutex_lock( &loader.mutex );
+
+		// sleeps only when nothing is queued or in flight
+		while ( loader.alive && loader.head == NULL && !has_pending_batch() )
 		{
-			ft_nanosleep( 500000000 );
-			continue;
+			ft_condition_variable_wait( &loader.jobs_available, &loader.mutex );
 		}
 
-		while ( !ft_mutex_try_lock( &loader.mutex ) ) {}
-
-		FT_TRACE( "loader jobs count %d", loader.job_count );
+		struct ft_loader_job* jobs        = loader.head;
+		uint64_t              staging_end = loader.staging.published_end;
 
-		ft_begin_command_buffer( loader.cmd );
+		loader.head = NULL;
+		loader.tail = NULL;
 
-		struct ft_loader_job* job = loader.head;
+		ft_mutex_unlock( &loader.mutex );
 
-		while ( job )
+		if ( jobs == NULL )
 		{
-			complete_job( loader.cmd, job );
-
-			job = job->next;
+			// one batch at a time so new jobs are picked up early, frees
+			// staging space for producers waiting on full ring
+			retire_oldest_batch();
+			continue;
 		}
 
-		ft_end_command_buffer( loader.cmd );
-		ft_immediate_submit( loader.queue, loader.cmd );
+		struct ft_loader_batch* batch = &loader.batches[ loader.batch_index ];
+		loader.batch_index = ( loader.batch_index + 1 ) % LOADER_BATCH_COUNT;
 
-		job = loader.head;
+		retire_batch( batch );
 
-		loader.head      = NULL;
-		loader.tail      = NULL;
-		loader.job_count = 0;
+		batch->jobs        = jobs;
+		batch->staging_end = staging_end;
 
-		ft_mutex_unlock( &loader.mutex );
-
-		while ( job )
+		for ( struct ft_loader_job* job = jobs; job; job = job->next )
 		{
-			if ( job->staging_buffer )
-			{
-				ft_destroy_buffer( loader.device, job->staging_buffer );
-			}
-
-			struct ft_loader_job* tmp = job;
-			job                       = job->next;
-			free( tmp );
+			batch->job_count++;
+			batch->last_token = job->token;
 		}
+
+		FT_TRACE( "loader batch jobs count %d", batch->job_count );
+
+		submit_batch( batch );
 	}
 
+	retire_batches();
+
 	return 0;
 }
 
-void
+ft_upload_token
 ft_upload_buffer( const struct ft_buffer_upload_job* job )
 {
 	FT_ASSERT( job );
 	FT_ASSERT( job->buffer );
 	FT_ASSERT( job->data );
 
-	struct ft_buffer* staging_buffer = create_staging_buffer( job->size );
-	ft_map_memory( loader.device, staging_buffer );
-	memcpy( staging_buffer->mapped_memory, job->data, job->size );
-	ft_unmap_memory( loader.device, staging_buffer );
-
-	add_job( &( struct ft_loader_job ) {
+	struct ft_loader_job loader_job = {
 	    .type              = FT_LOADER_JOB_TYPE_BUFFER_UPLOAD,
+	    .callback          = job->callback,
+	    .user_data         = job->user_data,
+	    .signal_semaphore  = job->signal_semaphore,
 	    .buffer_upload_job = *job,
-	    .staging_buffer    = staging_buffer,
-	} );
+	};
+
+	return add_staged_job( &loader_job, job->data, job->size );
 }
 
-void
+ft_upload_token
 ft_upload_image( const struct ft_image_upload_job* job )
 {
 	FT_ASSERT( job );
 	FT_ASSERT( job->image );
 	FT_ASSERT( job->data );
 
-	uint64_t upload_size =
-	    job->width * job->height * ft_format_size_bytes( job->image->format );
+	uint64_t upload_size = 0;
 
-	struct ft_buffer* staging_buffer = create_staging_buffer( upload_size );
-	ft_map_memory( loader.device, staging_buffer );
-	memcpy( staging_buffer->mapped_memory, job->data, upload_size );
-	ft_unmap_memory( loader.device, staging_buffer );
+	for ( uint32_t mip = 0; mip < FT_MAX( job->mip_count, 1 ); ++mip )
+	{
+		upload_size += ft_format_image_size( job->image->format,
+		                                     FT_MAX( job->width >> mip, 1 ),
+		                                     FT_MAX( job->height >> mip, 1 ) );
+	}
 
-	add_job( &( struct ft_loader_job ) {
+	struct ft_loader_job loader_job = {
 	    .type             = FT_LOADER_JOB_TYPE_IMAGE_UPLOAD,
+	    .callback         = job->callback,
+	    .user_data        = job->user_data,
+	    .signal_semaphore = job->signal_semaphore,
 	    .image_upload_job = *job,
-	    .staging_buffer   = staging_buffer,
-	} );
+	};
+
+	return add_staged_job( &loader_job, job->data, upload_size );
 }
 
-void
+ft_upload_token
 ft_generate_mipmaps( const struct ft_generate_mipmaps_job* job )
 {
-	add_job( &( struct ft_loader_job ) {
+	return add_job( &( struct ft_loader_job ) {
 	    .type                 = FT_LOADER_JOB_TYPE_GENERATE_MIPMAPS,
+	    .callback             = job->callback,
+	    .user_data            = job->user_data,
+	    .signal_semaphore     = job->signal_semaphore,
 	    .generate_mipmaps_job = *job,
 	} );
 }
 
+bool
+ft_upload_is_complete( ft_upload_token token )
+{
+	ft_mutex_lock( &loader.mutex );
+	bool complete = token <= loader.completed_token;
+	ft_mutex_unlock( &loader.mutex );
+
+	return complete;
+}
+
+void
+ft_upload_wait( ft_upload_token token )
+{
+	ft_mutex_lock( &loader.mutex );
+
+	FT_ASSERT( token <= loader.last_token );
+
+	while ( token > loader.completed_token )
+	{
+		ft_condition_variable_wait( &loader.completed, &loader.mutex );
+	}
+
+	ft_mutex_unlock( &loader.mutex );
+}
+
 void
 ft_resource_loader_wait_idle()
 {
-	while ( loader.job_count != 0 ) {}
-}
\ No newline at end of file
+	ft_mutex_lock( &loader.mutex );
+	ft_upload_token token = loader.last_token;
+	ft_mutex_unlock( &loader.mutex );
+
+	ft_upload_wait( token );
+}
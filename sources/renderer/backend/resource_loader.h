@@ -5,28 +5,49 @@
 
 struct ft_buffer;
 struct ft_image;
+struct ft_semaphore;
+
+// increases with every queued job, zero is always complete
+typedef uint64_t ft_upload_token;
+
+// runs on loader thread and must not wait for uploads
+typedef void ( *ft_upload_callback )( ft_upload_token token, void* user_data );
 
 struct ft_buffer_upload_job
 {
-	struct ft_buffer* buffer;
-	uint64_t          offset;
-	uint64_t          size;
-	const void*       data;
+	struct ft_buffer*    buffer;
+	uint64_t             offset;
+	uint64_t             size;
+	const void*          data;
+	// called once data is on gpu, optional
+	ft_upload_callback   callback;
+	void*                user_data;
+	// binary semaphore signaled with upload for graphics queue to wait on,
+	// optional
+	struct ft_semaphore* signal_semaphore;
 };
 
 struct ft_image_upload_job
 {
-	struct ft_image* image;
-	const void*      data;
-	uint32_t         width;
-	uint32_t         height;
-	uint32_t         mip_level;
+	struct ft_image*     image;
+	const void*          data;
+	uint32_t             width;
+	uint32_t             height;
+	uint32_t             mip_level;
+	// levels follow each other in data starting from mip_level, zero is one
+	uint32_t             mip_count;
+	ft_upload_callback   callback;
+	void*                user_data;
+	struct ft_semaphore* signal_semaphore;
 };
 
 struct ft_generate_mipmaps_job
 {
 	struct ft_image*       image;
 	enum ft_resource_state state;
+	ft_upload_callback     callback;
+	void*                  user_data;
+	struct ft_semaphore*   signal_semaphore;
 };
 
 FT_API void
@@ -35,14 +56,21 @@ ft_resource_loader_init( const struct ft_device* device );
 FT_API void
 ft_resource_loader_shutdown();
 
-FT_API void
+FT_API ft_upload_token
 ft_upload_buffer( const struct ft_buffer_upload_job* );
 
-FT_API void
+FT_API ft_upload_token
 ft_upload_image( const struct ft_image_upload_job* );
 
-FT_API void
+FT_API ft_upload_token
 ft_generate_mipmaps( const struct ft_generate_mipmaps_job* );
 
+FT_API bool
+ft_upload_is_complete( ft_upload_token token );
+
+// blocks until gpu finished job of token and every job queued before it
+FT_API void
+ft_upload_wait( ft_upload_token token );
+
 FT_API void
 ft_resource_loader_wait_idle( void );
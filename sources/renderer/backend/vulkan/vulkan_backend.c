@@ -195,15 +195,44 @@ find_queue_family_index( VkPhysicalDevice   physical_device,
 	                                          queue_families );
 
 	VkQueueFlagBits target_queue_type = to_vk_queue_type( queue_type );
+	uint32_t        best_extra        = UINT32_MAX;
 
-	// TODO: Find dedicated queue first
+	// graphics and compute take first family supporting them, transfer
+	// prefers family with fewest other capabilities so copies run on
+	// dedicated dma queue
 	for ( uint32_t i = 0; i < queue_family_count; ++i )
 	{
-		if ( queue_families[ i ].queueFlags & target_queue_type )
+		VkQueueFlags flags = queue_families[ i ].queueFlags;
+
+		if ( !( flags & target_queue_type ) )
+		{
+			continue;
+		}
+
+		if ( queue_type != FT_QUEUE_TYPE_TRANSFER )
 		{
 			index = i;
 			break;
 		}
+
+		uint32_t extra = 0;
+
+		for ( uint32_t t = 0; t < FT_QUEUE_TYPE_COUNT; ++t )
+		{
+			VkQueueFlagBits other =
+			    to_vk_queue_type( ( enum ft_queue_type ) t );
+
+			if ( other != target_queue_type && ( flags & other ) )
+			{
+				extra++;
+			}
+		}
+
+		if ( extra < best_extra )
+		{
+			index      = i;
+			best_extra = extra;
+		}
 	}
 
 	// TODO: Rewrite more elegant way
@@ -327,25 +356,58 @@ vk_create_device( const struct ft_instance*    iinstance,
 
 	uint32_t                queue_create_info_count = 0;
 	VkDeviceQueueCreateInfo queue_create_infos[ FT_QUEUE_TYPE_COUNT ];
-	float                   queue_priority = 1.0f;
+	float                   queue_priorities[ VK_QUEUES_PER_FAMILY ];
 
-	// TODO: Select queues
-	for ( uint32_t i = 0; i < queue_family_count; ++i )
+	for ( uint32_t q = 0; q < VK_QUEUES_PER_FAMILY; ++q )
+	{
+		queue_priorities[ q ] = 1.0f;
+	}
+
+	// family picked for each queue type gets several queues, so render and
+	// loader threads don't submit to the same queue
+	for ( uint32_t t = 0; t < FT_QUEUE_TYPE_COUNT; ++t )
 	{
+		uint32_t i = find_queue_family_index( device->physical_device,
+		                                      ( enum ft_queue_type ) t );
+
+		bool created = false;
+
+		for ( uint32_t q = 0; q < queue_create_info_count; ++q )
+		{
+			created = created || queue_create_infos[ q ].queueFamilyIndex == i;
+		}
+
+		if ( created )
+		{
+			continue;
+		}
+
+		uint32_t queue_count =
+		    FT_MIN( queue_families[ i ].queueCount, VK_QUEUES_PER_FAMILY );
+
+		struct vk_queue_family* family =
+		    &device->queue_families[ queue_create_info_count ];
+		family->index       = i;
+		family->queue_count = queue_count;
+
+		for ( uint32_t q = 0; q < queue_count; ++q )
+		{
+			ft_mutex_create( &family->mutexes[ q ] );
+		}
+
 		queue_create_infos[ queue_create_info_count ].sType =
 		    VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 		queue_create_infos[ queue_create_info_count ].pNext      = NULL;
 		queue_create_infos[ queue_create_info_count ].flags      = 0;
-		queue_create_infos[ queue_create_info_count ].queueCount = 1;
+		queue_create_infos[ queue_create_info_count ].queueCount = queue_count;
 		queue_create_infos[ queue_create_info_count ].pQueuePriorities =
-		    &queue_priority;
+		    queue_priorities;
 		queue_create_infos[ queue_create_info_count ].queueFamilyIndex = i;
 		queue_create_info_count++;
-
-		if ( queue_create_info_count == FT_QUEUE_TYPE_COUNT )
-			break;
 	}
 
+	device->queue_family_count = queue_create_info_count;
+
 	const char* wanted_extensions[] =
 	{ VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 	  VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME,
@@ -538,6 +600,16 @@ vk_destroy_device( struct ft_device* idevice )
 	vmaDestroyAllocator( device->memory_allocator );
 	vkDestroyDevice( device->logical_device, device->vulkan_allocator );
 
+	for ( uint32_t f = 0; f < device->queue_family_count; ++f )
+	{
+		struct vk_queue_family* family = &device->queue_families[ f ];
+
+		for ( uint32_t q = 0; q < family->queue_count; ++q )
+		{
+			ft_mutex_destroy( &family->mutexes[ q ] );
+		}
+	}
+
 	free( device );
 }
 
@@ -553,23 +625,64 @@ vk_create_queue( const struct ft_device*     idevice,
 	uint32_t index =
 	    find_queue_family_index( device->physical_device, info->queue_type );
 
+	struct vk_queue_family* family = NULL;
+
+	for ( uint32_t f = 0; f < device->queue_family_count; ++f )
+	{
+		if ( device->queue_families[ f ].index == index )
+		{
+			family = &device->queue_families[ f ];
+		}
+	}
+
+	FT_ASSERT( family );
+
+	// distinct queues first, once family runs out they are shared and
+	// submissions serialize on mutex of queue
+	uint32_t queue_index = 0;
+
+	for ( uint32_t q = 1; q < family->queue_count; ++q )
+	{
+		if ( family->queue_users[ q ] < family->queue_users[ queue_index ] )
+		{
+			queue_index = q;
+		}
+	}
+
+	family->queue_users[ queue_index ]++;
+
 	queue->interface.family_index = index;
 	queue->interface.type         = info->queue_type;
-	vkGetDeviceQueue( device->logical_device, index, 0, &queue->queue );
+	queue->family                 = family;
+	queue->queue_index            = queue_index;
+	vkGetDeviceQueue( device->logical_device,
+	                  index,
+	                  queue_index,
+	                  &queue->queue );
 }
 
 static void
 vk_destroy_queue( struct ft_queue* iqueue )
 {
 	FT_FROM_HANDLE( queue, iqueue, vk_queue );
+	queue->family->queue_users[ queue->queue_index ]--;
 	free( queue );
 }
 
+// vulkan queues need external synchronization when shared by threads
+FT_INLINE struct ft_mutex*
+get_queue_mutex( const struct vk_queue* queue )
+{
+	return &queue->family->mutexes[ queue->queue_index ];
+}
+
 static void
 vk_queue_wait_idle( const struct ft_queue* iqueue )
 {
 	FT_FROM_HANDLE( queue, iqueue, vk_queue );
+	ft_mutex_lock( get_queue_mutex( queue ) );
 	vkQueueWaitIdle( queue->queue );
+	ft_mutex_unlock( get_queue_mutex( queue ) );
 }
 
 static void
@@ -621,6 +734,7 @@ vk_queue_submit( const struct ft_queue*             iqueue,
 	    .pSignalSemaphores    = signal_semaphores,
 	};
 
+	ft_mutex_lock( get_queue_mutex( queue ) );
 	vkQueueSubmit(
 	    queue->queue,
 	    1,
@@ -628,6 +742,7 @@ vk_queue_submit( const struct ft_queue*             iqueue,
 	    info->signal_fence
 	        ? ( ( struct vk_fence* ) ( info->signal_fence->handle ) )->fence
 	        : VK_NULL_HANDLE );
+	ft_mutex_unlock( get_queue_mutex( queue ) );
 }
 
 static void
@@ -670,7 +785,9 @@ vk_queue_present( const struct ft_queue*              iqueue,
 	    .pImageIndices      = &info->image_index,
 	    .pResults           = NULL,
 	};
+	ft_mutex_lock( get_queue_mutex( queue ) );
 	vkQueuePresentKHR( queue->queue, &present_info );
+	ft_mutex_unlock( get_queue_mutex( queue ) );
 }
 
 static void
@@ -6,6 +6,7 @@
 
 #include <volk/volk.h>
 #include <vk_mem_alloc/vk_mem_alloc.h>
+#include "thread/thread.h"
 
 #if FT_DEBUG
 #define VK_ASSERT( x )                                                         \
@@ -31,6 +32,19 @@ struct vk_instance
 	struct ft_instance       interface;
 };
 
+// queues created in every used family, when more are requested least used
+// queue is shared
+#define VK_QUEUES_PER_FAMILY 2
+
+struct vk_queue_family
+{
+	uint32_t        index;
+	uint32_t        queue_count;
+	uint32_t        queue_users[ VK_QUEUES_PER_FAMILY ];
+	// shared queue may be used by several threads, they lock its mutex
+	struct ft_mutex mutexes[ VK_QUEUES_PER_FAMILY ];
+};
+
 struct vk_device
 {
 	VkAllocationCallbacks* vulkan_allocator;
@@ -39,6 +53,8 @@ struct vk_device
 	VkDevice               logical_device;
 	VmaAllocator           memory_allocator;
 	VkDescriptorPool       descriptor_pool;
+	uint32_t               queue_family_count;
+	struct vk_queue_family queue_families[ FT_QUEUE_TYPE_COUNT ];
 	struct ft_device       interface;
 };
 
@@ -56,8 +72,10 @@ struct vk_command_buffer
 
 struct vk_queue
 {
-	VkQueue         queue;
-	struct ft_queue interface;
+	VkQueue                 queue;
+	struct vk_queue_family* family;
+	uint32_t                queue_index;
+	struct ft_queue         interface;
 };
 
 struct vk_semaphore
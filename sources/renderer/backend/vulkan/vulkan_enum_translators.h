@@ -362,6 +362,19 @@ determine_pipeline_stage_flags( VkAccessFlags      access_flags,
 	{
 		break;
 	}
+	case FT_QUEUE_TYPE_TRANSFER:
+	{
+		// other accesses belong to queue ownership release and end at bottom
+		// of pipe, transfer queue has no other stages
+		if ( access_flags &
+		     ( VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT ) )
+		{
+			return VK_PIPELINE_STAGE_TRANSFER_BIT;
+		}
+
+		return access_flags ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT
+		                    : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	}
 	default:
 	{
 	}
@@ -263,8 +263,7 @@ nk_ft_device_upload_atlas( const void *image, int width, int height )
 	    .mip_level = 0,
 	};
 
-	ft_upload_image( &job );
-	ft_resource_loader_wait_idle();
+	ft_upload_wait( ft_upload_image( &job ) );
 
 	struct ft_sampler_info sampler_info = {
 	    .mag_filter     = FT_FILTER_LINEAR,
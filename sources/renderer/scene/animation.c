@@ -0,0 +1,440 @@
+#include "animation.h"
+
+enum
+{
+	POSE_WEIGHT_TRANSLATION,
+	POSE_WEIGHT_ROTATION,
+	POSE_WEIGHT_SCALE,
+};
+
+FT_INLINE float
+sample_frames( const struct ft_animation_sampler* sampler,
+               float                              current_time,
+               uint32_t*                          previous_frame,
+               uint32_t*                          next_frame )
+{
+	const float* times = sampler->times;
+	uint32_t     last  = sampler->frame_count - 1;
+
+	if ( current_time <= times[ 0 ] )
+	{
+		*previous_frame = 0;
+		*next_frame     = 0;
+		return 0.0f;
+	}
+
+	if ( current_time >= times[ last ] )
+	{
+		*previous_frame = last;
+		*next_frame     = last;
+		return 0.0f;
+	}
+
+	uint32_t lo = 0;
+	uint32_t hi = last;
+
+	while ( hi - lo > 1 )
+	{
+		uint32_t mid = ( lo + hi ) / 2;
+
+		if ( times[ mid ] < current_time )
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	*previous_frame = lo;
+	*next_frame     = hi;
+
+	if ( sampler->interpolation == FT_ANIMATION_INTERPOLATION_STEP )
+	{
+		return 0.0f;
+	}
+
+	return ( current_time - times[ lo ] ) / ( times[ hi ] - times[ lo ] );
+}
+
+FT_INLINE void
+quat_align( quat r, const quat reference, const quat q )
+{
+	float s = float4_mul_inner( reference, q ) < 0.0f ? -1.0f : 1.0f;
+	float4_scale( r, q, s );
+}
+
+FT_INLINE void
+quat_nlerp( quat r, const quat a, const quat b, float t )
+{
+	quat aligned;
+	quat_align( aligned, a, b );
+	float4_lerp( r, a, aligned, t );
+	quat_norm( r, r );
+}
+
+// hermite curve between values of two frames with their tangents scaled by
+// frame duration, as glTF cubic spline sampler defines it
+FT_INLINE void
+sample_spline( float*                             value,
+               const struct ft_animation_sampler* sampler,
+               uint32_t                           previous_frame,
+               uint32_t                           next_frame,
+               float                              t )
+{
+	uint32_t     c  = sampler->component_count;
+	const float* v0 = &sampler->values[ ( previous_frame * 3 + 1 ) * c ];
+	const float* b0 = &sampler->values[ ( previous_frame * 3 + 2 ) * c ];
+	const float* a1 = &sampler->values[ ( next_frame * 3 ) * c ];
+	const float* v1 = &sampler->values[ ( next_frame * 3 + 1 ) * c ];
+
+	float dt = sampler->times[ next_frame ] - sampler->times[ previous_frame ];
+	float t2 = t * t;
+	float t3 = t2 * t;
+
+	float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+	float h10 = ( t3 - 2.0f * t2 + t ) * dt;
+	float h01 = -2.0f * t3 + 3.0f * t2;
+	float h11 = ( t3 - t2 ) * dt;
+
+	for ( uint32_t i = 0; i < c; ++i )
+	{
+		value[ i ] = h00 * v0[ i ] + h10 * b0[ i ] + h01 * v1[ i ] +
+		             h11 * a1[ i ];
+	}
+}
+
+FT_INLINE void
+sample_channel( float*                             value,
+                float*                             reference,
+                const struct ft_animation_channel* channel,
+                float                              current_time )
+{
+	const struct ft_animation_sampler* sampler = channel->sampler;
+
+	uint32_t previous_frame;
+	uint32_t next_frame;
+	float    t =
+	    sample_frames( sampler, current_time, &previous_frame, &next_frame );
+
+	if ( sampler->interpolation == FT_ANIMATION_INTERPOLATION_SPLINE )
+	{
+		sample_spline( value, sampler, previous_frame, next_frame, t );
+
+		if ( channel->transform_type == FT_TRANSFORM_TYPE_ROTATION )
+		{
+			quat_norm( value, value );
+		}
+
+		if ( reference )
+		{
+			// value of first frame follows its in tangent
+			memcpy( reference,
+			        &sampler->values[ sampler->component_count ],
+			        sampler->component_count * sizeof( float ) );
+		}
+
+		return;
+	}
+
+	if ( channel->transform_type == FT_TRANSFORM_TYPE_ROTATION )
+	{
+		const quat* quats = ( const quat* ) sampler->values;
+		quat_nlerp( value, quats[ previous_frame ], quats[ next_frame ], t );
+
+		if ( reference )
+		{
+			float4_dup( reference, quats[ 0 ] );
+		}
+	}
+	else
+	{
+		const float3* values = ( const float3* ) sampler->values;
+		float3_lerp( value, values[ previous_frame ], values[ next_frame ], t );
+
+		if ( reference )
+		{
+			float3_dup( reference, values[ 0 ] );
+		}
+	}
+}
+
+FT_INLINE void
+accumulate_layer( struct ft_joint_pose*            pose,
+                  float3*                          weights,
+                  uint32_t                         joint_count,
+                  const struct ft_animation_layer* layer,
+                  float                            current_time )
+{
+	const struct ft_animation* animation = layer->animation;
+
+	for ( uint32_t ch = 0; ch < animation->channel_count; ++ch )
+	{
+		const struct ft_animation_channel* channel = &animation->channels[ ch ];
+
+		uint32_t j = channel->target;
+
+		if ( j >= joint_count || channel->sampler->frame_count == 0 ||
+		     channel->transform_type == FT_TRANSFORM_TYPE_WEIGHTS )
+		{
+			continue;
+		}
+
+		float w = layer->weight * ( layer->joint_mask ? layer->joint_mask[ j ]
+		                                              : 1.0f );
+
+		if ( w <= 0.0f )
+		{
+			continue;
+		}
+
+		float4 value;
+		sample_channel( value, NULL, channel, current_time );
+
+		struct ft_joint_pose* joint = &pose[ j ];
+
+		switch ( channel->transform_type )
+		{
+		case FT_TRANSFORM_TYPE_TRANSLATION:
+		{
+			float3_scale( value, value, w );
+			float3_add( joint->translation, joint->translation, value );
+			weights[ j ][ POSE_WEIGHT_TRANSLATION ] += w;
+			break;
+		}
+		case FT_TRANSFORM_TYPE_ROTATION:
+		{
+			quat_align( value, joint->rotation, value );
+			quat_scale( value, value, w );
+			quat_add( joint->rotation, joint->rotation, value );
+			weights[ j ][ POSE_WEIGHT_ROTATION ] += w;
+			break;
+		}
+		case FT_TRANSFORM_TYPE_SCALE:
+		{
+			float3_scale( value, value, w );
+			float3_add( joint->scale, joint->scale, value );
+			weights[ j ][ POSE_WEIGHT_SCALE ] += w;
+			break;
+		}
+		default: break;
+		}
+	}
+}
+
+FT_INLINE void
+apply_additive_layer( struct ft_joint_pose*            pose,
+                      uint32_t                         joint_count,
+                      const struct ft_animation_layer* layer,
+                      float                            current_time )
+{
+	const struct ft_animation* animation = layer->animation;
+
+	for ( uint32_t ch = 0; ch < animation->channel_count; ++ch )
+	{
+		const struct ft_animation_channel* channel = &animation->channels[ ch ];
+
+		uint32_t j = channel->target;
+
+		if ( j >= joint_count || channel->sampler->frame_count == 0 ||
+		     channel->transform_type == FT_TRANSFORM_TYPE_WEIGHTS )
+		{
+			continue;
+		}
+
+		float w = layer->weight * ( layer->joint_mask ? layer->joint_mask[ j ]
+		                                              : 1.0f );
+
+		if ( w <= 0.0f )
+		{
+			continue;
+		}
+
+		float4 value;
+		float4 reference;
+		sample_channel( value, reference, channel, current_time );
+
+		struct ft_joint_pose* joint = &pose[ j ];
+
+		switch ( channel->transform_type )
+		{
+		case FT_TRANSFORM_TYPE_TRANSLATION:
+		{
+			float3 delta;
+			float3_sub( delta, value, reference );
+			float3_scale( delta, delta, w );
+			float3_add( joint->translation, joint->translation, delta );
+			break;
+		}
+		case FT_TRANSFORM_TYPE_ROTATION:
+		{
+			quat identity;
+			quat_identity( identity );
+
+			quat inverse_reference;
+			quat_conj( inverse_reference, reference );
+
+			quat delta;
+			quat_mul( delta, inverse_reference, value );
+			quat_nlerp( delta, identity, delta, w );
+
+			quat rotation;
+			quat_mul( rotation, joint->rotation, delta );
+			quat_norm( joint->rotation, rotation );
+			break;
+		}
+		case FT_TRANSFORM_TYPE_SCALE:
+		{
+			for ( uint32_t i = 0; i < 3; ++i )
+			{
+				float ratio = reference[ i ] != 0.0f
+				                  ? value[ i ] / reference[ i ]
+				                  : 1.0f;
+				joint->scale[ i ] *= FT_LERP( 1.0f, ratio, w );
+			}
+			break;
+		}
+		default: break;
+		}
+	}
+}
+
+FT_INLINE float
+layer_time( const struct ft_animation_layer* layer )
+{
+	float duration = layer->animation->duration;
+	return duration > 0.0f ? fmodf( layer->time, duration ) : 0.0f;
+}
+
+void
+ft_pose_from_transforms( struct ft_joint_pose* pose,
+                         const float4x4*       transforms,
+                         uint32_t              joint_count )
+{
+	for ( uint32_t j = 0; j < joint_count; ++j )
+	{
+		float4x4_decompose( pose[ j ].translation,
+		                    pose[ j ].rotation,
+		                    pose[ j ].scale,
+		                    transforms[ j ] );
+	}
+}
+
+void
+ft_pose_to_transforms( float4x4*                   transforms,
+                       const struct ft_joint_pose* pose,
+                       uint32_t                    joint_count )
+{
+	for ( uint32_t j = 0; j < joint_count; ++j )
+	{
+		float4x4_compose( transforms[ j ],
+		                  pose[ j ].translation,
+		                  pose[ j ].rotation,
+		                  pose[ j ].scale );
+	}
+}
+
+void
+ft_interpolate_poses( struct ft_joint_pose*       pose,
+                      const struct ft_joint_pose* from,
+                      const struct ft_joint_pose* to,
+                      uint32_t                    joint_count,
+                      float                       t )
+{
+	for ( uint32_t j = 0; j < joint_count; ++j )
+	{
+		float3_lerp( pose[ j ].translation,
+		             from[ j ].translation,
+		             to[ j ].translation,
+		             t );
+		quat_nlerp( pose[ j ].rotation, from[ j ].rotation, to[ j ].rotation, t );
+		float3_lerp( pose[ j ].scale, from[ j ].scale, to[ j ].scale, t );
+	}
+}
+
+void
+ft_blend_animation_layers( struct ft_joint_pose*            pose,
+                           const struct ft_joint_pose*      rest_pose,
+                           uint32_t                         joint_count,
+                           uint32_t                         layer_count,
+                           const struct ft_animation_layer* layers )
+{
+	FT_ASSERT( pose );
+	FT_ASSERT( rest_pose );
+
+	FT_ALLOC_STACK_ARRAY( float3, weights, joint_count );
+	memset( weights, 0, sizeof( float3 ) * joint_count );
+	memset( pose, 0, sizeof( struct ft_joint_pose ) * joint_count );
+
+	for ( uint32_t l = 0; l < layer_count; ++l )
+	{
+		const struct ft_animation_layer* layer = &layers[ l ];
+
+		if ( layer->blend_mode != FT_ANIMATION_BLEND_MODE_OVERRIDE ||
+		     layer->weight <= 0.0f )
+		{
+			continue;
+		}
+
+		accumulate_layer( pose,
+		                  weights,
+		                  joint_count,
+		                  layer,
+		                  layer_time( layer ) );
+	}
+
+	for ( uint32_t j = 0; j < joint_count; ++j )
+	{
+		struct ft_joint_pose*       joint = &pose[ j ];
+		const struct ft_joint_pose* rest  = &rest_pose[ j ];
+
+		float wt = weights[ j ][ POSE_WEIGHT_TRANSLATION ];
+		float wr = weights[ j ][ POSE_WEIGHT_ROTATION ];
+		float ws = weights[ j ][ POSE_WEIGHT_SCALE ];
+
+		if ( wt < 1.0f )
+		{
+			float3 r;
+			float3_scale( r, rest->translation, 1.0f - wt );
+			float3_add( joint->translation, joint->translation, r );
+		}
+		else
+		{
+			float3_inv_scale( joint->translation, joint->translation, wt );
+		}
+
+		if ( wr < 1.0f )
+		{
+			quat r;
+			quat_align( r, joint->rotation, rest->rotation );
+			quat_scale( r, r, 1.0f - wr );
+			quat_add( joint->rotation, joint->rotation, r );
+		}
+		quat_norm( joint->rotation, joint->rotation );
+
+		if ( ws < 1.0f )
+		{
+			float3 r;
+			float3_scale( r, rest->scale, 1.0f - ws );
+			float3_add( joint->scale, joint->scale, r );
+		}
+		else
+		{
+			float3_inv_scale( joint->scale, joint->scale, ws );
+		}
+	}
+
+	for ( uint32_t l = 0; l < layer_count; ++l )
+	{
+		const struct ft_animation_layer* layer = &layers[ l ];
+
+		if ( layer->blend_mode != FT_ANIMATION_BLEND_MODE_ADDITIVE ||
+		     layer->weight <= 0.0f )
+		{
+			continue;
+		}
+
+		apply_additive_layer( pose, joint_count, layer, layer_time( layer ) );
+	}
+}
@@ -3,6 +3,29 @@
 #include "math/linear.h"
 #include "model_loader.h"
 
+enum ft_animation_blend_mode
+{
+	FT_ANIMATION_BLEND_MODE_OVERRIDE,
+	FT_ANIMATION_BLEND_MODE_ADDITIVE,
+};
+
+struct ft_joint_pose
+{
+	float3 translation;
+	quat   rotation;
+	float3 scale;
+};
+
+struct ft_animation_layer
+{
+	const struct ft_animation*   animation;
+	float                        time;
+	float                        weight;
+	enum ft_animation_blend_mode blend_mode;
+	// per joint weights, NULL applies layer to every joint
+	const float* joint_mask;
+};
+
 FT_INLINE void
 apply_animation_channel( float4x4                           r,
                          float                              current_time,
@@ -47,6 +70,14 @@ apply_animation_channel( float4x4                           r,
 		    ( sampler->times[ next_frame ] - sampler->times[ previous_frame ] );
 	}
 
+	// spline frames hold in tangent, value and out tangent, tangents are
+	// ignored here
+	if ( sampler->interpolation == FT_ANIMATION_INTERPOLATION_SPLINE )
+	{
+		previous_frame = previous_frame * 3 + 1;
+		next_frame     = next_frame * 3 + 1;
+	}
+
 	switch ( channel->transform_type )
 	{
 	case FT_TRANSFORM_TYPE_TRANSLATION:
@@ -103,3 +134,55 @@ apply_animation( float4x4*                  transforms,
 		                         channel );
 	}
 }
+
+FT_API void
+ft_pose_from_transforms( struct ft_joint_pose* pose,
+                         const float4x4*       transforms,
+                         uint32_t              joint_count );
+
+FT_API void
+ft_pose_to_transforms( float4x4*                   transforms,
+                       const struct ft_joint_pose* pose,
+                       uint32_t                    joint_count );
+
+// override layers are weighted and mixed with rest pose where their total
+// weight is below one, additive layers apply delta from their first frame
+FT_API void
+ft_blend_animation_layers( struct ft_joint_pose*            pose,
+                           const struct ft_joint_pose*      rest_pose,
+                           uint32_t                         joint_count,
+                           uint32_t                         layer_count,
+                           const struct ft_animation_layer* layers );
+
+FT_API void
+ft_interpolate_poses( struct ft_joint_pose*       pose,
+                      const struct ft_joint_pose* from,
+                      const struct ft_joint_pose* to,
+                      uint32_t                    joint_count,
+                      float                       t );
+
+FT_INLINE void
+ft_animation_cross_fade( struct ft_animation_layer  layers[ 2 ],
+                         const struct ft_animation* from,
+                         float                      from_time,
+                         const struct ft_animation* to,
+                         float                      to_time,
+                         float                      elapsed,
+                         float                      duration )
+{
+	float t = duration > 0.0f ? FT_CLAMP( elapsed / duration, 0.0f, 1.0f )
+	                          : 1.0f;
+	t       = t * t * ( 3.0f - 2.0f * t );
+
+	memset( layers, 0, 2 * sizeof( struct ft_animation_layer ) );
+
+	layers[ 0 ].animation  = from;
+	layers[ 0 ].time       = from_time;
+	layers[ 0 ].weight     = 1.0f - t;
+	layers[ 0 ].blend_mode = FT_ANIMATION_BLEND_MODE_OVERRIDE;
+
+	layers[ 1 ].animation  = to;
+	layers[ 1 ].time       = to_time;
+	layers[ 1 ].weight     = t;
+	layers[ 1 ].blend_mode = FT_ANIMATION_BLEND_MODE_OVERRIDE;
+}
@@ -0,0 +1,155 @@
+#include "animation_lod.h"
+
+void
+ft_animation_lod_state_init( struct ft_animation_lod_state* state,
+                             uint32_t                       joint_count,
+                             uint32_t                       phase )
+{
+	FT_ASSERT( state );
+
+	memset( state, 0, sizeof( struct ft_animation_lod_state ) );
+	state->joint_count         = joint_count;
+	state->phase               = phase;
+	state->interval            = 1;
+	state->previous_pose =
+	    calloc( joint_count, sizeof( struct ft_joint_pose ) );
+	state->next_pose = calloc( joint_count, sizeof( struct ft_joint_pose ) );
+}
+
+void
+ft_animation_lod_state_free( struct ft_animation_lod_state* state )
+{
+	ft_safe_free( state->previous_pose );
+	ft_safe_free( state->next_pose );
+	memset( state, 0, sizeof( struct ft_animation_lod_state ) );
+}
+
+uint32_t
+ft_select_animation_lod( const struct ft_animation_lod_policy* policy,
+                         const struct ft_camera*               camera,
+                         const struct ft_frustum*              frustum,
+                         const struct ft_bounds*               bounds,
+                         const float4x4                        world )
+{
+	FT_ASSERT( policy->level_count > 0 && bounds );
+
+	struct ft_bounds placed;
+	ft_transform_bounds( &placed, bounds, world );
+
+	if ( policy->skip_invisible && frustum &&
+	     !ft_frustum_test_sphere( frustum, placed.center, placed.radius ) )
+	{
+		return policy->level_count;
+	}
+
+	float screen_size =
+	    ft_camera_get_screen_size( camera, placed.center, placed.radius );
+
+	for ( uint32_t l = 0; l < policy->level_count; ++l )
+	{
+		if ( screen_size >= policy->levels[ l ].min_screen_size )
+		{
+			return l;
+		}
+	}
+
+	return policy->skip_invisible ? policy->level_count
+	                              : policy->level_count - 1;
+}
+
+bool
+ft_animate_with_lod( struct ft_animation_lod_state*        state,
+                     const struct ft_animation_lod_policy* policy,
+                     const struct ft_camera*               camera,
+                     const struct ft_frustum*              frustum,
+                     const struct ft_bounds*               bounds,
+                     const float4x4                        world,
+                     float                                 delta_time,
+                     uint32_t                              layer_count,
+                     const struct ft_animation_layer*      layers,
+                     const struct ft_joint_pose*           rest_pose,
+                     struct ft_joint_pose*                 pose )
+{
+	FT_ASSERT( state->previous_pose && state->next_pose );
+
+	uint32_t lod =
+	    ft_select_animation_lod( policy, camera, frustum, bounds, world );
+
+	state->visible = lod < policy->level_count;
+
+	if ( !state->visible )
+	{
+		state->valid = false;
+		return false;
+	}
+
+	const struct ft_animation_lod_level* level = &policy->levels[ lod ];
+
+	state->lod      = lod;
+	state->interval = FT_MAX( level->update_interval, 1 );
+	state->frames_since_update++;
+
+	uint32_t joint_count = state->joint_count;
+
+	if ( !state->valid || state->frames_since_update >= state->interval )
+	{
+		uint32_t animated_joint_count =
+		    level->joint_count ? FT_MIN( level->joint_count, joint_count )
+		                       : joint_count;
+
+		// spread first evaluations of instances across frames
+		uint32_t start = state->valid ? 0 : state->phase % state->interval;
+
+		// evaluate pose which will be reached on last frame of interval
+		float ahead = ( float ) ( state->interval - 1 - start ) * delta_time;
+
+		FT_ALLOC_STACK_ARRAY( struct ft_animation_layer,
+		                      ahead_layers,
+		                      layer_count );
+
+		for ( uint32_t l = 0; l < layer_count; ++l )
+		{
+			ahead_layers[ l ] = layers[ l ];
+			ahead_layers[ l ].time += ahead;
+		}
+
+		if ( state->valid )
+		{
+			memcpy( state->previous_pose,
+			        pose,
+			        joint_count * sizeof( struct ft_joint_pose ) );
+		}
+
+		ft_blend_animation_layers( state->next_pose,
+		                           rest_pose,
+		                           animated_joint_count,
+		                           layer_count,
+		                           ahead_layers );
+
+		memcpy( state->next_pose + animated_joint_count,
+		        rest_pose + animated_joint_count,
+		        ( joint_count - animated_joint_count ) *
+		            sizeof( struct ft_joint_pose ) );
+
+		if ( !state->valid )
+		{
+			memcpy( state->previous_pose,
+			        state->next_pose,
+			        joint_count * sizeof( struct ft_joint_pose ) );
+		}
+
+		state->valid               = true;
+		state->frames_since_update = start;
+	}
+
+	float t = ( float ) ( state->frames_since_update + 1 ) /
+	          ( float ) state->interval;
+
+	ft_interpolate_poses( pose,
+	                      state->previous_pose,
+	                      state->next_pose,
+	                      joint_count,
+	                      t );
+
+	return true;
+}
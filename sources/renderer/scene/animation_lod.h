@@ -0,0 +1,69 @@
+#pragma once
+
+#include "base/base.h"
+#include "camera/camera.h"
+#include "animation.h"
+
+#define FT_MAX_ANIMATION_LOD_COUNT 4
+
+struct ft_animation_lod_level
+{
+	// level is used while instance covers at least this fraction of screen
+	float    min_screen_size;
+	// pose is evaluated every nth frame and interpolated in between
+	uint32_t update_interval;
+	// joints are expected in parent before child order, 0 means all joints
+	uint32_t joint_count;
+};
+
+struct ft_animation_lod_policy
+{
+	uint32_t                      level_count;
+	struct ft_animation_lod_level levels[ FT_MAX_ANIMATION_LOD_COUNT ];
+	bool                          skip_invisible;
+};
+
+struct ft_animation_lod_state
+{
+	uint32_t              lod;
+	uint32_t              phase;
+	uint32_t              frames_since_update;
+	uint32_t              interval;
+	bool                  visible;
+	bool                  valid;
+	uint32_t              joint_count;
+	struct ft_joint_pose* previous_pose;
+	struct ft_joint_pose* next_pose;
+};
+
+FT_API void
+ft_animation_lod_state_init( struct ft_animation_lod_state* state,
+                             uint32_t                       joint_count,
+                             uint32_t                       phase );
+
+FT_API void
+ft_animation_lod_state_free( struct ft_animation_lod_state* state );
+
+// instance is bounds placed by world, e.g. model bounds with identity or
+// mesh bounds with one of mesh instance transforms. returns
+// policy->level_count when instance is culled
+FT_API uint32_t
+ft_select_animation_lod( const struct ft_animation_lod_policy* policy,
+                         const struct ft_camera*               camera,
+                         const struct ft_frustum*              frustum,
+                         const struct ft_bounds*               bounds,
+                         const float4x4                        world );
+
+// returns false when pose was left untouched because instance is culled
+FT_API bool
+ft_animate_with_lod( struct ft_animation_lod_state*        state,
+                     const struct ft_animation_lod_policy* policy,
+                     const struct ft_camera*               camera,
+                     const struct ft_frustum*              frustum,
+                     const struct ft_bounds*               bounds,
+                     const float4x4                        world,
+                     float                                 delta_time,
+                     uint32_t                              layer_count,
+                     const struct ft_animation_layer*      layers,
+                     const struct ft_joint_pose*           rest_pose,
+                     struct ft_joint_pose*                 pose );
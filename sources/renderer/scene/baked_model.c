@@ -0,0 +1,508 @@
+#include <stdio.h>
+#include "fs/fs.h"
+#include "baked_model.h"
+
+#define BAKED_MODEL_ALIGNMENT 16
+// mip chains of larger textures do not fit any format
+#define MAX_BAKED_MIP_LEVELS 32
+
+// same walk measures model, writes it and validates mapped file against
+// element counts it reads
+enum bake_pass
+{
+	BAKE_PASS_MEASURE,
+	BAKE_PASS_WRITE,
+	BAKE_PASS_VALIDATE,
+};
+
+struct bake_context
+{
+	enum bake_pass pass;
+	// null while measuring, mapped file while validating
+	uint8_t*       data;
+	// written bytes, file size while validating
+	uint64_t       size;
+	uint64_t*      relocations;
+	uint64_t       relocation_count;
+	// cleared by validation pass on first array outside file
+	bool           valid;
+};
+
+FT_INLINE uint64_t
+align_size( uint64_t size )
+{
+	return ( size + BAKED_MODEL_ALIGNMENT - 1 ) &
+	       ~( uint64_t ) ( BAKED_MODEL_ALIGNMENT - 1 );
+}
+
+FT_INLINE void
+record_pointer( struct bake_context* ctx, void* pointer )
+{
+	if ( ctx->pass == BAKE_PASS_WRITE )
+	{
+		ctx->relocations[ ctx->relocation_count ] =
+		    ( uint8_t* ) pointer - ctx->data;
+	}
+
+	ctx->relocation_count++;
+}
+
+// array of size bytes must be aligned and fit in file
+static void
+validate_array( struct bake_context* ctx, const void* array, uint64_t size )
+{
+	if ( array == NULL || size == 0 )
+	{
+		return;
+	}
+
+	uintptr_t first = ( uintptr_t ) ctx->data;
+	uintptr_t p     = ( uintptr_t ) array;
+
+	// written so that corrupted counts can not overflow
+	if ( p < first || p - first > ctx->size ||
+	     size > ctx->size - ( p - first ) ||
+	     ( p - first ) % BAKED_MODEL_ALIGNMENT != 0 )
+	{
+		ctx->valid = false;
+	}
+}
+
+// copies array into file and points field to the copy
+static void
+bake_array( struct bake_context* ctx, void* field, uint64_t size )
+{
+	void** pointer = field;
+
+	if ( ctx->pass == BAKE_PASS_VALIDATE )
+	{
+		validate_array( ctx, *pointer, size );
+		return;
+	}
+
+	if ( *pointer == NULL || size == 0 )
+	{
+		if ( ctx->pass == BAKE_PASS_WRITE )
+		{
+			*pointer = NULL;
+		}
+
+		return;
+	}
+
+	uint64_t offset = ctx->size;
+	ctx->size       = align_size( ctx->size + size );
+
+	if ( ctx->pass == BAKE_PASS_WRITE )
+	{
+		memcpy( ctx->data + offset, *pointer, size );
+		*pointer = ctx->data + offset;
+	}
+
+	record_pointer( ctx, pointer );
+}
+
+static void
+bake_mesh( struct bake_context* ctx, struct ft_mesh* mesh )
+{
+	uint64_t vertex_count = mesh->vertex_count;
+
+	// counts of fixed size arrays bound walk itself
+	if ( ctx->pass == BAKE_PASS_VALIDATE &&
+	     ( mesh->packed_vertices.stream_count > FT_MAX_VERTEX_STREAM_COUNT ||
+	       mesh->lod_count > FT_MAX_MESH_LOD_COUNT ) )
+	{
+		ctx->valid = false;
+		return;
+	}
+
+	bake_array( ctx, &mesh->positions, vertex_count * 3 * sizeof( float ) );
+	bake_array( ctx, &mesh->normals, vertex_count * 3 * sizeof( float ) );
+	bake_array( ctx, &mesh->tangents, vertex_count * 4 * sizeof( float ) );
+	bake_array( ctx, &mesh->texcoords, vertex_count * 2 * sizeof( float ) );
+	bake_array( ctx, &mesh->joints, vertex_count * 4 * sizeof( float ) );
+	bake_array( ctx, &mesh->weights, vertex_count * 4 * sizeof( float ) );
+	bake_array( ctx,
+	            &mesh->instance_nodes,
+	            mesh->instance_count * sizeof( uint32_t ) );
+	bake_array( ctx,
+	            &mesh->instance_transforms,
+	            mesh->instance_count * sizeof( float4x4 ) );
+	bake_array( ctx,
+	            &mesh->indices_16,
+	            mesh->index_count * sizeof( uint16_t ) );
+	bake_array( ctx,
+	            &mesh->indices_32,
+	            mesh->index_count * sizeof( uint32_t ) );
+
+	struct ft_vertex_streams* streams = &mesh->packed_vertices;
+
+	for ( uint32_t s = 0; s < streams->stream_count; ++s )
+	{
+		bake_array( ctx,
+		            &streams->data[ s ],
+		            vertex_count * streams->strides[ s ] );
+	}
+
+	struct ft_meshlets* meshlets = &mesh->meshlets;
+
+	bake_array( ctx,
+	            &meshlets->meshlets,
+	            meshlets->meshlet_count * sizeof( struct ft_meshlet ) );
+	bake_array( ctx,
+	            &meshlets->vertices,
+	            meshlets->vertex_count * sizeof( uint32_t ) );
+	bake_array( ctx, &meshlets->triangles, meshlets->triangle_count * 3 );
+
+	for ( uint32_t l = 0; l < mesh->lod_count; ++l )
+	{
+		struct ft_mesh_lod* lod = &mesh->lods[ l ];
+
+		bake_array( ctx,
+		            &lod->indices_16,
+		            lod->index_count * sizeof( uint16_t ) );
+		bake_array( ctx,
+		            &lod->indices_32,
+		            lod->index_count * sizeof( uint32_t ) );
+	}
+}
+
+static void
+bake_animation( struct bake_context* ctx, struct ft_animation* animation )
+{
+	struct ft_animation_sampler* samplers = animation->samplers;
+
+	bake_array( ctx,
+	            &animation->samplers,
+	            animation->sampler_count *
+	                sizeof( struct ft_animation_sampler ) );
+
+	// arrays are read only after validation accepted them
+	for ( uint32_t s = 0; s < animation->sampler_count && ctx->valid; ++s )
+	{
+		struct ft_animation_sampler* sampler = &animation->samplers[ s ];
+
+		uint32_t value_count =
+		    sampler->interpolation == FT_ANIMATION_INTERPOLATION_SPLINE
+		        ? sampler->frame_count * 3
+		        : sampler->frame_count;
+
+		bake_array( ctx,
+		            &sampler->times,
+		            sampler->frame_count * sizeof( float ) );
+		bake_array( ctx,
+		            &sampler->values,
+		            value_count * sampler->component_count * sizeof( float ) );
+	}
+
+	bake_array( ctx,
+	            &animation->channels,
+	            animation->channel_count *
+	                sizeof( struct ft_animation_channel ) );
+
+	// channels point into sampler array which has moved
+	for ( uint32_t c = 0; c < animation->channel_count && ctx->valid; ++c )
+	{
+		struct ft_animation_channel* channel = &animation->channels[ c ];
+
+		if ( channel->sampler == NULL )
+		{
+			continue;
+		}
+
+		if ( ctx->pass == BAKE_PASS_VALIDATE )
+		{
+			uintptr_t first = ( uintptr_t ) animation->samplers;
+			uintptr_t p     = ( uintptr_t ) channel->sampler;
+
+			if ( p < first ||
+			     ( p - first ) % sizeof( struct ft_animation_sampler ) != 0 ||
+			     ( p - first ) / sizeof( struct ft_animation_sampler ) >=
+			         animation->sampler_count )
+			{
+				ctx->valid = false;
+			}
+
+			continue;
+		}
+
+		if ( ctx->pass == BAKE_PASS_WRITE )
+		{
+			channel->sampler =
+			    animation->samplers + ( channel->sampler - samplers );
+		}
+
+		record_pointer( ctx, &channel->sampler );
+	}
+}
+
+static void
+bake_scene_graph( struct bake_context* ctx, struct ft_scene_graph* graph )
+{
+	uint32_t count = graph->node_count;
+
+	bake_array( ctx, &graph->parents, count * sizeof( uint32_t ) );
+	bake_array( ctx, &graph->subtree_ends, count * sizeof( uint32_t ) );
+	bake_array( ctx, &graph->translations, count * sizeof( float3 ) );
+	bake_array( ctx, &graph->rotations, count * sizeof( quat ) );
+	bake_array( ctx, &graph->scales, count * sizeof( float3 ) );
+	bake_array( ctx, &graph->world_transforms, count * sizeof( float4x4 ) );
+	bake_array( ctx, &graph->dirty, count * sizeof( bool ) );
+	bake_array( ctx, &graph->dirty_nodes, count * sizeof( uint32_t ) );
+	bake_array( ctx,
+	            &graph->changed_ranges,
+	            count * sizeof( struct ft_scene_range ) );
+}
+
+// walks model copying every array it owns, measure pass leaves model
+// untouched and validation pass checks arrays before reading them
+static void
+bake_model( struct bake_context* ctx, struct ft_model* model )
+{
+	bake_array( ctx,
+	            &model->meshes,
+	            model->mesh_count * sizeof( struct ft_mesh ) );
+
+	for ( uint32_t m = 0; m < model->mesh_count && ctx->valid; ++m )
+	{
+		bake_mesh( ctx, &model->meshes[ m ] );
+	}
+
+	bake_array( ctx,
+	            &model->animations,
+	            model->animation_count * sizeof( struct ft_animation ) );
+
+	for ( uint32_t a = 0; a < model->animation_count && ctx->valid; ++a )
+	{
+		bake_animation( ctx, &model->animations[ a ] );
+	}
+
+	bake_array( ctx,
+	            &model->textures,
+	            model->texture_count * sizeof( struct ft_texture ) );
+
+	for ( uint32_t t = 0; t < model->texture_count && ctx->valid; ++t )
+	{
+		struct ft_texture* texture = &model->textures[ t ];
+
+		if ( ctx->pass == BAKE_PASS_VALIDATE &&
+		     texture->mip_levels > MAX_BAKED_MIP_LEVELS )
+		{
+			ctx->valid = false;
+			break;
+		}
+
+		bake_array( ctx,
+		            &texture->data,
+		            ft_texture_mip_offset( texture, texture->mip_levels ) );
+	}
+
+	bake_scene_graph( ctx, &model->scene_graph );
+}
+
+bool
+ft_save_baked_model( const struct ft_model* model,
+                     enum ft_model_flags    load_flags,
+                     const char*            filename )
+{
+	FT_ASSERT( model );
+	FT_ASSERT( model->texture_decoder == NULL );
+	FT_ASSERT( model->streamer == NULL );
+
+	uint64_t model_offset =
+	    align_size( sizeof( struct ft_baked_model_header ) );
+
+	// measure pass only reads model
+	struct bake_context ctx;
+	memset( &ctx, 0, sizeof( ctx ) );
+	ctx.pass  = BAKE_PASS_MEASURE;
+	ctx.size  = model_offset + align_size( sizeof( struct ft_model ) );
+	ctx.valid = true;
+	bake_model( &ctx, ( struct ft_model* ) model );
+
+	uint64_t relocation_offset = ctx.size;
+	uint64_t relocation_count  = ctx.relocation_count;
+	uint64_t size = relocation_offset + relocation_count * sizeof( uint64_t );
+
+	uint8_t* data = calloc( 1, size );
+
+	struct ft_baked_model_header* header = ( void* ) data;
+	header->magic                        = FT_BAKED_MODEL_MAGIC;
+	header->version                      = FT_BAKED_MODEL_VERSION;
+	header->pointer_size                 = sizeof( void* );
+	header->load_flags                   = load_flags;
+	header->model_offset                 = model_offset;
+	header->relocation_offset            = relocation_offset;
+	header->relocation_count             = relocation_count;
+	header->size                         = size;
+
+	// instance index is rebuilt by first transform update after load
+	struct ft_model* baked       = ( void* ) ( data + model_offset );
+	*baked                       = *model;
+	baked->node_instance_offsets = NULL;
+	baked->node_instances        = NULL;
+	baked->instance_bounds       = NULL;
+	baked->texture_decoder       = NULL;
+	baked->streamer              = NULL;
+	baked->mapped_file           = NULL;
+
+	ctx.pass             = BAKE_PASS_WRITE;
+	ctx.data             = data;
+	ctx.size             = model_offset + align_size( sizeof( struct ft_model ) );
+	ctx.relocations      = ( uint64_t* ) ( data + relocation_offset );
+	ctx.relocation_count = 0;
+	bake_model( &ctx, baked );
+
+	FT_ASSERT( ctx.size == relocation_offset );
+	FT_ASSERT( ctx.relocation_count == relocation_count );
+
+	// pointers are stored relative to file start
+	for ( uint64_t r = 0; r < relocation_count; ++r )
+	{
+		uint8_t** pointer = ( uint8_t** ) ( data + ctx.relocations[ r ] );
+		*pointer          = ( uint8_t* ) ( uintptr_t ) ( *pointer - data );
+	}
+
+	bool  result = false;
+	FILE* file   = fopen( filename, "wb" );
+
+	if ( file )
+	{
+		result = fwrite( data, size, 1, file ) == 1;
+		result = fclose( file ) == 0 && result;
+	}
+
+	if ( !result )
+	{
+		FT_WARN( "failed to write baked model %s", filename );
+	}
+
+	free( data );
+
+	return result;
+}
+
+FT_INLINE bool
+validate_header( const struct ft_baked_model_header* header, uint64_t size )
+{
+	// written so that corrupted offsets can not overflow
+	return header->magic == FT_BAKED_MODEL_MAGIC &&
+	       header->version == FT_BAKED_MODEL_VERSION &&
+	       header->pointer_size == sizeof( void* ) && header->size == size &&
+	       header->model_offset <= size &&
+	       sizeof( struct ft_model ) <= size - header->model_offset &&
+	       header->relocation_offset <= size &&
+	       header->relocation_count <=
+	           ( size - header->relocation_offset ) / sizeof( uint64_t );
+}
+
+// pointer must lie in file and point into it
+FT_INLINE bool
+validate_relocation( const uint8_t* data, uint64_t offset, uint64_t size )
+{
+	return offset % sizeof( void* ) == 0 && offset <= size - sizeof( void* ) &&
+	       *( const uintptr_t* ) ( data + offset ) < size;
+}
+
+struct ft_model
+ft_load_baked_model( const char* filename )
+{
+	struct ft_model model;
+	memset( &model, 0, sizeof( struct ft_model ) );
+
+	struct ft_mapped_file file;
+
+	if ( !ft_map_file( filename, &file ) )
+	{
+		return model;
+	}
+
+	uint8_t*                            data   = file.data;
+	const struct ft_baked_model_header* header = file.data;
+
+	if ( file.size < sizeof( struct ft_baked_model_header ) ||
+	     !validate_header( header, file.size ) )
+	{
+		FT_WARN( "invalid or outdated baked model %s", filename );
+		ft_unmap_file( &file );
+		return model;
+	}
+
+	const uint64_t* relocations =
+	    ( const uint64_t* ) ( data + header->relocation_offset );
+
+	for ( uint64_t r = 0; r < header->relocation_count; ++r )
+	{
+		if ( !validate_relocation( data, relocations[ r ], file.size ) )
+		{
+			FT_WARN( "invalid pointer in baked model %s", filename );
+			ft_unmap_file( &file );
+			return model;
+		}
+
+		uint8_t** pointer = ( uint8_t** ) ( data + relocations[ r ] );
+		*pointer          = data + ( uintptr_t ) *pointer;
+	}
+
+	struct ft_model* baked = ( void* ) ( data + header->model_offset );
+
+	// counts stored in file must match arrays relocated above
+	struct bake_context ctx;
+	memset( &ctx, 0, sizeof( ctx ) );
+	ctx.pass  = BAKE_PASS_VALIDATE;
+	ctx.data  = data;
+	ctx.size  = file.size;
+	ctx.valid = header->model_offset % BAKED_MODEL_ALIGNMENT == 0;
+
+	if ( ctx.valid )
+	{
+		bake_model( &ctx, baked );
+	}
+
+	if ( !ctx.valid )
+	{
+		FT_WARN( "invalid array in baked model %s", filename );
+		ft_unmap_file( &file );
+		return model;
+	}
+
+	// arrays live in mapping, mark them so nothing frees or resizes them
+	for ( uint32_t m = 0; m < baked->mesh_count; ++m )
+	{
+		baked->meshes[ m ].mapped = true;
+	}
+
+	for ( uint32_t t = 0; t < baked->texture_count; ++t )
+	{
+		baked->textures[ t ].mapped = true;
+	}
+
+	model                       = *baked;
+	model.node_instance_offsets = NULL;
+	model.node_instances        = NULL;
+	model.instance_bounds       = NULL;
+	model.texture_decoder       = NULL;
+	model.streamer              = NULL;
+	model.mapped_file           = malloc( sizeof( struct ft_mapped_file ) );
+	*model.mapped_file          = file;
+
+	return model;
+}
+
+bool
+ft_read_baked_model_header( const char*                   filename,
+                            struct ft_baked_model_header* header )
+{
+	FILE* file = fopen( filename, "rb" );
+
+	if ( file == NULL )
+	{
+		return false;
+	}
+
+	bool result = fread( header, sizeof( *header ), 1, file ) == 1;
+	fclose( file );
+
+	return result && header->magic == FT_BAKED_MODEL_MAGIC &&
+	       header->version == FT_BAKED_MODEL_VERSION;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "base/base.h"
+#include "model_loader.h"
+
+#define FT_BAKED_MODEL_MAGIC   0x444d5446
+#define FT_BAKED_MODEL_VERSION 7
+
+// file starts with header, followed by model, arrays and relocation table,
+// every pointer in file is stored as offset from file start
+struct ft_baked_model_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t pointer_size;
+	uint32_t load_flags;
+	uint64_t model_offset;
+	uint64_t relocation_offset;
+	uint64_t relocation_count;
+	uint64_t size;
+};
+
+// textures must be decoded, load flags are stored for change detection
+FT_API bool
+ft_save_baked_model( const struct ft_model* model,
+                     enum ft_model_flags    load_flags,
+                     const char*            filename );
+
+// maps file and patches pointers in place, free with ft_free_gltf
+FT_API struct ft_model
+ft_load_baked_model( const char* filename );
+
+FT_API bool
+ft_read_baked_model_header( const char*                   filename,
+                            struct ft_baked_model_header* header );
@@ -0,0 +1,327 @@
+#include "geometry_packer.h"
+
+static bool
+same_vertex_layout( const struct ft_vertex_streams* a,
+                    const struct ft_vertex_streams* b )
+{
+	if ( a->stream_count != b->stream_count ||
+	     a->layout.attribute_info_count != b->layout.attribute_info_count )
+	{
+		return false;
+	}
+
+	for ( uint32_t s = 0; s < a->stream_count; ++s )
+	{
+		if ( a->strides[ s ] != b->strides[ s ] )
+		{
+			return false;
+		}
+	}
+
+	for ( uint32_t i = 0; i < a->layout.attribute_info_count; ++i )
+	{
+		const struct ft_vertex_attribute_info* aa =
+		    &a->layout.attribute_infos[ i ];
+		const struct ft_vertex_attribute_info* ba =
+		    &b->layout.attribute_infos[ i ];
+
+		if ( aa->location != ba->location || aa->binding != ba->binding ||
+		     aa->format != ba->format || aa->offset != ba->offset )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// meshes without index buffer are drawn with sequential indices
+FT_INLINE uint32_t
+get_level_index_count( const struct ft_mesh* mesh, uint32_t level )
+{
+	if ( level > 0 )
+	{
+		return mesh->lods[ level - 1 ].index_count;
+	}
+
+	return mesh->indices_16 || mesh->indices_32 ? mesh->index_count
+	                                            : mesh->vertex_count;
+}
+
+static void
+write_level_indices( struct ft_geometry_group* group,
+                     const struct ft_mesh*     mesh,
+                     uint32_t                  level,
+                     uint32_t                  first_index )
+{
+	const uint16_t* indices_16 =
+	    level > 0 ? mesh->lods[ level - 1 ].indices_16 : mesh->indices_16;
+	const uint32_t* indices_32 =
+	    level > 0 ? mesh->lods[ level - 1 ].indices_32 : mesh->indices_32;
+	uint32_t count = get_level_index_count( mesh, level );
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		uint32_t index = indices_16   ? indices_16[ i ]
+		                 : indices_32 ? indices_32[ i ]
+		                              : i;
+
+		if ( group->index_type == FT_INDEX_TYPE_U16 )
+		{
+			( ( uint16_t* ) group->indices )[ first_index + i ] =
+			    ( uint16_t ) index;
+		}
+		else
+		{
+			( ( uint32_t* ) group->indices )[ first_index + i ] = index;
+		}
+	}
+}
+
+// counts vertices, indices and ranges of every group, references hold layout
+// of each group and mesh groups group of each mesh in model and mesh order
+static bool
+group_meshes( struct ft_packed_geometry*       geometry,
+              uint32_t                         model_count,
+              const struct ft_model*           models,
+              const struct ft_vertex_streams** references,
+              uint32_t*                        mesh_groups )
+{
+	uint32_t mesh_index = 0;
+
+	for ( uint32_t m = 0; m < model_count; ++m )
+	{
+		for ( uint32_t i = 0; i < models[ m ].mesh_count; ++i )
+		{
+			const struct ft_mesh* mesh = &models[ m ].meshes[ i ];
+
+			if ( mesh->packed_vertices.stream_count == 0 )
+			{
+				FT_WARN( "geometry packing needs packed mesh vertices" );
+				return false;
+			}
+
+			uint32_t g = 0;
+
+			while ( g < geometry->group_count &&
+			        !same_vertex_layout( references[ g ],
+			                             &mesh->packed_vertices ) )
+			{
+				g++;
+			}
+
+			struct ft_geometry_group* group = &geometry->groups[ g ];
+
+			if ( g == geometry->group_count )
+			{
+				references[ g ]   = &mesh->packed_vertices;
+				group->index_type = FT_INDEX_TYPE_U16;
+				geometry->group_count++;
+			}
+
+			uint64_t vertex_count = group->vertex_count;
+			uint64_t index_count  = group->index_count;
+
+			for ( uint32_t l = 0; l <= mesh->lod_count; ++l )
+			{
+				index_count += get_level_index_count( mesh, l );
+			}
+
+			vertex_count += mesh->vertex_count;
+
+			if ( vertex_count > INT32_MAX || index_count > UINT32_MAX )
+			{
+				FT_WARN( "packed geometry too large" );
+				return false;
+			}
+
+			if ( mesh->vertex_count > UINT16_MAX + 1 )
+			{
+				group->index_type = FT_INDEX_TYPE_U32;
+			}
+
+			group->vertex_count = ( uint32_t ) vertex_count;
+			group->index_count  = ( uint32_t ) index_count;
+			group->range_count++;
+
+			mesh_groups[ mesh_index++ ] = g;
+		}
+	}
+
+	return true;
+}
+
+static void
+allocate_group( struct ft_geometry_group*       group,
+                const struct ft_vertex_streams* reference )
+{
+	uint64_t index_size = group->index_type == FT_INDEX_TYPE_U16
+	                          ? sizeof( uint16_t )
+	                          : sizeof( uint32_t );
+
+	group->stream_count = reference->stream_count;
+	group->layout       = reference->layout;
+	group->indices      = malloc( group->index_count * index_size );
+	group->ranges =
+	    calloc( group->range_count, sizeof( struct ft_geometry_range ) );
+
+	for ( uint32_t s = 0; s < group->stream_count; ++s )
+	{
+		group->strides[ s ]  = reference->strides[ s ];
+		group->vertices[ s ] = malloc( ( uint64_t ) group->vertex_count *
+		                               reference->strides[ s ] );
+	}
+}
+
+bool
+ft_pack_geometry( struct ft_packed_geometry* geometry,
+                  uint32_t                   model_count,
+                  const struct ft_model*     models )
+{
+	FT_ASSERT( geometry );
+
+	memset( geometry, 0, sizeof( struct ft_packed_geometry ) );
+
+	uint32_t mesh_count = 0;
+
+	for ( uint32_t m = 0; m < model_count; ++m )
+	{
+		mesh_count += models[ m ].mesh_count;
+	}
+
+	if ( mesh_count == 0 )
+	{
+		return true;
+	}
+
+	// at most one group per mesh, shrunk once groups are known
+	const struct ft_vertex_streams** references =
+	    malloc( mesh_count * sizeof( struct ft_vertex_streams* ) );
+	uint32_t* mesh_groups = malloc( mesh_count * sizeof( uint32_t ) );
+	geometry->groups =
+	    calloc( mesh_count, sizeof( struct ft_geometry_group ) );
+
+	if ( !group_meshes( geometry,
+	                    model_count,
+	                    models,
+	                    references,
+	                    mesh_groups ) )
+	{
+		free( references );
+		free( mesh_groups );
+		ft_free_packed_geometry( geometry );
+		return false;
+	}
+
+	geometry->groups =
+	    realloc( geometry->groups,
+	             geometry->group_count * sizeof( struct ft_geometry_group ) );
+
+	for ( uint32_t g = 0; g < geometry->group_count; ++g )
+	{
+		struct ft_geometry_group* group = &geometry->groups[ g ];
+
+		allocate_group( group, references[ g ] );
+
+		uint32_t mesh_index   = 0;
+		uint32_t range        = 0;
+		uint32_t first_vertex = 0;
+		uint32_t first_index  = 0;
+
+		for ( uint32_t m = 0; m < model_count; ++m )
+		{
+			for ( uint32_t i = 0; i < models[ m ].mesh_count; ++i )
+			{
+				if ( mesh_groups[ mesh_index++ ] != g )
+				{
+					continue;
+				}
+
+				const struct ft_mesh*           mesh = &models[ m ].meshes[ i ];
+				const struct ft_vertex_streams* streams =
+				    &mesh->packed_vertices;
+				struct ft_geometry_range* r = &group->ranges[ range++ ];
+
+				r->model          = m;
+				r->mesh           = i;
+				r->vertex_offset  = ( int32_t ) first_vertex;
+				r->vertex_count   = mesh->vertex_count;
+				r->level_count    = mesh->lod_count + 1;
+				r->first_instance = geometry->instance_count;
+				r->instance_count = FT_MAX( mesh->instance_count, 1 );
+
+				float3_dup( r->position_offset, streams->position_offset );
+				float3_dup( r->position_scale, streams->position_scale );
+				float2_dup( r->texcoord_offset, streams->texcoord_offset );
+				float2_dup( r->texcoord_scale, streams->texcoord_scale );
+
+				for ( uint32_t s = 0; s < group->stream_count; ++s )
+				{
+					memcpy( group->vertices[ s ] +
+					            ( uint64_t ) first_vertex * group->strides[ s ],
+					        streams->data[ s ],
+					        ( uint64_t ) mesh->vertex_count *
+					            group->strides[ s ] );
+				}
+
+				for ( uint32_t l = 0; l < r->level_count; ++l )
+				{
+					r->levels[ l ].first_index = first_index;
+					r->levels[ l ].index_count =
+					    get_level_index_count( mesh, l );
+
+					write_level_indices( group, mesh, l, first_index );
+					first_index += r->levels[ l ].index_count;
+				}
+
+				first_vertex += mesh->vertex_count;
+				geometry->instance_count += r->instance_count;
+			}
+		}
+	}
+
+	free( references );
+	free( mesh_groups );
+
+	return true;
+}
+
+void
+ft_free_packed_geometry( struct ft_packed_geometry* geometry )
+{
+	for ( uint32_t g = 0; g < geometry->group_count; ++g )
+	{
+		struct ft_geometry_group* group = &geometry->groups[ g ];
+
+		for ( uint32_t s = 0; s < FT_MAX_VERTEX_STREAM_COUNT; ++s )
+		{
+			ft_safe_free( group->vertices[ s ] );
+		}
+
+		ft_safe_free( group->indices );
+		ft_safe_free( group->ranges );
+	}
+
+	ft_safe_free( geometry->groups );
+
+	memset( geometry, 0, sizeof( struct ft_packed_geometry ) );
+}
+
+void
+ft_write_geometry_draws( const struct ft_geometry_group*          group,
+                         uint32_t                                 level,
+                         struct ft_draw_indexed_indirect_command* commands )
+{
+	for ( uint32_t r = 0; r < group->range_count; ++r )
+	{
+		const struct ft_geometry_range* range = &group->ranges[ r ];
+		const struct ft_geometry_level* l =
+		    &range->levels[ FT_MIN( level, range->level_count - 1 ) ];
+
+		commands[ r ].index_count    = l->index_count;
+		commands[ r ].instance_count = range->instance_count;
+		commands[ r ].first_index    = l->first_index;
+		commands[ r ].vertex_offset  = range->vertex_offset;
+		commands[ r ].first_instance = range->first_instance;
+	}
+}
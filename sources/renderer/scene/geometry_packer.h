@@ -0,0 +1,83 @@
+#pragma once
+
+#include "base/base.h"
+#include "model_loader.h"
+
+// index range of one mesh level inside shared index buffer
+struct ft_geometry_level
+{
+	uint32_t first_index;
+	uint32_t index_count;
+};
+
+// draw range of one mesh, indices stay mesh local and are rebased by vertex
+// offset. level 0 is full mesh, lods of mesh follow it
+struct ft_geometry_range
+{
+	uint32_t                 model;
+	uint32_t                 mesh;
+	int32_t                  vertex_offset;
+	uint32_t                 vertex_count;
+	uint32_t                 level_count;
+	struct ft_geometry_level levels[ FT_MAX_MESH_LOD_COUNT + 1 ];
+	// instances of all ranges are laid out in group and range order
+	uint32_t                 first_instance;
+	uint32_t                 instance_count;
+	// dequantization of packed vertices of mesh
+	float3                   position_offset;
+	float3                   position_scale;
+	float2                   texcoord_offset;
+	float2                   texcoord_scale;
+};
+
+// shared buffers of meshes with equal vertex layout
+struct ft_geometry_group
+{
+	uint32_t                  vertex_count;
+	uint32_t                  stream_count;
+	uint32_t                  strides[ FT_MAX_VERTEX_STREAM_COUNT ];
+	uint8_t                  *vertices[ FT_MAX_VERTEX_STREAM_COUNT ];
+	struct ft_vertex_layout   layout;
+	enum ft_index_type        index_type;
+	uint32_t                  index_count;
+	// 16 or 32 bit by index type
+	void                     *indices;
+	uint32_t                  range_count;
+	struct ft_geometry_range *ranges;
+};
+
+struct ft_packed_geometry
+{
+	uint32_t                  instance_count;
+	uint32_t                  group_count;
+	struct ft_geometry_group *groups;
+};
+
+// argument layout of indexed indirect draws on every backend
+struct ft_draw_indexed_indirect_command
+{
+	uint32_t index_count;
+	uint32_t instance_count;
+	uint32_t first_index;
+	int32_t  vertex_offset;
+	uint32_t first_instance;
+};
+
+// merges packed vertices and every index level of all meshes of models into
+// shared buffers, one group per distinct vertex layout in order of first use.
+// indices of group are 16 bit when every mesh of it fits, meshes without
+// indices get sequential ones
+FT_API bool
+ft_pack_geometry( struct ft_packed_geometry* geometry,
+                  uint32_t                   model_count,
+                  const struct ft_model*     models );
+
+FT_API void
+ft_free_packed_geometry( struct ft_packed_geometry* geometry );
+
+// writes one command per range of group, ranges with fewer levels draw their
+// coarsest one
+FT_API void
+ft_write_geometry_draws( const struct ft_geometry_group*          group,
+                         uint32_t                                 level,
+                         struct ft_draw_indexed_indirect_command* commands );
@@ -0,0 +1,197 @@
+#include <stb/stb_image.h>
+#include <tiny_image_format/tinyimageformat_apis.h>
+#include "zstd_decoder.h"
+#include "ktx2_loader.h"
+
+#define KTX2_IDENTIFIER_SIZE 12
+// color model of uastc payloads in data format descriptor
+#define KTX2_MODEL_UASTC     166
+
+enum ktx2_supercompression
+{
+	KTX2_SUPERCOMPRESSION_NONE,
+	KTX2_SUPERCOMPRESSION_BASIS_LZ,
+	KTX2_SUPERCOMPRESSION_ZSTD,
+	KTX2_SUPERCOMPRESSION_ZLIB,
+};
+
+struct ktx2_header
+{
+	uint8_t  identifier[ KTX2_IDENTIFIER_SIZE ];
+	uint32_t vk_format;
+	uint32_t type_size;
+	uint32_t pixel_width;
+	uint32_t pixel_height;
+	uint32_t pixel_depth;
+	uint32_t layer_count;
+	uint32_t face_count;
+	uint32_t level_count;
+	uint32_t supercompression_scheme;
+	uint32_t dfd_byte_offset;
+	uint32_t dfd_byte_length;
+	uint32_t kvd_byte_offset;
+	uint32_t kvd_byte_length;
+	uint64_t sgd_byte_offset;
+	uint64_t sgd_byte_length;
+};
+
+struct ktx2_level
+{
+	uint64_t byte_offset;
+	uint64_t byte_length;
+	uint64_t uncompressed_byte_length;
+};
+
+static const uint8_t KTX2_IDENTIFIER[ KTX2_IDENTIFIER_SIZE ] = {
+	0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A,
+};
+
+// color model byte of first basic descriptor block, it follows total size
+// and two words of block header
+static uint32_t
+get_color_model( const uint8_t*            bytes,
+                 uint64_t                  size,
+                 const struct ktx2_header* header )
+{
+	if ( header->dfd_byte_length <= 12 ||
+	     ( uint64_t ) header->dfd_byte_offset + 12 >= size )
+	{
+		return 0;
+	}
+
+	return bytes[ header->dfd_byte_offset + 12 ];
+}
+
+bool
+ft_is_ktx2( const void* data, uint64_t size )
+{
+	return size >= KTX2_IDENTIFIER_SIZE &&
+	       memcmp( data, KTX2_IDENTIFIER, KTX2_IDENTIFIER_SIZE ) == 0;
+}
+
+bool
+ft_load_ktx2( const void* data, uint64_t size, struct ft_texture* texture )
+{
+	FT_ASSERT( texture );
+
+	memset( texture, 0, sizeof( struct ft_texture ) );
+
+	if ( !ft_is_ktx2( data, size ) || size < sizeof( struct ktx2_header ) )
+	{
+		FT_WARN( "not a ktx2 texture" );
+		return false;
+	}
+
+	const uint8_t*     bytes = data;
+	struct ktx2_header header;
+	memcpy( &header, bytes, sizeof( header ) );
+
+	uint32_t level_count = FT_MAX( header.level_count, 1 );
+
+	if ( header.pixel_depth > 1 || header.layer_count > 1 ||
+	     header.face_count != 1 )
+	{
+		FT_WARN( "only 2d ktx2 textures are supported" );
+		return false;
+	}
+
+	if ( header.supercompression_scheme == KTX2_SUPERCOMPRESSION_BASIS_LZ ||
+	     ( header.vk_format == 0 &&
+	       get_color_model( bytes, size, &header ) == KTX2_MODEL_UASTC ) )
+	{
+		FT_WARN( "basis universal ktx2 textures need transcoder" );
+		return false;
+	}
+
+	if ( header.supercompression_scheme != KTX2_SUPERCOMPRESSION_NONE &&
+	     header.supercompression_scheme != KTX2_SUPERCOMPRESSION_ZSTD &&
+	     header.supercompression_scheme != KTX2_SUPERCOMPRESSION_ZLIB )
+	{
+		FT_WARN( "unsupported ktx2 supercompression scheme %d",
+		         header.supercompression_scheme );
+		return false;
+	}
+
+	enum ft_format format = ( enum ft_format ) TinyImageFormat_FromVkFormat(
+	    ( TinyImageFormat_VkFormat ) header.vk_format );
+
+	if ( format == FT_FORMAT_UNDEFINED )
+	{
+		FT_WARN( "unsupported ktx2 vk format %d", header.vk_format );
+		return false;
+	}
+
+	uint64_t levels_offset = sizeof( struct ktx2_header );
+
+	if ( levels_offset + level_count * sizeof( struct ktx2_level ) > size )
+	{
+		FT_WARN( "truncated ktx2 level index" );
+		return false;
+	}
+
+	texture->width      = header.pixel_width;
+	texture->height     = FT_MAX( header.pixel_height, 1 );
+	texture->mip_levels = level_count;
+	texture->format     = format;
+
+	uint8_t* pixels =
+	    malloc( ft_texture_mip_offset( texture, texture->mip_levels ) );
+
+	// level index starts at largest level like mips of ft_texture
+	for ( uint32_t l = 0; l < level_count; ++l )
+	{
+		struct ktx2_level level;
+		memcpy( &level,
+		        bytes + levels_offset + l * sizeof( struct ktx2_level ),
+		        sizeof( level ) );
+
+		uint8_t* dst = pixels + ft_texture_mip_offset( texture, l );
+		uint64_t dst_size =
+		    ft_texture_mip_offset( texture, l + 1 ) -
+		    ft_texture_mip_offset( texture, l );
+
+		bool valid = level.byte_offset <= size &&
+		             level.byte_length <= size - level.byte_offset;
+
+		if ( valid &&
+		     header.supercompression_scheme == KTX2_SUPERCOMPRESSION_ZSTD )
+		{
+			valid = ft_decode_zstd( dst,
+			                        dst_size,
+			                        bytes + level.byte_offset,
+			                        level.byte_length );
+		}
+		else if ( valid &&
+		          header.supercompression_scheme == KTX2_SUPERCOMPRESSION_ZLIB )
+		{
+			int32_t written =
+			    stbi_zlib_decode_buffer( ( char* ) dst,
+			                             ( int32_t ) dst_size,
+			                             ( const char* ) bytes +
+			                                 level.byte_offset,
+			                             ( int32_t ) level.byte_length );
+			valid = written == ( int32_t ) dst_size;
+		}
+		else if ( valid )
+		{
+			valid = level.byte_length == dst_size;
+
+			if ( valid )
+			{
+				memcpy( dst, bytes + level.byte_offset, dst_size );
+			}
+		}
+
+		if ( !valid )
+		{
+			FT_WARN( "invalid ktx2 level %d", l );
+			free( pixels );
+			memset( texture, 0, sizeof( struct ft_texture ) );
+			return false;
+		}
+	}
+
+	texture->data = pixels;
+
+	return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "base/base.h"
+#include "model_loader.h"
+
+// whether data starts with ktx2 identifier
+FT_API bool
+ft_is_ktx2( const void* data, uint64_t size );
+
+// reads 2d ktx2 texture with every stored mip level, levels are copied as is
+// so block compressed payloads need no decoding. payloads may be
+// uncompressed or zstd or zlib supercompressed, basis universal needs
+// transcoder and is rejected
+FT_API bool
+ft_load_ktx2( const void* data, uint64_t size, struct ft_texture* texture );
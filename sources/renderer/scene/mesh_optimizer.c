@@ -0,0 +1,1079 @@
+#include <math.h>
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "meshlet.h"
+#include "vertex_packing.h"
+
+#define CACHE_DECAY_POWER     1.5f
+#define LAST_TRIANGLE_SCORE   0.75f
+#define VALENCE_BOOST_SCALE   2.0f
+#define VALENCE_BOOST_POWER   0.5f
+#define MAX_SCORED_VALENCE    32
+#define OVERDRAW_CACHE_SIZE   16
+#define MAX_INDEX_16          UINT16_MAX
+#define MESH_ATTRIBUTE_COUNT  6
+#define INVALID_VERTEX        UINT32_MAX
+
+struct mesh_attribute
+{
+	float**  data;
+	uint32_t component_count;
+};
+
+// attributes in fixed order, absent ones point to NULL arrays
+FT_INLINE void
+get_mesh_attributes( struct ft_mesh*       mesh,
+                     struct mesh_attribute attributes[ MESH_ATTRIBUTE_COUNT ] )
+{
+	attributes[ 0 ] = ( struct mesh_attribute ) { &mesh->positions, 3 };
+	attributes[ 1 ] = ( struct mesh_attribute ) { &mesh->normals, 3 };
+	attributes[ 2 ] = ( struct mesh_attribute ) { &mesh->tangents, 4 };
+	attributes[ 3 ] = ( struct mesh_attribute ) { &mesh->texcoords, 2 };
+	attributes[ 4 ] = ( struct mesh_attribute ) { &mesh->joints, 4 };
+	attributes[ 5 ] = ( struct mesh_attribute ) { &mesh->weights, 4 };
+}
+
+// makes sure mesh has 32 bit index buffer, generating one if mesh has none
+FT_INLINE uint32_t*
+promote_indices( struct ft_mesh* mesh )
+{
+	if ( mesh->indices_32 )
+	{
+		return mesh->indices_32;
+	}
+
+	if ( mesh->indices_16 )
+	{
+		mesh->indices_32 = malloc( mesh->index_count * sizeof( uint32_t ) );
+
+		for ( uint32_t i = 0; i < mesh->index_count; ++i )
+		{
+			mesh->indices_32[ i ] = mesh->indices_16[ i ];
+		}
+
+		free( mesh->indices_16 );
+		mesh->indices_16 = NULL;
+	}
+	else
+	{
+		mesh->index_count = mesh->vertex_count;
+		mesh->indices_32  = malloc( mesh->index_count * sizeof( uint32_t ) );
+
+		for ( uint32_t i = 0; i < mesh->index_count; ++i )
+		{
+			mesh->indices_32[ i ] = i;
+		}
+	}
+
+	return mesh->indices_32;
+}
+
+FT_INLINE uint64_t
+hash_vertex( const struct mesh_attribute* attributes, uint32_t vertex )
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	for ( uint32_t a = 0; a < MESH_ATTRIBUTE_COUNT; ++a )
+	{
+		if ( *attributes[ a ].data == NULL )
+		{
+			continue;
+		}
+
+		const uint8_t* bytes =
+		    ( const uint8_t* ) ( *attributes[ a ].data +
+		                         vertex * attributes[ a ].component_count );
+		uint32_t size = attributes[ a ].component_count * sizeof( float );
+
+		for ( uint32_t b = 0; b < size; ++b )
+		{
+			hash ^= bytes[ b ];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	return hash;
+}
+
+FT_INLINE bool
+compare_vertices( const struct mesh_attribute* attributes,
+                  uint32_t                     a,
+                  uint32_t                     b )
+{
+	for ( uint32_t i = 0; i < MESH_ATTRIBUTE_COUNT; ++i )
+	{
+		uint32_t     c    = attributes[ i ].component_count;
+		const float* data = *attributes[ i ].data;
+
+		if ( data == NULL )
+		{
+			continue;
+		}
+
+		if ( memcmp( data + a * c, data + b * c, c * sizeof( float ) ) != 0 )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void
+ft_weld_mesh_vertices( struct ft_mesh* mesh )
+{
+	FT_ASSERT( mesh );
+
+	if ( mesh->mapped )
+	{
+		FT_WARN( "mesh of baked model can not be resized" );
+		return;
+	}
+
+	if ( mesh->vertex_count == 0 )
+	{
+		return;
+	}
+
+	uint32_t* indices = promote_indices( mesh );
+
+	struct mesh_attribute attributes[ MESH_ATTRIBUTE_COUNT ];
+	get_mesh_attributes( mesh, attributes );
+
+	uint32_t table_size = 1;
+	while ( table_size < mesh->vertex_count * 2 )
+	{
+		table_size *= 2;
+	}
+
+	uint32_t* table = malloc( table_size * sizeof( uint32_t ) );
+	memset( table, 0xff, table_size * sizeof( uint32_t ) );
+
+	uint32_t* remap        = malloc( mesh->vertex_count * sizeof( uint32_t ) );
+	uint32_t  unique_count = 0;
+
+	for ( uint32_t v = 0; v < mesh->vertex_count; ++v )
+	{
+		uint32_t bucket = ( uint32_t ) hash_vertex( attributes, v ) &
+		                  ( table_size - 1 );
+
+		while ( table[ bucket ] != INVALID_VERTEX &&
+		        !compare_vertices( attributes, table[ bucket ], v ) )
+		{
+			bucket = ( bucket + 1 ) & ( table_size - 1 );
+		}
+
+		if ( table[ bucket ] == INVALID_VERTEX )
+		{
+			// unique vertices are compacted in place, destination never
+			// overtakes source
+			for ( uint32_t a = 0; a < MESH_ATTRIBUTE_COUNT; ++a )
+			{
+				uint32_t c    = attributes[ a ].component_count;
+				float*   data = *attributes[ a ].data;
+
+				if ( data == NULL )
+				{
+					continue;
+				}
+
+				memmove( data + unique_count * c,
+				         data + v * c,
+				         c * sizeof( float ) );
+			}
+
+			table[ bucket ] = unique_count++;
+		}
+
+		remap[ v ] = table[ bucket ];
+	}
+
+	for ( uint32_t i = 0; i < mesh->index_count; ++i )
+	{
+		indices[ i ] = remap[ indices[ i ] ];
+	}
+
+	mesh->vertex_count = unique_count;
+
+	free( remap );
+	free( table );
+}
+
+struct vertex_cache_tables
+{
+	float cache[ FT_VERTEX_CACHE_SIZE ];
+	float valence[ MAX_SCORED_VALENCE ];
+};
+
+FT_INLINE void
+init_vertex_cache_tables( struct vertex_cache_tables* tables )
+{
+	for ( uint32_t i = 0; i < FT_VERTEX_CACHE_SIZE; ++i )
+	{
+		if ( i < 3 )
+		{
+			tables->cache[ i ] = LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			float scaler = 1.0f / ( FT_VERTEX_CACHE_SIZE - 3 );
+			tables->cache[ i ] =
+			    powf( 1.0f - ( i - 3 ) * scaler, CACHE_DECAY_POWER );
+		}
+	}
+
+	for ( uint32_t i = 0; i < MAX_SCORED_VALENCE; ++i )
+	{
+		tables->valence[ i ] =
+		    i == 0 ? 0.0f
+		           : VALENCE_BOOST_SCALE * powf( i, -VALENCE_BOOST_POWER );
+	}
+}
+
+FT_INLINE float
+vertex_score( const struct vertex_cache_tables* tables,
+              int32_t                           cache_position,
+              uint32_t                          remaining )
+{
+	if ( remaining == 0 )
+	{
+		return -1.0f;
+	}
+
+	float score = cache_position >= 0 ? tables->cache[ cache_position ] : 0.0f;
+
+	return score +
+	       tables->valence[ FT_MIN( remaining, MAX_SCORED_VALENCE - 1 ) ];
+}
+
+void
+ft_optimize_vertex_cache( uint32_t* indices,
+                          uint32_t  index_count,
+                          uint32_t  vertex_count )
+{
+	uint32_t triangle_count = index_count / 3;
+
+	if ( triangle_count == 0 )
+	{
+		return;
+	}
+
+	struct vertex_cache_tables tables;
+	init_vertex_cache_tables( &tables );
+
+	uint32_t* offsets   = calloc( vertex_count + 1, sizeof( uint32_t ) );
+	uint32_t* remaining = calloc( vertex_count, sizeof( uint32_t ) );
+	uint32_t* adjacency = malloc( triangle_count * 3 * sizeof( uint32_t ) );
+	int32_t*  positions = malloc( vertex_count * sizeof( int32_t ) );
+	float*    v_scores  = malloc( vertex_count * sizeof( float ) );
+	float*    t_scores  = malloc( triangle_count * sizeof( float ) );
+	bool*     emitted   = calloc( triangle_count, sizeof( bool ) );
+	uint32_t* result    = malloc( index_count * sizeof( uint32_t ) );
+
+	for ( uint32_t i = 0; i < triangle_count * 3; ++i )
+	{
+		remaining[ indices[ i ] ]++;
+	}
+
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		offsets[ v + 1 ] = offsets[ v ] + remaining[ v ];
+		positions[ v ]   = -1;
+	}
+
+	{
+		FT_ALLOC_HEAP_ARRAY( uint32_t, fill, vertex_count );
+		for ( uint32_t t = 0; t < triangle_count; ++t )
+		{
+			for ( uint32_t k = 0; k < 3; ++k )
+			{
+				uint32_t v = indices[ t * 3 + k ];
+				adjacency[ offsets[ v ] + fill[ v ]++ ] = t;
+			}
+		}
+		free( fill );
+	}
+
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		v_scores[ v ] = vertex_score( &tables, -1, remaining[ v ] );
+	}
+
+	uint32_t best_triangle = 0;
+	float    best_score    = -1.0f;
+
+	for ( uint32_t t = 0; t < triangle_count; ++t )
+	{
+		t_scores[ t ] = v_scores[ indices[ t * 3 + 0 ] ] +
+		                v_scores[ indices[ t * 3 + 1 ] ] +
+		                v_scores[ indices[ t * 3 + 2 ] ];
+
+		if ( t_scores[ t ] > best_score )
+		{
+			best_score    = t_scores[ t ];
+			best_triangle = t;
+		}
+	}
+
+	uint32_t cache[ FT_VERTEX_CACHE_SIZE + 3 ];
+	uint32_t cache_count = 0;
+	uint32_t cursor      = 0;
+
+	for ( uint32_t out = 0; out < triangle_count; ++out )
+	{
+		if ( best_triangle == INVALID_VERTEX )
+		{
+			// dead end, continue with next triangle in input order
+			while ( emitted[ cursor ] )
+			{
+				cursor++;
+			}
+			best_triangle = cursor;
+		}
+
+		uint32_t        t   = best_triangle;
+		const uint32_t* tri = &indices[ t * 3 ];
+
+		emitted[ t ] = true;
+		memcpy( &result[ out * 3 ], tri, 3 * sizeof( uint32_t ) );
+
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			uint32_t  v    = tri[ k ];
+			uint32_t* list = &adjacency[ offsets[ v ] ];
+
+			for ( uint32_t a = 0; a < remaining[ v ]; ++a )
+			{
+				if ( list[ a ] == t )
+				{
+					list[ a ] = list[ remaining[ v ] - 1 ];
+					break;
+				}
+			}
+			remaining[ v ]--;
+		}
+
+		uint32_t new_cache[ FT_VERTEX_CACHE_SIZE + 3 ];
+		uint32_t new_cache_count = 0;
+
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			if ( k == 0 || ( tri[ k ] != tri[ 0 ] && tri[ k ] != tri[ 1 ] ) )
+			{
+				new_cache[ new_cache_count++ ] = tri[ k ];
+			}
+		}
+
+		for ( uint32_t c = 0; c < cache_count; ++c )
+		{
+			uint32_t v = cache[ c ];
+
+			if ( v != tri[ 0 ] && v != tri[ 1 ] && v != tri[ 2 ] )
+			{
+				new_cache[ new_cache_count++ ] = v;
+			}
+		}
+
+		best_triangle = INVALID_VERTEX;
+		best_score    = -1.0f;
+
+		for ( uint32_t c = 0; c < new_cache_count; ++c )
+		{
+			uint32_t v = new_cache[ c ];
+
+			positions[ v ] = c < FT_VERTEX_CACHE_SIZE ? ( int32_t ) c : -1;
+
+			float score  = vertex_score( &tables, positions[ v ], remaining[ v ] );
+			float delta  = score - v_scores[ v ];
+			v_scores[ v ] = score;
+
+			const uint32_t* list = &adjacency[ offsets[ v ] ];
+
+			for ( uint32_t a = 0; a < remaining[ v ]; ++a )
+			{
+				uint32_t at = list[ a ];
+				t_scores[ at ] += delta;
+
+				if ( t_scores[ at ] > best_score )
+				{
+					best_score    = t_scores[ at ];
+					best_triangle = at;
+				}
+			}
+		}
+
+		cache_count = FT_MIN( new_cache_count, FT_VERTEX_CACHE_SIZE );
+		memcpy( cache, new_cache, cache_count * sizeof( uint32_t ) );
+	}
+
+	memcpy( indices, result, index_count * sizeof( uint32_t ) );
+
+	free( result );
+	free( emitted );
+	free( t_scores );
+	free( v_scores );
+	free( positions );
+	free( adjacency );
+	free( remaining );
+	free( offsets );
+}
+
+struct overdraw_cluster
+{
+	uint32_t start;
+	uint32_t count;
+	float    sort_key;
+};
+
+static int
+compare_overdraw_clusters( const void* a, const void* b )
+{
+	const struct overdraw_cluster* ca = a;
+	const struct overdraw_cluster* cb = b;
+
+	if ( ca->sort_key != cb->sort_key )
+	{
+		return ca->sort_key > cb->sort_key ? -1 : 1;
+	}
+
+	return ca->start < cb->start ? -1 : 1;
+}
+
+FT_INLINE uint32_t
+count_cache_misses( const uint32_t* tri,
+                    uint32_t*       timestamps,
+                    uint32_t*       timestamp )
+{
+	uint32_t misses = 0;
+
+	for ( uint32_t k = 0; k < 3; ++k )
+	{
+		uint32_t v = tri[ k ];
+
+		if ( *timestamp - timestamps[ v ] > OVERDRAW_CACHE_SIZE )
+		{
+			timestamps[ v ] = ( *timestamp )++;
+			misses++;
+		}
+	}
+
+	return misses;
+}
+
+void
+ft_optimize_overdraw( uint32_t*    indices,
+                      uint32_t     index_count,
+                      const float* positions,
+                      uint32_t     vertex_count,
+                      float        threshold )
+{
+	uint32_t triangle_count = index_count / 3;
+
+	if ( triangle_count == 0 )
+	{
+		return;
+	}
+
+	uint32_t* timestamps = calloc( vertex_count, sizeof( uint32_t ) );
+	uint32_t  timestamp  = OVERDRAW_CACHE_SIZE + 1;
+
+	// hard boundaries where simulated cache was fully flushed
+	uint32_t* hard = malloc( ( triangle_count + 1 ) * sizeof( uint32_t ) );
+	uint32_t  hard_count = 0;
+
+	for ( uint32_t t = 0; t < triangle_count; ++t )
+	{
+		uint32_t misses =
+		    count_cache_misses( &indices[ t * 3 ], timestamps, &timestamp );
+
+		if ( t == 0 || misses == 3 )
+		{
+			hard[ hard_count++ ] = t;
+		}
+	}
+	hard[ hard_count ] = triangle_count;
+
+	struct overdraw_cluster* clusters =
+	    malloc( triangle_count * sizeof( struct overdraw_cluster ) );
+	uint32_t cluster_count = 0;
+
+	// soft boundaries inside hard clusters while cache efficiency stays
+	// within threshold of whole cluster
+	for ( uint32_t h = 0; h < hard_count; ++h )
+	{
+		uint32_t start = hard[ h ];
+		uint32_t end   = hard[ h + 1 ];
+
+		timestamp += OVERDRAW_CACHE_SIZE + 1;
+
+		uint32_t cluster_misses = 0;
+		for ( uint32_t t = start; t < end; ++t )
+		{
+			cluster_misses +=
+			    count_cache_misses( &indices[ t * 3 ], timestamps, &timestamp );
+		}
+
+		float cluster_acmr = ( float ) cluster_misses / ( float ) ( end - start );
+
+		timestamp += OVERDRAW_CACHE_SIZE + 1;
+
+		uint32_t sub_start  = start;
+		uint32_t sub_misses = 0;
+
+		for ( uint32_t t = start; t < end; ++t )
+		{
+			sub_misses +=
+			    count_cache_misses( &indices[ t * 3 ], timestamps, &timestamp );
+
+			float acmr = ( float ) sub_misses / ( float ) ( t - sub_start + 1 );
+
+			if ( t + 1 == end || acmr <= cluster_acmr * threshold )
+			{
+				clusters[ cluster_count ].start = sub_start;
+				clusters[ cluster_count ].count = t - sub_start + 1;
+				cluster_count++;
+
+				sub_start  = t + 1;
+				sub_misses = 0;
+				timestamp += OVERDRAW_CACHE_SIZE + 1;
+			}
+		}
+	}
+
+	float3 mesh_centroid = { 0.0f, 0.0f, 0.0f };
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		float3_add( mesh_centroid, mesh_centroid, &positions[ v * 3 ] );
+	}
+	float3_scale( mesh_centroid, mesh_centroid, 1.0f / ( float ) vertex_count );
+
+	for ( uint32_t c = 0; c < cluster_count; ++c )
+	{
+		struct overdraw_cluster* cluster = &clusters[ c ];
+
+		float3 centroid = { 0.0f, 0.0f, 0.0f };
+		float3 normal   = { 0.0f, 0.0f, 0.0f };
+		float  area     = 0.0f;
+
+		for ( uint32_t t = cluster->start; t < cluster->start + cluster->count;
+		      ++t )
+		{
+			const float* p0 = &positions[ indices[ t * 3 + 0 ] * 3 ];
+			const float* p1 = &positions[ indices[ t * 3 + 1 ] * 3 ];
+			const float* p2 = &positions[ indices[ t * 3 + 2 ] * 3 ];
+
+			float3 e0, e1, n;
+			float3_sub( e0, p1, p0 );
+			float3_sub( e1, p2, p0 );
+			float3_mul_cross( n, e0, e1 );
+
+			float a = float3_len( n );
+
+			float3 c;
+			float3_add( c, p0, p1 );
+			float3_add( c, c, p2 );
+			float3_scale( c, c, a / 3.0f );
+
+			float3_add( centroid, centroid, c );
+			float3_add( normal, normal, n );
+			area += a;
+		}
+
+		float len = float3_len( normal );
+
+		if ( area > 0.0f && len > 0.0f )
+		{
+			float3_scale( centroid, centroid, 1.0f / area );
+			float3_scale( normal, normal, 1.0f / len );
+
+			float3 d;
+			float3_sub( d, centroid, mesh_centroid );
+			cluster->sort_key = float3_mul_inner( d, normal );
+		}
+		else
+		{
+			cluster->sort_key = 0.0f;
+		}
+	}
+
+	qsort( clusters,
+	       cluster_count,
+	       sizeof( struct overdraw_cluster ),
+	       compare_overdraw_clusters );
+
+	uint32_t* result = malloc( index_count * sizeof( uint32_t ) );
+	uint32_t  offset = 0;
+
+	for ( uint32_t c = 0; c < cluster_count; ++c )
+	{
+		memcpy( &result[ offset ],
+		        &indices[ clusters[ c ].start * 3 ],
+		        clusters[ c ].count * 3 * sizeof( uint32_t ) );
+		offset += clusters[ c ].count * 3;
+	}
+
+	memcpy( indices, result, triangle_count * 3 * sizeof( uint32_t ) );
+
+	free( result );
+	free( clusters );
+	free( hard );
+	free( timestamps );
+}
+
+FT_INLINE void
+remap_attributes( struct ft_mesh* mesh,
+                  const uint32_t* remap,
+                  uint32_t        new_vertex_count )
+{
+	struct mesh_attribute attributes[ MESH_ATTRIBUTE_COUNT ];
+	get_mesh_attributes( mesh, attributes );
+
+	for ( uint32_t a = 0; a < MESH_ATTRIBUTE_COUNT; ++a )
+	{
+		uint32_t c   = attributes[ a ].component_count;
+		float*   src = *attributes[ a ].data;
+
+		if ( src == NULL )
+		{
+			continue;
+		}
+
+		float* dst = malloc( new_vertex_count * c * sizeof( float ) );
+
+		for ( uint32_t v = 0; v < mesh->vertex_count; ++v )
+		{
+			if ( remap[ v ] != INVALID_VERTEX )
+			{
+				memcpy( dst + remap[ v ] * c, src + v * c, c * sizeof( float ) );
+			}
+		}
+
+		free( src );
+		*attributes[ a ].data = dst;
+	}
+
+	mesh->vertex_count = new_vertex_count;
+}
+
+void
+ft_optimize_vertex_fetch( struct ft_mesh* mesh )
+{
+	FT_ASSERT( mesh );
+
+	if ( mesh->vertex_count == 0 )
+	{
+		return;
+	}
+
+	uint32_t* indices = promote_indices( mesh );
+	uint32_t* remap   = malloc( mesh->vertex_count * sizeof( uint32_t ) );
+	memset( remap, 0xff, mesh->vertex_count * sizeof( uint32_t ) );
+
+	uint32_t next = 0;
+
+	for ( uint32_t i = 0; i < mesh->index_count; ++i )
+	{
+		uint32_t v = indices[ i ];
+
+		if ( remap[ v ] == INVALID_VERTEX )
+		{
+			remap[ v ] = next++;
+		}
+
+		indices[ i ] = remap[ v ];
+	}
+
+	// unreferenced vertices are dropped
+	remap_attributes( mesh, remap, next );
+
+	free( remap );
+}
+
+void
+ft_optimize_mesh( struct ft_mesh* mesh )
+{
+	FT_ASSERT( mesh );
+
+	if ( mesh->mapped )
+	{
+		FT_WARN( "mesh of baked model can not be resized" );
+		return;
+	}
+
+	if ( mesh->vertex_count == 0 || mesh->positions == NULL )
+	{
+		return;
+	}
+
+	ft_weld_mesh_vertices( mesh );
+	ft_optimize_vertex_cache( mesh->indices_32,
+	                          mesh->index_count,
+	                          mesh->vertex_count );
+	ft_optimize_overdraw( mesh->indices_32,
+	                      mesh->index_count,
+	                      mesh->positions,
+	                      mesh->vertex_count,
+	                      1.05f );
+	ft_optimize_vertex_fetch( mesh );
+}
+
+bool
+ft_cluster_mesh( struct ft_mesh*       dst,
+                 const struct ft_mesh* mesh,
+                 uint32_t              grid_size )
+{
+	FT_ASSERT( dst && mesh );
+	FT_ASSERT( grid_size > 0 );
+
+	if ( mesh->positions == NULL || mesh->vertex_count == 0 )
+	{
+		return false;
+	}
+
+	const float* positions = mesh->positions;
+
+	float3 min, max;
+	float3_dup( min, positions );
+	float3_dup( max, positions );
+
+	for ( uint32_t v = 1; v < mesh->vertex_count; ++v )
+	{
+		float3_min( min, min, &positions[ v * 3 ] );
+		float3_max( max, max, &positions[ v * 3 ] );
+	}
+
+	float extent = FT_MAX( max[ 0 ] - min[ 0 ],
+	                       FT_MAX( max[ 1 ] - min[ 1 ], max[ 2 ] - min[ 2 ] ) );
+	float scale  = extent > 0.0f ? ( float ) grid_size / extent : 0.0f;
+
+	uint32_t  cell_count = grid_size * grid_size * grid_size;
+	uint32_t* cells      = malloc( cell_count * sizeof( uint32_t ) );
+	uint32_t* remap      = malloc( mesh->vertex_count * sizeof( uint32_t ) );
+	memset( cells, 0xff, cell_count * sizeof( uint32_t ) );
+
+	for ( uint32_t v = 0; v < mesh->vertex_count; ++v )
+	{
+		uint32_t cell[ 3 ];
+
+		for ( uint32_t c = 0; c < 3; ++c )
+		{
+			float offset = ( positions[ v * 3 + c ] - min[ c ] ) * scale;
+			cell[ c ]    = FT_MIN( ( uint32_t ) offset, grid_size - 1 );
+		}
+
+		remap[ v ] =
+		    cell[ 0 ] + ( cell[ 1 ] + cell[ 2 ] * grid_size ) * grid_size;
+	}
+
+	uint32_t index_count =
+	    mesh->index_count > 0 ? mesh->index_count : mesh->vertex_count;
+	uint32_t* indices      = malloc( index_count * sizeof( uint32_t ) );
+	uint32_t* sources      = malloc( mesh->vertex_count * sizeof( uint32_t ) );
+	uint32_t  vertex_count = 0;
+
+	dst->index_count = 0;
+
+	for ( uint32_t i = 0; i + 2 < index_count; i += 3 )
+	{
+		uint32_t vertices[ 3 ];
+
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			vertices[ k ] = mesh->indices_32   ? mesh->indices_32[ i + k ]
+			                : mesh->indices_16 ? mesh->indices_16[ i + k ]
+			                                   : i + k;
+		}
+
+		uint32_t c0 = remap[ vertices[ 0 ] ];
+		uint32_t c1 = remap[ vertices[ 1 ] ];
+		uint32_t c2 = remap[ vertices[ 2 ] ];
+
+		// triangles inside one row of cells collapse to lines or points
+		if ( c0 == c1 || c1 == c2 || c0 == c2 )
+		{
+			continue;
+		}
+
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			uint32_t cell = remap[ vertices[ k ] ];
+
+			if ( cells[ cell ] == INVALID_VERTEX )
+			{
+				cells[ cell ]             = vertex_count;
+				sources[ vertex_count++ ] = vertices[ k ];
+			}
+
+			indices[ dst->index_count++ ] = cells[ cell ];
+		}
+	}
+
+	free( remap );
+	free( cells );
+
+	if ( dst->index_count == 0 )
+	{
+		free( sources );
+		free( indices );
+		return false;
+	}
+
+	dst->indices_32 =
+	    realloc( indices, dst->index_count * sizeof( uint32_t ) );
+	dst->indices_16   = NULL;
+	dst->vertex_count = vertex_count;
+
+	struct mesh_attribute src_attributes[ MESH_ATTRIBUTE_COUNT ];
+	struct mesh_attribute dst_attributes[ MESH_ATTRIBUTE_COUNT ];
+	get_mesh_attributes( ( struct ft_mesh* ) mesh, src_attributes );
+	get_mesh_attributes( dst, dst_attributes );
+
+	for ( uint32_t a = 0; a < MESH_ATTRIBUTE_COUNT; ++a )
+	{
+		const float* src_data = *src_attributes[ a ].data;
+
+		if ( src_data == NULL )
+		{
+			*dst_attributes[ a ].data = NULL;
+			continue;
+		}
+
+		uint32_t c    = src_attributes[ a ].component_count;
+		float*   data = malloc( vertex_count * c * sizeof( float ) );
+		*dst_attributes[ a ].data = data;
+
+		for ( uint32_t v = 0; v < vertex_count; ++v )
+		{
+			memcpy( data + v * c,
+			        src_data + sources[ v ] * c,
+			        c * sizeof( float ) );
+		}
+	}
+
+	free( sources );
+
+	return true;
+}
+
+FT_INLINE void
+copy_mesh_part( struct ft_mesh*       dst,
+                const struct ft_mesh* src,
+                const uint32_t*       indices,
+                uint32_t              triangle_count,
+                uint32_t*             remap )
+{
+	memset( dst, 0, sizeof( struct ft_mesh ) );
+	memcpy( dst->world, src->world, sizeof( float4x4 ) );
+	dst->material       = src->material;
+	dst->node           = src->node;
+	dst->instance_count = src->instance_count;
+	dst->instance_nodes = malloc( src->instance_count * sizeof( uint32_t ) );
+	dst->instance_transforms =
+	    malloc( src->instance_count * sizeof( float4x4 ) );
+	memcpy( dst->instance_nodes,
+	        src->instance_nodes,
+	        src->instance_count * sizeof( uint32_t ) );
+	memcpy( dst->instance_transforms,
+	        src->instance_transforms,
+	        src->instance_count * sizeof( float4x4 ) );
+
+	uint32_t vertex_count = 0;
+	dst->index_count      = triangle_count * 3;
+	dst->indices_16       = malloc( dst->index_count * sizeof( uint16_t ) );
+
+	for ( uint32_t i = 0; i < dst->index_count; ++i )
+	{
+		uint32_t v = indices[ i ];
+
+		if ( remap[ v ] == INVALID_VERTEX )
+		{
+			remap[ v ] = vertex_count++;
+		}
+
+		dst->indices_16[ i ] = ( uint16_t ) remap[ v ];
+	}
+
+	dst->vertex_count = vertex_count;
+
+	struct mesh_attribute src_attributes[ MESH_ATTRIBUTE_COUNT ];
+	struct mesh_attribute dst_attributes[ MESH_ATTRIBUTE_COUNT ];
+	get_mesh_attributes( ( struct ft_mesh* ) src, src_attributes );
+	get_mesh_attributes( dst, dst_attributes );
+
+	for ( uint32_t a = 0; a < MESH_ATTRIBUTE_COUNT; ++a )
+	{
+		const float* src_data = *src_attributes[ a ].data;
+
+		if ( src_data == NULL )
+		{
+			continue;
+		}
+
+		uint32_t c     = src_attributes[ a ].component_count;
+		float*   data  = malloc( vertex_count * c * sizeof( float ) );
+		*dst_attributes[ a ].data = data;
+
+		for ( uint32_t i = 0; i < dst->index_count; ++i )
+		{
+			uint32_t v = indices[ i ];
+			memcpy( data + remap[ v ] * c, src_data + v * c, c * sizeof( float ) );
+		}
+	}
+
+	for ( uint32_t i = 0; i < dst->index_count; ++i )
+	{
+		remap[ indices[ i ] ] = INVALID_VERTEX;
+	}
+
+	ft_compute_mesh_bounds( dst );
+}
+
+FT_INLINE void
+free_mesh_arrays( struct ft_mesh* mesh )
+{
+	ft_safe_free( mesh->positions );
+	ft_safe_free( mesh->normals );
+	ft_safe_free( mesh->tangents );
+	ft_safe_free( mesh->texcoords );
+	ft_safe_free( mesh->joints );
+	ft_safe_free( mesh->weights );
+	ft_safe_free( mesh->indices_16 );
+	ft_safe_free( mesh->indices_32 );
+	ft_safe_free( mesh->instance_nodes );
+	ft_safe_free( mesh->instance_transforms );
+	// parts are cut from float vertices, later stages must run on them again
+	ft_free_packed_vertices( &mesh->packed_vertices );
+	ft_free_meshlets( &mesh->meshlets );
+	ft_free_mesh_lods( mesh );
+}
+
+FT_INLINE void
+push_mesh( struct ft_mesh** meshes,
+           uint32_t*        mesh_count,
+           uint32_t*        mesh_capacity )
+{
+	if ( *mesh_count == *mesh_capacity )
+	{
+		*mesh_capacity *= 2;
+		*meshes = realloc( *meshes, *mesh_capacity * sizeof( struct ft_mesh ) );
+	}
+
+	( *mesh_count )++;
+}
+
+void
+ft_narrow_model_indices( struct ft_model* model )
+{
+	FT_ASSERT( model );
+
+	if ( model->mapped_file )
+	{
+		FT_WARN( "meshes of baked model can not be split" );
+		return;
+	}
+
+	if ( model->mesh_count == 0 )
+	{
+		return;
+	}
+
+	uint32_t        mesh_capacity = model->mesh_count;
+	uint32_t        mesh_count    = 0;
+	struct ft_mesh* meshes = calloc( mesh_capacity, sizeof( struct ft_mesh ) );
+
+	for ( uint32_t m = 0; m < model->mesh_count; ++m )
+	{
+		struct ft_mesh* mesh = &model->meshes[ m ];
+
+		if ( mesh->vertex_count <= MAX_INDEX_16 + 1 )
+		{
+			if ( mesh->indices_16 == NULL )
+			{
+				uint32_t* indices = promote_indices( mesh );
+
+				mesh->indices_16 =
+				    malloc( mesh->index_count * sizeof( uint16_t ) );
+
+				for ( uint32_t i = 0; i < mesh->index_count; ++i )
+				{
+					mesh->indices_16[ i ] = ( uint16_t ) indices[ i ];
+				}
+
+				free( mesh->indices_32 );
+				mesh->indices_32 = NULL;
+			}
+
+			push_mesh( &meshes, &mesh_count, &mesh_capacity );
+			meshes[ mesh_count - 1 ] = *mesh;
+			continue;
+		}
+
+		uint32_t* indices   = promote_indices( mesh );
+		uint32_t  triangles = mesh->index_count / 3;
+
+		// vertex belongs to current part when its marker equals part id
+		uint32_t* markers = calloc( mesh->vertex_count, sizeof( uint32_t ) );
+		uint32_t* remap   = malloc( mesh->vertex_count * sizeof( uint32_t ) );
+		memset( remap, 0xff, mesh->vertex_count * sizeof( uint32_t ) );
+
+		uint32_t part_id           = 1;
+		uint32_t part_start        = 0;
+		uint32_t part_vertex_count = 0;
+
+		for ( uint32_t t = 0; t <= triangles; ++t )
+		{
+			uint32_t new_vertices = 0;
+
+			if ( t < triangles )
+			{
+				const uint32_t* tri = &indices[ t * 3 ];
+
+				new_vertices += markers[ tri[ 0 ] ] != part_id;
+				new_vertices += markers[ tri[ 1 ] ] != part_id &&
+				                tri[ 1 ] != tri[ 0 ];
+				new_vertices += markers[ tri[ 2 ] ] != part_id &&
+				                tri[ 2 ] != tri[ 0 ] && tri[ 2 ] != tri[ 1 ];
+			}
+
+			if ( t == triangles ||
+			     part_vertex_count + new_vertices > MAX_INDEX_16 + 1 )
+			{
+				if ( t > part_start )
+				{
+					push_mesh( &meshes, &mesh_count, &mesh_capacity );
+					copy_mesh_part( &meshes[ mesh_count - 1 ],
+					                mesh,
+					                &indices[ part_start * 3 ],
+					                t - part_start,
+					                remap );
+				}
+
+				part_id++;
+				part_start        = t;
+				part_vertex_count = 0;
+
+				if ( t == triangles )
+				{
+					break;
+				}
+
+				new_vertices = 3;
+			}
+
+			for ( uint32_t k = 0; k < 3; ++k )
+			{
+				markers[ indices[ t * 3 + k ] ] = part_id;
+			}
+
+			part_vertex_count += new_vertices;
+		}
+
+		free( remap );
+		free( markers );
+		free_mesh_arrays( mesh );
+	}
+
+	free( model->meshes );
+	model->meshes     = meshes;
+	model->mesh_count = mesh_count;
+}
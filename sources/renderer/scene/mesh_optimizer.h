@@ -0,0 +1,49 @@
+#pragma once
+
+#include "base/base.h"
+#include "model_loader.h"
+
+#define FT_VERTEX_CACHE_SIZE 32
+
+// merges bitwise identical vertices and builds index buffer for non indexed
+// meshes
+FT_API void
+ft_weld_mesh_vertices( struct ft_mesh* mesh );
+
+// reorders triangles for post transform vertex cache reuse
+FT_API void
+ft_optimize_vertex_cache( uint32_t* indices,
+                          uint32_t  index_count,
+                          uint32_t  vertex_count );
+
+// reorders clusters of cache optimized triangles front to back, threshold
+// bounds how much cache efficiency may be lost, 1.05 is a good default
+FT_API void
+ft_optimize_overdraw( uint32_t*    indices,
+                      uint32_t     index_count,
+                      const float* positions,
+                      uint32_t     vertex_count,
+                      float        threshold );
+
+// reorders vertices in order of first use by index buffer
+FT_API void
+ft_optimize_vertex_fetch( struct ft_mesh* mesh );
+
+// runs all passes above on a single mesh, indices stay 32 bit
+FT_API void
+ft_optimize_mesh( struct ft_mesh* mesh );
+
+// coarse copy of mesh for previews, vertices are snapped to grid_size cells
+// along longest side of mesh and first vertex of each cell stands for all
+// of them. triangles collapsed by snapping are dropped. dst only gets its own
+// attributes and 32 bit indices, returns false when no triangle is left
+FT_API bool
+ft_cluster_mesh( struct ft_mesh*       dst,
+                 const struct ft_mesh* mesh,
+                 uint32_t              grid_size );
+
+// converts every mesh to 16 bit indices, meshes above 65536 vertices are
+// split into several meshes sharing material and instances. split meshes
+// drop packed vertices, meshlets and lods, so run it before those stages
+FT_API void
+ft_narrow_model_indices( struct ft_model* model );
@@ -0,0 +1,1288 @@
+#include <math.h>
+#include <float.h>
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+#define BORDER_WEIGHT   10.0f
+#define SEAM_WEIGHT     1.0f
+#define INVALID_VERTEX  UINT32_MAX
+#define MIN_LOD_INDICES 96
+// level is dropped when it removes less than this fraction of triangles
+#define MIN_LOD_REDUCTION 0.2f
+#define LOD_BASE_ERROR    0.01f
+// attribute errors are weighted against position error in unit box
+#define NORMAL_WEIGHT   0.5f
+#define TEXCOORD_WEIGHT 1.0f
+
+enum vertex_kind
+{
+	VERTEX_KIND_MANIFOLD,
+	VERTEX_KIND_BORDER,
+	VERTEX_KIND_SEAM,
+	VERTEX_KIND_LOCKED,
+};
+
+struct quadric
+{
+	float a00, a11, a22;
+	float a10, a20, a21;
+	float b0, b1, b2;
+	float c;
+	float w;
+};
+
+// attributes are linear over triangle, a = g . p + d. quadric keeps sums of
+// g g^T, d g, d^2 and weight followed by g and d of every attribute
+#define ATTRIBUTE_QUADRIC_BASE 11
+#define MAX_ATTRIBUTE_COUNT    8
+
+struct collapse
+{
+	uint32_t src;
+	uint32_t dst;
+	float    error;
+};
+
+FT_INLINE void
+quadric_from_plane( struct quadric* q,
+                    const float3    n,
+                    float           d,
+                    float           w )
+{
+	q->a00 = w * n[ 0 ] * n[ 0 ];
+	q->a11 = w * n[ 1 ] * n[ 1 ];
+	q->a22 = w * n[ 2 ] * n[ 2 ];
+	q->a10 = w * n[ 1 ] * n[ 0 ];
+	q->a20 = w * n[ 2 ] * n[ 0 ];
+	q->a21 = w * n[ 2 ] * n[ 1 ];
+	q->b0  = w * n[ 0 ] * d;
+	q->b1  = w * n[ 1 ] * d;
+	q->b2  = w * n[ 2 ] * d;
+	q->c   = w * d * d;
+	q->w   = w;
+}
+
+FT_INLINE void
+quadric_add( struct quadric* r, const struct quadric* q )
+{
+	r->a00 += q->a00;
+	r->a11 += q->a11;
+	r->a22 += q->a22;
+	r->a10 += q->a10;
+	r->a20 += q->a20;
+	r->a21 += q->a21;
+	r->b0 += q->b0;
+	r->b1 += q->b1;
+	r->b2 += q->b2;
+	r->c += q->c;
+	r->w += q->w;
+}
+
+// mean squared distance of point to planes accumulated in quadric
+FT_INLINE float
+quadric_error( const struct quadric* q, const float3 p )
+{
+	float rx = q->b0;
+	float ry = q->b1;
+	float rz = q->b2;
+
+	rx += q->a10 * p[ 1 ];
+	ry += q->a21 * p[ 2 ];
+	rz += q->a20 * p[ 0 ];
+
+	rx *= 2.0f;
+	ry *= 2.0f;
+	rz *= 2.0f;
+
+	rx += q->a00 * p[ 0 ];
+	ry += q->a11 * p[ 1 ];
+	rz += q->a22 * p[ 2 ];
+
+	float r = q->c + rx * p[ 0 ] + ry * p[ 1 ] + rz * p[ 2 ];
+
+	return q->w > 0.0f ? fabsf( r ) / q->w : 0.0f;
+}
+
+FT_INLINE uint32_t
+attribute_quadric_stride( uint32_t attribute_count )
+{
+	return ATTRIBUTE_QUADRIC_BASE + attribute_count * 4;
+}
+
+FT_INLINE void
+attribute_quadric_add( float* r, const float* q, uint32_t attribute_count )
+{
+	uint32_t stride = attribute_quadric_stride( attribute_count );
+
+	for ( uint32_t i = 0; i < stride; ++i )
+	{
+		r[ i ] += q[ i ];
+	}
+}
+
+// fits gradients of attributes over triangle into quadric
+static void
+attribute_quadric_from_triangle( float*       q,
+                                 const float3 p0,
+                                 const float3 p1,
+                                 const float3 p2,
+                                 const float* a0,
+                                 const float* a1,
+                                 const float* a2,
+                                 uint32_t     attribute_count,
+                                 float        w )
+{
+	uint32_t stride = attribute_quadric_stride( attribute_count );
+	memset( q, 0, stride * sizeof( float ) );
+
+	float3 e1, e2;
+	float3_sub( e1, p1, p0 );
+	float3_sub( e2, p2, p0 );
+
+	float d11 = float3_mul_inner( e1, e1 );
+	float d12 = float3_mul_inner( e1, e2 );
+	float d22 = float3_mul_inner( e2, e2 );
+	float det = d11 * d22 - d12 * d12;
+
+	if ( det <= 0.0f )
+	{
+		return;
+	}
+
+	q[ 10 ] = w;
+
+	for ( uint32_t k = 0; k < attribute_count; ++k )
+	{
+		float da1 = a1[ k ] - a0[ k ];
+		float da2 = a2[ k ] - a0[ k ];
+		float u   = ( da1 * d22 - da2 * d12 ) / det;
+		float v   = ( da2 * d11 - da1 * d12 ) / det;
+
+		float3 g;
+		g[ 0 ] = u * e1[ 0 ] + v * e2[ 0 ];
+		g[ 1 ] = u * e1[ 1 ] + v * e2[ 1 ];
+		g[ 2 ] = u * e1[ 2 ] + v * e2[ 2 ];
+
+		float d = a0[ k ] - float3_mul_inner( g, p0 );
+
+		q[ 0 ] += w * g[ 0 ] * g[ 0 ];
+		q[ 1 ] += w * g[ 1 ] * g[ 1 ];
+		q[ 2 ] += w * g[ 2 ] * g[ 2 ];
+		q[ 3 ] += w * g[ 1 ] * g[ 0 ];
+		q[ 4 ] += w * g[ 2 ] * g[ 0 ];
+		q[ 5 ] += w * g[ 2 ] * g[ 1 ];
+		q[ 6 ] += w * d * g[ 0 ];
+		q[ 7 ] += w * d * g[ 1 ];
+		q[ 8 ] += w * d * g[ 2 ];
+		q[ 9 ] += w * d * d;
+
+		float* gk = &q[ ATTRIBUTE_QUADRIC_BASE + k * 4 ];
+		gk[ 0 ]   = w * g[ 0 ];
+		gk[ 1 ]   = w * g[ 1 ];
+		gk[ 2 ]   = w * g[ 2 ];
+		gk[ 3 ]   = w * d;
+	}
+}
+
+// mean squared difference between attributes of vertex and attributes
+// interpolated over triangles accumulated in quadric
+FT_INLINE float
+attribute_quadric_error( const float* q,
+                         const float3 p,
+                         const float* a,
+                         uint32_t     attribute_count )
+{
+	float r = q[ 0 ] * p[ 0 ] * p[ 0 ] + q[ 1 ] * p[ 1 ] * p[ 1 ] +
+	          q[ 2 ] * p[ 2 ] * p[ 2 ] + q[ 9 ];
+
+	r += 2.0f * ( q[ 3 ] * p[ 1 ] * p[ 0 ] + q[ 4 ] * p[ 2 ] * p[ 0 ] +
+	              q[ 5 ] * p[ 2 ] * p[ 1 ] );
+	r += 2.0f * ( q[ 6 ] * p[ 0 ] + q[ 7 ] * p[ 1 ] + q[ 8 ] * p[ 2 ] );
+
+	for ( uint32_t k = 0; k < attribute_count; ++k )
+	{
+		const float* gk = &q[ ATTRIBUTE_QUADRIC_BASE + k * 4 ];
+
+		float interpolated = gk[ 0 ] * p[ 0 ] + gk[ 1 ] * p[ 1 ] +
+		                     gk[ 2 ] * p[ 2 ] + gk[ 3 ];
+
+		r += q[ 10 ] * a[ k ] * a[ k ] - 2.0f * a[ k ] * interpolated;
+	}
+
+	return q[ 10 ] > 0.0f ? fabsf( r ) / q[ 10 ] : 0.0f;
+}
+
+FT_INLINE uint32_t
+hash_u32( uint32_t h )
+{
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+FT_INLINE uint32_t
+table_size( uint32_t count )
+{
+	uint32_t size = 1;
+
+	while ( size < count + count / 4 )
+	{
+		size *= 2;
+	}
+
+	return size;
+}
+
+// links vertices sharing position into rings, uv and normal seams. position
+// ids point at first vertex of every position
+static void
+build_position_rings( uint32_t*    position_ids,
+                      uint32_t*    wedges,
+                      const float* positions,
+                      uint32_t     vertex_count )
+{
+	uint32_t  size  = table_size( vertex_count );
+	uint32_t* table = malloc( size * sizeof( uint32_t ) );
+	memset( table, 0xff, size * sizeof( uint32_t ) );
+
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		const float* p = &positions[ v * 3 ];
+
+		position_ids[ v ] = v;
+		wedges[ v ]       = v;
+
+		uint32_t bits[ 3 ];
+		memcpy( bits, p, sizeof( bits ) );
+
+		uint32_t h = hash_u32( bits[ 0 ] ^ hash_u32( bits[ 1 ] ) ^
+		                       hash_u32( hash_u32( bits[ 2 ] ) ) ) &
+		             ( size - 1 );
+
+		for ( ;; )
+		{
+			uint32_t o = table[ h ];
+
+			if ( o == INVALID_VERTEX )
+			{
+				table[ h ] = v;
+				break;
+			}
+
+			if ( memcmp( &positions[ o * 3 ], p, 3 * sizeof( float ) ) == 0 )
+			{
+				position_ids[ v ] = o;
+				wedges[ v ]       = wedges[ o ];
+				wedges[ o ]       = v;
+				break;
+			}
+
+			h = ( h + 1 ) & ( size - 1 );
+		}
+	}
+
+	free( table );
+}
+
+struct edge_table
+{
+	uint32_t  size;
+	uint64_t* keys;
+	uint32_t* counts;
+};
+
+FT_INLINE uint64_t
+edge_key( uint32_t a, uint32_t b )
+{
+	return ( ( uint64_t ) a << 32 ) | b;
+}
+
+FT_INLINE uint32_t*
+edge_lookup( struct edge_table* table, uint64_t key, bool insert )
+{
+	uint32_t h = hash_u32( ( uint32_t ) key ^ hash_u32( key >> 32 ) ) &
+	             ( table->size - 1 );
+
+	for ( ;; )
+	{
+		if ( table->keys[ h ] == key )
+		{
+			return &table->counts[ h ];
+		}
+
+		if ( table->keys[ h ] == UINT64_MAX )
+		{
+			if ( !insert )
+			{
+				return NULL;
+			}
+
+			table->keys[ h ] = key;
+			return &table->counts[ h ];
+		}
+
+		h = ( h + 1 ) & ( table->size - 1 );
+	}
+}
+
+// kinds of vertices with their neighbours along open edges, seams are open
+// edges in index space whose twins close them in position space
+struct topology
+{
+	uint8_t*  kinds;
+	uint32_t* border_next;
+	uint32_t* border_prev;
+	uint32_t* wedges;
+	uint32_t* position_ids;
+};
+
+static void
+classify_vertices( struct topology* topology,
+                   const uint32_t*  indices,
+                   uint32_t         index_count,
+                   const float*     positions,
+                   uint32_t         vertex_count )
+{
+	uint8_t*  kinds        = topology->kinds;
+	uint32_t* border_next  = topology->border_next;
+	uint32_t* border_prev  = topology->border_prev;
+	uint32_t* wedges       = topology->wedges;
+	uint32_t* position_ids = topology->position_ids;
+
+	build_position_rings( position_ids, wedges, positions, vertex_count );
+
+	struct edge_table edges;
+	edges.size   = table_size( index_count );
+	edges.keys   = malloc( edges.size * sizeof( uint64_t ) );
+	edges.counts = calloc( edges.size, sizeof( uint32_t ) );
+	memset( edges.keys, 0xff, edges.size * sizeof( uint64_t ) );
+
+	for ( uint32_t i = 0; i < index_count; i += 3 )
+	{
+		for ( uint32_t e = 0; e < 3; ++e )
+		{
+			uint32_t a = indices[ i + e ];
+			uint32_t b = indices[ i + ( e + 1 ) % 3 ];
+			( *edge_lookup( &edges, edge_key( a, b ), true ) )++;
+		}
+	}
+
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		kinds[ v ]       = VERTEX_KIND_MANIFOLD;
+		border_next[ v ] = INVALID_VERTEX;
+		border_prev[ v ] = INVALID_VERTEX;
+	}
+
+	for ( uint32_t i = 0; i < index_count; i += 3 )
+	{
+		for ( uint32_t e = 0; e < 3; ++e )
+		{
+			uint32_t a = indices[ i + e ];
+			uint32_t b = indices[ i + ( e + 1 ) % 3 ];
+
+			uint32_t  count    = *edge_lookup( &edges, edge_key( a, b ), false );
+			uint32_t* opposite = edge_lookup( &edges, edge_key( b, a ), false );
+
+			if ( count > 1 || ( opposite && *opposite > 1 ) )
+			{
+				kinds[ a ] = VERTEX_KIND_LOCKED;
+				kinds[ b ] = VERTEX_KIND_LOCKED;
+			}
+			else if ( opposite == NULL )
+			{
+				// more than one open edge per vertex means it is not a
+				// simple border loop
+				if ( border_next[ a ] != INVALID_VERTEX ||
+				     border_prev[ b ] != INVALID_VERTEX )
+				{
+					kinds[ a ] = VERTEX_KIND_LOCKED;
+					kinds[ b ] = VERTEX_KIND_LOCKED;
+				}
+
+				border_next[ a ] = b;
+				border_prev[ b ] = a;
+			}
+		}
+	}
+
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		if ( kinds[ v ] == VERTEX_KIND_MANIFOLD &&
+		     ( border_next[ v ] != INVALID_VERTEX ||
+		       border_prev[ v ] != INVALID_VERTEX ) )
+		{
+			kinds[ v ] = border_next[ v ] != INVALID_VERTEX &&
+			                     border_prev[ v ] != INVALID_VERTEX
+			                 ? VERTEX_KIND_BORDER
+			                 : VERTEX_KIND_LOCKED;
+		}
+	}
+
+	// vertex with single twin whose open edges mirror its own lies on seam
+	// and may slide along it, other shared positions stay locked
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		uint32_t w = wedges[ v ];
+
+		if ( w == v )
+		{
+			continue;
+		}
+
+		bool seam = wedges[ w ] == v && kinds[ v ] != VERTEX_KIND_LOCKED &&
+		            kinds[ w ] != VERTEX_KIND_LOCKED &&
+		            border_next[ v ] != INVALID_VERTEX &&
+		            border_next[ w ] != INVALID_VERTEX &&
+		            position_ids[ border_next[ v ] ] ==
+		                position_ids[ border_prev[ w ] ] &&
+		            position_ids[ border_prev[ v ] ] ==
+		                position_ids[ border_next[ w ] ];
+
+		kinds[ v ] = seam ? VERTEX_KIND_SEAM : VERTEX_KIND_LOCKED;
+	}
+
+	free( edges.keys );
+	free( edges.counts );
+}
+
+FT_INLINE void
+triangle_normal( float3 r, const float3 a, const float3 b, const float3 c )
+{
+	float3 e0, e1;
+	float3_sub( e0, b, a );
+	float3_sub( e1, c, a );
+	float3_mul_cross( r, e0, e1 );
+}
+
+// position quadrics are shared by all vertices of position, attribute
+// quadrics belong to every vertex
+static void
+fill_quadrics( struct quadric*        quadrics,
+               float*                 attribute_quadrics,
+               const uint32_t*        indices,
+               uint32_t               index_count,
+               const float3*          positions,
+               const float*           attributes,
+               uint32_t               attribute_count,
+               const struct topology* topology )
+{
+	uint32_t stride = attribute_quadric_stride( attribute_count );
+	float    aq[ ATTRIBUTE_QUADRIC_BASE + MAX_ATTRIBUTE_COUNT * 4 ];
+
+	for ( uint32_t i = 0; i < index_count; i += 3 )
+	{
+		const uint32_t* tri = &indices[ i ];
+
+		float3 n;
+		triangle_normal( n,
+		                 positions[ tri[ 0 ] ],
+		                 positions[ tri[ 1 ] ],
+		                 positions[ tri[ 2 ] ] );
+
+		float len = float3_len( n );
+
+		if ( len == 0.0f )
+		{
+			continue;
+		}
+
+		float3_scale( n, n, 1.0f / len );
+
+		struct quadric q;
+		quadric_from_plane( &q,
+		                    n,
+		                    -float3_mul_inner( n, positions[ tri[ 0 ] ] ),
+		                    len * 0.5f );
+
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			quadric_add( &quadrics[ topology->position_ids[ tri[ k ] ] ], &q );
+		}
+
+		if ( attribute_count )
+		{
+			attribute_quadric_from_triangle(
+			    aq,
+			    positions[ tri[ 0 ] ],
+			    positions[ tri[ 1 ] ],
+			    positions[ tri[ 2 ] ],
+			    &attributes[ tri[ 0 ] * attribute_count ],
+			    &attributes[ tri[ 1 ] * attribute_count ],
+			    &attributes[ tri[ 2 ] * attribute_count ],
+			    attribute_count,
+			    len * 0.5f );
+
+			for ( uint32_t k = 0; k < 3; ++k )
+			{
+				attribute_quadric_add( &attribute_quadrics[ tri[ k ] * stride ],
+				                       aq,
+				                       attribute_count );
+			}
+		}
+
+		// keep open edges in place with planes perpendicular to triangle,
+		// seams are held weaker than borders as they may slide
+		for ( uint32_t e = 0; e < 3; ++e )
+		{
+			uint32_t a = tri[ e ];
+			uint32_t b = tri[ ( e + 1 ) % 3 ];
+
+			if ( topology->border_next[ a ] != b )
+			{
+				continue;
+			}
+
+			float3 edge;
+			float3_sub( edge, positions[ b ], positions[ a ] );
+			float edge_len = float3_len( edge );
+
+			float3 en;
+			float3_mul_cross( en, edge, n );
+
+			float en_len = float3_len( en );
+
+			if ( en_len == 0.0f )
+			{
+				continue;
+			}
+
+			float3_scale( en, en, 1.0f / en_len );
+
+			bool  seam   = topology->wedges[ a ] != a &&
+			            topology->wedges[ b ] != b;
+			float weight = seam ? SEAM_WEIGHT : BORDER_WEIGHT;
+
+			quadric_from_plane( &q,
+			                    en,
+			                    -float3_mul_inner( en, positions[ a ] ),
+			                    edge_len * edge_len * weight );
+
+			quadric_add( &quadrics[ topology->position_ids[ a ] ], &q );
+			quadric_add( &quadrics[ topology->position_ids[ b ] ], &q );
+		}
+	}
+}
+
+// twin of dst that twin of seam vertex src collapses to so both sides of
+// seam move together, invalid when seam edge is not shared
+FT_INLINE uint32_t
+seam_twin_target( const struct topology* topology,
+                  uint32_t               src,
+                  uint32_t               dst )
+{
+	uint32_t twin   = topology->wedges[ src ];
+	uint32_t next   = topology->border_next[ twin ];
+	uint32_t prev   = topology->border_prev[ twin ];
+	uint32_t target = INVALID_VERTEX;
+
+	if ( topology->position_ids[ next ] == topology->position_ids[ dst ] )
+	{
+		target = next;
+	}
+	else if ( topology->position_ids[ prev ] == topology->position_ids[ dst ] )
+	{
+		target = prev;
+	}
+
+	return target != dst && topology->wedges[ dst ] == target
+	           ? target
+	           : INVALID_VERTEX;
+}
+
+FT_INLINE bool
+can_collapse( const struct topology* topology, uint32_t src, uint32_t dst )
+{
+	const uint8_t*  kinds       = topology->kinds;
+	const uint32_t* border_next = topology->border_next;
+	const uint32_t* border_prev = topology->border_prev;
+
+	switch ( kinds[ src ] )
+	{
+	case VERTEX_KIND_MANIFOLD: return true;
+	case VERTEX_KIND_BORDER:
+		return kinds[ dst ] == VERTEX_KIND_BORDER &&
+		       ( border_next[ src ] == dst || border_prev[ src ] == dst );
+	case VERTEX_KIND_SEAM:
+		return kinds[ dst ] == VERTEX_KIND_SEAM &&
+		       ( border_next[ src ] == dst || border_prev[ src ] == dst ) &&
+		       seam_twin_target( topology, src, dst ) != INVALID_VERTEX;
+	default: return false;
+	}
+}
+
+// removes src from its open edge loop, src slides onto neighbour dst
+FT_INLINE void
+unlink_open_edge( struct topology* topology, uint32_t src, uint32_t dst )
+{
+	uint32_t* border_next = topology->border_next;
+	uint32_t* border_prev = topology->border_prev;
+
+	if ( border_next[ src ] == dst )
+	{
+		border_next[ border_prev[ src ] ] = dst;
+		border_prev[ dst ]                = border_prev[ src ];
+	}
+	else
+	{
+		border_prev[ border_next[ src ] ] = dst;
+		border_next[ dst ]                = border_next[ src ];
+	}
+}
+
+static int
+compare_collapses( const void* a, const void* b )
+{
+	float ea = ( ( const struct collapse* ) a )->error;
+	float eb = ( ( const struct collapse* ) b )->error;
+	return ( ea > eb ) - ( ea < eb );
+}
+
+// triangles around every vertex in compact form
+struct adjacency
+{
+	uint32_t* offsets;
+	uint32_t* counts;
+	uint32_t* triangles;
+};
+
+static void
+build_adjacency( struct adjacency* adjacency,
+                 const uint32_t*   indices,
+                 uint32_t          index_count,
+                 uint32_t          vertex_count )
+{
+	memset( adjacency->counts, 0, vertex_count * sizeof( uint32_t ) );
+
+	for ( uint32_t i = 0; i < index_count; ++i )
+	{
+		adjacency->counts[ indices[ i ] ]++;
+	}
+
+	uint32_t offset = 0;
+
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		adjacency->offsets[ v ] = offset;
+		offset += adjacency->counts[ v ];
+		adjacency->counts[ v ] = 0;
+	}
+
+	for ( uint32_t i = 0; i < index_count; ++i )
+	{
+		uint32_t v = indices[ i ];
+		adjacency->triangles[ adjacency->offsets[ v ] +
+		                      adjacency->counts[ v ]++ ] = i / 3;
+	}
+}
+
+// checks that moving src to dst does not flip any triangle around src,
+// returns number of triangles collapse removes or -1 when it flips
+static int32_t
+check_collapse( const struct adjacency* adjacency,
+                const uint32_t*         indices,
+                const float3*           positions,
+                uint32_t                src,
+                uint32_t                dst )
+{
+	int32_t removed = 0;
+
+	for ( uint32_t t = 0; t < adjacency->counts[ src ]; ++t )
+	{
+		const uint32_t* tri =
+		    &indices[ adjacency->triangles[ adjacency->offsets[ src ] + t ] *
+		              3 ];
+
+		if ( tri[ 0 ] == dst || tri[ 1 ] == dst || tri[ 2 ] == dst )
+		{
+			removed++;
+			continue;
+		}
+
+		const float* p[ 3 ];
+		const float* q[ 3 ];
+
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			p[ k ] = positions[ tri[ k ] ];
+			q[ k ] = tri[ k ] == src ? positions[ dst ] : p[ k ];
+		}
+
+		float3 before, after;
+		triangle_normal( before, p[ 0 ], p[ 1 ], p[ 2 ] );
+		triangle_normal( after, q[ 0 ], q[ 1 ], q[ 2 ] );
+
+		// reject flips and collapses producing near degenerate triangles
+		float d = float3_mul_inner( before, after );
+
+		if ( d <= 0.25f * float3_len( before ) * float3_len( after ) )
+		{
+			return -1;
+		}
+	}
+
+	return removed;
+}
+
+// lock whole neighbourhood so flip checks stay valid this pass
+static void
+lock_neighbourhood( bool*                   locked,
+                    const struct adjacency* adjacency,
+                    const uint32_t*         indices,
+                    uint32_t                v )
+{
+	for ( uint32_t t = 0; t < adjacency->counts[ v ]; ++t )
+	{
+		const uint32_t* tri =
+		    &indices[ adjacency->triangles[ adjacency->offsets[ v ] + t ] * 3 ];
+		locked[ tri[ 0 ] ] = true;
+		locked[ tri[ 1 ] ] = true;
+		locked[ tri[ 2 ] ] = true;
+	}
+}
+
+// removes degenerate triangles left after remap, returns new index count
+static uint32_t
+apply_remap( uint32_t* indices, uint32_t index_count, const uint32_t* remap )
+{
+	uint32_t count = 0;
+
+	for ( uint32_t i = 0; i < index_count; i += 3 )
+	{
+		uint32_t a = remap[ indices[ i + 0 ] ];
+		uint32_t b = remap[ indices[ i + 1 ] ];
+		uint32_t c = remap[ indices[ i + 2 ] ];
+
+		if ( a != b && b != c && a != c )
+		{
+			indices[ count++ ] = a;
+			indices[ count++ ] = b;
+			indices[ count++ ] = c;
+		}
+	}
+
+	return count;
+}
+
+struct simplifier
+{
+	struct topology topology;
+	struct quadric* quadrics;
+	float*          attribute_quadrics;
+	const float3*   vertices;
+	const float*    attributes;
+	uint32_t        attribute_count;
+};
+
+FT_INLINE float
+attribute_error( const struct simplifier* s, uint32_t src, uint32_t dst )
+{
+	if ( s->attribute_count == 0 )
+	{
+		return 0.0f;
+	}
+
+	uint32_t stride = attribute_quadric_stride( s->attribute_count );
+
+	return attribute_quadric_error( &s->attribute_quadrics[ src * stride ],
+	                                s->vertices[ dst ],
+	                                &s->attributes[ dst * s->attribute_count ],
+	                                s->attribute_count );
+}
+
+// position error plus attribute error of every vertex moving in collapse
+static float
+collapse_error( const struct simplifier* s, uint32_t src, uint32_t dst )
+{
+	const struct topology* topology = &s->topology;
+
+	float error =
+	    quadric_error( &s->quadrics[ topology->position_ids[ src ] ],
+	                   s->vertices[ dst ] ) +
+	    attribute_error( s, src, dst );
+
+	if ( topology->kinds[ src ] == VERTEX_KIND_SEAM )
+	{
+		error += attribute_error( s,
+		                          topology->wedges[ src ],
+		                          seam_twin_target( topology, src, dst ) );
+	}
+
+	return error;
+}
+
+static void
+merge_quadrics( struct simplifier* s, uint32_t src, uint32_t dst )
+{
+	uint32_t ps = s->topology.position_ids[ src ];
+	uint32_t pd = s->topology.position_ids[ dst ];
+
+	if ( ps != pd )
+	{
+		quadric_add( &s->quadrics[ pd ], &s->quadrics[ ps ] );
+	}
+
+	if ( s->attribute_count )
+	{
+		uint32_t stride = attribute_quadric_stride( s->attribute_count );
+		attribute_quadric_add( &s->attribute_quadrics[ dst * stride ],
+		                       &s->attribute_quadrics[ src * stride ],
+		                       s->attribute_count );
+	}
+}
+
+uint32_t
+ft_simplify_mesh_indices( uint32_t*       dst,
+                          const uint32_t* indices,
+                          uint32_t        index_count,
+                          const float*    positions,
+                          const float*    attributes,
+                          uint32_t        attribute_count,
+                          uint32_t        vertex_count,
+                          uint32_t        target_index_count,
+                          float           target_error,
+                          float*          result_error )
+{
+	FT_ASSERT( index_count % 3 == 0 );
+	FT_ASSERT( attribute_count <= MAX_ATTRIBUTE_COUNT );
+	FT_ASSERT( attributes || attribute_count == 0 );
+
+	memcpy( dst, indices, index_count * sizeof( uint32_t ) );
+
+	if ( result_error )
+	{
+		*result_error = 0.0f;
+	}
+
+	if ( index_count <= target_index_count )
+	{
+		return index_count;
+	}
+
+	// rescale positions into unit box so errors do not depend on mesh size
+	float3 min = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for ( uint32_t i = 0; i < index_count; ++i )
+	{
+		float3_min( min, min, &positions[ indices[ i ] * 3 ] );
+		float3_max( max, max, &positions[ indices[ i ] * 3 ] );
+	}
+
+	float extent = FT_MAX( FT_MAX( max[ 0 ] - min[ 0 ], max[ 1 ] - min[ 1 ] ),
+	                       max[ 2 ] - min[ 2 ] );
+	float scale  = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+	float3* vertices = malloc( vertex_count * sizeof( float3 ) );
+
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		float3_sub( vertices[ v ], &positions[ v * 3 ], min );
+		float3_scale( vertices[ v ], vertices[ v ], scale );
+	}
+
+	struct simplifier s;
+	s.vertices        = ( const float3* ) vertices;
+	s.attributes      = attributes;
+	s.attribute_count = attribute_count;
+
+	struct topology* topology = &s.topology;
+	topology->kinds           = malloc( vertex_count );
+	topology->border_next     = malloc( vertex_count * sizeof( uint32_t ) );
+	topology->border_prev     = malloc( vertex_count * sizeof( uint32_t ) );
+	topology->wedges          = malloc( vertex_count * sizeof( uint32_t ) );
+	topology->position_ids    = malloc( vertex_count * sizeof( uint32_t ) );
+	classify_vertices( topology,
+	                   indices,
+	                   index_count,
+	                   positions,
+	                   vertex_count );
+
+	s.quadrics           = calloc( vertex_count, sizeof( struct quadric ) );
+	s.attribute_quadrics = NULL;
+
+	if ( attribute_count )
+	{
+		s.attribute_quadrics =
+		    calloc( ( size_t ) vertex_count *
+		                attribute_quadric_stride( attribute_count ),
+		            sizeof( float ) );
+	}
+
+	fill_quadrics( s.quadrics,
+	               s.attribute_quadrics,
+	               indices,
+	               index_count,
+	               s.vertices,
+	               attributes,
+	               attribute_count,
+	               topology );
+
+	struct adjacency adjacency;
+	adjacency.offsets   = malloc( vertex_count * sizeof( uint32_t ) );
+	adjacency.counts    = malloc( vertex_count * sizeof( uint32_t ) );
+	adjacency.triangles = malloc( index_count * sizeof( uint32_t ) );
+
+	struct collapse* collapses =
+	    malloc( index_count * sizeof( struct collapse ) );
+	uint32_t* remap  = malloc( vertex_count * sizeof( uint32_t ) );
+	bool*     locked = malloc( vertex_count * sizeof( bool ) );
+
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		remap[ v ] = v;
+	}
+
+	float error_limit = target_error * target_error;
+	float max_error   = 0.0f;
+
+	while ( index_count > target_index_count )
+	{
+		build_adjacency( &adjacency, dst, index_count, vertex_count );
+
+		uint32_t collapse_count = 0;
+
+		for ( uint32_t i = 0; i < index_count; ++i )
+		{
+			uint32_t a = dst[ i ];
+			uint32_t b = dst[ i - i % 3 + ( i % 3 + 1 ) % 3 ];
+
+			bool ab = can_collapse( topology, a, b );
+			bool ba = can_collapse( topology, b, a );
+
+			if ( !ab && !ba )
+			{
+				continue;
+			}
+
+			float eab = ab ? collapse_error( &s, a, b ) : FLT_MAX;
+			float eba = ba ? collapse_error( &s, b, a ) : FLT_MAX;
+
+			collapses[ collapse_count++ ] =
+			    eab <= eba ? ( struct collapse ) { a, b, eab }
+			               : ( struct collapse ) { b, a, eba };
+		}
+
+		if ( collapse_count == 0 )
+		{
+			break;
+		}
+
+		qsort( collapses,
+		       collapse_count,
+		       sizeof( struct collapse ),
+		       compare_collapses );
+
+		memset( locked, 0, vertex_count * sizeof( bool ) );
+
+		uint32_t triangle_goal = ( index_count - target_index_count ) / 3;
+		uint32_t removed_total = 0;
+		uint32_t applied       = 0;
+
+		for ( uint32_t c = 0; c < collapse_count; ++c )
+		{
+			const struct collapse* it = &collapses[ c ];
+
+			if ( it->error > error_limit || removed_total >= triangle_goal )
+			{
+				break;
+			}
+
+			if ( locked[ it->src ] || locked[ it->dst ] )
+			{
+				continue;
+			}
+
+			int32_t removed = check_collapse( &adjacency,
+			                                  dst,
+			                                  vertices,
+			                                  it->src,
+			                                  it->dst );
+
+			if ( removed < 0 )
+			{
+				continue;
+			}
+
+			uint8_t kind = topology->kinds[ it->src ];
+
+			// seam collapses move twin on other side along the same edge
+			if ( kind == VERTEX_KIND_SEAM )
+			{
+				uint32_t twin   = topology->wedges[ it->src ];
+				uint32_t target =
+				    seam_twin_target( topology, it->src, it->dst );
+
+				if ( locked[ twin ] || locked[ target ] )
+				{
+					continue;
+				}
+
+				int32_t twin_removed = check_collapse( &adjacency,
+				                                       dst,
+				                                       vertices,
+				                                       twin,
+				                                       target );
+
+				if ( twin_removed < 0 )
+				{
+					continue;
+				}
+
+				lock_neighbourhood( locked, &adjacency, dst, twin );
+				unlink_open_edge( topology, twin, target );
+
+				remap[ twin ] = target;
+				removed += twin_removed;
+
+				if ( attribute_count )
+				{
+					uint32_t stride =
+					    attribute_quadric_stride( attribute_count );
+					attribute_quadric_add(
+					    &s.attribute_quadrics[ target * stride ],
+					    &s.attribute_quadrics[ twin * stride ],
+					    attribute_count );
+				}
+			}
+
+			lock_neighbourhood( locked, &adjacency, dst, it->src );
+
+			if ( kind == VERTEX_KIND_BORDER || kind == VERTEX_KIND_SEAM )
+			{
+				unlink_open_edge( topology, it->src, it->dst );
+			}
+
+			remap[ it->src ] = it->dst;
+			merge_quadrics( &s, it->src, it->dst );
+			max_error = FT_MAX( max_error, it->error );
+			removed_total += removed;
+			applied++;
+		}
+
+		if ( applied == 0 )
+		{
+			break;
+		}
+
+		index_count = apply_remap( dst, index_count, remap );
+
+		for ( uint32_t v = 0; v < vertex_count; ++v )
+		{
+			remap[ v ] = v;
+		}
+	}
+
+	if ( result_error )
+	{
+		*result_error = sqrtf( max_error );
+	}
+
+	free( locked );
+	free( remap );
+	free( collapses );
+	free( adjacency.triangles );
+	free( adjacency.counts );
+	free( adjacency.offsets );
+	free( s.attribute_quadrics );
+	free( s.quadrics );
+	free( topology->position_ids );
+	free( topology->wedges );
+	free( topology->border_prev );
+	free( topology->border_next );
+	free( topology->kinds );
+	free( vertices );
+
+	return index_count;
+}
+
+void
+ft_generate_mesh_lods( struct ft_mesh* mesh )
+{
+	FT_ASSERT( mesh );
+
+	if ( mesh->mapped )
+	{
+		FT_WARN( "mesh of baked model can not be resized" );
+		return;
+	}
+
+	ft_free_mesh_lods( mesh );
+
+	if ( mesh->positions == NULL ||
+	     ( mesh->indices_16 == NULL && mesh->indices_32 == NULL ) ||
+	     mesh->index_count < MIN_LOD_INDICES )
+	{
+		return;
+	}
+
+	uint32_t* previous = malloc( mesh->index_count * sizeof( uint32_t ) );
+
+	for ( uint32_t i = 0; i < mesh->index_count; ++i )
+	{
+		previous[ i ] = mesh->indices_16 ? mesh->indices_16[ i ]
+		                                 : mesh->indices_32[ i ];
+	}
+
+	float3 min = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float3 max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	for ( uint32_t v = 0; v < mesh->vertex_count; ++v )
+	{
+		float3_min( min, min, &mesh->positions[ v * 3 ] );
+		float3_max( max, max, &mesh->positions[ v * 3 ] );
+	}
+
+	float extent = FT_MAX( FT_MAX( max[ 0 ] - min[ 0 ], max[ 1 ] - min[ 1 ] ),
+	                       max[ 2 ] - min[ 2 ] );
+
+	// weighted normals and texcoords keep shading and uv layout across lods
+	uint32_t attribute_count = ( mesh->normals ? 3 : 0 ) +
+	                           ( mesh->texcoords ? 2 : 0 );
+	float*   attributes      = NULL;
+
+	if ( attribute_count )
+	{
+		attributes = malloc( ( size_t ) mesh->vertex_count * attribute_count *
+		                     sizeof( float ) );
+
+		for ( uint32_t v = 0; v < mesh->vertex_count; ++v )
+		{
+			float* a = &attributes[ v * attribute_count ];
+
+			if ( mesh->normals )
+			{
+				a[ 0 ] = mesh->normals[ v * 3 + 0 ] * NORMAL_WEIGHT;
+				a[ 1 ] = mesh->normals[ v * 3 + 1 ] * NORMAL_WEIGHT;
+				a[ 2 ] = mesh->normals[ v * 3 + 2 ] * NORMAL_WEIGHT;
+				a += 3;
+			}
+
+			if ( mesh->texcoords )
+			{
+				a[ 0 ] = mesh->texcoords[ v * 2 + 0 ] * TEXCOORD_WEIGHT;
+				a[ 1 ] = mesh->texcoords[ v * 2 + 1 ] * TEXCOORD_WEIGHT;
+			}
+		}
+	}
+
+	uint32_t previous_count = mesh->index_count;
+	float    error          = 0.0f;
+
+	for ( uint32_t l = 0; l < FT_MAX_MESH_LOD_COUNT; ++l )
+	{
+		uint32_t target = previous_count / 6 * 3;
+
+		if ( target < MIN_LOD_INDICES )
+		{
+			break;
+		}
+
+		// simplifying from previous level is cheaper, errors add up
+		uint32_t* indices = malloc( previous_count * sizeof( uint32_t ) );
+		float     level_error;
+		uint32_t  count = ft_simplify_mesh_indices( indices,
+                                                   previous,
+                                                   previous_count,
+                                                   mesh->positions,
+                                                   attributes,
+                                                   attribute_count,
+                                                   mesh->vertex_count,
+                                                   target,
+                                                   LOD_BASE_ERROR * ( 1 << l ),
+                                                   &level_error );
+
+		if ( count > previous_count * ( 1.0f - MIN_LOD_REDUCTION ) )
+		{
+			free( indices );
+			break;
+		}
+
+		ft_optimize_vertex_cache( indices, count, mesh->vertex_count );
+
+		error += level_error * extent;
+
+		struct ft_mesh_lod* lod = &mesh->lods[ mesh->lod_count++ ];
+		lod->index_count        = count;
+		lod->error              = error;
+
+		if ( mesh->indices_16 )
+		{
+			lod->indices_16 = malloc( count * sizeof( uint16_t ) );
+
+			for ( uint32_t i = 0; i < count; ++i )
+			{
+				lod->indices_16[ i ] = ( uint16_t ) indices[ i ];
+			}
+		}
+		else
+		{
+			lod->indices_32 = malloc( count * sizeof( uint32_t ) );
+			memcpy( lod->indices_32, indices, count * sizeof( uint32_t ) );
+		}
+
+		free( previous );
+		previous       = indices;
+		previous_count = count;
+	}
+
+	free( attributes );
+	free( previous );
+}
+
+void
+ft_free_mesh_lods( struct ft_mesh* mesh )
+{
+	// lods of baked meshes go away with mapping
+	if ( mesh->mapped )
+	{
+		return;
+	}
+
+	for ( uint32_t l = 0; l < mesh->lod_count; ++l )
+	{
+		ft_safe_free( mesh->lods[ l ].indices_16 );
+		ft_safe_free( mesh->lods[ l ].indices_32 );
+	}
+
+	memset( mesh->lods, 0, sizeof( mesh->lods ) );
+	mesh->lod_count = 0;
+}
+
+uint32_t
+ft_select_mesh_lod( const struct ft_mesh*   mesh,
+                    const float4x4          world,
+                    const struct ft_camera* camera,
+                    float                   max_screen_error )
+{
+	struct ft_bounds bounds;
+	ft_transform_bounds( &bounds, &mesh->bounds, world );
+
+	float3 d;
+	float3_sub( d, bounds.center, camera->position );
+	float distance = FT_MAX( float3_len( d ) - bounds.radius, camera->near );
+
+	float scale = FT_MAX( FT_MAX( float3_len( world[ 0 ] ),
+	                              float3_len( world[ 1 ] ) ),
+	                      float3_len( world[ 2 ] ) );
+
+	// world space error projected at nearest point of bounds
+	float k = scale * camera->projection[ 1 ][ 1 ] * 0.5f / distance;
+
+	uint32_t lod = 0;
+
+	for ( uint32_t l = 0; l < mesh->lod_count; ++l )
+	{
+		if ( mesh->lods[ l ].error * k > max_screen_error )
+		{
+			break;
+		}
+
+		lod = l + 1;
+	}
+
+	return lod;
+}
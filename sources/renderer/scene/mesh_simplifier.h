@@ -0,0 +1,39 @@
+#pragma once
+
+#include "base/base.h"
+#include "camera/camera.h"
+#include "model_loader.h"
+
+// collapses edges by quadric error until target index count is reached or
+// error would exceed target error, errors are relative to mesh extent.
+// attributes hold attribute count floats per vertex scaled by importance
+// and may be null. vertices on uv and normal seams slide along the seam
+// together with their twins. destination must hold index count indices,
+// returns new index count
+FT_API uint32_t
+ft_simplify_mesh_indices( uint32_t*       dst,
+                          const uint32_t* indices,
+                          uint32_t        index_count,
+                          const float*    positions,
+                          const float*    attributes,
+                          uint32_t        attribute_count,
+                          uint32_t        vertex_count,
+                          uint32_t        target_index_count,
+                          float           target_error,
+                          float*          result_error );
+
+// fills mesh lods, each level halves triangle count of previous one
+FT_API void
+ft_generate_mesh_lods( struct ft_mesh* mesh );
+
+FT_API void
+ft_free_mesh_lods( struct ft_mesh* mesh );
+
+// picks coarsest level whose error covers less than max screen error as
+// fraction of screen height, 0 is full mesh and i > 0 is lods[ i - 1 ].
+// world places mesh instance, e.g. one of mesh instance transforms
+FT_API uint32_t
+ft_select_mesh_lod( const struct ft_mesh*   mesh,
+                    const float4x4          world,
+                    const struct ft_camera* camera,
+                    float                   max_screen_error );
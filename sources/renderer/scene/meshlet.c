@@ -0,0 +1,340 @@
+#include <math.h>
+#include "meshlet.h"
+
+FT_INLINE uint32_t
+mesh_index( const struct ft_mesh* mesh, uint32_t i )
+{
+	if ( mesh->indices_16 )
+	{
+		return mesh->indices_16[ i ];
+	}
+
+	if ( mesh->indices_32 )
+	{
+		return mesh->indices_32[ i ];
+	}
+
+	return i;
+}
+
+FT_INLINE uint32_t
+mesh_index_count( const struct ft_mesh* mesh )
+{
+	return ( mesh->indices_16 || mesh->indices_32 ) ? mesh->index_count
+	                                                : mesh->vertex_count;
+}
+
+static void
+compute_meshlet_bounds( struct ft_meshlet*    meshlet,
+                        const struct ft_mesh* mesh,
+                        const uint32_t*       vertices,
+                        const uint8_t*        triangles )
+{
+	float3 min;
+	float3 max;
+	float3_dup( min, &mesh->positions[ vertices[ 0 ] * 3 ] );
+	float3_dup( max, min );
+
+	for ( uint32_t v = 1; v < meshlet->vertex_count; ++v )
+	{
+		const float* p = &mesh->positions[ vertices[ v ] * 3 ];
+		float3_min( min, min, p );
+		float3_max( max, max, p );
+	}
+
+	float3_add( meshlet->center, min, max );
+	float3_scale( meshlet->center, meshlet->center, 0.5f );
+
+	meshlet->radius = 0.0f;
+	for ( uint32_t v = 0; v < meshlet->vertex_count; ++v )
+	{
+		float3 d;
+		float3_sub( d, &mesh->positions[ vertices[ v ] * 3 ], meshlet->center );
+		meshlet->radius = FT_MAX( meshlet->radius, float3_len( d ) );
+	}
+
+	FT_ALLOC_STACK_ARRAY( float3, normals, meshlet->triangle_count );
+
+	float3 axis = { 0.0f, 0.0f, 0.0f };
+
+	for ( uint32_t t = 0; t < meshlet->triangle_count; ++t )
+	{
+		const float* p0 = &mesh->positions[ vertices[ triangles[ t * 3 ] ] * 3 ];
+		const float* p1 =
+		    &mesh->positions[ vertices[ triangles[ t * 3 + 1 ] ] * 3 ];
+		const float* p2 =
+		    &mesh->positions[ vertices[ triangles[ t * 3 + 2 ] ] * 3 ];
+
+		float3 e0, e1;
+		float3_sub( e0, p1, p0 );
+		float3_sub( e1, p2, p0 );
+		float3_mul_cross( normals[ t ], e0, e1 );
+
+		float len = float3_len( normals[ t ] );
+
+		if ( len > 0.0f )
+		{
+			float3_scale( normals[ t ], normals[ t ], 1.0f / len );
+		}
+
+		float3_add( axis, axis, normals[ t ] );
+	}
+
+	// cutoff of one never culls
+	float3_dup( meshlet->cone_apex, meshlet->center );
+	meshlet->cone_axis[ 0 ] = 0.0f;
+	meshlet->cone_axis[ 1 ] = 0.0f;
+	meshlet->cone_axis[ 2 ] = 1.0f;
+	meshlet->cone_cutoff = 1.0f;
+
+	float axis_len = float3_len( axis );
+
+	if ( axis_len == 0.0f )
+	{
+		return;
+	}
+
+	float3_scale( axis, axis, 1.0f / axis_len );
+
+	float min_dot = 1.0f;
+
+	for ( uint32_t t = 0; t < meshlet->triangle_count; ++t )
+	{
+		min_dot = FT_MIN( min_dot, float3_mul_inner( axis, normals[ t ] ) );
+	}
+
+	if ( min_dot <= 0.1f )
+	{
+		return;
+	}
+
+	// move apex back so every triangle plane lies in front of it
+	float max_t = 0.0f;
+
+	for ( uint32_t t = 0; t < meshlet->triangle_count; ++t )
+	{
+		const float* p0 = &mesh->positions[ vertices[ triangles[ t * 3 ] ] * 3 ];
+
+		float3 c;
+		float3_sub( c, meshlet->center, p0 );
+
+		float dc = float3_mul_inner( c, normals[ t ] );
+		float dn = float3_mul_inner( axis, normals[ t ] );
+
+		max_t = FT_MAX( max_t, dc / dn );
+	}
+
+	float3 offset;
+	float3_scale( offset, axis, max_t );
+	float3_sub( meshlet->cone_apex, meshlet->center, offset );
+	float3_dup( meshlet->cone_axis, axis );
+	meshlet->cone_cutoff = sqrtf( 1.0f - min_dot * min_dot );
+}
+
+void
+ft_build_meshlets( struct ft_mesh* mesh )
+{
+	FT_ASSERT( mesh );
+
+	if ( mesh->mapped )
+	{
+		FT_WARN( "mesh of baked model can not be resized" );
+		return;
+	}
+
+	ft_free_meshlets( &mesh->meshlets );
+
+	uint32_t index_count = mesh_index_count( mesh );
+
+	if ( index_count < 3 || mesh->positions == NULL )
+	{
+		return;
+	}
+
+	struct ft_meshlets* result         = &mesh->meshlets;
+	uint32_t            triangle_count = index_count / 3;
+
+	// upper bounds, arrays are shrunk once meshlets are built
+	uint32_t max_meshlets =
+	    ( triangle_count + FT_MESHLET_MAX_TRIANGLES - 1 ) /
+	        FT_MESHLET_MAX_TRIANGLES +
+	    index_count / FT_MESHLET_MAX_VERTICES + 1;
+
+	result->meshlets  = calloc( max_meshlets, sizeof( struct ft_meshlet ) );
+	result->vertices  = malloc( index_count * sizeof( uint32_t ) );
+	result->triangles = malloc( index_count * sizeof( uint8_t ) );
+
+	// local index of vertex in current meshlet, 0xff when not present
+	uint8_t* local = malloc( mesh->vertex_count );
+	memset( local, 0xff, mesh->vertex_count );
+
+	struct ft_meshlet* meshlet = &result->meshlets[ 0 ];
+
+	for ( uint32_t t = 0; t < triangle_count; ++t )
+	{
+		uint32_t a = mesh_index( mesh, t * 3 + 0 );
+		uint32_t b = mesh_index( mesh, t * 3 + 1 );
+		uint32_t c = mesh_index( mesh, t * 3 + 2 );
+
+		uint32_t new_vertices = ( local[ a ] == 0xff ) +
+		                        ( local[ b ] == 0xff && b != a ) +
+		                        ( local[ c ] == 0xff && c != a && c != b );
+
+		if ( meshlet->vertex_count + new_vertices > FT_MESHLET_MAX_VERTICES ||
+		     meshlet->triangle_count + 1 > FT_MESHLET_MAX_TRIANGLES )
+		{
+			for ( uint32_t v = 0; v < meshlet->vertex_count; ++v )
+			{
+				local[ result->vertices[ meshlet->vertex_offset + v ] ] = 0xff;
+			}
+
+			result->vertex_count += meshlet->vertex_count;
+			result->triangle_count += meshlet->triangle_count;
+
+			meshlet = &result->meshlets[ ++result->meshlet_count ];
+			meshlet->vertex_offset   = result->vertex_count;
+			meshlet->triangle_offset = result->triangle_count * 3;
+		}
+
+		uint32_t tri[ 3 ] = { a, b, c };
+
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			uint32_t v = tri[ k ];
+
+			if ( local[ v ] == 0xff )
+			{
+				local[ v ] = ( uint8_t ) meshlet->vertex_count;
+				result->vertices[ meshlet->vertex_offset +
+				                  meshlet->vertex_count++ ] = v;
+			}
+
+			result->triangles[ meshlet->triangle_offset +
+			                   meshlet->triangle_count * 3 + k ] = local[ v ];
+		}
+
+		meshlet->triangle_count++;
+	}
+
+	result->vertex_count += meshlet->vertex_count;
+	result->triangle_count += meshlet->triangle_count;
+	result->meshlet_count++;
+
+	free( local );
+
+	result->meshlets  = realloc( result->meshlets,
+                                result->meshlet_count *
+                                    sizeof( struct ft_meshlet ) );
+	result->vertices  = realloc( result->vertices,
+                                result->vertex_count * sizeof( uint32_t ) );
+	result->triangles = realloc( result->triangles, result->triangle_count * 3 );
+
+	for ( uint32_t m = 0; m < result->meshlet_count; ++m )
+	{
+		struct ft_meshlet* it = &result->meshlets[ m ];
+
+		compute_meshlet_bounds( it,
+		                        mesh,
+		                        &result->vertices[ it->vertex_offset ],
+		                        &result->triangles[ it->triangle_offset ] );
+	}
+}
+
+void
+ft_free_meshlets( struct ft_meshlets* meshlets )
+{
+	ft_safe_free( meshlets->meshlets );
+	ft_safe_free( meshlets->vertices );
+	ft_safe_free( meshlets->triangles );
+	memset( meshlets, 0, sizeof( struct ft_meshlets ) );
+}
+
+FT_INLINE void
+transform_point( float3 r, const float4x4 m, const float3 p )
+{
+	float4 v = { p[ 0 ], p[ 1 ], p[ 2 ], 1.0f };
+	float4 t;
+	float4x4_mul_float4( t, m, v );
+	float3_dup( r, t );
+}
+
+bool
+ft_meshlet_is_visible( const struct ft_meshlet* meshlet,
+                       const float4x4           world,
+                       const struct ft_frustum* frustum,
+                       const float3             camera_position )
+{
+	float3 center;
+	transform_point( center, world, meshlet->center );
+
+	float scale = FT_MAX( FT_MAX( float3_len( world[ 0 ] ),
+	                              float3_len( world[ 1 ] ) ),
+	                      float3_len( world[ 2 ] ) );
+
+	if ( frustum &&
+	     !ft_frustum_test_sphere( frustum, center, meshlet->radius * scale ) )
+	{
+		return false;
+	}
+
+	if ( meshlet->cone_cutoff >= 1.0f )
+	{
+		return true;
+	}
+
+	float3 apex;
+	transform_point( apex, world, meshlet->cone_apex );
+
+	float4 axis = { meshlet->cone_axis[ 0 ],
+	                meshlet->cone_axis[ 1 ],
+	                meshlet->cone_axis[ 2 ],
+	                0.0f };
+	float4 world_axis;
+	float4x4_mul_float4( world_axis, world, axis );
+	float3_norm( world_axis, world_axis );
+
+	float3 view;
+	float3_sub( view, apex, camera_position );
+	float len = float3_len( view );
+
+	if ( len == 0.0f )
+	{
+		return true;
+	}
+
+	return float3_mul_inner( view, world_axis ) < meshlet->cone_cutoff * len;
+}
+
+uint32_t
+ft_cull_meshlets( const struct ft_mesh*    mesh,
+                  const float4x4           world,
+                  const struct ft_camera*  camera,
+                  const struct ft_frustum* frustum,
+                  uint32_t*                visible_meshlets )
+{
+	uint32_t visible_count = 0;
+
+	if ( frustum )
+	{
+		struct ft_bounds bounds;
+		ft_transform_bounds( &bounds, &mesh->bounds, world );
+
+		if ( !ft_frustum_test_sphere( frustum, bounds.center, bounds.radius ) )
+		{
+			return 0;
+		}
+	}
+
+	for ( uint32_t m = 0; m < mesh->meshlets.meshlet_count; ++m )
+	{
+		if ( ft_meshlet_is_visible( &mesh->meshlets.meshlets[ m ],
+		                            world,
+		                            frustum,
+		                            camera->position ) )
+		{
+			visible_meshlets[ visible_count++ ] = m;
+		}
+	}
+
+	return visible_count;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "base/base.h"
+#include "camera/camera.h"
+#include "model_loader.h"
+
+#define FT_MESHLET_MAX_VERTICES  64
+#define FT_MESHLET_MAX_TRIANGLES 124
+
+FT_API void
+ft_build_meshlets( struct ft_mesh* mesh );
+
+FT_API void
+ft_free_meshlets( struct ft_meshlets* meshlets );
+
+// tests meshlet against frustum and its normal cone against camera position,
+// world transforms meshlet from mesh space
+FT_API bool
+ft_meshlet_is_visible( const struct ft_meshlet* meshlet,
+                       const float4x4           world,
+                       const struct ft_frustum* frustum,
+                       const float3             camera_position );
+
+// writes indices of visible meshlets of one mesh instance placed by world,
+// e.g. one of mesh instance transforms, and returns their count
+FT_API uint32_t
+ft_cull_meshlets( const struct ft_mesh*    mesh,
+                  const float4x4           world,
+                  const struct ft_camera*  camera,
+                  const struct ft_frustum* frustum,
+                  uint32_t*                visible_meshlets );
@@ -0,0 +1,591 @@
+#include <math.h>
+#include "math/linear.h"
+#include "meshopt_decoder.h"
+
+#define VERTEX_HEADER        0xa0
+#define TRIANGLES_HEADER     0xe0
+#define INDICES_HEADER       0xd0
+#define VERTEX_BLOCK_BYTES   8192
+#define VERTEX_BLOCK_MAX     256
+#define BYTE_GROUP_SIZE      16
+// largest byte group is 4 header and 16 value bytes
+#define BYTE_GROUP_MAX_BYTES 24
+#define VERTEX_TAIL_MIN      32
+#define TRIANGLES_TAIL_SIZE  16
+#define INDICES_TAIL_SIZE    4
+#define FIFO_SIZE            16
+
+FT_INLINE uint8_t
+unzigzag8( uint8_t v )
+{
+	return ( uint8_t ) ( -( v & 1 ) ^ ( v >> 1 ) );
+}
+
+FT_INLINE uint32_t
+unzigzag32( uint32_t v )
+{
+	return ( v >> 1 ) ^ ( uint32_t ) - ( int32_t ) ( v & 1 );
+}
+
+// values of byte group are packed msb first in 2 or 4 bits, all ones
+// value is escape to next full byte after packed ones
+static const uint8_t*
+decode_byte_group( const uint8_t* data, uint8_t* dst, uint32_t bits_log2 )
+{
+	if ( bits_log2 == 0 )
+	{
+		memset( dst, 0, BYTE_GROUP_SIZE );
+		return data;
+	}
+
+	if ( bits_log2 == 3 )
+	{
+		memcpy( dst, data, BYTE_GROUP_SIZE );
+		return data + BYTE_GROUP_SIZE;
+	}
+
+	uint32_t       bits     = 1u << bits_log2;
+	uint32_t       sentinel = ( 1u << bits ) - 1;
+	uint32_t       per_byte = 8 / bits;
+	const uint8_t* escapes  = data + BYTE_GROUP_SIZE / per_byte;
+
+	for ( uint32_t i = 0; i < BYTE_GROUP_SIZE; i += per_byte )
+	{
+		uint8_t byte = *data++;
+
+		for ( uint32_t k = 0; k < per_byte; ++k )
+		{
+			uint8_t v = byte >> ( 8 - bits );
+			byte      = ( uint8_t ) ( byte << bits );
+
+			dst[ i + k ] = v == sentinel ? *escapes++ : v;
+		}
+	}
+
+	return escapes;
+}
+
+// one byte of every vertex in block, two bit width of every group is
+// stored in header in front of groups
+static const uint8_t*
+decode_bytes( const uint8_t* data,
+              const uint8_t* end,
+              uint8_t*       dst,
+              uint32_t       count )
+{
+	const uint8_t* header      = data;
+	uint32_t       header_size = ( count / BYTE_GROUP_SIZE + 3 ) / 4;
+
+	if ( ( uint64_t ) ( end - data ) < header_size )
+	{
+		return NULL;
+	}
+
+	data += header_size;
+
+	for ( uint32_t i = 0; i < count; i += BYTE_GROUP_SIZE )
+	{
+		if ( ( uint64_t ) ( end - data ) < BYTE_GROUP_MAX_BYTES )
+		{
+			return NULL;
+		}
+
+		uint32_t group     = i / BYTE_GROUP_SIZE;
+		uint32_t bits_log2 = ( header[ group / 4 ] >> ( group % 4 * 2 ) ) & 3;
+
+		data = decode_byte_group( data, dst + i, bits_log2 );
+	}
+
+	return data;
+}
+
+// bytes are delta coded against same byte of previous vertex
+static const uint8_t*
+decode_vertex_block( const uint8_t* data,
+                     const uint8_t* end,
+                     uint8_t*       dst,
+                     uint32_t       vertex_count,
+                     uint32_t       vertex_size,
+                     uint8_t*       last_vertex )
+{
+	uint8_t  deltas[ VERTEX_BLOCK_MAX ];
+	uint32_t aligned_count = ( vertex_count + BYTE_GROUP_SIZE - 1 ) &
+	                         ~( uint32_t ) ( BYTE_GROUP_SIZE - 1 );
+
+	for ( uint32_t k = 0; k < vertex_size; ++k )
+	{
+		data = decode_bytes( data, end, deltas, aligned_count );
+
+		if ( data == NULL )
+		{
+			return NULL;
+		}
+
+		uint8_t p = last_vertex[ k ];
+
+		for ( uint32_t i = 0; i < vertex_count; ++i )
+		{
+			p = ( uint8_t ) ( p + unzigzag8( deltas[ i ] ) );
+			dst[ i * vertex_size + k ] = p;
+		}
+
+		last_vertex[ k ] = p;
+	}
+
+	return data;
+}
+
+static bool
+decode_vertices( uint8_t*       dst,
+                 uint64_t       vertex_count,
+                 uint32_t       vertex_size,
+                 const uint8_t* src,
+                 uint64_t       size )
+{
+	if ( vertex_size == 0 || vertex_size > 256 || vertex_size % 4 != 0 ||
+	     size < 1 + vertex_size || src[ 0 ] != VERTEX_HEADER )
+	{
+		return false;
+	}
+
+	const uint8_t* data = src + 1;
+	const uint8_t* end  = src + size;
+
+	// first vertex is stored in tail as baseline of first block
+	uint8_t last_vertex[ 256 ];
+	memcpy( last_vertex, end - vertex_size, vertex_size );
+
+	uint32_t block_size = ( VERTEX_BLOCK_BYTES / vertex_size ) &
+	                      ~( uint32_t ) ( BYTE_GROUP_SIZE - 1 );
+	block_size          = FT_MIN( block_size, VERTEX_BLOCK_MAX );
+
+	for ( uint64_t v = 0; v < vertex_count; v += block_size )
+	{
+		uint32_t count =
+		    ( uint32_t ) FT_MIN( ( uint64_t ) block_size, vertex_count - v );
+
+		data = decode_vertex_block( data,
+		                            end,
+		                            dst + v * vertex_size,
+		                            count,
+		                            vertex_size,
+		                            last_vertex );
+
+		if ( data == NULL )
+		{
+			return false;
+		}
+	}
+
+	uint64_t tail_size = FT_MAX( vertex_size, VERTEX_TAIL_MIN );
+
+	return ( uint64_t ) ( end - data ) == tail_size;
+}
+
+// little endian base 128, at most five bytes
+static uint32_t
+decode_vbyte( const uint8_t** data )
+{
+	const uint8_t* p    = *data;
+	uint8_t        lead = *p++;
+	uint32_t       v    = lead & 127;
+
+	if ( lead >= 128 )
+	{
+		for ( uint32_t i = 0, shift = 7; i < 4; ++i, shift += 7 )
+		{
+			uint8_t group = *p++;
+			v |= ( uint32_t ) ( group & 127 ) << shift;
+
+			if ( group < 128 )
+			{
+				break;
+			}
+		}
+	}
+
+	*data = p;
+
+	return v;
+}
+
+FT_INLINE uint32_t
+decode_index( const uint8_t** data, uint32_t last )
+{
+	return last + unzigzag32( decode_vbyte( data ) );
+}
+
+FT_INLINE void
+write_index( void* dst, uint64_t i, uint32_t index_size, uint32_t index )
+{
+	if ( index_size == 2 )
+	{
+		( ( uint16_t* ) dst )[ i ] = ( uint16_t ) index;
+	}
+	else
+	{
+		( ( uint32_t* ) dst )[ i ] = index;
+	}
+}
+
+struct index_fifos
+{
+	uint32_t edges[ FIFO_SIZE ][ 2 ];
+	uint32_t edge_offset;
+	uint32_t vertices[ FIFO_SIZE ];
+	uint32_t vertex_offset;
+};
+
+FT_INLINE void
+push_edge( struct index_fifos* f, uint32_t a, uint32_t b )
+{
+	f->edges[ f->edge_offset ][ 0 ] = a;
+	f->edges[ f->edge_offset ][ 1 ] = b;
+	f->edge_offset                  = ( f->edge_offset + 1 ) % FIFO_SIZE;
+}
+
+FT_INLINE void
+push_vertex( struct index_fifos* f, uint32_t v, bool cond )
+{
+	f->vertices[ f->vertex_offset ] = v;
+	f->vertex_offset                = ( f->vertex_offset + cond ) % FIFO_SIZE;
+}
+
+FT_INLINE uint32_t
+fifo_vertex( const struct index_fifos* f, uint32_t back )
+{
+	return f->vertices[ ( f->vertex_offset - back ) % FIFO_SIZE ];
+}
+
+// every triangle is one code byte, either reusing an edge from edge fifo
+// plus a vertex, or three vertices described by aux byte. new vertices
+// come from running counter, others from vertex fifo or delta coded
+// free indices
+static bool
+decode_triangles( void*          dst,
+                  uint64_t       index_count,
+                  uint32_t       index_size,
+                  const uint8_t* src,
+                  uint64_t       size )
+{
+	if ( index_count % 3 != 0 || ( index_size != 2 && index_size != 4 ) ||
+	     size < 1 + index_count / 3 + TRIANGLES_TAIL_SIZE ||
+	     ( src[ 0 ] & 0xf0 ) != TRIANGLES_HEADER || ( src[ 0 ] & 0x0f ) > 1 )
+	{
+		return false;
+	}
+
+	struct index_fifos f;
+	memset( &f, 0xff, sizeof( f ) );
+	f.edge_offset   = 0;
+	f.vertex_offset = 0;
+
+	uint32_t next = 0;
+	uint32_t last = 0;
+	// version 1 codes last index plus or minus one in fec 13 and 14
+	uint32_t fec_max = ( src[ 0 ] & 0x0f ) >= 1 ? 13 : 15;
+
+	const uint8_t* code      = src + 1;
+	const uint8_t* data      = code + index_count / 3;
+	const uint8_t* data_end  = src + size - TRIANGLES_TAIL_SIZE;
+	const uint8_t* aux_table = data_end;
+
+	for ( uint64_t i = 0; i < index_count; i += 3 )
+	{
+		// triangle reads at most 16 bytes, tail keeps reads in bounds
+		if ( data > data_end )
+		{
+			return false;
+		}
+
+		uint8_t  code_tri = *code++;
+		uint32_t a, b, c;
+
+		if ( code_tri < 0xf0 )
+		{
+			uint32_t edge =
+			    ( f.edge_offset - 1 - ( code_tri >> 4 ) ) % FIFO_SIZE;
+			uint32_t fec  = code_tri & 15;
+
+			a = f.edges[ edge ][ 0 ];
+			b = f.edges[ edge ][ 1 ];
+
+			if ( fec < fec_max )
+			{
+				c = fec == 0 ? next++ : fifo_vertex( &f, 1 + fec );
+				push_vertex( &f, c, fec == 0 );
+			}
+			else
+			{
+				// 13 and 14 decode into -1 and 1
+				c = fec != 15 ? last + ( fec - ( fec ^ 3 ) )
+				              : decode_index( &data, last );
+				last = c;
+				push_vertex( &f, c, true );
+			}
+
+			push_edge( &f, c, b );
+			push_edge( &f, a, c );
+		}
+		else
+		{
+			uint32_t fea, feb, fec;
+
+			if ( code_tri < 0xfe )
+			{
+				uint8_t aux = aux_table[ code_tri & 15 ];
+				fea         = 0;
+				feb         = aux >> 4;
+				fec         = aux & 15;
+			}
+			else
+			{
+				uint8_t aux = *data++;
+				fea         = code_tri == 0xfe ? 0 : 15;
+				feb         = aux >> 4;
+				fec         = aux & 15;
+
+				// zero aux outside of table restarts vertex counter
+				if ( aux == 0 )
+				{
+					next = 0;
+				}
+			}
+
+			// every new vertex takes counter before free indices are read
+			a = fea == 0 ? next++ : 0;
+			b = feb == 0 ? next++ : fifo_vertex( &f, feb );
+			c = fec == 0 ? next++ : fifo_vertex( &f, fec );
+
+			if ( fea == 15 )
+			{
+				last = a = decode_index( &data, last );
+			}
+			if ( feb == 15 )
+			{
+				last = b = decode_index( &data, last );
+			}
+			if ( fec == 15 )
+			{
+				last = c = decode_index( &data, last );
+			}
+
+			push_vertex( &f, a, true );
+			push_vertex( &f, b, feb == 0 || feb == 15 );
+			push_vertex( &f, c, fec == 0 || fec == 15 );
+			push_edge( &f, b, a );
+			push_edge( &f, c, b );
+			push_edge( &f, a, c );
+		}
+
+		write_index( dst, i + 0, index_size, a );
+		write_index( dst, i + 1, index_size, b );
+		write_index( dst, i + 2, index_size, c );
+	}
+
+	return data == data_end;
+}
+
+// every index is delta against one of two previous indices, low bit of
+// code selects which
+static bool
+decode_indices( void*          dst,
+                uint64_t       index_count,
+                uint32_t       index_size,
+                const uint8_t* src,
+                uint64_t       size )
+{
+	if ( ( index_size != 2 && index_size != 4 ) ||
+	     size < 1 + index_count + INDICES_TAIL_SIZE ||
+	     ( src[ 0 ] & 0xf0 ) != INDICES_HEADER || ( src[ 0 ] & 0x0f ) > 1 )
+	{
+		return false;
+	}
+
+	const uint8_t* data     = src + 1;
+	const uint8_t* data_end = src + size - INDICES_TAIL_SIZE;
+	uint32_t       last[ 2 ] = { 0, 0 };
+
+	for ( uint64_t i = 0; i < index_count; ++i )
+	{
+		// index reads at most 5 bytes, tail keeps reads in bounds
+		if ( data >= data_end )
+		{
+			return false;
+		}
+
+		uint32_t v       = decode_vbyte( &data );
+		uint32_t current = v & 1;
+		uint32_t index   = last[ current ] + unzigzag32( v >> 1 );
+
+		last[ current ] = index;
+		write_index( dst, i, index_size, index );
+	}
+
+	return data == data_end;
+}
+
+FT_INLINE int32_t
+round_to_int( float v )
+{
+	return ( int32_t ) ( v + ( v >= 0.0f ? 0.5f : -0.5f ) );
+}
+
+// snorm x and y on octahedron, z holds encoded one so any bit count works
+static void
+filter_octahedral( void* data, uint64_t count, uint32_t stride )
+{
+	int8_t*  data8  = data;
+	int16_t* data16 = data;
+	float    max    = stride == 4 ? 127.0f : 32767.0f;
+
+	for ( uint64_t i = 0; i < count * 4; i += 4 )
+	{
+		float3 n;
+
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			n[ k ] = stride == 4 ? data8[ i + k ] : data16[ i + k ];
+		}
+
+		n[ 2 ] = n[ 2 ] - fabsf( n[ 0 ] ) - fabsf( n[ 1 ] );
+
+		// unfold lower hemisphere
+		float t = FT_MIN( n[ 2 ], 0.0f );
+		n[ 0 ] += n[ 0 ] >= 0.0f ? t : -t;
+		n[ 1 ] += n[ 1 ] >= 0.0f ? t : -t;
+
+		float s = max / float3_len( n );
+
+		for ( uint32_t k = 0; k < 3; ++k )
+		{
+			int32_t v = round_to_int( n[ k ] * s );
+
+			if ( stride == 4 )
+			{
+				data8[ i + k ] = ( int8_t ) v;
+			}
+			else
+			{
+				data16[ i + k ] = ( int16_t ) v;
+			}
+		}
+	}
+}
+
+// three smallest components scaled by sqrt 2, largest one is rebuilt from
+// unit length. low two bits of fourth component tell its position, rest of
+// them scale of others
+static void
+filter_quaternion( int16_t* data, uint64_t count )
+{
+	const float scale = 1.0f / sqrtf( 2.0f );
+
+	for ( uint64_t i = 0; i < count * 4; i += 4 )
+	{
+		int32_t sf = data[ i + 3 ] | 3;
+		float   ss = scale / ( float ) sf;
+
+		float x  = data[ i + 0 ] * ss;
+		float y  = data[ i + 1 ] * ss;
+		float z  = data[ i + 2 ] * ss;
+		float ww = 1.0f - x * x - y * y - z * z;
+		float w  = sqrtf( FT_MAX( ww, 0.0f ) );
+
+		uint32_t qc = data[ i + 3 ] & 3;
+
+		data[ i + ( ( qc + 1 ) & 3 ) ] = ( int16_t ) round_to_int( x * 32767.0f );
+		data[ i + ( ( qc + 2 ) & 3 ) ] = ( int16_t ) round_to_int( y * 32767.0f );
+		data[ i + ( ( qc + 3 ) & 3 ) ] = ( int16_t ) round_to_int( z * 32767.0f );
+		data[ i + ( ( qc + 0 ) & 3 ) ] = ( int16_t ) round_to_int( w * 32767.0f );
+	}
+}
+
+// 24 bit signed mantissa and 8 bit signed exponent into float
+static void
+filter_exponential( uint32_t* data, uint64_t count )
+{
+	for ( uint64_t i = 0; i < count; ++i )
+	{
+		int32_t m = ( int32_t ) ( data[ i ] << 8 ) >> 8;
+		int32_t e = ( int32_t ) data[ i ] >> 24;
+
+		union
+		{
+			float    f;
+			uint32_t u;
+		} v;
+
+		v.u = ( uint32_t ) ( e + 127 ) << 23;
+		v.f = v.f * ( float ) m;
+
+		data[ i ] = v.u;
+	}
+}
+
+bool
+ft_decode_meshopt_buffer( void*                  dst,
+                          uint64_t               count,
+                          uint32_t               stride,
+                          enum ft_meshopt_mode   mode,
+                          enum ft_meshopt_filter filter,
+                          const uint8_t*         src,
+                          uint64_t               size )
+{
+	FT_ASSERT( dst );
+	FT_ASSERT( src );
+
+	switch ( mode )
+	{
+	case FT_MESHOPT_MODE_ATTRIBUTES:
+	{
+		if ( !decode_vertices( dst, count, stride, src, size ) )
+		{
+			return false;
+		}
+		break;
+	}
+	case FT_MESHOPT_MODE_TRIANGLES:
+	{
+		return filter == FT_MESHOPT_FILTER_NONE &&
+		       decode_triangles( dst, count, stride, src, size );
+	}
+	case FT_MESHOPT_MODE_INDICES:
+	{
+		return filter == FT_MESHOPT_FILTER_NONE &&
+		       decode_indices( dst, count, stride, src, size );
+	}
+	default: return false;
+	}
+
+	switch ( filter )
+	{
+	case FT_MESHOPT_FILTER_NONE: return true;
+	case FT_MESHOPT_FILTER_OCTAHEDRAL:
+	{
+		if ( stride != 4 && stride != 8 )
+		{
+			return false;
+		}
+
+		filter_octahedral( dst, count, stride );
+		return true;
+	}
+	case FT_MESHOPT_FILTER_QUATERNION:
+	{
+		if ( stride != 8 )
+		{
+			return false;
+		}
+
+		filter_quaternion( dst, count );
+		return true;
+	}
+	case FT_MESHOPT_FILTER_EXPONENTIAL:
+	{
+		filter_exponential( dst, count * stride / 4 );
+		return true;
+	}
+	default: return false;
+	}
+}
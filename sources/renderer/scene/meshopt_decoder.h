@@ -0,0 +1,31 @@
+#pragma once
+
+#include "base/base.h"
+
+// layouts of EXT_meshopt_compression buffer views
+enum ft_meshopt_mode
+{
+	FT_MESHOPT_MODE_ATTRIBUTES,
+	FT_MESHOPT_MODE_TRIANGLES,
+	FT_MESHOPT_MODE_INDICES,
+};
+
+enum ft_meshopt_filter
+{
+	FT_MESHOPT_FILTER_NONE,
+	FT_MESHOPT_FILTER_OCTAHEDRAL,
+	FT_MESHOPT_FILTER_QUATERNION,
+	FT_MESHOPT_FILTER_EXPONENTIAL,
+};
+
+// decodes count elements of stride bytes into dst and applies filter to
+// them, dst must hold count * stride bytes. returns false on malformed or
+// unsupported stream
+FT_API bool
+ft_decode_meshopt_buffer( void*                  dst,
+                          uint64_t               count,
+                          uint32_t               stride,
+                          enum ft_meshopt_mode   mode,
+                          enum ft_meshopt_filter filter,
+                          const uint8_t*         src,
+                          uint64_t               size );
@@ -0,0 +1,418 @@
+#include <math.h>
+#include "math/simd.h"
+#include "mip_generator.h"
+
+#define ROWS_PER_TASK     16
+#define BOX_RADIUS        0.5f
+#define KAISER_RADIUS     3.0f
+#define KAISER_ALPHA      4.0f
+#define MAX_ALPHA_SCALE   4.0f
+#define ALPHA_SCALE_STEPS 16
+
+// source taps of every destination coordinate along one axis, taps past
+// image edge are clamped to it
+struct filter_weights
+{
+	uint32_t  tap_count;
+	uint32_t* indices;
+	float*    weights;
+};
+
+struct downsample_task
+{
+	const float*                 src;
+	uint32_t                     src_width;
+	float*                       dst;
+	uint32_t                     dst_width;
+	const struct filter_weights* horizontal;
+	const struct filter_weights* vertical;
+	uint32_t                     first_row;
+	uint32_t                     row_count;
+};
+
+static float
+bessel_i0( float x )
+{
+	float sum  = 1.0f;
+	float term = 1.0f;
+
+	for ( uint32_t k = 1; k < 16; ++k )
+	{
+		float t = x / ( 2.0f * k );
+		term *= t * t;
+		sum += term;
+	}
+
+	return sum;
+}
+
+// d is distance in destination pixels
+static float
+filter_weight( enum ft_mip_filter filter, float d )
+{
+	if ( filter == FT_MIP_FILTER_BOX )
+	{
+		return fabsf( d ) < BOX_RADIUS ? 1.0f : 0.0f;
+	}
+
+	if ( fabsf( d ) >= KAISER_RADIUS )
+	{
+		return 0.0f;
+	}
+
+	float x    = ( float ) M_PI * d;
+	float sinc = d == 0.0f ? 1.0f : sinf( x ) / x;
+	float r    = d / KAISER_RADIUS;
+
+	return sinc * bessel_i0( KAISER_ALPHA * sqrtf( 1.0f - r * r ) ) /
+	       bessel_i0( KAISER_ALPHA );
+}
+
+static void
+compute_filter_weights( struct filter_weights* w,
+                        enum ft_mip_filter     filter,
+                        uint32_t               src_size,
+                        uint32_t               dst_size )
+{
+	float scale = ( float ) src_size / dst_size;
+	float radius =
+	    ( filter == FT_MIP_FILTER_BOX ? BOX_RADIUS : KAISER_RADIUS ) * scale;
+
+	w->tap_count = ( uint32_t ) ceilf( radius * 2.0f ) + 1;
+	w->indices   = malloc( dst_size * w->tap_count * sizeof( uint32_t ) );
+	w->weights   = malloc( dst_size * w->tap_count * sizeof( float ) );
+
+	for ( uint32_t x = 0; x < dst_size; ++x )
+	{
+		float   center = ( x + 0.5f ) * scale;
+		int32_t first  = ( int32_t ) floorf( center - radius );
+		float   sum    = 0.0f;
+
+		uint32_t* indices = &w->indices[ x * w->tap_count ];
+		float*    weights = &w->weights[ x * w->tap_count ];
+
+		for ( uint32_t t = 0; t < w->tap_count; ++t )
+		{
+			int32_t i = first + ( int32_t ) t;
+
+			indices[ t ] = FT_MIN( FT_MAX( i, 0 ), ( int32_t ) src_size - 1 );
+			weights[ t ] =
+			    filter_weight( filter, ( i + 0.5f - center ) / scale );
+			sum += weights[ t ];
+		}
+
+		for ( uint32_t t = 0; t < w->tap_count && sum != 0.0f; ++t )
+		{
+			weights[ t ] /= sum;
+		}
+	}
+}
+
+static void
+free_filter_weights( struct filter_weights* w )
+{
+	free( w->indices );
+	free( w->weights );
+}
+
+// filters source rows into one row first, then filters that row
+// horizontally. pixels are rgba floats so every pixel fills one simd register
+static void
+downsample_rows( const struct downsample_task* task )
+{
+	uint32_t src_stride = task->src_width * 4;
+	float*   row        = malloc( src_stride * sizeof( float ) );
+
+	const struct filter_weights* h = task->horizontal;
+	const struct filter_weights* v = task->vertical;
+
+	ft_simd4 zero = ft_simd4_zero();
+	ft_simd4 one  = ft_simd4_splat( 1.0f );
+
+	for ( uint32_t y = task->first_row; y < task->first_row + task->row_count;
+	      ++y )
+	{
+		memset( row, 0, src_stride * sizeof( float ) );
+
+		for ( uint32_t t = 0; t < v->tap_count; ++t )
+		{
+			float weight = v->weights[ y * v->tap_count + t ];
+
+			if ( weight == 0.0f )
+			{
+				continue;
+			}
+
+			const float* src =
+			    task->src +
+			    ( uint64_t ) v->indices[ y * v->tap_count + t ] * src_stride;
+			ft_simd4 w = ft_simd4_splat( weight );
+
+			for ( uint32_t i = 0; i < src_stride; i += 4 )
+			{
+				ft_simd4 sum = ft_simd4_load( &row[ i ] );
+				ft_simd4 s   = ft_simd4_load( &src[ i ] );
+				ft_simd4_store( &row[ i ], ft_simd4_madd( w, s, sum ) );
+			}
+		}
+
+		float* dst = task->dst + ( uint64_t ) y * task->dst_width * 4;
+
+		for ( uint32_t x = 0; x < task->dst_width; ++x )
+		{
+			ft_simd4 sum = ft_simd4_zero();
+
+			for ( uint32_t t = 0; t < h->tap_count; ++t )
+			{
+				uint32_t tap = x * h->tap_count + t;
+				ft_simd4 w   = ft_simd4_splat( h->weights[ tap ] );
+				ft_simd4 s   = ft_simd4_load( &row[ h->indices[ tap ] * 4 ] );
+
+				sum = ft_simd4_madd( w, s, sum );
+			}
+
+			// kaiser lobes may overshoot
+			sum = ft_simd4_min( ft_simd4_max( sum, zero ), one );
+			ft_simd4_store( &dst[ x * 4 ], sum );
+		}
+	}
+
+	free( row );
+}
+
+static void
+downsample_task_fun( void* arg )
+{
+	downsample_rows( arg );
+}
+
+FT_INLINE float
+srgb_to_linear( float v )
+{
+	return v <= 0.04045f ? v / 12.92f : powf( ( v + 0.055f ) / 1.055f, 2.4f );
+}
+
+FT_INLINE float
+linear_to_srgb( float v )
+{
+	return v <= 0.0031308f ? v * 12.92f
+	                       : 1.055f * powf( v, 1.0f / 2.4f ) - 0.055f;
+}
+
+static float
+alpha_coverage( const float* pixels,
+                uint64_t     pixel_count,
+                float        alpha_cutoff,
+                float        scale )
+{
+	uint64_t covered = 0;
+
+	// compare alpha as it will be stored
+	for ( uint64_t p = 0; p < pixel_count; ++p )
+	{
+		float alpha = FT_MIN( pixels[ p * 4 + 3 ] * scale, 1.0f );
+		covered += floorf( alpha * 255.0f + 0.5f ) > alpha_cutoff * 255.0f;
+	}
+
+	return ( float ) covered / pixel_count;
+}
+
+// scale which brings level coverage closest to coverage of top level
+static float
+find_alpha_scale( const float* pixels,
+                  uint64_t     pixel_count,
+                  float        alpha_cutoff,
+                  float        coverage )
+{
+	float low  = 0.0f;
+	float high = MAX_ALPHA_SCALE;
+
+	for ( uint32_t step = 0; step < ALPHA_SCALE_STEPS; ++step )
+	{
+		float middle = ( low + high ) * 0.5f;
+
+		if ( alpha_coverage( pixels, pixel_count, alpha_cutoff, middle ) <
+		     coverage )
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return ( low + high ) * 0.5f;
+}
+
+uint32_t
+ft_get_mip_count( uint32_t width, uint32_t height )
+{
+	uint32_t count = 1;
+	uint32_t size  = FT_MAX( width, height );
+
+	while ( size > 1 )
+	{
+		size >>= 1;
+		count++;
+	}
+
+	return count;
+}
+
+bool
+ft_generate_texture_mips( struct ft_texture*     texture,
+                          enum ft_mip_filter     filter,
+                          float                  alpha_cutoff,
+                          struct ft_thread_pool* pool )
+{
+	FT_ASSERT( texture );
+
+	if ( texture->mapped )
+	{
+		FT_WARN( "texture of baked model can not be replaced" );
+		return false;
+	}
+
+	bool srgb = texture->format == FT_FORMAT_R8G8B8A8_SRGB;
+
+	if ( texture->data == NULL ||
+	     ( !srgb && texture->format != FT_FORMAT_R8G8B8A8_UNORM ) )
+	{
+		return false;
+	}
+
+	struct ft_texture result = *texture;
+	result.mip_levels = ft_get_mip_count( texture->width, texture->height );
+
+	if ( result.mip_levels == texture->mip_levels )
+	{
+		return true;
+	}
+
+	uint8_t* data =
+	    malloc( ft_texture_mip_offset( &result, result.mip_levels ) );
+	memcpy( data, texture->data, ft_texture_mip_offset( texture, 1 ) );
+
+	float to_color[ 256 ];
+
+	for ( uint32_t v = 0; v < 256; ++v )
+	{
+		to_color[ v ] = srgb ? srgb_to_linear( v / 255.0f ) : v / 255.0f;
+	}
+
+	// every level is filtered from previous one in float to avoid
+	// accumulating quantization error
+	uint64_t pixel_count = ( uint64_t ) texture->width * texture->height;
+	uint64_t mip1_count  = ( uint64_t ) FT_MAX( texture->width >> 1, 1 ) *
+	                      FT_MAX( texture->height >> 1, 1 );
+	float*   src         = malloc( pixel_count * 4 * sizeof( float ) );
+	float*   dst         = malloc( mip1_count * 4 * sizeof( float ) );
+
+	for ( uint64_t i = 0; i < pixel_count * 4; ++i )
+	{
+		src[ i ] = i % 4 == 3 ? data[ i ] / 255.0f : to_color[ data[ i ] ];
+	}
+
+	float coverage = alpha_cutoff > 0.0f ? alpha_coverage( src,
+	                                                       pixel_count,
+	                                                       alpha_cutoff,
+	                                                       1.0f )
+	                                     : 0.0f;
+
+	uint32_t                src_width  = texture->width;
+	uint32_t                src_height = texture->height;
+	struct downsample_task* tasks =
+	    malloc( ( texture->height / ROWS_PER_TASK + 1 ) *
+	            sizeof( struct downsample_task ) );
+
+	for ( uint32_t mip = 1; mip < result.mip_levels; ++mip )
+	{
+		uint32_t dst_width  = FT_MAX( src_width >> 1, 1 );
+		uint32_t dst_height = FT_MAX( src_height >> 1, 1 );
+
+		struct filter_weights horizontal;
+		struct filter_weights vertical;
+		compute_filter_weights( &horizontal, filter, src_width, dst_width );
+		compute_filter_weights( &vertical, filter, src_height, dst_height );
+
+		uint32_t rows_per_task = pool ? ROWS_PER_TASK : dst_height;
+		uint32_t task_count    = 0;
+
+		struct ft_task_group group = { 0 };
+
+		for ( uint32_t row = 0; row < dst_height; row += rows_per_task )
+		{
+			struct downsample_task* task = &tasks[ task_count++ ];
+
+			task->src        = src;
+			task->src_width  = src_width;
+			task->dst        = dst;
+			task->dst_width  = dst_width;
+			task->horizontal = &horizontal;
+			task->vertical   = &vertical;
+			task->first_row  = row;
+			task->row_count  = FT_MIN( rows_per_task, dst_height - row );
+
+			if ( pool )
+			{
+				ft_thread_pool_push_group( pool,
+				                           &group,
+				                           downsample_task_fun,
+				                           task );
+			}
+			else
+			{
+				downsample_rows( task );
+			}
+		}
+
+		if ( pool )
+		{
+			ft_thread_pool_wait_group( pool, &group );
+		}
+
+		free_filter_weights( &horizontal );
+		free_filter_weights( &vertical );
+
+		uint64_t level_pixels = ( uint64_t ) dst_width * dst_height;
+		float    alpha_scale  = 1.0f;
+
+		if ( alpha_cutoff > 0.0f )
+		{
+			alpha_scale =
+			    find_alpha_scale( dst, level_pixels, alpha_cutoff, coverage );
+		}
+
+		uint8_t* out = data + ft_texture_mip_offset( &result, mip );
+
+		for ( uint64_t p = 0; p < level_pixels; ++p )
+		{
+			for ( uint32_t c = 0; c < 3; ++c )
+			{
+				float v = dst[ p * 4 + c ];
+				v       = srgb ? linear_to_srgb( v ) : v;
+				out[ p * 4 + c ] = ( uint8_t ) ( v * 255.0f + 0.5f );
+			}
+
+			float alpha = FT_MIN( dst[ p * 4 + 3 ] * alpha_scale, 1.0f );
+			out[ p * 4 + 3 ] = ( uint8_t ) ( alpha * 255.0f + 0.5f );
+		}
+
+		float* tmp = src;
+		src        = dst;
+		dst        = tmp;
+		src_width  = dst_width;
+		src_height = dst_height;
+	}
+
+	free( tasks );
+	free( src );
+	free( dst );
+	free( texture->data );
+
+	texture->data       = data;
+	texture->mip_levels = result.mip_levels;
+
+	return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "base/base.h"
+#include "thread/thread_pool.h"
+#include "model_loader.h"
+
+enum ft_mip_filter
+{
+	FT_MIP_FILTER_BOX,
+	// windowed sinc, sharper than box at slightly higher cost
+	FT_MIP_FILTER_KAISER,
+};
+
+FT_API uint32_t
+ft_get_mip_count( uint32_t width, uint32_t height );
+
+// appends full mip chain to rgba8 texture, srgb textures are filtered in
+// linear space. positive alpha cutoff rescales alpha of every level so alpha
+// tested surfaces keep coverage of top level. rows are spread over pool when
+// it is not null, calling task may run on same pool
+FT_API bool
+ft_generate_texture_mips( struct ft_texture*     texture,
+                          enum ft_mip_filter     filter,
+                          float                  alpha_cutoff,
+                          struct ft_thread_pool* pool );
@@ -1,9 +1,20 @@
+#include <float.h>
 #include <math.h>
 #include <cgltf/cgltf.h>
-#include <stb/stb_image.h>
 #include <hashmap_c/hashmap_c.h>
 #include "fs/fs.h"
+#include "math/simd.h"
+#include "thread/thread_pool.h"
 #include "model_loader.h"
+#include "vertex_packing.h"
+#include "mesh_optimizer.h"
+#include "meshlet.h"
+#include "mesh_simplifier.h"
+#include "texture_compression.h"
+#include "mip_generator.h"
+#include "tangent_generator.h"
+#include "ktx2_loader.h"
+#include "meshopt_decoder.h"
 
 struct node_map_item
 {
@@ -25,11 +36,9 @@ compare_node_map_item( const void* a, const void* b, void* udata )
 static uint64_t
 hash_node_map_item( const void* item, uint64_t seed0, uint64_t seed1 )
 {
-	FT_UNUSED( item );
-	FT_UNUSED( seed0 );
-	FT_UNUSED( seed1 );
-	// TODO: hash function
-	return 0;
+	const struct node_map_item* nmi = item;
+
+	return hashmap_murmur( &nmi->node, sizeof( nmi->node ), seed0, seed1 );
 }
 
 struct image_map_item
@@ -52,15 +61,38 @@ compare_image_map_item( const void* a, const void* b, void* udata )
 static uint64_t
 hash_image_map_item( const void* item, uint64_t seed0, uint64_t seed1 )
 {
-	FT_UNUSED( item );
-	FT_UNUSED( seed0 );
-	FT_UNUSED( seed1 );
-	// TODO: hash function
-	return 0;
+	const struct image_map_item* imi = item;
+
+	return hashmap_murmur( &imi->image, sizeof( imi->image ), seed0, seed1 );
+}
+
+// ktx2 levels are copied as stored, other images are decoded by stb
+static void
+decode_image_data( const void*        data,
+                   uint64_t           size,
+                   bool               srgb,
+                   struct ft_texture* image )
+{
+	if ( ft_is_ktx2( data, size ) )
+	{
+		ft_load_ktx2( data, size, image );
+		return;
+	}
+
+	image->mip_levels = 1;
+
+	image->data = ft_decode_image( data,
+	                               size,
+	                               srgb,
+	                               &image->width,
+	                               &image->height,
+	                               &image->format );
 }
 
 FT_INLINE struct ft_texture
-load_image_from_cgltf_image( cgltf_image* cgltf_image, const char* filename )
+load_image_from_cgltf_image( cgltf_image* cgltf_image,
+                             const char*  filename,
+                             bool         srgb )
 {
 	struct ft_texture image;
 	memset( &image, 0, sizeof( image ) );
@@ -86,39 +118,27 @@ load_image_from_cgltf_image( cgltf_image* cgltf_image, const char* filename )
 			}
 			else
 			{
-				uint32_t base64_size =
-				    ( uint32_t ) strlen( cgltf_image->uri + i + 1 );
-				uint32_t out_size = 3 * ( base64_size / 4 );
-				void*    data     = NULL;
-
-				cgltf_options options = { 0 };
-				cgltf_result  result =
-				    cgltf_load_buffer_base64( &options,
-				                              out_size,
-				                              cgltf_image->uri + i + 1,
-				                              &data );
-
-				if ( result == cgltf_result_success )
+				const char* base64      = cgltf_image->uri + i + 1;
+				uint64_t    base64_size = strlen( base64 );
+				uint64_t    out_size =
+				    ft_base64_decoded_size( base64, base64_size );
+				void* data = malloc( out_size );
+
+				if ( ft_decode_base64( data, base64, base64_size ) )
+				{
+					decode_image_data( data, out_size, srgb, &image );
+				}
+				else
 				{
-					int32_t ch;
-					int32_t w, h;
-					image.data   = stbi_loadf_from_memory( data,
-                                                         out_size,
-                                                         &w,
-                                                         &h,
-                                                         &ch,
-                                                         STBI_rgb_alpha );
-					image.width  = w;
-					image.height = h;
-					cgltf_free( ( cgltf_data* ) data );
+					FT_WARN( "invalid base64 image uri" );
 				}
+
+				free( data );
 			}
 		}
 		else
 		{
-			int32_t ch;
-			int32_t w, h;
-			char    path[ 100 ];
+			char path[ 100 ];
 			strcpy( path, filename );
 			uint32_t i          = 0;
 			uint32_t last_slash = 0;
@@ -130,84 +150,309 @@ load_image_from_cgltf_image( cgltf_image* cgltf_image, const char* filename )
 			};
 			path[ last_slash + 1 ] = '\0';
 			strcat( path, cgltf_image->uri );
-			FILE* f     = fopen( path, "rb" );
-			image.data  = stbi_load_from_file( f, &w, &h, &ch, STBI_rgb_alpha );
-			image.width = w;
-			image.height = h;
+
+			uint64_t size = 0;
+			void*    data = ft_read_file_binary( path, &size );
+
+			if ( data != NULL )
+			{
+				decode_image_data( data, size, srgb, &image );
+				ft_free_file_data( data );
+			}
 		}
 	}
-	else if ( cgltf_image->buffer_view->buffer->data !=
-	          NULL ) // Check if image is provided as data buffer
+	else if ( cgltf_image->buffer_view->data != NULL ||
+	          cgltf_image->buffer_view->buffer->data !=
+	              NULL ) // Check if image is provided as data buffer
 	{
-		uint8_t* data   = malloc( cgltf_image->buffer_view->size );
-		uint64_t offset = cgltf_image->buffer_view->offset;
-		uint64_t stride = cgltf_image->buffer_view->stride
-		                      ? cgltf_image->buffer_view->stride
-		                      : 1;
+		const cgltf_buffer_view* view = cgltf_image->buffer_view;
+
+		const uint8_t* data =
+		    view->data ? view->data
+		               : ( const uint8_t* ) view->buffer->data + view->offset;
+		uint8_t* copy = NULL;
 
-		// Copy buffer data to memory for loading
-		for ( uint32_t i = 0; i < cgltf_image->buffer_view->size; i++ )
+		// tightly packed views are decoded in place
+		if ( view->stride > 1 )
 		{
-			data[ i ] =
-			    ( ( uint8_t* )
-			          cgltf_image->buffer_view->buffer->data )[ offset ];
-			offset += stride;
+			copy = malloc( view->size );
+
+			for ( uint64_t i = 0; i < view->size; i++ )
+			{
+				copy[ i ] = data[ i * view->stride ];
+			}
+
+			data = copy;
 		}
 
 		if ( ( strcmp( cgltf_image->mime_type, "image\\/png" ) == 0 ) ||
-		     ( strcmp( cgltf_image->mime_type, "image/png" ) == 0 ) )
-		{
-			int32_t ch;
-			int32_t w, h;
-			image.data   = stbi_loadf_from_memory( data,
-                                                 cgltf_image->buffer_view->size,
-                                                 &w,
-                                                 &h,
-                                                 &ch,
-                                                 STBI_rgb_alpha );
-			image.width  = w;
-			image.height = h;
-		}
-		else if ( ( strcmp( cgltf_image->mime_type, "image\\/jpeg" ) == 0 ) ||
-		          ( strcmp( cgltf_image->mime_type, "image/jpeg" ) == 0 ) )
-		{
-			int32_t ch;
-			int32_t w, h;
-			image.data   = stbi_loadf_from_memory( data,
-                                                 cgltf_image->buffer_view->size,
-                                                 &w,
-                                                 &h,
-                                                 &ch,
-                                                 STBI_rgb_alpha );
-			image.width  = w;
-			image.height = h;
+		     ( strcmp( cgltf_image->mime_type, "image/png" ) == 0 ) ||
+		     ( strcmp( cgltf_image->mime_type, "image\\/jpeg" ) == 0 ) ||
+		     ( strcmp( cgltf_image->mime_type, "image/jpeg" ) == 0 ) ||
+		     ( strcmp( cgltf_image->mime_type, "image\\/ktx2" ) == 0 ) ||
+		     ( strcmp( cgltf_image->mime_type, "image/ktx2" ) == 0 ) )
+		{
+			decode_image_data( data,
+			                   cgltf_image->buffer_view->size,
+			                   srgb,
+			                   &image );
 		}
 		else
 		{
 			FT_WARN( "unknown image mime type" );
 		}
 
-		free( data );
+		free( copy );
+	}
+
+	image.mip_levels = FT_MAX( image.mip_levels, 1 );
+
+	return image;
+}
+
+FT_INLINE void
+get_material_textures( const cgltf_material* material,
+                       cgltf_texture*        textures[ FT_TEXTURE_TYPE_COUNT ] )
+{
+	textures[ FT_TEXTURE_TYPE_BASE_COLOR ] =
+	    material->pbr_metallic_roughness.base_color_texture.texture;
+	textures[ FT_TEXTURE_TYPE_NORMAL ] = material->normal_texture.texture;
+	textures[ FT_TEXTURE_TYPE_METAL_ROUGHNESS ] =
+	    material->pbr_metallic_roughness.metallic_roughness_texture.texture;
+	textures[ FT_TEXTURE_TYPE_AMBIENT_OCCLUSION ] =
+	    material->occlusion_texture.texture;
+	textures[ FT_TEXTURE_TYPE_EMISSIVE ] = material->emissive_texture.texture;
+}
+
+// every stage of load shares one pool, created here when caller passes
+// none. one thread per cpu except calling one which helps while waiting
+static struct ft_thread_pool*
+create_loader_pool( void )
+{
+	struct ft_thread_pool* pool = malloc( sizeof( struct ft_thread_pool ) );
+	ft_thread_pool_create( pool, 0 );
+	return pool;
+}
+
+static void
+destroy_loader_pool( struct ft_thread_pool* pool )
+{
+	if ( pool )
+	{
+		ft_thread_pool_destroy( pool );
+		free( pool );
+	}
+}
+
+struct texture_decode_job
+{
+	struct ft_texture_decoder* decoder;
+	cgltf_image*               image;
+	struct ft_texture*         texture;
+	uint32_t                   index;
+	// FT_TEXTURE_TYPE_COUNT when no material references texture
+	enum ft_texture_type       texture_type;
+	// nonzero for base color of alpha tested materials
+	float                      alpha_cutoff;
+};
+
+struct ft_texture_decoder
+{
+	// pool of loader, owned pool is set when loader created it
+	struct ft_thread_pool*     pool;
+	struct ft_thread_pool*     owned_pool;
+	struct ft_task_group       group;
+	struct ft_mutex            mutex;
+	// gltf data stays alive until images referencing it are decoded
+	cgltf_data*                data;
+	uint8_t*                   file_data;
+	char*                      filename;
+	struct texture_decode_job* jobs;
+	bool*                      ready;
+	bool                       generate_mips;
+	bool                       compress;
+};
+
+// fills job of every texture with how materials use it, texture types of
+// model are written here too
+static void
+init_texture_jobs( struct texture_decode_job* jobs,
+                   struct ft_model*           model,
+                   const cgltf_data*          data )
+{
+	for ( uint32_t t = 0; t < model->texture_count; ++t )
+	{
+		jobs[ t ].image        = data->textures[ t ].image;
+		jobs[ t ].texture      = &model->textures[ t ];
+		jobs[ t ].index        = t;
+		jobs[ t ].texture_type = FT_TEXTURE_TYPE_COUNT;
+	}
+
+	// decoded format depends on how materials use texture
+	for ( cgltf_size m = 0; m < data->materials_count; ++m )
+	{
+		const cgltf_material* material = &data->materials[ m ];
+		cgltf_texture*        textures[ FT_TEXTURE_TYPE_COUNT ];
+		get_material_textures( material, textures );
+
+		for ( uint32_t t = 0; t < FT_TEXTURE_TYPE_COUNT; ++t )
+		{
+			if ( textures[ t ] )
+			{
+				struct texture_decode_job* job =
+				    &jobs[ textures[ t ] - data->textures ];
+				job->texture_type          = t;
+				job->texture->texture_type = t;
+			}
+		}
+
+		cgltf_texture* base_color = textures[ FT_TEXTURE_TYPE_BASE_COLOR ];
+
+		if ( base_color && material->alpha_mode == cgltf_alpha_mode_mask )
+		{
+			jobs[ base_color - data->textures ].alpha_cutoff =
+			    material->alpha_cutoff;
+		}
 	}
+}
+
+static struct ft_texture
+load_texture_image( const struct texture_decode_job* job,
+                    const char*                      filename )
+{
+	// color textures are stored in srgb
+	bool srgb = job->texture_type == FT_TEXTURE_TYPE_BASE_COLOR ||
+	            job->texture_type == FT_TEXTURE_TYPE_EMISSIVE;
+
+	struct ft_texture image;
+	memset( &image, 0, sizeof( image ) );
 
-	image.mip_levels = 1;
+	// KHR_texture_basisu sources hold basis payloads that need transcoder,
+	// regular source is used instead
+	if ( job->image )
+	{
+		image = load_image_from_cgltf_image( job->image, filename, srgb );
+	}
 
 	return image;
 }
 
+// images with at least this many pixels split their work over pool, smaller
+// ones are cheaper to process on task that decoded them
+#define PARALLEL_TEXTURE_PIXELS ( 512 * 512 )
+
+// calling task is on pool already and helps while it waits for rows
+FT_INLINE struct ft_thread_pool*
+get_image_pool( uint32_t width, uint32_t height, struct ft_thread_pool* pool )
+{
+	return ( uint64_t ) width * height >= PARALLEL_TEXTURE_PIXELS ? pool
+	                                                               : NULL;
+}
+
+static void
+process_texture_image( const struct texture_decode_job* job,
+                       struct ft_texture*               image,
+                       bool                             generate_mips,
+                       bool                             compress,
+                       struct ft_thread_pool*           pool )
+{
+	struct ft_thread_pool* image_pool =
+	    get_image_pool( image->width, image->height, pool );
+
+	if ( generate_mips )
+	{
+		ft_generate_texture_mips( image,
+		                          FT_MIP_FILTER_KAISER,
+		                          job->alpha_cutoff,
+		                          image_pool );
+	}
+
+	if ( compress )
+	{
+		ft_compress_texture(
+		    image,
+		    ft_get_block_compressed_format( job->texture_type, image->format ),
+		    image_pool );
+	}
+}
+
 FT_INLINE void
-gltf_read_float( const float* accessor_data,
-                 cgltf_size   accessor_num_components,
-                 cgltf_size   index,
-                 cgltf_float* out,
-                 cgltf_size   out_element_size )
+set_texture_image( const struct texture_decode_job* job,
+                   const struct ft_texture*         image )
+{
+	// texture type is written by loading thread, leave it untouched
+	job->texture->width      = image->width;
+	job->texture->height     = image->height;
+	job->texture->mip_levels = image->mip_levels;
+	job->texture->format     = image->format;
+	job->texture->data       = image->data;
+}
+
+static void
+decode_texture( const struct texture_decode_job* job,
+                const char*                      filename,
+                bool                             generate_mips,
+                bool                             compress,
+                struct ft_thread_pool*           pool )
 {
-	const float* input = &accessor_data[ accessor_num_components * index ];
+	struct ft_texture image = load_texture_image( job, filename );
+	process_texture_image( job, &image, generate_mips, compress, pool );
+	set_texture_image( job, &image );
+}
+
+static void
+decode_texture_job( void* arg )
+{
+	struct texture_decode_job* job     = arg;
+	struct ft_texture_decoder* decoder = job->decoder;
+
+	decode_texture( job,
+	                decoder->filename,
+	                decoder->generate_mips,
+	                decoder->compress,
+	                decoder->pool );
+
+	ft_mutex_lock( &decoder->mutex );
+	decoder->ready[ job->index ] = true;
+	ft_mutex_unlock( &decoder->mutex );
+}
+
+static struct ft_texture_decoder*
+create_texture_decoder( struct ft_model*       model,
+                        cgltf_data*            data,
+                        uint8_t*               file_data,
+                        const char*            filename,
+                        enum ft_model_flags    flags,
+                        struct ft_thread_pool* pool )
+{
+	struct ft_texture_decoder* decoder =
+	    calloc( 1, sizeof( struct ft_texture_decoder ) );
+
+	decoder->pool      = pool;
+	decoder->data      = data;
+	decoder->file_data = file_data;
+	decoder->filename  = malloc( strlen( filename ) + 1 );
+	strcpy( decoder->filename, filename );
+	decoder->jobs =
+	    calloc( model->texture_count, sizeof( struct texture_decode_job ) );
+	decoder->ready         = calloc( model->texture_count, sizeof( bool ) );
+	decoder->generate_mips = flags & FT_MODEL_GENERATE_MIPS;
+	decoder->compress      = flags & FT_MODEL_COMPRESS_TEXTURES;
+
+	ft_mutex_create( &decoder->mutex );
 
-	for ( cgltf_size ii = 0; ii < out_element_size; ++ii )
+	init_texture_jobs( decoder->jobs, model, data );
+
+	for ( uint32_t t = 0; t < model->texture_count; ++t )
 	{
-		out[ ii ] = ( ii < accessor_num_components ) ? input[ ii ] : 0.0f;
+		decoder->jobs[ t ].decoder = decoder;
+		ft_thread_pool_push_group( pool,
+		                           &decoder->group,
+		                           decode_texture_job,
+		                           &decoder->jobs[ t ] );
 	}
+
+	return decoder;
 }
 
 FT_INLINE float**
@@ -252,51 +497,19 @@ get_mesh_attribute( struct ft_mesh* mesh, cgltf_attribute_type type )
 	}
 }
 
-FT_INLINE void
-read_attribute( struct ft_mesh*  mesh,
-                cgltf_attribute* attribute,
-                float*           accessor_data,
-                cgltf_size       accessor_count,
-                cgltf_size       component_count )
+// appends node and its descendants depth first
+static void
+add_scene_node( struct hashmap* node_map,
+                cgltf_node*     node,
+                uint32_t        parent,
+                cgltf_node**    nodes,
+                uint32_t*       parents,
+                uint32_t*       node_count )
 {
-	if ( attribute->index != 0 )
-	{
-		return;
-	}
-
-	float** vertices = get_mesh_attribute( mesh, attribute->type );
-
-	if ( vertices == NULL )
-	{
-		return;
-	}
-
-	*vertices =
-	    realloc( *vertices,
-	             ( mesh->vertex_count * component_count ) * sizeof( float ) );
-
-	for ( cgltf_size v = 0; v < accessor_count * component_count;
-	      v += component_count )
-	{
-		gltf_read_float( accessor_data,
-		                 component_count,
-		                 v / component_count,
-		                 &( ( *vertices )[ v ] ),
-		                 component_count );
-	}
-}
+	uint32_t index = ( *node_count )++;
 
-static uint32_t
-process_gltf_node( struct hashmap*    node_map,
-                   struct hashmap*    image_map,
-                   uint32_t           index,
-                   cgltf_node*        node,
-                   struct ft_mesh*    meshes,
-                   struct ft_texture* textures,
-                   const char*        filename )
-{
-	uint32_t    mesh_index = 0;
-	cgltf_mesh* gltf_mesh  = node->mesh;
+	nodes[ index ]   = node;
+	parents[ index ] = parent;
 
 	hashmap_set( node_map,
 	             &( struct node_map_item ) {
@@ -304,565 +517,2153 @@ process_gltf_node( struct hashmap*    node_map,
 	                 .index = index,
 	             } );
 
-	if ( gltf_mesh != NULL )
+	for ( cgltf_size c = 0; c < node->children_count; ++c )
 	{
-		for ( cgltf_size p = 0; p < gltf_mesh->primitives_count; ++p )
-		{
-			struct ft_mesh* mesh = &meshes[ p ];
-			float           node_to_world[ 16 ];
-			memset( node_to_world, 0, sizeof( node_to_world ) );
-			cgltf_node_transform_world( node, node_to_world );
-			memcpy( mesh->world, node_to_world, sizeof( node_to_world ) );
-
-			cgltf_primitive* primitive = &gltf_mesh->primitives[ p ];
+		add_scene_node( node_map,
+		                node->children[ c ],
+		                index,
+		                nodes,
+		                parents,
+		                node_count );
+	}
+}
 
-			for ( cgltf_size att = 0; att < primitive->attributes_count; ++att )
-			{
-				cgltf_attribute* attribute      = &primitive->attributes[ att ];
-				cgltf_accessor*  accessor       = attribute->data;
-				cgltf_size       accessor_count = accessor->count;
+// returns scene nodes in graph order, world transforms are computed once here
+// instead of walking parent chain for every primitive
+static cgltf_node**
+build_scene_graph( struct ft_scene_graph* graph,
+                   struct hashmap*        node_map,
+                   const cgltf_data*      data,
+                   const cgltf_scene*     scene )
+{
+	cgltf_node** nodes   = malloc( data->nodes_count * sizeof( cgltf_node* ) );
+	uint32_t*    parents = malloc( data->nodes_count * sizeof( uint32_t ) );
 
-				if ( attribute->type == cgltf_attribute_type_color )
-				{
-					continue;
-				}
+	uint32_t node_count = 0;
 
-				cgltf_size float_count =
-				    cgltf_accessor_unpack_floats( accessor, NULL, 0 );
-				float* accessor_data = malloc( float_count * sizeof( float ) );
-				cgltf_accessor_unpack_floats( accessor,
-				                              accessor_data,
-				                              float_count );
+	for ( cgltf_size n = 0; n < scene->nodes_count; ++n )
+	{
+		add_scene_node( node_map,
+		                scene->nodes[ n ],
+		                FT_SCENE_NODE_NONE,
+		                nodes,
+		                parents,
+		                &node_count );
+	}
 
-				mesh->vertex_count = ( att == 0 )
-				                         ? mesh->vertex_count + accessor_count
-				                         : mesh->vertex_count;
+	ft_scene_graph_create( graph, node_count, parents );
+	free( parents );
 
-				read_attribute( mesh,
-				                attribute,
-				                accessor_data,
-				                accessor_count,
-				                cgltf_num_components( accessor->type ) );
+	for ( uint32_t i = 0; i < node_count; ++i )
+	{
+		const cgltf_node* node = nodes[ i ];
 
-				free( accessor_data );
-			}
+		if ( node->has_matrix )
+		{
+			float4x4_decompose( graph->translations[ i ],
+			                    graph->rotations[ i ],
+			                    graph->scales[ i ],
+			                    ( const float( * )[ 4 ] ) node->matrix );
+			continue;
+		}
 
-			if ( primitive->indices != NULL )
-			{
-				cgltf_accessor* accessor = primitive->indices;
+		if ( node->has_translation )
+		{
+			float3_dup( graph->translations[ i ], node->translation );
+		}
 
-				mesh->index_count += accessor->count;
-				if ( accessor->component_type == cgltf_component_type_r_16u )
-				{
-					mesh->indices_16 =
-					    realloc( mesh->indices_16,
-					             mesh->index_count * sizeof( uint16_t ) );
-					for ( cgltf_size v = 0; v < accessor->count; ++v )
-					{
-						mesh->indices_16[ v ] =
-						    cgltf_accessor_read_index( accessor, v );
-					}
-				}
-				else if ( accessor->component_type ==
-				          cgltf_component_type_r_32u )
-				{
-					mesh->indices_32 =
-					    realloc( mesh->indices_32,
-					             mesh->index_count * sizeof( uint32_t ) );
-					for ( cgltf_size v = 0; v < accessor->count; ++v )
-					{
-						mesh->indices_32[ v ] =
-						    cgltf_accessor_read_index( accessor, v );
-					}
-				}
-			}
+		if ( node->has_rotation )
+		{
+			float4_dup( graph->rotations[ i ], node->rotation );
+		}
 
-			if ( primitive->material )
-			{
-				cgltf_material* material = primitive->material;
+		if ( node->has_scale )
+		{
+			float3_dup( graph->scales[ i ], node->scale );
+		}
+	}
 
-				float4_dup(
-				    mesh->material.base_color_factor,
-				    material->pbr_metallic_roughness.base_color_factor );
-				float3_dup( mesh->material.emissive_factor,
-				            material->emissive_factor );
+	ft_scene_graph_update( graph );
 
-				mesh->material.metallic_factor =
-				    material->pbr_metallic_roughness.metallic_factor;
-				mesh->material.roughness_factor =
-				    material->pbr_metallic_roughness.roughness_factor;
+	return nodes;
+}
 
-				mesh->material.emissive_strength = 1.0f;
-				if ( material->has_emissive_strength )
-				{
-					mesh->material.emissive_strength =
-					    material->emissive_strength.emissive_strength;
-				}
-				mesh->material.alpha_mode   = material->alpha_mode;
-				mesh->material.alpha_cutoff = material->alpha_cutoff;
-
-				cgltf_texture* gltf_textures[ FT_TEXTURE_TYPE_COUNT ];
-				gltf_textures[ FT_TEXTURE_TYPE_BASE_COLOR ] =
-				    material->pbr_metallic_roughness.base_color_texture.texture;
-				gltf_textures[ FT_TEXTURE_TYPE_NORMAL ] =
-				    material->normal_texture.texture;
-				gltf_textures[ FT_TEXTURE_TYPE_METAL_ROUGHNESS ] =
-				    material->pbr_metallic_roughness.metallic_roughness_texture
-				        .texture;
-				gltf_textures[ FT_TEXTURE_TYPE_AMBIENT_OCCLUSION ] =
-				    material->occlusion_texture.texture;
-				gltf_textures[ FT_TEXTURE_TYPE_EMISSIVE ] =
-				    material->emissive_texture.texture;
-
-				for ( uint32_t t = 0; t < FT_TEXTURE_TYPE_COUNT; ++t )
-				{
-					if ( gltf_textures[ t ] )
-					{
-						struct image_map_item* it =
-						    hashmap_get( image_map,
-						                 &( struct image_map_item ) {
-						                     .image = gltf_textures[ t ]->image,
-						                 } );
+// first element of accessor in buffer view, null for sparse accessors and
+// accessors without view which cgltf has to resolve
+static const uint8_t*
+get_accessor_data( const cgltf_accessor* accessor )
+{
+	const cgltf_buffer_view* view = accessor->buffer_view;
 
-						FT_ASSERT( it );
+	if ( accessor->is_sparse || view == NULL )
+	{
+		return NULL;
+	}
 
-						mesh->material.textures[ t ]       = it->index;
-						textures[ it->index ].texture_type = t;
-					}
-					else
-					{
-						mesh->material.textures[ t ] = -1;
-					}
-				}
-			}
-		}
-		mesh_index = gltf_mesh->primitives_count;
+	// decoded views hold their own data
+	if ( view->data != NULL )
+	{
+		return ( const uint8_t* ) view->data + accessor->offset;
 	}
 
-	for ( cgltf_size child_index = 0; child_index < node->children_count;
-	      ++child_index )
+	if ( view->buffer->data == NULL )
 	{
-		mesh_index += process_gltf_node( node_map,
-		                                 image_map,
-		                                 index,
-		                                 node->children[ child_index ],
-		                                 &meshes[ mesh_index ],
-		                                 textures,
-		                                 filename );
+		return NULL;
 	}
 
-	return mesh_index;
+	return ( const uint8_t* ) view->buffer->data + view->offset +
+	       accessor->offset;
 }
 
-FT_INLINE void
-read_animation_samplers( const cgltf_animation_sampler* src,
-                         struct ft_animation_sampler*   dst )
+// converts elements straight from buffer view into tightly packed floats,
+// normalized integers map to [0, 1] or [-1, 1]
+static void
+read_accessor_floats( const cgltf_accessor* accessor,
+                      float*                dst,
+                      uint32_t              component_count )
 {
-	const cgltf_accessor* timeline_accessor = src->input;
-	const uint8_t* timeline_blob = timeline_accessor->buffer_view->buffer->data;
-	const float*   timeline_floats =
-	    ( const float* ) ( timeline_blob + timeline_accessor->offset +
-	                       timeline_accessor->buffer_view->offset );
+	const uint8_t* src   = get_accessor_data( accessor );
+	uint64_t       count = accessor->count;
 
-	dst->frame_count = timeline_accessor->count;
+	if ( src == NULL )
+	{
+		cgltf_accessor_unpack_floats( accessor, dst, count * component_count );
+		return;
+	}
 
-	FT_ASSERT( dst->times == NULL );
-	dst->times = calloc( dst->frame_count, sizeof( float ) );
+	uint64_t stride = accessor->stride;
 
-	for ( uint32_t i = 0; i < dst->frame_count; ++i )
+	if ( accessor->component_type == cgltf_component_type_r_32f &&
+	     stride == component_count * sizeof( float ) )
 	{
-		dst->times[ i ] = timeline_floats[ i ];
+		memcpy( dst, src, count * stride );
+		return;
 	}
 
-	const cgltf_accessor* values_accessor = src->output;
+	for ( uint64_t e = 0; e < count; ++e )
+	{
+		const uint8_t* element = src + e * stride;
+		float*         out     = dst + e * component_count;
 
-	FT_ASSERT( dst->values == NULL );
+		for ( uint32_t c = 0; c < component_count; ++c )
+		{
+			switch ( accessor->component_type )
+			{
+			case cgltf_component_type_r_8:
+				out[ c ] = ( ( const int8_t* ) element )[ c ];
+				break;
+			case cgltf_component_type_r_8u:
+				out[ c ] = ( ( const uint8_t* ) element )[ c ];
+				break;
+			case cgltf_component_type_r_16:
+				out[ c ] = ( ( const int16_t* ) element )[ c ];
+				break;
+			case cgltf_component_type_r_16u:
+				out[ c ] = ( ( const uint16_t* ) element )[ c ];
+				break;
+			case cgltf_component_type_r_32u:
+				out[ c ] = ( float ) ( ( const uint32_t* ) element )[ c ];
+				break;
+			case cgltf_component_type_r_32f:
+				out[ c ] = ( ( const float* ) element )[ c ];
+				break;
+			default: out[ c ] = 0.0f; break;
+			}
+		}
+	}
 
-	switch ( values_accessor->type )
-	{
-	case cgltf_type_scalar:
+	if ( !accessor->normalized )
 	{
-		dst->values = calloc( dst->frame_count, sizeof( float ) );
-		cgltf_accessor_unpack_floats( src->output,
-		                              &dst->values[ 0 ],
-		                              dst->frame_count );
-		break;
+		return;
 	}
-	case cgltf_type_vec3:
+
+	float scale = 1.0f;
+	bool  snorm = false;
+
+	switch ( accessor->component_type )
 	{
-		dst->values = calloc( dst->frame_count, 3 * sizeof( float ) );
-		cgltf_accessor_unpack_floats( src->output,
-		                              &dst->values[ 0 ],
-		                              dst->frame_count * 3 );
+	case cgltf_component_type_r_8:
+		scale   = 1.0f / INT8_MAX;
+		snorm   = true;
 		break;
-	}
-	case cgltf_type_vec4:
-	{
-		dst->values = calloc( dst->frame_count, 4 * sizeof( float ) );
-		cgltf_accessor_unpack_floats( src->output,
-		                              &dst->values[ 0 ],
-		                              dst->frame_count * 4 );
+	case cgltf_component_type_r_8u: scale = 1.0f / UINT8_MAX; break;
+	case cgltf_component_type_r_16:
+		scale   = 1.0f / INT16_MAX;
+		snorm   = true;
 		break;
-	}
+	case cgltf_component_type_r_16u: scale = 1.0f / UINT16_MAX; break;
 	default: return;
 	}
 
-	switch ( src->interpolation )
+	// most negative snorm value maps past -1
+	float min = snorm ? -1.0f : 0.0f;
+
+	for ( uint64_t i = 0; i < count * component_count; ++i )
 	{
-	case cgltf_interpolation_type_step:
-		dst->interpolation = FT_ANIMATION_INTERPOLATION_STEP;
-		break;
-	case cgltf_interpolation_type_linear:
-		dst->interpolation = FT_ANIMATION_INTERPOLATION_LINEAR;
-		break;
-	case cgltf_interpolation_type_cubic_spline:
-		dst->interpolation = FT_ANIMATION_INTERPOLATION_SPLINE;
-		break;
-	default: break;
+		dst[ i ] = FT_MAX( dst[ i ] * scale, min );
 	}
 }
 
-FT_INLINE void
-read_animation_channels( struct hashmap*        node_map,
-                         const cgltf_animation* src,
-                         struct ft_animation*   dst )
+static void
+read_gltf_indices( const cgltf_accessor* accessor, struct ft_mesh* mesh )
 {
-	cgltf_animation_channel* src_channels = src->channels;
-	cgltf_animation_sampler* src_samplers = src->samplers;
+	const uint8_t* src    = get_accessor_data( accessor );
+	uint64_t       stride = accessor->stride;
 
-	dst->channel_count = src->channels_count;
-	dst->channels =
-	    calloc( src->channels_count, sizeof( struct ft_animation_channel ) );
+	mesh->index_count = accessor->count;
 
-	for ( cgltf_size j = 0; j < src->channels_count; ++j )
+	switch ( accessor->component_type )
 	{
-		const cgltf_animation_channel* src_channel = &src_channels[ j ];
-		struct ft_animation_channel*   dst_channel = &dst->channels[ j ];
-		dst_channel->sampler =
-		    dst->samplers + ( src_channel->sampler - src_samplers );
-
-		struct node_map_item* it =
-		    hashmap_get( node_map,
-		                 &( struct node_map_item ) {
-		                     .node = src_channel->target_node,
-		                 } );
+	case cgltf_component_type_r_8u:
+	case cgltf_component_type_r_16u:
+	{
+		// 8 bit indices are widened, gpus may not support them
+		mesh->indices_16 = malloc( mesh->index_count * sizeof( uint16_t ) );
 
-		if ( it != NULL )
+		if ( src && stride == sizeof( uint16_t ) &&
+		     accessor->component_type == cgltf_component_type_r_16u )
 		{
-			dst_channel->target = it->index;
+			memcpy( mesh->indices_16, src, mesh->index_count * stride );
+			break;
 		}
-		else
+
+		for ( uint32_t i = 0; i < mesh->index_count; ++i )
 		{
-			FT_WARN(
-			    "no scene root contains node %s for animation %s in channel %d",
-			    src_channel->target_node->name,
-			    src->name,
-			    j );
+			if ( src == NULL )
+			{
+				mesh->indices_16[ i ] =
+				    ( uint16_t ) cgltf_accessor_read_index( accessor, i );
+			}
+			else if ( accessor->component_type ==
+			          cgltf_component_type_r_8u )
+			{
+				mesh->indices_16[ i ] = src[ i * stride ];
+			}
+			else
+			{
+				mesh->indices_16[ i ] =
+				    *( const uint16_t* ) ( src + i * stride );
+			}
 		}
+		break;
+	}
+	case cgltf_component_type_r_32u:
+	{
+		mesh->indices_32 = malloc( mesh->index_count * sizeof( uint32_t ) );
 
-		switch ( src_channel->target_path )
+		if ( src && stride == sizeof( uint32_t ) )
 		{
-		case cgltf_animation_path_type_translation:
-			dst_channel->transform_type = FT_TRANSFORM_TYPE_TRANSLATION;
-			break;
-		case cgltf_animation_path_type_rotation:
-			dst_channel->transform_type = FT_TRANSFORM_TYPE_ROTATION;
-			break;
-		case cgltf_animation_path_type_scale:
-			dst_channel->transform_type = FT_TRANSFORM_TYPE_SCALE;
+			memcpy( mesh->indices_32, src, mesh->index_count * stride );
 			break;
-		case cgltf_animation_path_type_weights:
-			dst_channel->transform_type = FT_TRANSFORM_TYPE_WEIGHTS;
-			break;
-		default: break;
 		}
+
+		for ( uint32_t i = 0; i < mesh->index_count; ++i )
+		{
+			mesh->indices_32[ i ] =
+			    src ? *( const uint32_t* ) ( src + i * stride )
+			        : ( uint32_t ) cgltf_accessor_read_index( accessor, i );
+		}
+		break;
+	}
+	default:
+	{
+		FT_WARN( "invalid gltf index type" );
+		mesh->index_count = 0;
+		break;
+	}
+	}
+}
+
+// every attribute is decoded once into its final allocation, mesh must be
+// empty
+static void
+read_gltf_geometry( cgltf_primitive* primitive, struct ft_mesh* mesh )
+{
+	FT_ASSERT( mesh->vertex_count == 0 && mesh->index_count == 0 );
+
+	for ( cgltf_size att = 0; att < primitive->attributes_count; ++att )
+	{
+		cgltf_attribute* attribute = &primitive->attributes[ att ];
+		cgltf_accessor*  accessor  = attribute->data;
+
+		if ( att == 0 )
+		{
+			mesh->vertex_count = accessor->count;
+		}
+
+		if ( attribute->index != 0 ||
+		     attribute->type == cgltf_attribute_type_color )
+		{
+			continue;
+		}
+
+		float** vertices = get_mesh_attribute( mesh, attribute->type );
+
+		if ( vertices == NULL )
+		{
+			continue;
+		}
+
+		uint32_t component_count =
+		    ( uint32_t ) cgltf_num_components( accessor->type );
+
+		FT_ASSERT( *vertices == NULL );
+		*vertices = malloc( mesh->vertex_count * component_count *
+		                    sizeof( float ) );
+		read_accessor_floats( accessor, *vertices, component_count );
+	}
+
+	if ( primitive->indices != NULL )
+	{
+		read_gltf_indices( primitive->indices, mesh );
+	}
+}
+
+static void
+read_gltf_material( struct hashmap*     image_map,
+                    cgltf_primitive*    primitive,
+                    struct ft_material* dst )
+{
+	if ( primitive->material == NULL )
+	{
+		return;
+	}
+
+	cgltf_material* material = primitive->material;
+
+	float4_dup( dst->base_color_factor,
+	            material->pbr_metallic_roughness.base_color_factor );
+	float3_dup( dst->emissive_factor, material->emissive_factor );
+
+	dst->metallic_factor  = material->pbr_metallic_roughness.metallic_factor;
+	dst->roughness_factor = material->pbr_metallic_roughness.roughness_factor;
+
+	dst->emissive_strength = 1.0f;
+	if ( material->has_emissive_strength )
+	{
+		dst->emissive_strength =
+		    material->emissive_strength.emissive_strength;
+	}
+	dst->alpha_mode   = material->alpha_mode;
+	dst->alpha_cutoff = material->alpha_cutoff;
+
+	cgltf_texture* gltf_textures[ FT_TEXTURE_TYPE_COUNT ];
+	get_material_textures( material, gltf_textures );
+
+	for ( uint32_t t = 0; t < FT_TEXTURE_TYPE_COUNT; ++t )
+	{
+		if ( gltf_textures[ t ] )
+		{
+			struct image_map_item key = {
+				.image = gltf_textures[ t ]->image,
+			};
+			struct image_map_item* it = hashmap_get( image_map, &key );
+
+			FT_ASSERT( it );
+
+			dst->textures[ t ] = it->index;
+		}
+		else
+		{
+			dst->textures[ t ] = -1;
+		}
+	}
+}
+
+// primitives sharing accessors and material are drawn as instances of one
+// mesh, exporters often repeat mesh entries pointing to same accessors
+struct primitive_map_item
+{
+	cgltf_primitive*   primitive;
+	struct ft_material material;
+	uint32_t           mesh;
+};
+
+static bool
+same_primitive_geometry( const cgltf_primitive* a, const cgltf_primitive* b )
+{
+	if ( a == b )
+	{
+		return true;
+	}
+
+	if ( a->type != b->type || a->indices != b->indices ||
+	     a->attributes_count != b->attributes_count ||
+	     a->targets_count != 0 || b->targets_count != 0 )
+	{
+		return false;
+	}
+
+	for ( cgltf_size i = 0; i < a->attributes_count; ++i )
+	{
+		const cgltf_attribute* aa = &a->attributes[ i ];
+		const cgltf_attribute* ba = &b->attributes[ i ];
+
+		if ( aa->type != ba->type || aa->index != ba->index ||
+		     aa->data != ba->data )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int
+compare_primitive_map_item( const void* a, const void* b, void* udata )
+{
+	FT_UNUSED( udata );
+
+	const struct primitive_map_item* pa = a;
+	const struct primitive_map_item* pb = b;
+
+	return !( same_primitive_geometry( pa->primitive, pb->primitive ) &&
+	          memcmp( &pa->material,
+	                  &pb->material,
+	                  sizeof( struct ft_material ) ) == 0 );
+}
+
+static uint64_t
+hash_primitive_map_item( const void* item, uint64_t seed0, uint64_t seed1 )
+{
+	const cgltf_primitive* primitive =
+	    ( ( const struct primitive_map_item* ) item )->primitive;
+
+	// equal geometry means equal accessors, material only narrows it down
+	uintptr_t key = ( uintptr_t ) primitive->indices;
+
+	for ( cgltf_size i = 0; i < primitive->attributes_count; ++i )
+	{
+		key = key * 31 + ( uintptr_t ) primitive->attributes[ i ].data;
+	}
+
+	return hashmap_murmur( &key, sizeof( key ), seed0, seed1 );
+}
+
+static struct hashmap*
+create_primitive_map( void )
+{
+	return hashmap_new( sizeof( struct primitive_map_item ),
+	                    0,
+	                    0,
+	                    0,
+	                    hash_primitive_map_item,
+	                    compare_primitive_map_item,
+	                    NULL,
+	                    NULL );
+}
+
+// upper bound of mesh count, reached when no primitive is shared
+static uint32_t
+count_scene_primitives( const struct ft_scene_graph* graph,
+                        cgltf_node* const*           nodes )
+{
+	uint32_t count = 0;
+
+	for ( uint32_t n = 0; n < graph->node_count; ++n )
+	{
+		if ( nodes[ n ]->mesh )
+		{
+			count += nodes[ n ]->mesh->primitives_count;
+		}
+	}
+
+	return count;
+}
+
+// index of mesh made of same geometry and material, appends new mesh with
+// only material set when there is none yet
+static uint32_t
+find_gltf_mesh( struct hashmap*  primitive_map,
+                struct hashmap*  image_map,
+                cgltf_primitive* primitive,
+                struct ft_mesh*  meshes,
+                uint32_t*        mesh_count )
+{
+	struct primitive_map_item item;
+	memset( &item, 0, sizeof( item ) );
+	item.primitive = primitive;
+	item.mesh      = *mesh_count;
+	read_gltf_material( image_map, primitive, &item.material );
+
+	const struct primitive_map_item* it = hashmap_get( primitive_map, &item );
+
+	if ( it != NULL )
+	{
+		return it->mesh;
+	}
+
+	hashmap_set( primitive_map, &item );
+	meshes[ item.mesh ].material = item.material;
+
+	return ( *mesh_count )++;
+}
+
+static void
+add_mesh_instance( struct ft_mesh* mesh, uint32_t node, const float4x4 world )
+{
+	if ( mesh->instance_count == 0 )
+	{
+		mesh->node = node;
+		float4x4_dup( mesh->world, world );
+	}
+
+	uint32_t i = mesh->instance_count++;
+
+	mesh->instance_nodes =
+	    realloc( mesh->instance_nodes,
+	             mesh->instance_count * sizeof( uint32_t ) );
+	mesh->instance_transforms =
+	    realloc( mesh->instance_transforms,
+	             mesh->instance_count * sizeof( float4x4 ) );
+
+	mesh->instance_nodes[ i ] = node;
+	float4x4_dup( mesh->instance_transforms[ i ], world );
+}
+
+FT_INLINE void
+set_bounds_sphere( struct ft_bounds* bounds )
+{
+	float3 extent;
+	float3_sub( extent, bounds->max, bounds->min );
+	float3_add( bounds->center, bounds->min, bounds->max );
+	float3_scale( bounds->center, bounds->center, 0.5f );
+	bounds->radius = float3_len( extent ) * 0.5f;
+}
+
+// box from position accessor min and max, exporters must write them so no
+// vertex is read. normalized positions store them unscaled and are skipped
+static bool
+get_primitive_bounds( const cgltf_primitive* primitive,
+                      struct ft_bounds*      bounds )
+{
+	for ( cgltf_size a = 0; a < primitive->attributes_count; ++a )
+	{
+		const cgltf_accessor* accessor = primitive->attributes[ a ].data;
+
+		if ( primitive->attributes[ a ].type != cgltf_attribute_type_position )
+		{
+			continue;
+		}
+
+		if ( !accessor->has_min || !accessor->has_max ||
+		     accessor->normalized || accessor->type != cgltf_type_vec3 )
+		{
+			return false;
+		}
+
+		for ( uint32_t c = 0; c < 3; ++c )
+		{
+			bounds->min[ c ] = accessor->min[ c ];
+			bounds->max[ c ] = accessor->max[ c ];
+		}
+
+		set_bounds_sphere( bounds );
+		return true;
+	}
+
+	return false;
+}
+
+static void
+process_gltf_node( struct hashmap*              primitive_map,
+                   struct hashmap*              image_map,
+                   const struct ft_scene_graph* graph,
+                   uint32_t                     index,
+                   cgltf_node*                  node,
+                   struct ft_model*             model )
+{
+	cgltf_mesh* gltf_mesh = node->mesh;
+
+	if ( gltf_mesh == NULL )
+	{
+		return;
+	}
+
+	for ( cgltf_size p = 0; p < gltf_mesh->primitives_count; ++p )
+	{
+		cgltf_primitive* primitive  = &gltf_mesh->primitives[ p ];
+		uint32_t         mesh_count = model->mesh_count;
+
+		uint32_t m = find_gltf_mesh( primitive_map,
+		                             image_map,
+		                             primitive,
+		                             model->meshes,
+		                             &model->mesh_count );
+
+		if ( m == mesh_count )
+		{
+			struct ft_mesh* mesh = &model->meshes[ m ];
+
+			read_gltf_geometry( primitive, mesh );
+
+			if ( !get_primitive_bounds( primitive, &mesh->bounds ) )
+			{
+				ft_compute_mesh_bounds( mesh );
+			}
+		}
+
+		add_mesh_instance( &model->meshes[ m ],
+		                   index,
+		                   graph->world_transforms[ index ] );
+	}
+}
+
+FT_INLINE void
+read_animation_samplers( const cgltf_animation_sampler* src,
+                         struct ft_animation_sampler*   dst )
+{
+	const cgltf_accessor* timeline_accessor = src->input;
+
+	dst->frame_count = timeline_accessor->count;
+
+	FT_ASSERT( dst->times == NULL );
+	dst->times = calloc( dst->frame_count, sizeof( float ) );
+	read_accessor_floats( timeline_accessor, dst->times, 1 );
+
+	switch ( src->interpolation )
+	{
+	case cgltf_interpolation_type_step:
+		dst->interpolation = FT_ANIMATION_INTERPOLATION_STEP;
+		break;
+	case cgltf_interpolation_type_linear:
+		dst->interpolation = FT_ANIMATION_INTERPOLATION_LINEAR;
+		break;
+	case cgltf_interpolation_type_cubic_spline:
+		dst->interpolation = FT_ANIMATION_INTERPOLATION_SPLINE;
+		break;
+	default: break;
+	}
+
+	const cgltf_accessor* values_accessor = src->output;
+
+	// spline frames hold in tangent, value and out tangent
+	uint32_t value_count =
+	    dst->interpolation == FT_ANIMATION_INTERPOLATION_SPLINE
+	        ? dst->frame_count * 3
+	        : dst->frame_count;
+
+	FT_ASSERT( dst->values == NULL );
+
+	switch ( values_accessor->type )
+	{
+	case cgltf_type_scalar:
+	{
+		dst->component_count = 1;
+		dst->values          = calloc( value_count, sizeof( float ) );
+		cgltf_accessor_unpack_floats( src->output,
+		                              &dst->values[ 0 ],
+		                              value_count );
+		break;
+	}
+	case cgltf_type_vec3:
+	{
+		dst->component_count = 3;
+		dst->values          = calloc( value_count, 3 * sizeof( float ) );
+		cgltf_accessor_unpack_floats( src->output,
+		                              &dst->values[ 0 ],
+		                              value_count * 3 );
+		break;
+	}
+	case cgltf_type_vec4:
+	{
+		dst->component_count = 4;
+		dst->values          = calloc( value_count, 4 * sizeof( float ) );
+		cgltf_accessor_unpack_floats( src->output,
+		                              &dst->values[ 0 ],
+		                              value_count * 4 );
+		break;
+	}
+	default: return;
+	}
+}
+
+FT_INLINE void
+read_animation_channels( struct hashmap*        node_map,
+                         const cgltf_animation* src,
+                         struct ft_animation*   dst )
+{
+	cgltf_animation_channel* src_channels = src->channels;
+	cgltf_animation_sampler* src_samplers = src->samplers;
+
+	dst->channel_count = src->channels_count;
+	dst->channels =
+	    calloc( src->channels_count, sizeof( struct ft_animation_channel ) );
+
+	for ( cgltf_size j = 0; j < src->channels_count; ++j )
+	{
+		const cgltf_animation_channel* src_channel = &src_channels[ j ];
+		struct ft_animation_channel*   dst_channel = &dst->channels[ j ];
+		dst_channel->sampler =
+		    dst->samplers + ( src_channel->sampler - src_samplers );
+
+		struct node_map_item* it =
+		    hashmap_get( node_map,
+		                 &( struct node_map_item ) {
+		                     .node = src_channel->target_node,
+		                 } );
+
+		if ( it != NULL )
+		{
+			dst_channel->target = it->index;
+		}
+		else
+		{
+			FT_WARN(
+			    "no scene root contains node %s for animation %s in channel %d",
+			    src_channel->target_node->name,
+			    src->name,
+			    j );
+		}
+
+		switch ( src_channel->target_path )
+		{
+		case cgltf_animation_path_type_translation:
+			dst_channel->transform_type = FT_TRANSFORM_TYPE_TRANSLATION;
+			break;
+		case cgltf_animation_path_type_rotation:
+			dst_channel->transform_type = FT_TRANSFORM_TYPE_ROTATION;
+			break;
+		case cgltf_animation_path_type_scale:
+			dst_channel->transform_type = FT_TRANSFORM_TYPE_SCALE;
+			break;
+		case cgltf_animation_path_type_weights:
+			dst_channel->transform_type = FT_TRANSFORM_TYPE_WEIGHTS;
+			break;
+		default: break;
+		}
+	}
+}
+
+static struct hashmap*
+create_node_map( void )
+{
+	return hashmap_new( sizeof( struct node_map_item ),
+	                    0,
+	                    0,
+	                    0,
+	                    hash_node_map_item,
+	                    compare_node_map_item,
+	                    NULL,
+	                    NULL );
+}
+
+static struct hashmap*
+create_image_map( const cgltf_data* data )
+{
+	struct hashmap* image_map = hashmap_new( sizeof( struct image_map_item ),
+	                                         0,
+	                                         0,
+	                                         0,
+	                                         hash_image_map_item,
+	                                         compare_image_map_item,
+	                                         NULL,
+	                                         NULL );
+
+	for ( cgltf_size t = 0; t < data->textures_count; ++t )
+	{
+		hashmap_set( image_map,
+		             &( struct image_map_item ) {
+		                 .image = data->textures[ t ].image,
+		                 .index = t,
+		             } );
+	}
+
+	return image_map;
+}
+
+static void
+read_gltf_animations( struct ft_model*  model,
+                      const cgltf_data* data,
+                      struct hashmap*   node_map )
+{
+	model->animation_count = data->animations_count;
+	model->animations      = NULL;
+
+	if ( model->animation_count > 0 )
+	{
+		model->animations =
+		    calloc( model->animation_count, sizeof( struct ft_animation ) );
+	}
+
+	for ( cgltf_size a = 0; a < model->animation_count; ++a )
+	{
+		cgltf_animation*         animation = &data->animations[ a ];
+		cgltf_animation_sampler* samplers  = animation->samplers;
+
+		model->animations[ a ].samplers =
+		    calloc( animation->samplers_count,
+		            sizeof( struct ft_animation_sampler ) );
+		model->animations[ a ].sampler_count = animation->samplers_count;
+
+		for ( cgltf_size s = 0; s < animation->samplers_count; ++s )
+		{
+			struct ft_animation_sampler* sampler =
+			    &model->animations[ a ].samplers[ s ];
+
+			read_animation_samplers( &samplers[ s ], sampler );
+
+			if ( sampler->times[ sampler->frame_count - 1 ] >
+			     model->animations[ a ].duration )
+			{
+				model->animations[ a ].duration =
+				    sampler->times[ sampler->frame_count - 1 ];
+			}
+		}
+
+		read_animation_channels( node_map,
+		                         animation,
+		                         &model->animations[ a ] );
+	}
+}
+
+static bool
+get_meshopt_layout( const cgltf_meshopt_compression* mc,
+                    enum ft_meshopt_mode*            mode,
+                    enum ft_meshopt_filter*          filter )
+{
+	switch ( mc->mode )
+	{
+	case cgltf_meshopt_compression_mode_attributes:
+		*mode = FT_MESHOPT_MODE_ATTRIBUTES;
+		break;
+	case cgltf_meshopt_compression_mode_triangles:
+		*mode = FT_MESHOPT_MODE_TRIANGLES;
+		break;
+	case cgltf_meshopt_compression_mode_indices:
+		*mode = FT_MESHOPT_MODE_INDICES;
+		break;
+	default: return false;
+	}
+
+	switch ( mc->filter )
+	{
+	case cgltf_meshopt_compression_filter_none:
+		*filter = FT_MESHOPT_FILTER_NONE;
+		break;
+	case cgltf_meshopt_compression_filter_octahedral:
+		*filter = FT_MESHOPT_FILTER_OCTAHEDRAL;
+		break;
+	case cgltf_meshopt_compression_filter_quaternion:
+		*filter = FT_MESHOPT_FILTER_QUATERNION;
+		break;
+	case cgltf_meshopt_compression_filter_exponential:
+		*filter = FT_MESHOPT_FILTER_EXPONENTIAL;
+		break;
+	default: return false;
+	}
+
+	return true;
+}
+
+// decoded view is left without data on failure
+static void
+decode_meshopt_view( void* arg )
+{
+	cgltf_buffer_view*         view = arg;
+	cgltf_meshopt_compression* mc   = &view->meshopt_compression;
+
+	enum ft_meshopt_mode   mode;
+	enum ft_meshopt_filter filter;
+
+	if ( mc->buffer == NULL || mc->buffer->data == NULL ||
+	     mc->offset + mc->size > mc->buffer->size ||
+	     !get_meshopt_layout( mc, &mode, &filter ) )
+	{
+		return;
+	}
+
+	void* data = malloc( mc->count * mc->stride );
+
+	if ( ft_decode_meshopt_buffer( data,
+	                               mc->count,
+	                               ( uint32_t ) mc->stride,
+	                               mode,
+	                               filter,
+	                               ( const uint8_t* ) mc->buffer->data +
+	                                   mc->offset,
+	                               mc->size ) )
+	{
+		view->data = data;
+	}
+	else
+	{
+		free( data );
+	}
+}
+
+// accessors without buffer view read as zeros, that is all draco
+// primitives have when their uncompressed copy is left out
+static bool
+has_fallback_accessors( const cgltf_primitive* primitive )
+{
+	if ( primitive->indices && primitive->indices->buffer_view == NULL )
+	{
+		return false;
+	}
+
+	for ( cgltf_size a = 0; a < primitive->attributes_count; ++a )
+	{
+		if ( primitive->attributes[ a ].data->buffer_view == NULL )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// EXT_meshopt_compression views are decoded into view data which cgltf
+// reads instead of buffer, so uncompressed fallback buffers may be absent.
+// every view is decoded in its own task on loader pool
+static cgltf_result
+decode_compressed_buffers( cgltf_data*            data,
+                           const char*            filename,
+                           struct ft_thread_pool* pool )
+{
+	struct ft_task_group group      = { 0 };
+	uint32_t             view_count = 0;
+
+	for ( cgltf_size v = 0; v < data->buffer_views_count; ++v )
+	{
+		cgltf_buffer_view* view = &data->buffer_views[ v ];
+
+		if ( view->has_meshopt_compression && view->data == NULL )
+		{
+			ft_thread_pool_push_group( pool,
+			                           &group,
+			                           decode_meshopt_view,
+			                           view );
+			view_count++;
+		}
+	}
+
+	if ( view_count > 0 )
+	{
+		ft_thread_pool_wait_group( pool, &group );
+
+		for ( cgltf_size v = 0; v < data->buffer_views_count; ++v )
+		{
+			if ( data->buffer_views[ v ].has_meshopt_compression &&
+			     data->buffer_views[ v ].data == NULL )
+			{
+				FT_WARN( "failed to decode meshopt buffer view %u %s",
+				         ( uint32_t ) v,
+				         filename );
+				return cgltf_result_invalid_gltf;
+			}
+		}
+	}
+
+	// no draco decoder is linked, only uncompressed fallback accessors
+	// can be read. without them primitive would load zero filled
+	for ( cgltf_size m = 0; m < data->meshes_count; ++m )
+	{
+		for ( cgltf_size p = 0; p < data->meshes[ m ].primitives_count; ++p )
+		{
+			const cgltf_primitive* primitive =
+			    &data->meshes[ m ].primitives[ p ];
+
+			if ( primitive->has_draco_mesh_compression &&
+			     !has_fallback_accessors( primitive ) )
+			{
+				FT_WARN( "draco compressed primitive without uncompressed "
+				         "fallback not supported %s",
+				         filename );
+				return cgltf_result_invalid_gltf;
+			}
+		}
+	}
+
+	return cgltf_result_success;
+}
+
+struct ft_model
+ft_load_gltf( const char*            filename,
+              enum ft_model_flags    load_flags,
+              struct ft_thread_pool* pool )
+{
+	struct ft_model model;
+	memset( &model, 0, sizeof( struct ft_model ) );
+
+	uint64_t data_size = 0;
+	uint8_t* file_data = ft_read_file_binary( filename, &data_size );
+
+	if ( file_data == NULL )
+	{
+		FT_WARN( "failed to read gltf file %s", filename );
+		return model;
+	}
+
+	struct ft_thread_pool* owned_pool = NULL;
+
+	if ( pool == NULL )
+	{
+		owned_pool = create_loader_pool();
+		pool       = owned_pool;
+	}
+
+	cgltf_options options = { 0 };
+	cgltf_data*   data    = NULL;
+	cgltf_result  result = cgltf_parse( &options, file_data, data_size, &data );
+
+	if ( result == cgltf_result_success )
+	{
+		result = cgltf_load_buffers( &options, data, filename );
+
+		if ( result == cgltf_result_success )
+		{
+			result = decode_compressed_buffers( data, filename, pool );
+		}
+
+		if ( result == cgltf_result_success )
+		{
+			if ( data->scenes_count > 1 )
+			{
+				FT_WARN( "multiple scenes gltf not supported %s", filename );
+				data->scenes_count = 1;
+			}
+
+			struct hashmap* node_map  = create_node_map();
+			struct hashmap* image_map = create_image_map( data );
+
+			model.texture_count = data->textures_count;
+			model.textures =
+			    calloc( model.texture_count, sizeof( struct ft_texture ) );
+
+			// decode textures while geometry is processed
+			if ( model.texture_count > 0 )
+			{
+				model.texture_decoder =
+				    create_texture_decoder( &model,
+				                            data,
+				                            file_data,
+				                            filename,
+				                            load_flags,
+				                            pool );
+			}
+
+			for ( cgltf_size s = 0; s < data->scenes_count; ++s )
+			{
+				cgltf_scene* scene = &data->scenes[ s ];
+
+				cgltf_node** nodes = build_scene_graph( &model.scene_graph,
+				                                        node_map,
+				                                        data,
+				                                        scene );
+
+				uint32_t primitive_count =
+				    count_scene_primitives( &model.scene_graph, nodes );
+
+				if ( primitive_count == 0 )
+				{
+					free( nodes );
+					continue;
+				}
+
+				model.meshes =
+				    calloc( primitive_count, sizeof( struct ft_mesh ) );
+
+				struct hashmap* primitive_map = create_primitive_map();
+
+				for ( uint32_t n = 0; n < model.scene_graph.node_count; ++n )
+				{
+					process_gltf_node( primitive_map,
+					                   image_map,
+					                   &model.scene_graph,
+					                   n,
+					                   nodes[ n ],
+					                   &model );
+				}
+
+				hashmap_free( primitive_map );
+				free( nodes );
+
+				model.meshes = realloc( model.meshes,
+				                        model.mesh_count *
+				                            sizeof( struct ft_mesh ) );
+			}
+
+			ft_compute_model_bounds( &model );
+
+			read_gltf_animations( &model, data, node_map );
+
+			hashmap_free( image_map );
+			hashmap_free( node_map );
+
+			if ( load_flags & FT_MODEL_OPTIMIZE_MESHES )
+			{
+				for ( uint32_t m = 0; m < model.mesh_count; ++m )
+				{
+					ft_optimize_mesh( &model.meshes[ m ] );
+				}
+			}
+
+			if ( load_flags & FT_MODEL_GENERATE_TANGENTS )
+			{
+				ft_generate_model_tangents( &model, pool );
+			}
+
+			if ( load_flags & FT_MODEL_OPTIMIZE_MESHES )
+			{
+				ft_narrow_model_indices( &model );
+			}
+
+			if ( load_flags & FT_MODEL_GENERATE_LODS )
+			{
+				for ( uint32_t m = 0; m < model.mesh_count; ++m )
+				{
+					ft_generate_mesh_lods( &model.meshes[ m ] );
+				}
+			}
+
+			if ( load_flags & FT_MODEL_GENERATE_MESHLETS )
+			{
+				for ( uint32_t m = 0; m < model.mesh_count; ++m )
+				{
+					ft_build_meshlets( &model.meshes[ m ] );
+				}
+			}
+
+			if ( load_flags & FT_MODEL_PACK_VERTICES )
+			{
+				for ( uint32_t m = 0; m < model.mesh_count; ++m )
+				{
+					ft_pack_mesh_vertices( &model.meshes[ m ], load_flags );
+				}
+			}
+
+			if ( model.texture_decoder )
+			{
+				// decoder owns gltf and file data and pool created for
+				// this load from now on
+				data                              = NULL;
+				file_data                         = NULL;
+				model.texture_decoder->owned_pool = owned_pool;
+				owned_pool                        = NULL;
+
+				if ( !( load_flags & FT_MODEL_ASYNC_TEXTURES ) )
+				{
+					ft_model_wait_textures( &model );
+				}
+			}
+		}
+		else
+		{
+			FT_WARN( "failed to load gltf buffers %s", filename );
+		}
+
+		cgltf_free( data );
+	}
+	else
+	{
+		FT_WARN( "failed to parse gltf %s", filename );
+	}
+
+	ft_free_file_data( file_data );
+	destroy_loader_pool( owned_pool );
+
+	return model;
+}
+
+FT_INLINE void
+free_mesh( struct ft_mesh* mesh )
+{
+	ft_safe_free( mesh->positions );
+	ft_safe_free( mesh->texcoords );
+	ft_safe_free( mesh->normals );
+	ft_safe_free( mesh->tangents );
+	ft_safe_free( mesh->joints );
+	ft_safe_free( mesh->weights );
+	ft_safe_free( mesh->indices_16 );
+	ft_safe_free( mesh->indices_32 );
+	ft_free_packed_vertices( &mesh->packed_vertices );
+	ft_free_meshlets( &mesh->meshlets );
+	ft_free_mesh_lods( mesh );
+	ft_safe_free( mesh->instance_nodes );
+	ft_safe_free( mesh->instance_transforms );
+}
+
+// largest side of texture delivered in coarse stage, first fine stage
+// delivers levels up to twice as large and each later one next larger level
+#define STREAM_PREVIEW_SIZE      64
+// meshes with fewer triangles are fully processed in coarse stage
+#define STREAM_PREVIEW_TRIANGLES 4096
+// cells along longest side of clustered mesh preview
+#define STREAM_PREVIEW_GRID      16
+
+// coarse stages of every asset run before any fine stage
+enum stream_stage
+{
+	STREAM_STAGE_COARSE_MESH,
+	STREAM_STAGE_COARSE_TEXTURE,
+	STREAM_STAGE_FINE_MESH,
+	STREAM_STAGE_FINE_TEXTURE,
+};
+
+struct stream_asset
+{
+	enum ft_model_asset_type type;
+	uint32_t                 index;
+	// from camera to nearest surface using asset
+	float                    distance;
+	// mesh accessors lack position min and max
+	bool                     missing_bounds;
+	// coarse stage left work for fine stage, last fine stage clears it
+	bool                     fine_stage;
+	bool                     complete;
+	// rgba8 texture still waits for mips or compression
+	bool                     process;
+	// texture levels from this one on are delivered
+	uint32_t                 first_level;
+	// largest side of level next fine stage delivers, smaller go first
+	uint32_t                 level_size;
+};
+
+struct ft_model_streamer
+{
+	// pool of caller, owned pool is set when streamer created it
+	struct ft_thread_pool*     pool;
+	struct ft_thread_pool*     owned_pool;
+	struct ft_task_group       group;
+	struct ft_mutex            mutex;
+	// gltf data stays alive until every asset is streamed
+	cgltf_data*                data;
+	uint8_t*                   file_data;
+	char*                      filename;
+	enum ft_model_flags        flags;
+	ft_model_stream_callback   callback;
+	void*                      user_data;
+	float3                     camera_position;
+	uint32_t                   mesh_count;
+	struct ft_mesh*            meshes;
+	cgltf_primitive**          primitives;
+	struct texture_decode_job* texture_jobs;
+	// clustered meshes of coarse stage, freed by fine stage
+	struct ft_mesh*            mesh_previews;
+	// downsampled textures of coarse stage, freed by fine stage
+	struct ft_texture*         texture_previews;
+	// rgba8 mip chains fine stages compress level by level
+	struct ft_texture*         texture_sources;
+	// meshes first, textures after them
+	uint32_t                   asset_count;
+	struct stream_asset*       assets;
+	// binary heap of queued stages, entry is asset index times two plus one
+	// for fine stages
+	uint32_t                   queue_size;
+	uint32_t*                  queue;
+};
+
+// parsed gltf with loaded buffers, null on failure
+static cgltf_data*
+load_gltf_data( const char*            filename,
+                uint8_t**              file_data,
+                struct ft_thread_pool* pool )
+{
+	uint64_t data_size = 0;
+	*file_data         = ft_read_file_binary( filename, &data_size );
+
+	if ( *file_data == NULL )
+	{
+		FT_WARN( "failed to read gltf file %s", filename );
+		return NULL;
+	}
+
+	cgltf_options options = { 0 };
+	cgltf_data*   data    = NULL;
+	cgltf_result  result =
+	    cgltf_parse( &options, *file_data, data_size, &data );
+
+	if ( result != cgltf_result_success )
+	{
+		FT_WARN( "failed to parse gltf %s", filename );
+		ft_free_file_data( *file_data );
+		return NULL;
+	}
+
+	result = cgltf_load_buffers( &options, data, filename );
+
+	if ( result == cgltf_result_success )
+	{
+		result = decode_compressed_buffers( data, filename, pool );
+	}
+
+	if ( result != cgltf_result_success )
+	{
+		FT_WARN( "failed to load gltf buffers %s", filename );
+		cgltf_free( data );
+		ft_free_file_data( *file_data );
+		return NULL;
+	}
+
+	if ( data->scenes_count > 1 )
+	{
+		FT_WARN( "multiple scenes gltf not supported %s", filename );
+		data->scenes_count = 1;
+	}
+
+	return data;
+}
+
+// distance from point to nearest instance of mesh bounds
+static float
+get_instances_distance( const struct ft_mesh* mesh, const float3 point )
+{
+	float  distance = FLT_MAX;
+	float4 center   = { 0.0f, 0.0f, 0.0f, 1.0f };
+	float3_dup( center, mesh->bounds.center );
+
+	for ( uint32_t i = 0; i < mesh->instance_count; ++i )
+	{
+		float4x4* world = &mesh->instance_transforms[ i ];
+		float     scale = 0.0f;
+
+		for ( uint32_t c = 0; c < 3; ++c )
+		{
+			scale = FT_MAX( scale, float3_len( ( *world )[ c ] ) );
+		}
+
+		float4 world_center;
+		float4x4_mul_float4( world_center, *world, center );
+
+		float3 offset;
+		float3_sub( offset, world_center, point );
+
+		float d  = float3_len( offset ) - mesh->bounds.radius * scale;
+		distance = FT_MIN( distance, FT_MAX( d, 0.0f ) );
 	}
+
+	return distance;
 }
 
-FT_INLINE void
-generate_tangents( struct ft_model* model )
+FT_INLINE enum stream_stage
+get_stream_stage( const struct ft_model_streamer* streamer, uint32_t entry )
 {
-	for ( uint32_t m = 0; m < model->mesh_count; ++m )
+	bool mesh = streamer->assets[ entry / 2 ].type == FT_MODEL_ASSET_MESH;
+
+	if ( entry % 2 )
+	{
+		return mesh ? STREAM_STAGE_FINE_MESH : STREAM_STAGE_FINE_TEXTURE;
+	}
+
+	return mesh ? STREAM_STAGE_COARSE_MESH : STREAM_STAGE_COARSE_TEXTURE;
+}
+
+FT_INLINE bool
+stream_entry_before( const struct ft_model_streamer* streamer,
+                     uint32_t                        a,
+                     uint32_t                        b )
+{
+	enum stream_stage stage_a = get_stream_stage( streamer, a );
+	enum stream_stage stage_b = get_stream_stage( streamer, b );
+
+	if ( stage_a != stage_b )
 	{
-		struct ft_mesh* mesh = &model->meshes[ m ];
+		return stage_a < stage_b;
+	}
+
+	const struct stream_asset* asset_a = &streamer->assets[ a / 2 ];
+	const struct stream_asset* asset_b = &streamer->assets[ b / 2 ];
+
+	// small mips of every texture come before large ones of any
+	if ( stage_a == STREAM_STAGE_FINE_TEXTURE &&
+	     asset_a->level_size != asset_b->level_size )
+	{
+		return asset_a->level_size < asset_b->level_size;
+	}
+
+	return asset_a->distance < asset_b->distance;
+}
+
+static void
+sift_stream_entry_down( struct ft_model_streamer* streamer, uint32_t i )
+{
+	uint32_t* queue = streamer->queue;
+
+	for ( ;; )
+	{
+		uint32_t first = i;
+		uint32_t left  = i * 2 + 1;
+		uint32_t right = i * 2 + 2;
 
-		if ( mesh->tangents )
+		if ( left < streamer->queue_size &&
+		     stream_entry_before( streamer, queue[ left ], queue[ first ] ) )
 		{
-			continue;
+			first = left;
+		}
+
+		if ( right < streamer->queue_size &&
+		     stream_entry_before( streamer, queue[ right ], queue[ first ] ) )
+		{
+			first = right;
+		}
+
+		if ( first == i )
+		{
+			return;
+		}
+
+		uint32_t entry = queue[ i ];
+		queue[ i ]     = queue[ first ];
+		queue[ first ] = entry;
+		i              = first;
+	}
+}
+
+static void
+push_stream_entry( struct ft_model_streamer* streamer, uint32_t entry )
+{
+	uint32_t* queue = streamer->queue;
+	uint32_t  i     = streamer->queue_size++;
+
+	queue[ i ] = entry;
+
+	while ( i > 0 )
+	{
+		uint32_t parent = ( i - 1 ) / 2;
+
+		if ( !stream_entry_before( streamer, queue[ i ], queue[ parent ] ) )
+		{
+			break;
 		}
 
-		mesh->tangents = malloc( mesh->vertex_count * 4 * sizeof( float ) );
+		queue[ i ]      = queue[ parent ];
+		queue[ parent ] = entry;
+		i               = parent;
+	}
+}
+
+static uint32_t
+pop_stream_entry( struct ft_model_streamer* streamer )
+{
+	FT_ASSERT( streamer->queue_size > 0 );
+
+	uint32_t entry       = streamer->queue[ 0 ];
+	streamer->queue[ 0 ] = streamer->queue[ --streamer->queue_size ];
+	sift_stream_entry_down( streamer, 0 );
+
+	return entry;
+}
+
+// texture distance is distance of closest mesh using it
+static void
+update_stream_distances( struct ft_model_streamer* streamer )
+{
+	struct stream_asset* textures = &streamer->assets[ streamer->mesh_count ];
+
+	for ( uint32_t a = streamer->mesh_count; a < streamer->asset_count; ++a )
+	{
+		streamer->assets[ a ].distance = FLT_MAX;
+	}
+
+	for ( uint32_t m = 0; m < streamer->mesh_count; ++m )
+	{
+		const struct ft_mesh* mesh = &streamer->meshes[ m ];
+
+		float distance =
+		    get_instances_distance( mesh, streamer->camera_position );
+		streamer->assets[ m ].distance = distance;
 
-		if ( !mesh->texcoords )
+		const struct ft_material* material = &mesh->material;
+
+		for ( uint32_t t = 0; t < FT_TEXTURE_TYPE_COUNT; ++t )
 		{
-			FT_WARN( "mesh %d does not contain texture coordinates. cannot "
-			         "generate tangents",
-			         m );
+			int32_t texture = material->textures[ t ];
 
-			for ( uint32_t v = 0; v < mesh->vertex_count; ++v )
+			if ( texture >= 0 )
 			{
-				float* tangent = mesh->tangents + v * 4;
-				tangent[ 0 ]   = 1;
-				tangent[ 1 ]   = 1;
-				tangent[ 2 ]   = 1;
-				tangent[ 3 ]   = 1;
+				textures[ texture ].distance =
+				    FT_MIN( textures[ texture ].distance, distance );
 			}
 		}
-		else
+	}
+
+	for ( uint32_t i = streamer->queue_size / 2; i-- > 0; )
+	{
+		sift_stream_entry_down( streamer, i );
+	}
+}
+
+// preview shares material and instances with its mesh, they are released
+// with mesh only
+static void
+free_mesh_preview( struct ft_mesh* preview )
+{
+	preview->instance_nodes      = NULL;
+	preview->instance_transforms = NULL;
+	free_mesh( preview );
+	memset( preview, 0, sizeof( struct ft_mesh ) );
+}
+
+// clustered stand in for mesh until fine stage processes it, small meshes
+// and ones clustering barely reduces get no preview
+static bool
+build_mesh_preview( struct ft_mesh*       preview,
+                    const struct ft_mesh* mesh,
+                    enum ft_model_flags   flags )
+{
+	uint32_t index_count =
+	    mesh->index_count > 0 ? mesh->index_count : mesh->vertex_count;
+
+	if ( index_count < STREAM_PREVIEW_TRIANGLES * 3 ||
+	     !ft_cluster_mesh( preview, mesh, STREAM_PREVIEW_GRID ) )
+	{
+		return false;
+	}
+
+	if ( preview->index_count * 2 > index_count )
+	{
+		free_mesh_preview( preview );
+		return false;
+	}
+
+	memcpy( preview->world, mesh->world, sizeof( float4x4 ) );
+	preview->bounds              = mesh->bounds;
+	preview->material            = mesh->material;
+	preview->node                = mesh->node;
+	preview->instance_count      = mesh->instance_count;
+	preview->instance_nodes      = mesh->instance_nodes;
+	preview->instance_transforms = mesh->instance_transforms;
+
+	if ( ( flags & FT_MODEL_GENERATE_TANGENTS ) && preview->tangents == NULL )
+	{
+		ft_generate_mesh_tangents( preview, NULL );
+	}
+
+	if ( flags & FT_MODEL_PACK_VERTICES )
+	{
+		ft_pack_mesh_vertices( preview, flags );
+	}
+
+	return true;
+}
+
+// passes of ft_load_gltf in same order, indices stay 32 bit
+static void
+process_stream_mesh( struct ft_mesh*        mesh,
+                     enum ft_model_flags    flags,
+                     struct ft_thread_pool* pool )
+{
+	if ( flags & FT_MODEL_OPTIMIZE_MESHES )
+	{
+		ft_optimize_mesh( mesh );
+	}
+
+	if ( ( flags & FT_MODEL_GENERATE_TANGENTS ) && mesh->tangents == NULL )
+	{
+		ft_generate_mesh_tangents( mesh, pool );
+	}
+
+	if ( flags & FT_MODEL_GENERATE_LODS )
+	{
+		ft_generate_mesh_lods( mesh );
+	}
+
+	if ( flags & FT_MODEL_GENERATE_MESHLETS )
+	{
+		ft_build_meshlets( mesh );
+	}
+
+	if ( flags & FT_MODEL_PACK_VERTICES )
+	{
+		ft_pack_mesh_vertices( mesh, flags );
+	}
+}
+
+static void
+stream_mesh( struct ft_model_streamer*     streamer,
+             struct stream_asset*          asset,
+             bool                          fine,
+             struct ft_model_stream_event* event )
+{
+	struct ft_mesh* mesh    = &streamer->meshes[ asset->index ];
+	struct ft_mesh* preview = &streamer->mesh_previews[ asset->index ];
+	event->mesh             = mesh;
+
+	if ( fine )
+	{
+		// preview was valid during coarse event only
+		free_mesh_preview( preview );
+	}
+	else
+	{
+		read_gltf_geometry( streamer->primitives[ asset->index ], mesh );
+
+		if ( asset->missing_bounds )
+		{
+			// other threads read bounds for distances, so they are computed
+			// aside and published under lock
+			struct ft_mesh positions = {
+				.vertex_count = mesh->vertex_count,
+				.positions    = mesh->positions,
+			};
+			ft_compute_mesh_bounds( &positions );
+
+			ft_mutex_lock( &streamer->mutex );
+			mesh->bounds = positions.bounds;
+			update_stream_distances( streamer );
+			ft_mutex_unlock( &streamer->mutex );
+		}
+
+		// coarsest lod goes first, mesh itself waits for fine stage
+		asset->fine_stage =
+		    build_mesh_preview( preview, mesh, streamer->flags );
+
+		if ( asset->fine_stage )
+		{
+			event->mesh        = preview;
+			event->level_count = 1;
+			return;
+		}
+	}
+
+	process_stream_mesh( mesh, streamer->flags, streamer->pool );
+
+	asset->fine_stage  = false;
+	event->level_count = mesh->lod_count + 1;
+}
+
+// box filtered copy of rgba8 texture with largest side at most preview size,
+// srgb texels are averaged as stored which is good enough for preview
+static void
+downsample_texture( struct ft_texture*       preview,
+                    const struct ft_texture* texture )
+{
+	uint32_t shift = 0;
+
+	while ( FT_MAX( texture->width, texture->height ) >> shift >
+	        STREAM_PREVIEW_SIZE )
+	{
+		shift++;
+	}
+
+	preview->width      = FT_MAX( texture->width >> shift, 1 );
+	preview->height     = FT_MAX( texture->height >> shift, 1 );
+	preview->mip_levels = 1;
+	preview->format     = texture->format;
+	preview->data       = malloc( preview->width * preview->height * 4 );
+
+	const uint8_t* src  = texture->data;
+	uint8_t*       dst  = preview->data;
+	uint32_t       step = 1u << shift;
+
+	for ( uint32_t y = 0; y < preview->height; ++y )
+	{
+		uint32_t y_end = FT_MIN( ( y + 1 ) * step, texture->height );
+
+		for ( uint32_t x = 0; x < preview->width; ++x )
 		{
-			for ( uint32_t i = 0; i < mesh->index_count; i += 3 )
+			uint32_t x_end    = FT_MIN( ( x + 1 ) * step, texture->width );
+			uint32_t sum[ 4 ] = { 0, 0, 0, 0 };
+			uint32_t count    = 0;
+
+			for ( uint32_t sy = y * step; sy < y_end; ++sy )
 			{
-				uint32_t i0;
-				uint32_t i1;
-				uint32_t i2;
+				const uint8_t* row =
+				    src + ( ( uint64_t ) sy * texture->width ) * 4;
 
-				if ( mesh->indices_16 )
-				{
-					i0 = mesh->indices_16[ i ];
-					i1 = mesh->indices_16[ i + 1 ];
-					i2 = mesh->indices_16[ i + 2 ];
-				}
-				else
+				for ( uint32_t sx = x * step; sx < x_end; ++sx )
 				{
-					i0 = mesh->indices_32[ i ];
-					i1 = mesh->indices_32[ i + 1 ];
-					i2 = mesh->indices_32[ i + 2 ];
+					for ( uint32_t c = 0; c < 4; ++c )
+					{
+						sum[ c ] += row[ sx * 4 + c ];
+					}
 				}
 
-				float* p0 = &mesh->positions[ i0 * 3 ];
-				float* p1 = &mesh->positions[ i1 * 3 ];
-				float* p2 = &mesh->positions[ i2 * 3 ];
-
-				float* uv0 = &mesh->texcoords[ i0 * 2 ];
-				float* uv1 = &mesh->texcoords[ i1 * 2 ];
-				float* uv2 = &mesh->texcoords[ i2 * 2 ];
-
-				float3 edge0 = {
-				    p1[ 0 ] - p0[ 0 ],
-				    p1[ 1 ] - p0[ 1 ],
-				    p1[ 2 ] - p0[ 2 ],
-				};
-
-				float3 edge1 = {
-				    p2[ 0 ] - p1[ 0 ],
-				    p2[ 1 ] - p1[ 1 ],
-				    p2[ 2 ] - p1[ 2 ],
-				};
-
-				float2 delta_uv0 = {
-				    uv1[ 0 ] - uv0[ 0 ],
-				    uv1[ 1 ] - uv0[ 1 ],
-				};
-
-				float2 delta_uv1 = {
-				    uv2[ 0 ] - uv1[ 0 ],
-				    uv2[ 1 ] - uv1[ 1 ],
-				};
-
-				float denominator = ( delta_uv0[ 0 ] * delta_uv1[ 1 ] -
-				                      delta_uv1[ 0 ] * delta_uv0[ 1 ] );
-				if ( denominator == 0 )
-				{
-					denominator = 0.0001;
-				}
+				count += x_end - x * step;
+			}
+
+			for ( uint32_t c = 0; c < 4; ++c )
+			{
+				dst[ ( y * preview->width + x ) * 4 + c ] =
+				    ( uint8_t ) ( ( sum[ c ] + count / 2 ) / count );
+			}
+		}
+	}
+}
+
+// first level next fine stage delivers, levels up to twice preview size
+// come together and larger ones one by one
+FT_INLINE uint32_t
+get_next_stream_level( const struct ft_texture* texture, uint32_t first_level )
+{
+	uint32_t size  = FT_MAX( texture->width, texture->height );
+	uint32_t level = first_level - 1;
 
-				float f = 1.0f / denominator;
+	while ( level > 0 && size >> ( level - 1 ) <= 2 * STREAM_PREVIEW_SIZE )
+	{
+		level--;
+	}
 
-				float4 tangent = {
-				    f * ( delta_uv1[ 1 ] * edge0[ 0 ] -
-				          delta_uv0[ 1 ] * edge1[ 0 ] ),
-				    f * ( delta_uv1[ 1 ] * edge0[ 1 ] -
-				          delta_uv0[ 1 ] * edge1[ 1 ] ),
-				    f * ( delta_uv1[ 1 ] * edge0[ 2 ] -
-				          delta_uv0[ 1 ] * edge1[ 2 ] ),
-				    1.0,
-				};
+	return level;
+}
 
-				float4_norm( tangent, tangent );
+// mips of whole texture, compressed chain is only allocated here and filled
+// level by level from rgba8 source by later fine stages
+static void
+prepare_stream_texture( struct ft_model_streamer*        streamer,
+                        const struct texture_decode_job* job,
+                        struct ft_texture*               source )
+{
+	struct ft_texture image = *job->texture;
 
-				float4_dup( &mesh->tangents[ i0 * 4 ], tangent );
-				float4_dup( &mesh->tangents[ i1 * 4 ], tangent );
-				float4_dup( &mesh->tangents[ i2 * 4 ], tangent );
-			}
+	if ( ( streamer->flags & FT_MODEL_GENERATE_MIPS ) && image.mip_levels == 1 )
+	{
+		ft_generate_texture_mips(
+		    &image,
+		    FT_MIP_FILTER_KAISER,
+		    job->alpha_cutoff,
+		    get_image_pool( image.width, image.height, streamer->pool ) );
+	}
+
+	enum ft_format format =
+	    ( streamer->flags & FT_MODEL_COMPRESS_TEXTURES )
+	        ? ft_get_block_compressed_format( job->texture_type, image.format )
+	        : FT_FORMAT_UNDEFINED;
+
+	if ( format != FT_FORMAT_UNDEFINED )
+	{
+		*source      = image;
+		image.format = format;
+		image.data   =
+		    malloc( ft_texture_mip_offset( &image, image.mip_levels ) );
+	}
+
+	set_texture_image( job, &image );
+}
+
+static void
+stream_texture_levels( struct ft_model_streamer*     streamer,
+                       struct stream_asset*          asset,
+                       struct ft_model_stream_event* event )
+{
+	struct texture_decode_job* job = &streamer->texture_jobs[ asset->index ];
+
+	struct ft_texture* texture = job->texture;
+	struct ft_texture* source  = &streamer->texture_sources[ asset->index ];
+
+	if ( asset->process )
+	{
+		// preview was valid during coarse event only
+		struct ft_texture* preview =
+		    &streamer->texture_previews[ asset->index ];
+		free( preview->data );
+		memset( preview, 0, sizeof( struct ft_texture ) );
+
+		// processed chain is delivered again from its smallest level
+		prepare_stream_texture( streamer, job, source );
+		asset->process     = false;
+		asset->first_level = texture->mip_levels;
+	}
+
+	uint32_t level = get_next_stream_level( texture, asset->first_level );
+
+	if ( source->data )
+	{
+		ft_compress_texture_mips(
+		    source,
+		    level,
+		    asset->first_level - level,
+		    texture->format,
+		    texture->data,
+		    get_image_pool( FT_MAX( source->width >> level, 1 ),
+		                    FT_MAX( source->height >> level, 1 ),
+		                    streamer->pool ) );
+	}
+
+	asset->first_level = level;
+	asset->fine_stage  = level > 0;
+	event->first_level = level;
+	event->level_count = texture->mip_levels - level;
+
+	if ( asset->fine_stage )
+	{
+		asset->level_size = FT_MAX( texture->width, texture->height ) >>
+		                    get_next_stream_level( texture, level );
+	}
+	else if ( source->data )
+	{
+		free( source->data );
+		memset( source, 0, sizeof( struct ft_texture ) );
+	}
+}
+
+static void
+stream_texture( struct ft_model_streamer*     streamer,
+                struct stream_asset*          asset,
+                bool                          fine,
+                struct ft_model_stream_event* event )
+{
+	struct texture_decode_job* job = &streamer->texture_jobs[ asset->index ];
+
+	struct ft_texture* texture = job->texture;
+	struct ft_texture* preview = &streamer->texture_previews[ asset->index ];
+
+	bool generate_mips = streamer->flags & FT_MODEL_GENERATE_MIPS;
+	bool compress      = streamer->flags & FT_MODEL_COMPRESS_TEXTURES;
+
+	event->texture = texture;
+
+	if ( fine )
+	{
+		stream_texture_levels( streamer, asset, event );
+		return;
+	}
+
+	// full decode can not be avoided for png and jpeg, mips and
+	// compression are what fine stages defer
+	struct ft_texture image = load_texture_image( job, streamer->filename );
+	set_texture_image( job, &image );
+
+	bool rgba8 = texture->format == FT_FORMAT_R8G8B8A8_UNORM ||
+	             texture->format == FT_FORMAT_R8G8B8A8_SRGB;
+	bool large =
+	    FT_MAX( texture->width, texture->height ) > STREAM_PREVIEW_SIZE;
+	bool mips = generate_mips && texture->mip_levels == 1;
+
+	asset->process = rgba8 && ( mips || compress );
+
+	// stored mip chain, e.g. of ktx2, already holds small levels
+	uint32_t first = 0;
+
+	while ( first + 1 < texture->mip_levels &&
+	        FT_MAX( texture->width, texture->height ) >> first >
+	            STREAM_PREVIEW_SIZE )
+	{
+		first++;
+	}
+
+	if ( first > 0 )
+	{
+		event->first_level = first;
+		event->level_count = texture->mip_levels - first;
+	}
+	else if ( asset->process && large )
+	{
+		downsample_texture( preview, texture );
+		preview->texture_type = texture->texture_type;
+
+		if ( generate_mips )
+		{
+			ft_generate_texture_mips( preview,
+			                          FT_MIP_FILTER_BOX,
+			                          job->alpha_cutoff,
+			                          NULL );
 		}
+
+		event->texture     = preview;
+		event->level_count = preview->mip_levels;
+	}
+	else
+	{
+		event->level_count = texture->mip_levels;
+	}
+
+	// processed chain is delivered from scratch, stored one continues
+	// above levels delivered here
+	asset->first_level = first;
+
+	if ( asset->process )
+	{
+		asset->first_level =
+		    mips ? ft_get_mip_count( texture->width, texture->height )
+		         : texture->mip_levels;
+	}
+
+	asset->fine_stage = asset->first_level > 0;
+
+	if ( asset->fine_stage )
+	{
+		uint32_t size     = FT_MAX( texture->width, texture->height );
+		asset->level_size =
+		    size >> get_next_stream_level( texture, asset->first_level );
+	}
+}
+
+static void
+stream_task( void* arg )
+{
+	struct ft_model_streamer* streamer = arg;
+
+	ft_mutex_lock( &streamer->mutex );
+	uint32_t entry = pop_stream_entry( streamer );
+	ft_mutex_unlock( &streamer->mutex );
+
+	struct stream_asset*         asset = &streamer->assets[ entry / 2 ];
+	bool                         fine  = entry % 2;
+	struct ft_model_stream_event event = {
+		.type  = asset->type,
+		.index = asset->index,
+	};
+
+	if ( asset->type == FT_MODEL_ASSET_MESH )
+	{
+		stream_mesh( streamer, asset, fine, &event );
+	}
+	else
+	{
+		stream_texture( streamer, asset, fine, &event );
+	}
+
+	event.complete = !asset->fine_stage;
+
+	if ( streamer->callback )
+	{
+		streamer->callback( &event, streamer->user_data );
+	}
+
+	ft_mutex_lock( &streamer->mutex );
+
+	asset->complete = event.complete;
+
+	if ( !event.complete )
+	{
+		push_stream_entry( streamer, entry | 1 );
+	}
+
+	ft_mutex_unlock( &streamer->mutex );
+
+	// one task runs every queued entry
+	if ( !event.complete )
+	{
+		ft_thread_pool_push_group( streamer->pool,
+		                           &streamer->group,
+		                           stream_task,
+		                           streamer );
 	}
 }
 
 struct ft_model
-ft_load_gltf( const char* filename, enum ft_model_flags load_flags )
+ft_stream_gltf( const char* filename, const struct ft_model_stream_info* info )
 {
+	FT_ASSERT( info );
+
 	struct ft_model model;
 	memset( &model, 0, sizeof( struct ft_model ) );
 
-	uint64_t data_size = 0;
-	uint8_t* file_data = ft_read_file_binary( filename, &data_size );
+	struct ft_thread_pool* pool       = info->pool;
+	struct ft_thread_pool* owned_pool = NULL;
 
-	if ( file_data == NULL )
+	if ( pool == NULL )
 	{
-		FT_WARN( "failed to read gltf file %s", filename );
+		owned_pool = create_loader_pool();
+		pool       = owned_pool;
+	}
+
+	uint8_t*    file_data = NULL;
+	cgltf_data* data      = load_gltf_data( filename, &file_data, pool );
+
+	if ( data == NULL )
+	{
+		destroy_loader_pool( owned_pool );
 		return model;
 	}
 
-	cgltf_options options = { 0 };
-	cgltf_data*   data    = NULL;
-	cgltf_result  result = cgltf_parse( &options, file_data, data_size, &data );
+	struct hashmap* node_map  = create_node_map();
+	struct hashmap* image_map = create_image_map( data );
 
-	if ( result == cgltf_result_success )
+	cgltf_node** nodes = NULL;
+
+	if ( data->scenes_count > 0 )
 	{
-		result = cgltf_load_buffers( &options, data, filename );
+		nodes = build_scene_graph( &model.scene_graph,
+		                           node_map,
+		                           data,
+		                           &data->scenes[ 0 ] );
+	}
 
-		if ( result == cgltf_result_success )
-		{
-			if ( data->scenes_count > 1 )
-			{
-				FT_WARN( "multiple scenes gltf not supported %s", filename );
-				data->scenes_count = 1;
-			}
+	struct ft_scene_graph* graph = &model.scene_graph;
+	uint32_t primitive_count     = count_scene_primitives( graph, nodes );
 
-			struct hashmap* node_map =
-			    hashmap_new( sizeof( struct node_map_item ),
-			                 0,
-			                 0,
-			                 0,
-			                 hash_node_map_item,
-			                 compare_node_map_item,
-			                 NULL,
-			                 NULL );
-
-			struct hashmap* image_map =
-			    hashmap_new( sizeof( struct image_map_item ),
-			                 0,
-			                 0,
-			                 0,
-			                 hash_image_map_item,
-			                 compare_image_map_item,
-			                 NULL,
-			                 NULL );
+	struct ft_model_streamer* streamer =
+	    calloc( 1, sizeof( struct ft_model_streamer ) );
 
-			model.texture_count = data->textures_count;
-			model.textures =
-			    calloc( model.texture_count, sizeof( struct ft_texture ) );
+	model.meshes        = calloc( primitive_count, sizeof( struct ft_mesh ) );
+	model.texture_count = data->textures_count;
+	model.textures = calloc( model.texture_count, sizeof( struct ft_texture ) );
+
+	streamer->primitives =
+	    malloc( primitive_count * sizeof( cgltf_primitive* ) );
+
+	struct hashmap* primitive_map = create_primitive_map();
+
+	// everything but geometry is known before streaming starts
+	for ( uint32_t n = 0; n < graph->node_count; ++n )
+	{
+		cgltf_mesh* gltf_mesh = nodes[ n ]->mesh;
+
+		for ( cgltf_size p = 0; gltf_mesh && p < gltf_mesh->primitives_count;
+		      ++p )
+		{
+			cgltf_primitive* primitive  = &gltf_mesh->primitives[ p ];
+			uint32_t         mesh_count = model.mesh_count;
+
+			uint32_t m = find_gltf_mesh( primitive_map,
+			                             image_map,
+			                             primitive,
+			                             model.meshes,
+			                             &model.mesh_count );
 
-			for ( cgltf_size t = 0; t < data->textures_count; ++t )
+			if ( m == mesh_count )
 			{
-				cgltf_texture* texture = &data->textures[ t ];
-				model.textures[ t ] =
-				    load_image_from_cgltf_image( texture->image, filename );
-
-				hashmap_set( image_map,
-				             &( struct image_map_item ) {
-				                 .image = texture->image,
-				                 .index = t,
-				             } );
+				// geometry streams later
+				streamer->primitives[ m ] = primitive;
 			}
 
-			for ( cgltf_size s = 0; s < data->scenes_count; ++s )
-			{
-				cgltf_scene* scene = &data->scenes[ s ];
+			add_mesh_instance( &model.meshes[ m ],
+			                   n,
+			                   graph->world_transforms[ n ] );
+		}
+	}
 
-				model.mesh_count = 0;
+	hashmap_free( primitive_map );
+
+	model.meshes =
+	    realloc( model.meshes, model.mesh_count * sizeof( struct ft_mesh ) );
+
+	read_gltf_animations( &model, data, node_map );
+
+	free( nodes );
+	hashmap_free( image_map );
+	hashmap_free( node_map );
+
+	streamer->pool       = pool;
+	streamer->owned_pool = owned_pool;
+	streamer->data       = data;
+	streamer->file_data  = file_data;
+	streamer->filename   = malloc( strlen( filename ) + 1 );
+	strcpy( streamer->filename, filename );
+	streamer->flags      = info->load_flags;
+	streamer->callback   = info->callback;
+	streamer->user_data  = info->user_data;
+	streamer->mesh_count = model.mesh_count;
+	streamer->meshes     = model.meshes;
+	float3_dup( streamer->camera_position, info->camera_position );
+
+	streamer->texture_jobs =
+	    calloc( model.texture_count, sizeof( struct texture_decode_job ) );
+	init_texture_jobs( streamer->texture_jobs, &model, data );
+	streamer->mesh_previews =
+	    calloc( model.mesh_count, sizeof( struct ft_mesh ) );
+	streamer->texture_previews =
+	    calloc( model.texture_count, sizeof( struct ft_texture ) );
+	streamer->texture_sources =
+	    calloc( model.texture_count, sizeof( struct ft_texture ) );
+
+	streamer->asset_count = model.mesh_count + model.texture_count;
+	streamer->assets =
+	    calloc( streamer->asset_count, sizeof( struct stream_asset ) );
+	streamer->queue = malloc( streamer->asset_count * sizeof( uint32_t ) );
+
+	for ( uint32_t a = 0; a < streamer->asset_count; ++a )
+	{
+		bool mesh = a < model.mesh_count;
 
-				for ( uint32_t m = 0; m < data->meshes_count; m++ )
-					model.mesh_count += data->meshes[ m ].primitives_count;
+		streamer->assets[ a ].type =
+		    mesh ? FT_MODEL_ASSET_MESH : FT_MODEL_ASSET_TEXTURE;
+		streamer->assets[ a ].index = mesh ? a : a - model.mesh_count;
 
-				if ( model.mesh_count == 0 )
-				{
-					continue;
-				}
+		// computed from vertices once geometry streams
+		streamer->assets[ a ].missing_bounds =
+		    mesh && !get_primitive_bounds( streamer->primitives[ a ],
+		                                   &model.meshes[ a ].bounds );
+	}
 
-				model.meshes =
-				    calloc( model.mesh_count, sizeof( struct ft_mesh ) );
+	ft_compute_model_bounds( &model );
+	update_stream_distances( streamer );
 
-				uint32_t mesh_index = 0;
-				for ( cgltf_size n = 0; n < scene->nodes_count; ++n )
-				{
-					cgltf_node* node = scene->nodes[ n ];
-
-					mesh_index +=
-					    process_gltf_node( node_map,
-					                       image_map,
-					                       n,
-					                       node,
-					                       &model.meshes[ mesh_index ],
-					                       model.textures,
-					                       filename );
-				}
-			}
+	for ( uint32_t a = 0; a < streamer->asset_count; ++a )
+	{
+		push_stream_entry( streamer, a * 2 );
+	}
 
-			model.animation_count = data->animations_count;
-			model.animations = NULL;
+	ft_mutex_create( &streamer->mutex );
 
-			if ( model.animation_count > 0 )
-			{
-				model.animations = calloc( model.animation_count,
-				                           sizeof( struct ft_animation ) );
-			}
+	for ( uint32_t a = 0; a < streamer->asset_count; ++a )
+	{
+		ft_thread_pool_push_group( pool,
+		                           &streamer->group,
+		                           stream_task,
+		                           streamer );
+	}
 
-			for ( cgltf_size a = 0; a < model.animation_count; ++a )
-			{
-				cgltf_animation*         animation = &data->animations[ a ];
-				cgltf_animation_sampler* samplers  = animation->samplers;
+	model.streamer = streamer;
 
-				model.animations[ a ].samplers =
-				    calloc( animation->samplers_count,
-				            sizeof( struct ft_animation_sampler ) );
-				model.animations[ a ].sampler_count = animation->samplers_count;
+	return model;
+}
 
-				for ( cgltf_size s = 0; s < animation->samplers_count; ++s )
-				{
-					struct ft_animation_sampler* sampler =
-					    &model.animations[ a ].samplers[ s ];
+void
+ft_model_stream_set_camera( struct ft_model* model, const float3 position )
+{
+	FT_ASSERT( model );
 
-					read_animation_samplers( &samplers[ s ], sampler );
+	struct ft_model_streamer* streamer = model->streamer;
 
-					if ( sampler->times[ sampler->frame_count - 1 ] >
-					     model.animations[ a ].duration )
-					{
-						model.animations[ a ].duration =
-						    sampler->times[ sampler->frame_count - 1 ];
-					}
-				}
+	if ( streamer == NULL )
+	{
+		return;
+	}
 
-				read_animation_channels( node_map,
-				                         animation,
-				                         &model.animations[ a ] );
-			}
+	ft_mutex_lock( &streamer->mutex );
+	float3_dup( streamer->camera_position, position );
+	update_stream_distances( streamer );
+	ft_mutex_unlock( &streamer->mutex );
+}
 
-			hashmap_free( image_map );
-			hashmap_free( node_map );
+void
+ft_model_wait_stream( struct ft_model* model )
+{
+	FT_ASSERT( model );
 
-			if ( load_flags & FT_MODEL_GENERATE_TANGENTS )
-			{
-				generate_tangents( &model );
-			}
-		}
-		else
-		{
-			FT_WARN( "failed to load gltf buffers %s", filename );
-		}
+	struct ft_model_streamer* streamer = model->streamer;
 
-		cgltf_free( data );
+	if ( streamer == NULL )
+	{
+		return;
 	}
-	else
+
+	ft_thread_pool_wait_group( streamer->pool, &streamer->group );
+	destroy_loader_pool( streamer->owned_pool );
+	ft_mutex_destroy( &streamer->mutex );
+
+	// mesh bounds missing from accessors are known only now
+	ft_compute_model_bounds( model );
+
+	for ( uint32_t m = 0; m < model->mesh_count; ++m )
 	{
-		FT_WARN( "failed to parse gltf %s", filename );
+		free_mesh_preview( &streamer->mesh_previews[ m ] );
 	}
 
-	ft_free_file_data( file_data );
+	for ( uint32_t t = 0; t < model->texture_count; ++t )
+	{
+		ft_safe_free( streamer->texture_previews[ t ].data );
+		ft_safe_free( streamer->texture_sources[ t ].data );
+	}
 
-	return model;
+	cgltf_free( streamer->data );
+	ft_free_file_data( streamer->file_data );
+	free( streamer->filename );
+	free( streamer->primitives );
+	free( streamer->texture_jobs );
+	free( streamer->mesh_previews );
+	free( streamer->texture_previews );
+	free( streamer->texture_sources );
+	free( streamer->assets );
+	free( streamer->queue );
+	free( streamer );
+
+	model->streamer = NULL;
 }
 
-FT_INLINE void
-free_mesh( struct ft_mesh* mesh )
+static void
+free_instance_index( struct ft_model* model )
 {
-	ft_safe_free( mesh->positions );
-	ft_safe_free( mesh->texcoords );
-	ft_safe_free( mesh->normals );
-	ft_safe_free( mesh->tangents );
-	ft_safe_free( mesh->joints );
-	ft_safe_free( mesh->indices_16 );
-	ft_safe_free( mesh->indices_32 );
+	ft_safe_free( model->node_instance_offsets );
+	ft_safe_free( model->node_instances );
+	ft_safe_free( model->instance_bounds );
+	model->node_instance_offsets = NULL;
+	model->node_instances        = NULL;
+	model->instance_bounds       = NULL;
 }
 
 FT_INLINE void
@@ -882,6 +2683,20 @@ free_animation( struct ft_animation* animation )
 void
 ft_free_gltf( struct ft_model* model )
 {
+	free_instance_index( model );
+
+	// baked model arrays all live in mapping
+	if ( model->mapped_file )
+	{
+		ft_unmap_file( model->mapped_file );
+		free( model->mapped_file );
+		memset( model, 0, sizeof( struct ft_model ) );
+		return;
+	}
+
+	ft_model_wait_stream( model );
+	ft_model_wait_textures( model );
+
 	for ( uint32_t i = 0; i < model->animation_count; ++i )
 	{
 		free_animation( &model->animations[ i ] );
@@ -901,4 +2716,347 @@ ft_free_gltf( struct ft_model* model )
 
 	ft_safe_free( model->textures );
 	ft_safe_free( model->meshes );
+
+	ft_scene_graph_destroy( &model->scene_graph );
+}
+
+void
+ft_compute_mesh_bounds( struct ft_mesh* mesh )
+{
+	FT_ASSERT( mesh );
+
+	struct ft_bounds* bounds = &mesh->bounds;
+	memset( bounds, 0, sizeof( struct ft_bounds ) );
+
+	if ( mesh->positions == NULL || mesh->vertex_count == 0 )
+	{
+		return;
+	}
+
+	const float* positions = mesh->positions;
+
+	float3_dup( bounds->min, positions );
+	float3_dup( bounds->max, positions );
+
+	// branchless min and max vectorize across components
+	for ( uint32_t v = 1; v < mesh->vertex_count; ++v )
+	{
+		for ( uint32_t c = 0; c < 3; ++c )
+		{
+			float p          = positions[ v * 3 + c ];
+			bounds->min[ c ] = FT_MIN( bounds->min[ c ], p );
+			bounds->max[ c ] = FT_MAX( bounds->max[ c ], p );
+		}
+	}
+
+	float3_add( bounds->center, bounds->min, bounds->max );
+	float3_scale( bounds->center, bounds->center, 0.5f );
+
+	// farthest vertex from box center is tighter than box corner
+	float radius_sq = 0.0f;
+
+	for ( uint32_t v = 0; v < mesh->vertex_count; ++v )
+	{
+		float3 offset;
+		float3_sub( offset, &positions[ v * 3 ], bounds->center );
+		radius_sq = FT_MAX( radius_sq, float3_mul_inner( offset, offset ) );
+	}
+
+	bounds->radius = sqrtf( radius_sq );
+}
+
+void
+ft_transform_bounds( struct ft_bounds*       dst,
+                     const struct ft_bounds* src,
+                     const float4x4          transform )
+{
+	FT_ASSERT( dst && src && dst != src );
+
+	float3 box_center;
+	float3 box_extent;
+	float3_add( box_center, src->min, src->max );
+	float3_scale( box_center, box_center, 0.5f );
+	float3_sub( box_extent, src->max, src->min );
+	float3_scale( box_extent, box_extent, 0.5f );
+
+	// lanes are rows, every column of transform is one register
+	ft_simd4 center = ft_simd4_load( transform[ 3 ] );
+	ft_simd4 sphere = center;
+	ft_simd4 extent = ft_simd4_zero();
+	float    scale  = 0.0f;
+
+	for ( uint32_t c = 0; c < 3; ++c )
+	{
+		ft_simd4 column = ft_simd4_load( transform[ c ] );
+		ft_simd4 box    = ft_simd4_splat( box_center[ c ] );
+		ft_simd4 point  = ft_simd4_splat( src->center[ c ] );
+		ft_simd4 size   = ft_simd4_splat( box_extent[ c ] );
+
+		center = ft_simd4_madd( column, box, center );
+		sphere = ft_simd4_madd( column, point, sphere );
+		extent = ft_simd4_madd( ft_simd4_abs( column ), size, extent );
+		scale  = FT_MAX( scale, float3_len( transform[ c ] ) );
+	}
+
+	float4 min, max, world_center;
+	ft_simd4_store( min, ft_simd4_sub( center, extent ) );
+	ft_simd4_store( max, ft_simd4_add( center, extent ) );
+	ft_simd4_store( world_center, sphere );
+
+	float3_dup( dst->min, min );
+	float3_dup( dst->max, max );
+	float3_dup( dst->center, world_center );
+	dst->radius = src->radius * scale;
+}
+
+// counting sort of instances by node. instances of nodes outside scene graph
+// go to one extra slot past last node, they count for bounds but never move
+static void
+build_instance_index( struct ft_model* model )
+{
+	uint32_t node_count     = model->scene_graph.node_count;
+	uint32_t instance_count = 0;
+
+	for ( uint32_t m = 0; m < model->mesh_count; ++m )
+	{
+		instance_count += model->meshes[ m ].instance_count;
+	}
+
+	free_instance_index( model );
+
+	uint32_t* offsets = calloc( node_count + 2, sizeof( uint32_t ) );
+	model->node_instance_offsets = offsets;
+	model->node_instances =
+	    malloc( instance_count * sizeof( struct ft_mesh_instance ) );
+	model->instance_bounds =
+	    malloc( instance_count * sizeof( struct ft_bounds ) );
+
+	for ( uint32_t m = 0; m < model->mesh_count; ++m )
+	{
+		const struct ft_mesh* mesh = &model->meshes[ m ];
+
+		for ( uint32_t i = 0; i < mesh->instance_count; ++i )
+		{
+			offsets[ FT_MIN( mesh->instance_nodes[ i ], node_count ) + 1 ]++;
+		}
+	}
+
+	for ( uint32_t n = 0; n <= node_count; ++n )
+	{
+		offsets[ n + 1 ] += offsets[ n ];
+	}
+
+	uint32_t* cursors = malloc( ( node_count + 1 ) * sizeof( uint32_t ) );
+	memcpy( cursors, offsets, ( node_count + 1 ) * sizeof( uint32_t ) );
+
+	for ( uint32_t m = 0; m < model->mesh_count; ++m )
+	{
+		const struct ft_mesh* mesh = &model->meshes[ m ];
+
+		for ( uint32_t i = 0; i < mesh->instance_count; ++i )
+		{
+			uint32_t slot = FT_MIN( mesh->instance_nodes[ i ], node_count );
+
+			model->node_instances[ cursors[ slot ]++ ] =
+			    ( struct ft_mesh_instance ) {
+			        .mesh     = m,
+			        .instance = i,
+			    };
+		}
+	}
+
+	free( cursors );
+}
+
+// model box around stored bounds of every instance
+static void
+merge_instance_bounds( struct ft_model* model )
+{
+	struct ft_bounds* bounds = &model->bounds;
+	memset( bounds, 0, sizeof( struct ft_bounds ) );
+
+	uint32_t instance_count =
+	    model->node_instance_offsets[ model->scene_graph.node_count + 1 ];
+
+	for ( uint32_t j = 0; j < instance_count; ++j )
+	{
+		const struct ft_bounds* world = &model->instance_bounds[ j ];
+
+		for ( uint32_t c = 0; c < 3; ++c )
+		{
+			bounds->min[ c ] =
+			    j == 0 ? world->min[ c ]
+			           : FT_MIN( bounds->min[ c ], world->min[ c ] );
+			bounds->max[ c ] =
+			    j == 0 ? world->max[ c ]
+			           : FT_MAX( bounds->max[ c ], world->max[ c ] );
+		}
+	}
+
+	set_bounds_sphere( bounds );
+}
+
+void
+ft_compute_model_bounds( struct ft_model* model )
+{
+	FT_ASSERT( model );
+
+	build_instance_index( model );
+
+	uint32_t instance_count =
+	    model->node_instance_offsets[ model->scene_graph.node_count + 1 ];
+
+	for ( uint32_t j = 0; j < instance_count; ++j )
+	{
+		const struct ft_mesh_instance* instance = &model->node_instances[ j ];
+		const struct ft_mesh*          mesh = &model->meshes[ instance->mesh ];
+
+		ft_transform_bounds( &model->instance_bounds[ j ],
+		                     &mesh->bounds,
+		                     mesh->instance_transforms[ instance->instance ] );
+	}
+
+	merge_instance_bounds( model );
+}
+
+// model box can only shrink when instance reaching its border moves
+FT_INLINE bool
+touches_border( const struct ft_bounds* world, const struct ft_bounds* model )
+{
+	for ( uint32_t c = 0; c < 3; ++c )
+	{
+		if ( world->min[ c ] <= model->min[ c ] ||
+		     world->max[ c ] >= model->max[ c ] )
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+ft_update_model_transforms( struct ft_model* model )
+{
+	FT_ASSERT( model );
+
+	struct ft_scene_graph* graph = &model->scene_graph;
+
+	ft_scene_graph_update( graph );
+
+	if ( graph->changed_range_count == 0 )
+	{
+		return;
+	}
+
+	// baked models have no index yet, instance transforms still hold
+	// previous update so bounds built here are the old ones
+	if ( model->node_instance_offsets == NULL )
+	{
+		ft_compute_model_bounds( model );
+	}
+
+	struct ft_bounds* bounds = &model->bounds;
+	bool              merge  = false;
+
+	for ( uint32_t r = 0; r < graph->changed_range_count; ++r )
+	{
+		const struct ft_scene_range* range = &graph->changed_ranges[ r ];
+
+		for ( uint32_t j = model->node_instance_offsets[ range->first ];
+		      j < model->node_instance_offsets[ range->end ];
+		      ++j )
+		{
+			uint32_t          m     = model->node_instances[ j ].mesh;
+			uint32_t          i     = model->node_instances[ j ].instance;
+			struct ft_mesh*   mesh  = &model->meshes[ m ];
+			uint32_t          node  = mesh->instance_nodes[ i ];
+			float4x4*         world = &mesh->instance_transforms[ i ];
+			struct ft_bounds* instance_bounds = &model->instance_bounds[ j ];
+
+			float4x4_dup( *world, graph->world_transforms[ node ] );
+
+			if ( mesh->node == node )
+			{
+				float4x4_dup( mesh->world, *world );
+			}
+
+			merge = merge || touches_border( instance_bounds, bounds );
+			ft_transform_bounds( instance_bounds, &mesh->bounds, *world );
+
+			for ( uint32_t c = 0; c < 3; ++c )
+			{
+				bounds->min[ c ] =
+				    FT_MIN( bounds->min[ c ], instance_bounds->min[ c ] );
+				bounds->max[ c ] =
+				    FT_MAX( bounds->max[ c ], instance_bounds->max[ c ] );
+			}
+		}
+	}
+
+	if ( merge )
+	{
+		merge_instance_bounds( model );
+	}
+	else
+	{
+		set_bounds_sphere( bounds );
+	}
+}
+
+bool
+ft_model_texture_ready( const struct ft_model* model, uint32_t texture )
+{
+	FT_ASSERT( model );
+	FT_ASSERT( texture < model->texture_count );
+
+	struct ft_model_streamer* streamer = model->streamer;
+
+	if ( streamer != NULL )
+	{
+		ft_mutex_lock( &streamer->mutex );
+		bool ready =
+		    streamer->assets[ streamer->mesh_count + texture ].complete;
+		ft_mutex_unlock( &streamer->mutex );
+
+		return ready;
+	}
+
+	struct ft_texture_decoder* decoder = model->texture_decoder;
+
+	if ( decoder == NULL )
+	{
+		return true;
+	}
+
+	ft_mutex_lock( &decoder->mutex );
+	bool ready = decoder->ready[ texture ];
+	ft_mutex_unlock( &decoder->mutex );
+
+	return ready;
+}
+
+void
+ft_model_wait_textures( struct ft_model* model )
+{
+	FT_ASSERT( model );
+
+	struct ft_texture_decoder* decoder = model->texture_decoder;
+
+	if ( decoder == NULL )
+	{
+		return;
+	}
+
+	ft_thread_pool_wait_group( decoder->pool, &decoder->group );
+	destroy_loader_pool( decoder->owned_pool );
+	ft_mutex_destroy( &decoder->mutex );
+	cgltf_free( decoder->data );
+	ft_free_file_data( decoder->file_data );
+	free( decoder->filename );
+	free( decoder->jobs );
+	free( decoder->ready );
+	free( decoder );
+
+	model->texture_decoder = NULL;
 }
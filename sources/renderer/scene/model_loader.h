@@ -2,6 +2,11 @@
 
 #include "base/base.h"
 #include "math/linear.h"
+#include "renderer/backend/renderer_backend.h"
+#include "scene_graph.h"
+
+#define FT_MAX_VERTEX_STREAM_COUNT 2
+#define FT_MAX_MESH_LOD_COUNT      4
 
 enum ft_texture_type
 {
@@ -18,10 +23,29 @@ struct ft_texture
 	uint32_t             width;
 	uint32_t             height;
 	uint32_t             mip_levels;
+	enum ft_format       format;
 	void                *data;
 	enum ft_texture_type texture_type;
+	// data lives in mapped baked model and can not be freed or replaced
+	bool                 mapped;
 };
 
+// mip levels are stored one after another starting from largest
+FT_INLINE uint64_t
+ft_texture_mip_offset( const struct ft_texture *texture, uint32_t mip )
+{
+	uint64_t offset = 0;
+
+	for ( uint32_t m = 0; m < mip; ++m )
+	{
+		offset += ft_format_image_size( texture->format,
+		                                FT_MAX( texture->width >> m, 1 ),
+		                                FT_MAX( texture->height >> m, 1 ) );
+	}
+
+	return offset;
+}
+
 struct ft_material
 {
 	int32_t textures[ FT_TEXTURE_TYPE_COUNT ];
@@ -53,6 +77,9 @@ struct ft_animation_sampler
 {
 	uint32_t                        frame_count;
 	float                          *times;
+	// component count floats per frame, cubic spline frames hold three
+	// values: in tangent, value and out tangent
+	uint32_t                        component_count;
 	float                          *values;
 	enum ft_animation_interpolation interpolation;
 };
@@ -73,39 +100,264 @@ struct ft_animation
 	struct ft_animation_channel *channels;
 };
 
-struct ft_mesh
+enum ft_vertex_attribute_location
+{
+	FT_VERTEX_ATTRIBUTE_LOCATION_POSITION,
+	FT_VERTEX_ATTRIBUTE_LOCATION_NORMAL,
+	FT_VERTEX_ATTRIBUTE_LOCATION_TANGENT,
+	FT_VERTEX_ATTRIBUTE_LOCATION_TEXCOORD,
+	FT_VERTEX_ATTRIBUTE_LOCATION_JOINTS,
+	FT_VERTEX_ATTRIBUTE_LOCATION_WEIGHTS,
+};
+
+struct ft_vertex_streams
+{
+	uint32_t                stream_count;
+	uint32_t                strides[ FT_MAX_VERTEX_STREAM_COUNT ];
+	uint8_t                *data[ FT_MAX_VERTEX_STREAM_COUNT ];
+	// value = offset + quantized * scale
+	float3                  position_offset;
+	float3                  position_scale;
+	float2                  texcoord_offset;
+	float2                  texcoord_scale;
+	struct ft_vertex_layout layout;
+};
+
+struct ft_meshlet
+{
+	uint32_t vertex_offset;
+	uint32_t triangle_offset;
+	uint32_t vertex_count;
+	uint32_t triangle_count;
+	float3   center;
+	float    radius;
+	float3   cone_apex;
+	float3   cone_axis;
+	float    cone_cutoff;
+};
+
+struct ft_meshlets
 {
+	uint32_t           meshlet_count;
+	struct ft_meshlet *meshlets;
+	// mesh vertex indices referenced by meshlets
 	uint32_t           vertex_count;
-	float             *positions;
-	float             *normals;
-	float             *tangents;
-	float             *texcoords;
-	float             *joints;
-	float             *weights;
-	uint32_t           index_count;
-	uint16_t          *indices_16;
-	uint32_t          *indices_32;
-	float4x4           world;
-	struct ft_material material;
+	uint32_t          *vertices;
+	// three meshlet local vertex indices per triangle
+	uint32_t           triangle_count;
+	uint8_t           *triangles;
+};
+
+// simplified index buffer sharing vertices of its mesh
+struct ft_mesh_lod
+{
+	uint32_t  index_count;
+	uint16_t *indices_16;
+	uint32_t *indices_32;
+	// max distance from original surface in mesh units
+	float     error;
+};
+
+// box and sphere around it, sphere may be tighter than box corners
+struct ft_bounds
+{
+	float3 min;
+	float3 max;
+	float3 center;
+	float  radius;
+};
+
+struct ft_mesh
+{
+	uint32_t                 vertex_count;
+	float                   *positions;
+	float                   *normals;
+	float                   *tangents;
+	float                   *texcoords;
+	float                   *joints;
+	float                   *weights;
+	uint32_t                 index_count;
+	uint16_t                *indices_16;
+	uint32_t                *indices_32;
+	// mesh space, kept when float vertices are discarded
+	struct ft_bounds         bounds;
+	// scene graph node placing mesh, world mirrors its world transform
+	uint32_t                 node;
+	float4x4                 world;
+	// every node drawing mesh, first one is node above. transforms mirror
+	// world transforms of nodes and can be uploaded as instance data
+	uint32_t                 instance_count;
+	uint32_t                *instance_nodes;
+	float4x4                *instance_transforms;
+	struct ft_material       material;
+	struct ft_vertex_streams packed_vertices;
+	struct ft_meshlets       meshlets;
+	// coarser levels, lods[ 0 ] is first level below full mesh
+	uint32_t                 lod_count;
+	struct ft_mesh_lod       lods[ FT_MAX_MESH_LOD_COUNT ];
+	// arrays live in mapped baked model, functions freeing or resizing them
+	// refuse mesh
+	bool                     mapped;
+};
+
+// instance of mesh placed by scene graph node
+struct ft_mesh_instance
+{
+	uint32_t mesh;
+	uint32_t instance;
 };
 
+struct ft_texture_decoder;
+struct ft_model_streamer;
+struct ft_mapped_file;
+struct ft_thread_pool;
+
 struct ft_model
 {
-	uint32_t             mesh_count;
-	struct ft_mesh      *meshes;
-	uint32_t             animation_count;
-	struct ft_animation *animations;
-	uint32_t             texture_count;
-	struct ft_texture   *textures;
+	uint32_t                   mesh_count;
+	struct ft_mesh            *meshes;
+	uint32_t                   animation_count;
+	struct ft_animation       *animations;
+	uint32_t                   texture_count;
+	struct ft_texture         *textures;
+	// world space around every mesh instance
+	struct ft_bounds           bounds;
+	// instances placed by node n are node_instances in
+	// [ node_instance_offsets[ n ], node_instance_offsets[ n + 1 ] ), each
+	// with world bounds at same position of instance_bounds. built with
+	// model bounds so transform updates touch changed nodes only
+	uint32_t                  *node_instance_offsets;
+	struct ft_mesh_instance   *node_instances;
+	struct ft_bounds          *instance_bounds;
+	// animation channels target nodes of this graph
+	struct ft_scene_graph      scene_graph;
+	// pending texture decodes, null once every texture is decoded
+	struct ft_texture_decoder *texture_decoder;
+	// pending streamed assets, null once every asset is streamed
+	struct ft_model_streamer  *streamer;
+	// set for baked models, all arrays live inside the mapping
+	struct ft_mapped_file     *mapped_file;
 };
 
 enum ft_model_flags
 {
 	FT_MODEL_GENERATE_TANGENTS        = 1 << 0,
+	// emit compact interleaved vertices into ft_mesh::packed_vertices
+	FT_MODEL_PACK_VERTICES            = 1 << 1,
+	// keep positions in separate stream for depth only passes
+	FT_MODEL_SPLIT_POSITION_STREAM    = 1 << 2,
+	// snorm16 positions relative to mesh box instead of half floats
+	FT_MODEL_SNORM_POSITIONS          = 1 << 3,
+	// free float vertex arrays once they are packed
+	FT_MODEL_DISCARD_FLOAT_VERTICES   = 1 << 4,
+	// weld and reorder vertices and triangles, narrow indices to 16 bit
+	FT_MODEL_OPTIMIZE_MESHES          = 1 << 5,
+	// split meshes into meshlets with bounds for cluster culling
+	FT_MODEL_GENERATE_MESHLETS        = 1 << 6,
+	// build simplified index buffers for distance based lod selection
+	FT_MODEL_GENERATE_LODS            = 1 << 7,
+	// return before textures are decoded, see ft_model_texture_ready
+	FT_MODEL_ASYNC_TEXTURES           = 1 << 8,
+	// encode decoded textures to bc formats picked by texture type
+	FT_MODEL_COMPRESS_TEXTURES        = 1 << 9,
+	// build mip chains of decoded textures on cpu
+	FT_MODEL_GENERATE_MIPS            = 1 << 10,
+};
+
+enum ft_model_asset_type
+{
+	FT_MODEL_ASSET_MESH,
+	FT_MODEL_ASSET_TEXTURE,
+};
+
+// coarse event of asset is cheap preview: clustered copy of large mesh,
+// which is not model mesh, smallest stored mips or downsampled copy of
+// texture. fine events follow once every asset has delivered coarse one.
+// mesh gets one with optimized mesh and its lods, small meshes are complete
+// after coarse event already. textures with mips and compression arrive
+// smallest levels first, each event adds larger levels down to first_level,
+// and may differ in size and format from preview. levels are mips of texture
+// or lods of mesh with level 0 being full mesh, delivered data is valid
+// during callback only
+struct ft_model_stream_event
+{
+	enum ft_model_asset_type type;
+	uint32_t                 index;
+	struct ft_mesh          *mesh;
+	struct ft_texture       *texture;
+	uint32_t                 first_level;
+	uint32_t                 level_count;
+	// last event of asset, it is not written anymore
+	bool                     complete;
 };
 
+// called on streaming threads, asset must not be read before its first event
+typedef void ( *ft_model_stream_callback )(
+    const struct ft_model_stream_event *event,
+    void                               *user_data );
+
+struct ft_model_stream_info
+{
+	enum ft_model_flags      load_flags;
+	// assets closest to camera stream first
+	float3                   camera_position;
+	ft_model_stream_callback callback;
+	void                    *user_data;
+	// shared with other work of caller, null streams on pool of its own
+	struct ft_thread_pool   *pool;
+};
+
+// decoding, tangents and textures run on pool, which may be running calling
+// task. null creates pool for this load, kept until textures are decoded
 FT_API struct ft_model
-ft_load_gltf( const char *filename, enum ft_model_flags load_flags );
+ft_load_gltf( const char            *filename,
+              enum ft_model_flags    load_flags,
+              struct ft_thread_pool *pool );
 
 FT_API void
 ft_free_gltf( struct ft_model *model );
+
+// propagates changed node transforms and refreshes world and instance
+// transforms of affected meshes and model bounds. only instances of changed
+// nodes are visited, model bounds grow by their new bounds and are rebuilt
+// from stored instance bounds when a changed instance touched their border
+FT_API void
+ft_update_model_transforms( struct ft_model *model );
+
+// mesh space bounds from float positions of mesh
+FT_API void
+ft_compute_mesh_bounds( struct ft_mesh *mesh );
+
+// bounds of src placed by transform, box stays axis aligned and sphere grows
+// by largest axis scale
+FT_API void
+ft_transform_bounds( struct ft_bounds       *dst,
+                     const struct ft_bounds *src,
+                     const float4x4          transform );
+
+// world bounds of every mesh instance, refreshed by transform updates. also
+// rebuilds node to instance index, call it after meshes or instances change
+FT_API void
+ft_compute_model_bounds( struct ft_model *model );
+
+// returns once scene graph, materials and animations are read, geometry and
+// textures are loaded in background ordered by camera distance. meshes are
+// not split to 16 bit indices
+FT_API struct ft_model
+ft_stream_gltf( const char *filename, const struct ft_model_stream_info *info );
+
+// reorders assets not yet streamed by distance to new camera position
+FT_API void
+ft_model_stream_set_camera( struct ft_model *model, const float3 position );
+
+// blocks until every asset is streamed and releases streamer resources
+FT_API void
+ft_model_wait_stream( struct ft_model *model );
+
+// texture data, width and height are valid once this returns true
+FT_API bool
+ft_model_texture_ready( const struct ft_model *model, uint32_t texture );
+
+// blocks until all textures are decoded and releases decoder resources
+FT_API void
+ft_model_wait_textures( struct ft_model *model );
@@ -0,0 +1,246 @@
+#include "math/simd.h"
+#include "scene_graph.h"
+
+static int
+compare_nodes( const void* a, const void* b )
+{
+	uint32_t na = *( const uint32_t* ) a;
+	uint32_t nb = *( const uint32_t* ) b;
+
+	return ( na > nb ) - ( na < nb );
+}
+
+FT_INLINE void
+mark_dirty( struct ft_scene_graph* graph, uint32_t node )
+{
+	FT_ASSERT( node < graph->node_count );
+
+	if ( !graph->dirty[ node ] )
+	{
+		graph->dirty[ node ]                        = true;
+		graph->dirty_nodes[ graph->dirty_count++ ] = node;
+	}
+}
+
+// world of parent times local, columns of parent stay in simd registers
+// and every column of local takes four multiply adds. column c of local is
+// read before it is overwritten, so result may replace local
+FT_INLINE void
+multiply_parent_world( float4x4 world, const float4x4 parent )
+{
+	ft_simd4 p[ 4 ];
+
+	for ( uint32_t k = 0; k < 4; ++k )
+	{
+		p[ k ] = ft_simd4_load( parent[ k ] );
+	}
+
+	for ( uint32_t c = 0; c < 4; ++c )
+	{
+		ft_simd4 r = ft_simd4_mul( p[ 0 ], ft_simd4_splat( world[ c ][ 0 ] ) );
+		r = ft_simd4_madd( p[ 1 ], ft_simd4_splat( world[ c ][ 1 ] ), r );
+		r = ft_simd4_madd( p[ 2 ], ft_simd4_splat( world[ c ][ 2 ] ), r );
+		r = ft_simd4_madd( p[ 3 ], ft_simd4_splat( world[ c ][ 3 ] ), r );
+		ft_simd4_store( world[ c ], r );
+	}
+}
+
+// whole range is recomputed in two flat passes over arrays instead of
+// recursing, locals first and then parent products in node order
+static void
+update_range( struct ft_scene_graph* graph, uint32_t first, uint32_t end )
+{
+	float4x4* worlds = graph->world_transforms;
+
+	for ( uint32_t i = first; i < end; ++i )
+	{
+		float4x4_compose( worlds[ i ],
+		                  graph->translations[ i ],
+		                  graph->rotations[ i ],
+		                  graph->scales[ i ] );
+	}
+
+	for ( uint32_t i = first; i < end; ++i )
+	{
+		uint32_t parent = graph->parents[ i ];
+
+		if ( parent != FT_SCENE_NODE_NONE )
+		{
+			multiply_parent_world( worlds[ i ], worlds[ parent ] );
+		}
+	}
+}
+
+void
+ft_scene_graph_create( struct ft_scene_graph* graph,
+                       uint32_t               node_count,
+                       const uint32_t*        parents )
+{
+	FT_ASSERT( graph );
+
+	memset( graph, 0, sizeof( struct ft_scene_graph ) );
+
+	if ( node_count == 0 )
+	{
+		return;
+	}
+
+	graph->node_count   = node_count;
+	graph->parents      = malloc( node_count * sizeof( uint32_t ) );
+	graph->subtree_ends = malloc( node_count * sizeof( uint32_t ) );
+	graph->translations = calloc( node_count, sizeof( float3 ) );
+	graph->rotations    = malloc( node_count * sizeof( quat ) );
+	graph->scales       = malloc( node_count * sizeof( float3 ) );
+	graph->world_transforms = malloc( node_count * sizeof( float4x4 ) );
+	graph->dirty            = calloc( node_count, sizeof( bool ) );
+	graph->dirty_nodes      = malloc( node_count * sizeof( uint32_t ) );
+	graph->changed_ranges =
+	    malloc( node_count * sizeof( struct ft_scene_range ) );
+
+	memcpy( graph->parents, parents, node_count * sizeof( uint32_t ) );
+
+	for ( uint32_t i = 0; i < node_count; ++i )
+	{
+		FT_ASSERT( parents[ i ] == FT_SCENE_NODE_NONE || parents[ i ] < i );
+
+		quat_identity( graph->rotations[ i ] );
+		float3_dup( graph->scales[ i ], ( float3 ) { 1.0f, 1.0f, 1.0f } );
+		graph->subtree_ends[ i ] = i + 1;
+		mark_dirty( graph, i );
+	}
+
+	// children come after parent, so walking backwards finishes every
+	// subtree before its parent reads it
+	for ( uint32_t i = node_count; i-- > 0; )
+	{
+		uint32_t parent = parents[ i ];
+
+		if ( parent != FT_SCENE_NODE_NONE )
+		{
+			graph->subtree_ends[ parent ] =
+			    FT_MAX( graph->subtree_ends[ parent ],
+			            graph->subtree_ends[ i ] );
+		}
+	}
+}
+
+void
+ft_scene_graph_destroy( struct ft_scene_graph* graph )
+{
+	FT_ASSERT( graph );
+
+	ft_safe_free( graph->parents );
+	ft_safe_free( graph->subtree_ends );
+	ft_safe_free( graph->translations );
+	ft_safe_free( graph->rotations );
+	ft_safe_free( graph->scales );
+	ft_safe_free( graph->world_transforms );
+	ft_safe_free( graph->dirty );
+	ft_safe_free( graph->dirty_nodes );
+	ft_safe_free( graph->changed_ranges );
+
+	memset( graph, 0, sizeof( struct ft_scene_graph ) );
+}
+
+void
+ft_scene_graph_set_translation( struct ft_scene_graph* graph,
+                                uint32_t               node,
+                                const float3           translation )
+{
+	mark_dirty( graph, node );
+	float3_dup( graph->translations[ node ], translation );
+}
+
+void
+ft_scene_graph_set_rotation( struct ft_scene_graph* graph,
+                             uint32_t               node,
+                             const quat             rotation )
+{
+	mark_dirty( graph, node );
+	float4_dup( graph->rotations[ node ], rotation );
+}
+
+void
+ft_scene_graph_set_scale( struct ft_scene_graph* graph,
+                          uint32_t               node,
+                          const float3           scale )
+{
+	mark_dirty( graph, node );
+	float3_dup( graph->scales[ node ], scale );
+}
+
+void
+ft_scene_graph_update( struct ft_scene_graph* graph )
+{
+	FT_ASSERT( graph );
+
+	graph->changed_range_count = 0;
+
+	if ( graph->dirty_count == 0 )
+	{
+		return;
+	}
+
+	// sorted dirty nodes visit subtrees in order, a node inside subtree
+	// already recomputed is skipped
+	qsort( graph->dirty_nodes,
+	       graph->dirty_count,
+	       sizeof( uint32_t ),
+	       compare_nodes );
+
+	uint32_t covered_end = 0;
+
+	for ( uint32_t d = 0; d < graph->dirty_count; ++d )
+	{
+		uint32_t node = graph->dirty_nodes[ d ];
+
+		graph->dirty[ node ] = false;
+
+		if ( node < covered_end )
+		{
+			continue;
+		}
+
+		covered_end = graph->subtree_ends[ node ];
+		update_range( graph, node, covered_end );
+
+		graph->changed_ranges[ graph->changed_range_count++ ] =
+		    ( struct ft_scene_range ) {
+		        .first = node,
+		        .end   = covered_end,
+		    };
+	}
+
+	graph->dirty_count = 0;
+}
+
+bool
+ft_scene_graph_world_changed( const struct ft_scene_graph* graph,
+                              uint32_t                     node )
+{
+	FT_ASSERT( graph );
+
+	uint32_t low  = 0;
+	uint32_t high = graph->changed_range_count;
+
+	while ( low < high )
+	{
+		uint32_t                     middle = ( low + high ) / 2;
+		const struct ft_scene_range* range = &graph->changed_ranges[ middle ];
+
+		if ( node < range->first )
+		{
+			high = middle;
+		}
+		else if ( node >= range->end )
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "base/base.h"
+#include "math/linear.h"
+
+#define FT_SCENE_NODE_NONE UINT32_MAX
+
+struct ft_scene_range
+{
+	uint32_t first;
+	uint32_t end;
+};
+
+// nodes are stored depth first, parent precedes its children and subtree of
+// node occupies [ node, subtree_ends[ node ] ). local transforms are kept as
+// separate translation, rotation and scale arrays
+struct ft_scene_graph
+{
+	uint32_t               node_count;
+	uint32_t              *parents;
+	uint32_t              *subtree_ends;
+	float3                *translations;
+	quat                  *rotations;
+	float3                *scales;
+	float4x4              *world_transforms;
+	// nodes whose local transform changed since last update
+	bool                  *dirty;
+	uint32_t               dirty_count;
+	uint32_t              *dirty_nodes;
+	// disjoint subtrees recomputed by last update, sorted by first node
+	uint32_t               changed_range_count;
+	struct ft_scene_range *changed_ranges;
+};
+
+// parents must be in depth first order, every parent index below its child.
+// local transforms start as identity and every node is dirty
+FT_API void
+ft_scene_graph_create( struct ft_scene_graph* graph,
+                       uint32_t               node_count,
+                       const uint32_t*        parents );
+
+FT_API void
+ft_scene_graph_destroy( struct ft_scene_graph* graph );
+
+FT_API void
+ft_scene_graph_set_translation( struct ft_scene_graph* graph,
+                                uint32_t               node,
+                                const float3           translation );
+
+FT_API void
+ft_scene_graph_set_rotation( struct ft_scene_graph* graph,
+                             uint32_t               node,
+                             const quat             rotation );
+
+FT_API void
+ft_scene_graph_set_scale( struct ft_scene_graph* graph,
+                          uint32_t               node,
+                          const float3           scale );
+
+// recomputes world transforms of dirty subtrees only
+FT_API void
+ft_scene_graph_update( struct ft_scene_graph* graph );
+
+// whether last update recomputed world transform of node
+FT_API bool
+ft_scene_graph_world_changed( const struct ft_scene_graph* graph,
+                              uint32_t                     node );
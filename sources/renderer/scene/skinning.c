@@ -0,0 +1,348 @@
+#include <math.h>
+#include "math/simd.h"
+#include "skinning.h"
+
+#define VERTICES_PER_TASK 4096
+#define JOINT_INFLUENCES  4
+
+struct dual_quat
+{
+	quat real;
+	quat dual;
+};
+
+struct skinning_task
+{
+	const struct ft_mesh*            mesh;
+	const float4x4*                  joint_matrices;
+	const struct dual_quat*          joint_dual_quats;
+	uint32_t                         joint_count;
+	const struct ft_skinning_output* output;
+	uint32_t                         first_vertex;
+	uint32_t                         vertex_count;
+};
+
+// rotation and translation of rigid part of joint matrix
+static void
+dual_quat_from_matrix( struct dual_quat* dq, const float4x4 m )
+{
+	float3 translation;
+	float3 scale;
+	float4x4_decompose( translation, dq->real, scale, m );
+
+	quat t = { translation[ 0 ], translation[ 1 ], translation[ 2 ], 0.0f };
+	quat_mul( dq->dual, t, dq->real );
+	float4_scale( dq->dual, dq->dual, 0.5f );
+}
+
+// writes through output, mapped memory may be write combined so it is
+// never read back
+FT_INLINE void
+write_attribute( const struct ft_skinning_output* output,
+                 uint32_t                         v,
+                 uint32_t                         offset,
+                 const float*                     value,
+                 uint32_t                         component_count )
+{
+	memcpy( ( uint8_t* ) output->data + ( uint64_t ) v * output->stride +
+	            offset,
+	        value,
+	        component_count * sizeof( float ) );
+}
+
+static void
+write_vertex( const struct skinning_task* task,
+              uint32_t                    v,
+              const float3                position,
+              const float3                normal,
+              const float4                tangent )
+{
+	const struct ft_mesh*            mesh   = task->mesh;
+	const struct ft_skinning_output* output = task->output;
+
+	if ( output->position_offset != FT_SKINNING_SKIP_ATTRIBUTE )
+	{
+		write_attribute( output, v, output->position_offset, position, 3 );
+	}
+
+	if ( mesh->normals &&
+	     output->normal_offset != FT_SKINNING_SKIP_ATTRIBUTE )
+	{
+		write_attribute( output, v, output->normal_offset, normal, 3 );
+	}
+
+	if ( mesh->tangents &&
+	     output->tangent_offset != FT_SKINNING_SKIP_ATTRIBUTE )
+	{
+		write_attribute( output, v, output->tangent_offset, tangent, 4 );
+	}
+}
+
+FT_INLINE void
+read_vertex( const struct ft_mesh* mesh,
+             uint32_t              v,
+             float3                position,
+             float3                normal,
+             float4                tangent )
+{
+	float3_dup( position, &mesh->positions[ v * 3 ] );
+
+	if ( mesh->normals )
+	{
+		float3_dup( normal, &mesh->normals[ v * 3 ] );
+	}
+
+	if ( mesh->tangents )
+	{
+		float4_dup( tangent, &mesh->tangents[ v * 4 ] );
+	}
+}
+
+FT_INLINE void
+normalize_direction( float3 r )
+{
+	float l = float3_len( r );
+
+	if ( l > 0.0f )
+	{
+		float3_scale( r, r, 1.0f / l );
+	}
+}
+
+// weighted sum of joint matrices divided by weight sum, so weights of
+// exporters that do not normalize them still keep vertex in place.
+// directions use it without inverse transpose which is exact for rotation
+// and uniform scale
+static void
+skin_linear_blend( const struct skinning_task* task )
+{
+	const struct ft_mesh* mesh = task->mesh;
+
+	for ( uint32_t v = task->first_vertex;
+	      v < task->first_vertex + task->vertex_count;
+	      ++v )
+	{
+		float3 position;
+		float3 normal  = { 0.0f, 0.0f, 0.0f };
+		float4 tangent = { 0.0f, 0.0f, 0.0f, 0.0f };
+		read_vertex( mesh, v, position, normal, tangent );
+
+		// columns of blended matrix, lane 3 is unused
+		ft_simd4 m[ 4 ] = { ft_simd4_zero(),
+			                ft_simd4_zero(),
+			                ft_simd4_zero(),
+			                ft_simd4_zero() };
+		float    weight_sum = 0.0f;
+
+		for ( uint32_t i = 0; i < JOINT_INFLUENCES; ++i )
+		{
+			uint32_t joint  = ( uint32_t ) mesh->joints[ v * 4 + i ];
+			float    weight = mesh->weights[ v * 4 + i ];
+
+			if ( weight == 0.0f || joint >= task->joint_count )
+			{
+				continue;
+			}
+
+			const float4* j = task->joint_matrices[ joint ];
+			ft_simd4      w = ft_simd4_splat( weight );
+
+			for ( uint32_t c = 0; c < 4; ++c )
+			{
+				m[ c ] = ft_simd4_madd( w, ft_simd4_load( j[ c ] ), m[ c ] );
+			}
+
+			weight_sum += weight;
+		}
+
+		// vertices without influences keep bind pose
+		if ( weight_sum > 0.0f )
+		{
+			ft_simd4 p = m[ 3 ];
+			ft_simd4 n = ft_simd4_zero();
+			ft_simd4 t = ft_simd4_zero();
+
+			for ( uint32_t c = 0; c < 3; ++c )
+			{
+				p = ft_simd4_madd( m[ c ], ft_simd4_splat( position[ c ] ), p );
+				n = ft_simd4_madd( m[ c ], ft_simd4_splat( normal[ c ] ), n );
+				t = ft_simd4_madd( m[ c ], ft_simd4_splat( tangent[ c ] ), t );
+			}
+
+			float4 r;
+			ft_simd4_store( r, p );
+			float3_scale( position, r, 1.0f / weight_sum );
+			ft_simd4_store( r, n );
+			float3_dup( normal, r );
+			ft_simd4_store( r, t );
+			float3_dup( tangent, r );
+			normalize_direction( normal );
+			normalize_direction( tangent );
+		}
+
+		write_vertex( task, v, position, normal, tangent );
+	}
+}
+
+// joint dual quaternions are blended in hemisphere of first influence and
+// normalized, translation is 2 * dual * conj( real )
+static void
+skin_dual_quaternion( const struct skinning_task* task )
+{
+	const struct ft_mesh* mesh = task->mesh;
+
+	for ( uint32_t v = task->first_vertex;
+	      v < task->first_vertex + task->vertex_count;
+	      ++v )
+	{
+		float3 position;
+		float3 normal  = { 0.0f, 0.0f, 0.0f };
+		float4 tangent = { 0.0f, 0.0f, 0.0f, 0.0f };
+		read_vertex( mesh, v, position, normal, tangent );
+
+		struct dual_quat        blend = { 0 };
+		const struct dual_quat* pivot = NULL;
+
+		for ( uint32_t i = 0; i < JOINT_INFLUENCES; ++i )
+		{
+			uint32_t joint  = ( uint32_t ) mesh->joints[ v * 4 + i ];
+			float    weight = mesh->weights[ v * 4 + i ];
+
+			if ( weight == 0.0f || joint >= task->joint_count )
+			{
+				continue;
+			}
+
+			const struct dual_quat* dq = &task->joint_dual_quats[ joint ];
+
+			pivot = pivot ? pivot : dq;
+
+			if ( float4_mul_inner( pivot->real, dq->real ) < 0.0f )
+			{
+				weight = -weight;
+			}
+
+			for ( uint32_t c = 0; c < 4; ++c )
+			{
+				blend.real[ c ] += weight * dq->real[ c ];
+				blend.dual[ c ] += weight * dq->dual[ c ];
+			}
+		}
+
+		float length = float4_len( blend.real );
+
+		if ( pivot != NULL && length > 0.0f )
+		{
+			float4_scale( blend.real, blend.real, 1.0f / length );
+			float4_scale( blend.dual, blend.dual, 1.0f / length );
+
+			quat conj;
+			quat translation;
+			quat_conj( conj, blend.real );
+			quat_mul( translation, blend.dual, conj );
+
+			float3 p;
+			quat_mul_float3( p, blend.real, position );
+
+			for ( uint32_t c = 0; c < 3; ++c )
+			{
+				position[ c ] = p[ c ] + 2.0f * translation[ c ];
+			}
+
+			float3 n;
+			quat_mul_float3( n, blend.real, normal );
+			float3_dup( normal, n );
+
+			float3 t;
+			quat_mul_float3( t, blend.real, tangent );
+			float3_dup( tangent, t );
+		}
+
+		write_vertex( task, v, position, normal, tangent );
+	}
+}
+
+static void
+skinning_task_fun( void* arg )
+{
+	const struct skinning_task* task = arg;
+
+	if ( task->joint_dual_quats )
+	{
+		skin_dual_quaternion( task );
+	}
+	else
+	{
+		skin_linear_blend( task );
+	}
+}
+
+void
+ft_skin_mesh( const struct ft_mesh*            mesh,
+              const float4x4*                  joint_matrices,
+              uint32_t                         joint_count,
+              enum ft_skinning_method          method,
+              const struct ft_skinning_output* output,
+              struct ft_thread_pool*           pool )
+{
+	FT_ASSERT( mesh );
+	FT_ASSERT( joint_matrices );
+	FT_ASSERT( output && output->data );
+
+	if ( mesh->positions == NULL || mesh->joints == NULL ||
+	     mesh->weights == NULL || mesh->vertex_count == 0 )
+	{
+		FT_WARN( "mesh has no skinning attributes" );
+		return;
+	}
+
+	struct dual_quat* dual_quats = NULL;
+
+	if ( method == FT_SKINNING_METHOD_DUAL_QUATERNION )
+	{
+		dual_quats = malloc( joint_count * sizeof( struct dual_quat ) );
+
+		for ( uint32_t j = 0; j < joint_count; ++j )
+		{
+			dual_quat_from_matrix( &dual_quats[ j ], joint_matrices[ j ] );
+		}
+	}
+
+	uint32_t vertices_per_task = pool ? VERTICES_PER_TASK : mesh->vertex_count;
+	uint32_t task_count =
+	    ( mesh->vertex_count + vertices_per_task - 1 ) / vertices_per_task;
+	struct skinning_task* tasks =
+	    malloc( task_count * sizeof( struct skinning_task ) );
+	struct ft_task_group group = { 0 };
+
+	for ( uint32_t t = 0; t < task_count; ++t )
+	{
+		struct skinning_task* task = &tasks[ t ];
+
+		task->mesh             = mesh;
+		task->joint_matrices   = joint_matrices;
+		task->joint_dual_quats = dual_quats;
+		task->joint_count      = joint_count;
+		task->output           = output;
+		task->first_vertex     = t * vertices_per_task;
+		task->vertex_count =
+		    FT_MIN( vertices_per_task, mesh->vertex_count - task->first_vertex );
+
+		if ( pool )
+		{
+			ft_thread_pool_push_group( pool, &group, skinning_task_fun, task );
+		}
+		else
+		{
+			skinning_task_fun( task );
+		}
+	}
+
+	if ( pool )
+	{
+		ft_thread_pool_wait_group( pool, &group );
+	}
+
+	free( tasks );
+	free( dual_quats );
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "base/base.h"
+#include "thread/thread_pool.h"
+#include "model_loader.h"
+
+#define FT_SKINNING_SKIP_ATTRIBUTE UINT32_MAX
+
+enum ft_skinning_method
+{
+	FT_SKINNING_METHOD_LINEAR_BLEND,
+	// keeps volume around twisting joints, joint scale is ignored
+	FT_SKINNING_METHOD_DUAL_QUATERNION,
+};
+
+// float vertices written into mapped buffer, position is xyz, normal xyz and
+// tangent xyzw. attributes with skip offset or missing in mesh are not
+// written
+struct ft_skinning_output
+{
+	void*    data;
+	uint32_t stride;
+	uint32_t position_offset;
+	uint32_t normal_offset;
+	uint32_t tangent_offset;
+};
+
+// skins float vertex streams of mesh with palette of joint matrices, each
+// being joint world transform times inverse bind matrix. vertex ranges are
+// spread over pool when it is not null, calling task may run on same pool
+FT_API void
+ft_skin_mesh( const struct ft_mesh*            mesh,
+              const float4x4*                  joint_matrices,
+              uint32_t                         joint_count,
+              enum ft_skinning_method          method,
+              const struct ft_skinning_output* output,
+              struct ft_thread_pool*           pool );
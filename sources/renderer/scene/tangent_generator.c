@@ -0,0 +1,726 @@
+#include <math.h>
+#include "tangent_generator.h"
+#include "vertex_packing.h"
+
+#define TRIANGLES_PER_TASK 16384
+#define VERTICES_PER_TASK  16384
+#define MIN_UV_AREA        1e-20f
+#define MAX_INDEX_16       UINT16_MAX
+
+// uv winding of face, corners of opposite windings never share tangent so
+// mirrored uv islands keep their own tangent and bitangent sign
+enum face_orientation
+{
+	FACE_ORIENTATION_POSITIVE,
+	FACE_ORIENTATION_NEGATIVE,
+	// degenerate uv mapping, face adds nothing to tangents
+	FACE_ORIENTATION_NONE,
+};
+
+struct tangent_context
+{
+	struct ft_mesh* mesh;
+	uint32_t*       indices;
+	uint32_t        triangle_count;
+	// unit face vectors, zero tangent marks degenerate uv mapping
+	float*          face_tangents;
+	float*          face_bitangents;
+	float*          face_normals;
+	uint8_t*        face_orientations;
+	// welded vertex of every vertex and first vertex of every welded one
+	uint32_t*       remap;
+	uint32_t*       representatives;
+	uint32_t        unique_count;
+	// index buffer positions referencing every welded vertex
+	uint32_t*       corner_offsets;
+	uint32_t*       corners;
+	// tangent of every orientation of welded vertex and mask of
+	// orientations its corners use
+	float*          group_tangents;
+	uint8_t*        group_masks;
+};
+
+struct tangent_task
+{
+	struct tangent_context* ctx;
+	uint32_t                first;
+	uint32_t                count;
+};
+
+FT_INLINE void
+safe_normalize( float3 r, const float3 v )
+{
+	float len = float3_len( v );
+
+	if ( len > 0.0f )
+	{
+		float3_scale( r, v, 1.0f / len );
+	}
+	else
+	{
+		r[ 0 ] = r[ 1 ] = r[ 2 ] = 0.0f;
+	}
+}
+
+static void
+compute_face_vectors( void* arg )
+{
+	const struct tangent_task*    task = arg;
+	const struct tangent_context* ctx  = task->ctx;
+	const struct ft_mesh*         mesh = ctx->mesh;
+
+	for ( uint32_t t = task->first; t < task->first + task->count; ++t )
+	{
+		const uint32_t* tri = &ctx->indices[ t * 3 ];
+		const float*    p0  = &mesh->positions[ tri[ 0 ] * 3 ];
+		const float*    p1  = &mesh->positions[ tri[ 1 ] * 3 ];
+		const float*    p2  = &mesh->positions[ tri[ 2 ] * 3 ];
+
+		float3 e1, e2, n;
+		float3_sub( e1, p1, p0 );
+		float3_sub( e2, p2, p0 );
+		float3_mul_cross( n, e1, e2 );
+		safe_normalize( &ctx->face_normals[ t * 3 ], n );
+
+		float* tangent   = &ctx->face_tangents[ t * 3 ];
+		float* bitangent = &ctx->face_bitangents[ t * 3 ];
+
+		tangent[ 0 ] = tangent[ 1 ] = tangent[ 2 ] = 0.0f;
+		bitangent[ 0 ] = bitangent[ 1 ] = bitangent[ 2 ] = 0.0f;
+		ctx->face_orientations[ t ] = FACE_ORIENTATION_NONE;
+
+		if ( mesh->texcoords == NULL )
+		{
+			continue;
+		}
+
+		const float* uv0 = &mesh->texcoords[ tri[ 0 ] * 2 ];
+		const float* uv1 = &mesh->texcoords[ tri[ 1 ] * 2 ];
+		const float* uv2 = &mesh->texcoords[ tri[ 2 ] * 2 ];
+
+		float2 d1, d2;
+		float2_sub( d1, uv1, uv0 );
+		float2_sub( d2, uv2, uv0 );
+
+		float det = d1[ 0 ] * d2[ 1 ] - d2[ 0 ] * d1[ 1 ];
+
+		if ( fabsf( det ) < MIN_UV_AREA )
+		{
+			continue;
+		}
+
+		// only direction matters, sign of det keeps mirrored mappings
+		float3 s, a, b;
+		float3_scale( a, e1, d2[ 1 ] );
+		float3_scale( b, e2, d1[ 1 ] );
+		float3_sub( s, a, b );
+		float3_scale( s, s, det > 0.0f ? 1.0f : -1.0f );
+		safe_normalize( tangent, s );
+
+		float3_scale( a, e2, d1[ 0 ] );
+		float3_scale( b, e1, d2[ 0 ] );
+		float3_sub( s, a, b );
+		float3_scale( s, s, det > 0.0f ? 1.0f : -1.0f );
+		safe_normalize( bitangent, s );
+
+		if ( float3_len( tangent ) > 0.0f )
+		{
+			ctx->face_orientations[ t ] = det > 0.0f
+			                                  ? FACE_ORIENTATION_POSITIVE
+			                                  : FACE_ORIENTATION_NEGATIVE;
+		}
+	}
+}
+
+FT_INLINE float
+corner_angle( const struct tangent_context* ctx, uint32_t corner )
+{
+	const uint32_t* tri = &ctx->indices[ corner - corner % 3 ];
+	uint32_t        k   = corner % 3;
+	const float*    p   = &ctx->mesh->positions[ tri[ k ] * 3 ];
+
+	float3 e1, e2;
+	float3_sub( e1, &ctx->mesh->positions[ tri[ ( k + 1 ) % 3 ] * 3 ], p );
+	float3_sub( e2, &ctx->mesh->positions[ tri[ ( k + 2 ) % 3 ] * 3 ], p );
+	safe_normalize( e1, e1 );
+	safe_normalize( e2, e2 );
+
+	float d = float3_mul_inner( e1, e2 );
+
+	return acosf( FT_MIN( FT_MAX( d, -1.0f ), 1.0f ) );
+}
+
+// removes component along normal and accumulates weighted direction
+FT_INLINE void
+accumulate_projected( float3       sum,
+                      const float3 v,
+                      const float3 normal,
+                      float        weight )
+{
+	float3 projected, offset;
+	float3_scale( offset, normal, float3_mul_inner( normal, v ) );
+	float3_sub( projected, v, offset );
+	safe_normalize( projected, projected );
+	float3_scale( projected, projected, weight );
+	float3_add( sum, sum, projected );
+}
+
+// tangent orthogonal to normal with bitangent sign in w
+static void
+finish_tangent( float        result[ 4 ],
+                float3       tangent,
+                const float3 bitangent,
+                const float3 normal )
+{
+	safe_normalize( tangent, tangent );
+
+	// degenerate uvs get any direction orthogonal to normal
+	if ( float3_len( tangent ) == 0.0f )
+	{
+		float3 axis = { 1.0f, 0.0f, 0.0f };
+
+		if ( fabsf( normal[ 0 ] ) > 0.9f )
+		{
+			axis[ 0 ] = 0.0f;
+			axis[ 1 ] = 1.0f;
+		}
+
+		accumulate_projected( tangent, axis, normal, 1.0f );
+	}
+
+	float3 cross;
+	float3_mul_cross( cross, normal, tangent );
+
+	float3_dup( result, tangent );
+	result[ 3 ] = float3_mul_inner( cross, bitangent ) < 0.0f ? -1.0f : 1.0f;
+}
+
+// corners of welded vertex are split by uv orientation like bOrient groups
+// of mikktspace, every group gets its own tangent
+static void
+compute_vertex_tangents( void* arg )
+{
+	const struct tangent_task*    task = arg;
+	const struct tangent_context* ctx  = task->ctx;
+	const struct ft_mesh*         mesh = ctx->mesh;
+
+	for ( uint32_t u = task->first; u < task->first + task->count; ++u )
+	{
+		uint32_t first_corner = ctx->corner_offsets[ u ];
+		uint32_t last_corner  = ctx->corner_offsets[ u + 1 ];
+		uint32_t v            = ctx->representatives[ u ];
+
+		float3 normal = { 0.0f, 0.0f, 0.0f };
+
+		if ( mesh->normals )
+		{
+			safe_normalize( normal, &mesh->normals[ v * 3 ] );
+		}
+		else
+		{
+			for ( uint32_t c = first_corner; c < last_corner; ++c )
+			{
+				uint32_t corner = ctx->corners[ c ];
+				float3   n;
+				float3_scale( n,
+				              &ctx->face_normals[ corner / 3 * 3 ],
+				              corner_angle( ctx, corner ) );
+				float3_add( normal, normal, n );
+			}
+
+			safe_normalize( normal, normal );
+		}
+
+		if ( float3_len( normal ) == 0.0f )
+		{
+			normal[ 2 ] = 1.0f;
+		}
+
+		float3  tangents[ 2 ]   = { { 0.0f, 0.0f, 0.0f },
+			                        { 0.0f, 0.0f, 0.0f } };
+		float3  bitangents[ 2 ] = { { 0.0f, 0.0f, 0.0f },
+			                        { 0.0f, 0.0f, 0.0f } };
+		uint8_t mask            = 0;
+
+		for ( uint32_t c = first_corner; c < last_corner; ++c )
+		{
+			uint32_t corner = ctx->corners[ c ];
+			uint32_t o      = ctx->face_orientations[ corner / 3 ];
+
+			if ( o == FACE_ORIENTATION_NONE )
+			{
+				continue;
+			}
+
+			float angle = corner_angle( ctx, corner );
+			mask |= 1 << o;
+
+			accumulate_projected( tangents[ o ],
+			                      &ctx->face_tangents[ corner / 3 * 3 ],
+			                      normal,
+			                      angle );
+			accumulate_projected( bitangents[ o ],
+			                      &ctx->face_bitangents[ corner / 3 * 3 ],
+			                      normal,
+			                      angle );
+		}
+
+		// vertex with degenerate uvs only still gets one tangent
+		ctx->group_masks[ u ] =
+		    mask ? mask : 1 << FACE_ORIENTATION_POSITIVE;
+
+		for ( uint32_t o = 0; o < 2; ++o )
+		{
+			if ( ctx->group_masks[ u ] & ( 1 << o ) )
+			{
+				finish_tangent( &ctx->group_tangents[ ( u * 2 + o ) * 4 ],
+				                tangents[ o ],
+				                bitangents[ o ],
+				                normal );
+			}
+		}
+	}
+}
+
+FT_INLINE uint64_t
+hash_tangent_vertex( const struct ft_mesh* mesh, uint32_t v )
+{
+	const float* attributes[ 3 ] = {
+	    mesh->positions,
+	    mesh->normals,
+	    mesh->texcoords,
+	};
+	uint32_t sizes[ 3 ] = { 3, 3, 2 };
+	uint64_t hash       = 14695981039346656037ull;
+
+	for ( uint32_t a = 0; a < 3; ++a )
+	{
+		if ( attributes[ a ] == NULL )
+		{
+			continue;
+		}
+
+		const uint8_t* bytes =
+		    ( const uint8_t* ) ( attributes[ a ] + v * sizes[ a ] );
+
+		for ( uint32_t b = 0; b < sizes[ a ] * sizeof( float ); ++b )
+		{
+			hash ^= bytes[ b ];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	return hash;
+}
+
+FT_INLINE bool
+compare_tangent_vertices( const struct ft_mesh* mesh, uint32_t a, uint32_t b )
+{
+	return memcmp( &mesh->positions[ a * 3 ],
+	               &mesh->positions[ b * 3 ],
+	               3 * sizeof( float ) ) == 0 &&
+	       ( mesh->normals == NULL ||
+	         memcmp( &mesh->normals[ a * 3 ],
+	                 &mesh->normals[ b * 3 ],
+	                 3 * sizeof( float ) ) == 0 ) &&
+	       ( mesh->texcoords == NULL ||
+	         memcmp( &mesh->texcoords[ a * 2 ],
+	                 &mesh->texcoords[ b * 2 ],
+	                 2 * sizeof( float ) ) == 0 );
+}
+
+static void
+weld_vertices( struct tangent_context* ctx )
+{
+	const struct ft_mesh* mesh = ctx->mesh;
+
+	uint32_t table_size = 1;
+	while ( table_size < mesh->vertex_count * 2 )
+	{
+		table_size *= 2;
+	}
+
+	uint32_t* table = malloc( table_size * sizeof( uint32_t ) );
+	memset( table, 0xff, table_size * sizeof( uint32_t ) );
+
+	ctx->remap           = malloc( mesh->vertex_count * sizeof( uint32_t ) );
+	ctx->representatives = malloc( mesh->vertex_count * sizeof( uint32_t ) );
+	ctx->unique_count    = 0;
+
+	for ( uint32_t v = 0; v < mesh->vertex_count; ++v )
+	{
+		uint32_t bucket = ( uint32_t ) hash_tangent_vertex( mesh, v ) &
+		                  ( table_size - 1 );
+
+		while ( table[ bucket ] != UINT32_MAX &&
+		        !compare_tangent_vertices(
+		            mesh,
+		            ctx->representatives[ table[ bucket ] ],
+		            v ) )
+		{
+			bucket = ( bucket + 1 ) & ( table_size - 1 );
+		}
+
+		if ( table[ bucket ] == UINT32_MAX )
+		{
+			ctx->representatives[ ctx->unique_count ] = v;
+			table[ bucket ]                           = ctx->unique_count++;
+		}
+
+		ctx->remap[ v ] = table[ bucket ];
+	}
+
+	free( table );
+}
+
+static void
+build_corner_lists( struct tangent_context* ctx )
+{
+	uint32_t index_count = ctx->triangle_count * 3;
+
+	ctx->corner_offsets = calloc( ctx->unique_count + 1, sizeof( uint32_t ) );
+	ctx->corners        = malloc( index_count * sizeof( uint32_t ) );
+
+	for ( uint32_t i = 0; i < index_count; ++i )
+	{
+		ctx->corner_offsets[ ctx->remap[ ctx->indices[ i ] ] + 1 ]++;
+	}
+
+	for ( uint32_t u = 0; u < ctx->unique_count; ++u )
+	{
+		ctx->corner_offsets[ u + 1 ] += ctx->corner_offsets[ u ];
+	}
+
+	uint32_t* cursors = malloc( ctx->unique_count * sizeof( uint32_t ) );
+	memcpy( cursors,
+	        ctx->corner_offsets,
+	        ctx->unique_count * sizeof( uint32_t ) );
+
+	for ( uint32_t i = 0; i < index_count; ++i )
+	{
+		ctx->corners[ cursors[ ctx->remap[ ctx->indices[ i ] ] ]++ ] = i;
+	}
+
+	free( cursors );
+}
+
+FT_INLINE void
+append_vertex_copies( struct ft_mesh* mesh,
+                      const uint32_t* sources,
+                      uint32_t        count )
+{
+	float** attributes[ 6 ] = {
+	    &mesh->positions,
+	    &mesh->normals,
+	    &mesh->tangents,
+	    &mesh->texcoords,
+	    &mesh->joints,
+	    &mesh->weights,
+	};
+	uint32_t sizes[ 6 ] = { 3, 3, 4, 2, 4, 4 };
+
+	for ( uint32_t a = 0; a < 6; ++a )
+	{
+		if ( *attributes[ a ] == NULL )
+		{
+			continue;
+		}
+
+		uint32_t c    = sizes[ a ];
+		float*   data = realloc( *attributes[ a ],
+		                         ( mesh->vertex_count + count ) * c *
+		                             sizeof( float ) );
+
+		for ( uint32_t i = 0; i < count; ++i )
+		{
+			memcpy( data + ( mesh->vertex_count + i ) * c,
+			        data + sources[ i ] * c,
+			        c * sizeof( float ) );
+		}
+
+		*attributes[ a ] = data;
+	}
+
+	mesh->vertex_count += count;
+}
+
+FT_INLINE void
+write_mesh_indices( struct ft_mesh* mesh, const uint32_t* indices )
+{
+	// copies may push vertex count past 16 bit range
+	if ( mesh->indices_16 && mesh->vertex_count - 1 > MAX_INDEX_16 )
+	{
+		free( mesh->indices_16 );
+		mesh->indices_16 = NULL;
+		mesh->indices_32 = malloc( mesh->index_count * sizeof( uint32_t ) );
+	}
+
+	for ( uint32_t i = 0; i < mesh->index_count; ++i )
+	{
+		if ( mesh->indices_16 )
+		{
+			mesh->indices_16[ i ] = ( uint16_t ) indices[ i ];
+		}
+		else
+		{
+			mesh->indices_32[ i ] = indices[ i ];
+		}
+	}
+}
+
+// every vertex takes tangent of orientation its corners use. vertices used
+// by both orientations keep positive one and get a copy for negative corners
+static void
+assign_vertex_tangents( struct tangent_context* ctx )
+{
+	struct ft_mesh* mesh         = ctx->mesh;
+	uint32_t        vertex_count = mesh->vertex_count;
+	uint32_t        index_count  = ctx->triangle_count * 3;
+	uint8_t*        masks        = calloc( vertex_count, sizeof( uint8_t ) );
+
+	for ( uint32_t i = 0; i < index_count; ++i )
+	{
+		uint32_t o = ctx->face_orientations[ i / 3 ];
+
+		if ( o != FACE_ORIENTATION_NONE )
+		{
+			masks[ ctx->indices[ i ] ] |= 1 << o;
+		}
+	}
+
+	uint32_t* copies     = malloc( vertex_count * sizeof( uint32_t ) );
+	uint32_t* sources    = malloc( vertex_count * sizeof( uint32_t ) );
+	uint32_t  copy_count = 0;
+
+	for ( uint32_t v = 0; v < vertex_count; ++v )
+	{
+		copies[ v ] = UINT32_MAX;
+
+		if ( masks[ v ] == 3 )
+		{
+			sources[ copy_count ] = v;
+			copies[ v ]           = vertex_count + copy_count++;
+		}
+	}
+
+	if ( copy_count > 0 )
+	{
+		append_vertex_copies( mesh, sources, copy_count );
+
+		for ( uint32_t i = 0; i < index_count; ++i )
+		{
+			uint32_t v = ctx->indices[ i ];
+
+			if ( copies[ v ] != UINT32_MAX &&
+			     ctx->face_orientations[ i / 3 ] == FACE_ORIENTATION_NEGATIVE )
+			{
+				ctx->indices[ i ] = copies[ v ];
+			}
+		}
+
+		write_mesh_indices( mesh, ctx->indices );
+
+		// packed streams no longer match vertex count, packing must run
+		// again
+		ft_free_packed_vertices( &mesh->packed_vertices );
+	}
+
+	for ( uint32_t v = 0; v < mesh->vertex_count; ++v )
+	{
+		bool     copy = v >= vertex_count;
+		uint32_t u    = ctx->remap[ copy ? sources[ v - vertex_count ] : v ];
+		uint32_t o    = FACE_ORIENTATION_POSITIVE;
+
+		if ( copy || masks[ v ] == 1 << FACE_ORIENTATION_NEGATIVE ||
+		     ( masks[ v ] == 0 &&
+		       ctx->group_masks[ u ] == 1 << FACE_ORIENTATION_NEGATIVE ) )
+		{
+			o = FACE_ORIENTATION_NEGATIVE;
+		}
+
+		float4_dup( &mesh->tangents[ v * 4 ],
+		            &ctx->group_tangents[ ( u * 2 + o ) * 4 ] );
+	}
+
+	free( masks );
+	free( copies );
+	free( sources );
+}
+
+static void
+run_tasks( struct tangent_context* ctx,
+           struct ft_thread_pool*  pool,
+           ft_task_fun             fun,
+           uint32_t                count,
+           uint32_t                count_per_task )
+{
+	uint32_t task_count = ( count + count_per_task - 1 ) / count_per_task;
+
+	if ( pool == NULL || task_count <= 1 )
+	{
+		fun( &( struct tangent_task ) {
+		    .ctx   = ctx,
+		    .first = 0,
+		    .count = count,
+		} );
+		return;
+	}
+
+	struct tangent_task* tasks =
+	    malloc( task_count * sizeof( struct tangent_task ) );
+	struct ft_task_group group = { 0 };
+
+	for ( uint32_t t = 0; t < task_count; ++t )
+	{
+		tasks[ t ].ctx   = ctx;
+		tasks[ t ].first = t * count_per_task;
+		tasks[ t ].count = FT_MIN( count_per_task, count - tasks[ t ].first );
+		ft_thread_pool_push_group( pool, &group, fun, &tasks[ t ] );
+	}
+
+	ft_thread_pool_wait_group( pool, &group );
+	free( tasks );
+}
+
+void
+ft_generate_mesh_tangents( struct ft_mesh* mesh, struct ft_thread_pool* pool )
+{
+	FT_ASSERT( mesh );
+
+	if ( mesh->mapped )
+	{
+		FT_WARN( "mesh of baked model can not be resized" );
+		return;
+	}
+
+	if ( mesh->vertex_count == 0 || mesh->positions == NULL )
+	{
+		return;
+	}
+
+	struct tangent_context ctx;
+	memset( &ctx, 0, sizeof( ctx ) );
+	ctx.mesh = mesh;
+
+	uint32_t index_count =
+	    ( mesh->indices_16 || mesh->indices_32 ) ? mesh->index_count
+	                                             : mesh->vertex_count;
+
+	ctx.triangle_count = index_count / 3;
+	ctx.indices        = malloc( index_count * sizeof( uint32_t ) );
+
+	for ( uint32_t i = 0; i < index_count; ++i )
+	{
+		ctx.indices[ i ] = mesh->indices_16   ? mesh->indices_16[ i ]
+		                   : mesh->indices_32 ? mesh->indices_32[ i ]
+		                                      : i;
+	}
+
+	ctx.face_tangents     = malloc( ctx.triangle_count * 3 * sizeof( float ) );
+	ctx.face_bitangents   = malloc( ctx.triangle_count * 3 * sizeof( float ) );
+	ctx.face_normals      = malloc( ctx.triangle_count * 3 * sizeof( float ) );
+	ctx.face_orientations = malloc( ctx.triangle_count * sizeof( uint8_t ) );
+
+	mesh->tangents = realloc( mesh->tangents,
+	                          mesh->vertex_count * 4 * sizeof( float ) );
+
+	run_tasks( &ctx,
+	           pool,
+	           compute_face_vectors,
+	           ctx.triangle_count,
+	           TRIANGLES_PER_TASK );
+
+	weld_vertices( &ctx );
+	build_corner_lists( &ctx );
+
+	ctx.group_tangents = malloc( ctx.unique_count * 8 * sizeof( float ) );
+	ctx.group_masks    = malloc( ctx.unique_count * sizeof( uint8_t ) );
+
+	run_tasks( &ctx,
+	           pool,
+	           compute_vertex_tangents,
+	           ctx.unique_count,
+	           VERTICES_PER_TASK );
+
+	assign_vertex_tangents( &ctx );
+
+	free( ctx.indices );
+	free( ctx.face_tangents );
+	free( ctx.face_bitangents );
+	free( ctx.face_normals );
+	free( ctx.face_orientations );
+	free( ctx.remap );
+	free( ctx.representatives );
+	free( ctx.corner_offsets );
+	free( ctx.corners );
+	free( ctx.group_tangents );
+	free( ctx.group_masks );
+}
+
+static void
+mesh_tangents_task( void* arg )
+{
+	ft_generate_mesh_tangents( arg, NULL );
+}
+
+FT_INLINE uint32_t
+mesh_triangle_count( const struct ft_mesh* mesh )
+{
+	return ( ( mesh->indices_16 || mesh->indices_32 ) ? mesh->index_count
+	                                                  : mesh->vertex_count ) /
+	       3;
+}
+
+void
+ft_generate_model_tangents( struct ft_model*       model,
+                            struct ft_thread_pool* pool )
+{
+	FT_ASSERT( model );
+
+	// meshes split into ranges or run on calling thread, decided up front
+	// since workers write tangents of other meshes meanwhile
+	bool* split = calloc( model->mesh_count, sizeof( bool ) );
+
+	struct ft_task_group group = { 0 };
+
+	for ( uint32_t m = 0; m < model->mesh_count; ++m )
+	{
+		struct ft_mesh* mesh = &model->meshes[ m ];
+
+		if ( mesh->tangents )
+		{
+			continue;
+		}
+
+		if ( mesh->texcoords == NULL )
+		{
+			FT_WARN( "mesh %d does not contain texture coordinates. "
+			         "tangents are arbitrary",
+			         m );
+		}
+
+		split[ m ] = pool == NULL ||
+		             mesh_triangle_count( mesh ) > TRIANGLES_PER_TASK;
+
+		// small meshes run whole on one thread each
+		if ( !split[ m ] )
+		{
+			ft_thread_pool_push_group( pool, &group, mesh_tangents_task, mesh );
+		}
+	}
+
+	for ( uint32_t m = 0; m < model->mesh_count; ++m )
+	{
+		if ( split[ m ] )
+		{
+			ft_generate_mesh_tangents( &model->meshes[ m ], pool );
+		}
+	}
+
+	if ( pool )
+	{
+		ft_thread_pool_wait_group( pool, &group );
+	}
+
+	free( split );
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "base/base.h"
+#include "thread/thread_pool.h"
+#include "model_loader.h"
+
+// mikktspace style tangents: face tangents are projected onto vertex normal,
+// weighted by corner angle and shared between vertices with equal position,
+// normal and uv whose faces have same uv orientation. vertices used by both
+// orientations, e.g. on mirror seams, are duplicated. w stores bitangent
+// sign. triangle and vertex ranges are spread over pool when it is not null,
+// calling task may run on same pool
+FT_API void
+ft_generate_mesh_tangents( struct ft_mesh* mesh, struct ft_thread_pool* pool );
+
+// generates missing tangents of every mesh, meshes run in parallel on pool
+// when it is not null
+FT_API void
+ft_generate_model_tangents( struct ft_model*       model,
+                            struct ft_thread_pool* pool );
@@ -0,0 +1,726 @@
+#include <float.h>
+#include <math.h>
+#include "math/simd.h"
+#include "texture_compression.h"
+
+#define BLOCK_ROWS_PER_TASK 8
+
+// interpolation weights of 4 bit bc7 indices
+static const int32_t bc7_weights[ 16 ] =
+    { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct compress_task
+{
+	const uint8_t* pixels;
+	uint32_t       width;
+	uint32_t       height;
+	enum ft_format format;
+	uint8_t*       blocks;
+	uint32_t       first_row;
+	uint32_t       row_count;
+};
+
+// 4x4 pixels, edge pixels are repeated past image bounds
+static void
+fetch_block( uint8_t        block[ 16 ][ 4 ],
+             const uint8_t* pixels,
+             uint32_t       width,
+             uint32_t       height,
+             uint32_t       bx,
+             uint32_t       by )
+{
+	for ( uint32_t y = 0; y < 4; ++y )
+	{
+		uint64_t py = FT_MIN( by * 4 + y, height - 1 );
+
+		for ( uint32_t x = 0; x < 4; ++x )
+		{
+			uint64_t px = FT_MIN( bx * 4 + x, width - 1 );
+			memcpy( block[ y * 4 + x ], &pixels[ ( py * width + px ) * 4 ], 4 );
+		}
+	}
+}
+
+FT_INLINE float
+clamp_unorm8( float v )
+{
+	return v < 0.0f ? 0.0f : ( v > 255.0f ? 255.0f : v );
+}
+
+// lanes[ c ][ g ] holds channel c of pixels 4 * g to 4 * g + 3, so simd
+// lanes walk pixels of block
+static void
+load_block_lanes( const uint8_t block[ 16 ][ 4 ], ft_simd4 lanes[ 4 ][ 4 ] )
+{
+	float channels[ 4 ][ 16 ];
+
+	for ( uint32_t p = 0; p < 16; ++p )
+	{
+		for ( uint32_t c = 0; c < 4; ++c )
+		{
+			channels[ c ][ p ] = block[ p ][ c ];
+		}
+	}
+
+	for ( uint32_t c = 0; c < 4; ++c )
+	{
+		for ( uint32_t g = 0; g < 4; ++g )
+		{
+			lanes[ c ][ g ] = ft_simd4_load( &channels[ c ][ g * 4 ] );
+		}
+	}
+}
+
+FT_INLINE float
+lanes_sum( ft_simd4 a )
+{
+	float v[ 4 ];
+	ft_simd4_store( v, a );
+	return ( v[ 0 ] + v[ 1 ] ) + ( v[ 2 ] + v[ 3 ] );
+}
+
+FT_INLINE float
+lanes_min( ft_simd4 a )
+{
+	float v[ 4 ];
+	ft_simd4_store( v, a );
+	return FT_MIN( FT_MIN( v[ 0 ], v[ 1 ] ), FT_MIN( v[ 2 ], v[ 3 ] ) );
+}
+
+FT_INLINE float
+lanes_max( ft_simd4 a )
+{
+	float v[ 4 ];
+	ft_simd4_store( v, a );
+	return FT_MAX( FT_MAX( v[ 0 ], v[ 1 ] ), FT_MAX( v[ 2 ], v[ 3 ] ) );
+}
+
+// endpoints of segment along principal axis of block colors, first endpoint
+// lies at lowest projection
+static void
+fit_endpoints( const ft_simd4 lanes[ 4 ][ 4 ],
+               uint32_t       channel_count,
+               float          endpoints[ 2 ][ 4 ] )
+{
+	float    mean[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	ft_simd4 d[ 4 ][ 4 ];
+
+	for ( uint32_t c = 0; c < channel_count; ++c )
+	{
+		ft_simd4 sum = ft_simd4_zero();
+
+		for ( uint32_t g = 0; g < 4; ++g )
+		{
+			sum = ft_simd4_add( sum, lanes[ c ][ g ] );
+		}
+
+		mean[ c ]  = lanes_sum( sum ) / 16.0f;
+		ft_simd4 m = ft_simd4_splat( mean[ c ] );
+
+		for ( uint32_t g = 0; g < 4; ++g )
+		{
+			d[ c ][ g ] = ft_simd4_sub( lanes[ c ][ g ], m );
+		}
+	}
+
+	float covariance[ 4 ][ 4 ];
+	memset( covariance, 0, sizeof( covariance ) );
+
+	for ( uint32_t i = 0; i < channel_count; ++i )
+	{
+		for ( uint32_t j = 0; j <= i; ++j )
+		{
+			ft_simd4 sum = ft_simd4_zero();
+
+			for ( uint32_t g = 0; g < 4; ++g )
+			{
+				sum = ft_simd4_madd( d[ i ][ g ], d[ j ][ g ], sum );
+			}
+
+			covariance[ i ][ j ] = lanes_sum( sum );
+			covariance[ j ][ i ] = covariance[ i ][ j ];
+		}
+	}
+
+	// power iteration starting from channel with largest variance
+	uint32_t largest = 0;
+
+	for ( uint32_t c = 1; c < channel_count; ++c )
+	{
+		if ( covariance[ c ][ c ] > covariance[ largest ][ largest ] )
+		{
+			largest = c;
+		}
+	}
+
+	float axis[ 4 ];
+	memcpy( axis, covariance[ largest ], sizeof( axis ) );
+
+	for ( uint32_t iteration = 0; iteration < 8; ++iteration )
+	{
+		float next[ 4 ] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float scale     = 0.0f;
+
+		for ( uint32_t i = 0; i < channel_count; ++i )
+		{
+			for ( uint32_t j = 0; j < channel_count; ++j )
+			{
+				next[ i ] += covariance[ i ][ j ] * axis[ j ];
+			}
+
+			scale = FT_MAX( scale, fabsf( next[ i ] ) );
+		}
+
+		if ( scale == 0.0f )
+		{
+			break;
+		}
+
+		for ( uint32_t c = 0; c < channel_count; ++c )
+		{
+			axis[ c ] = next[ c ] / scale;
+		}
+	}
+
+	float length = 0.0f;
+
+	for ( uint32_t c = 0; c < channel_count; ++c )
+	{
+		length += axis[ c ] * axis[ c ];
+	}
+
+	length = sqrtf( length );
+
+	float min_t = 0.0f;
+	float max_t = 0.0f;
+
+	if ( length > 0.0f )
+	{
+		ft_simd4 lowest  = ft_simd4_zero();
+		ft_simd4 highest = ft_simd4_zero();
+
+		for ( uint32_t g = 0; g < 4; ++g )
+		{
+			ft_simd4 t = ft_simd4_zero();
+
+			for ( uint32_t c = 0; c < channel_count; ++c )
+			{
+				t = ft_simd4_madd( d[ c ][ g ],
+				                   ft_simd4_splat( axis[ c ] / length ),
+				                   t );
+			}
+
+			lowest  = ft_simd4_min( lowest, t );
+			highest = ft_simd4_max( highest, t );
+		}
+
+		min_t = lanes_min( lowest );
+		max_t = lanes_max( highest );
+	}
+
+	for ( uint32_t c = 0; c < 4; ++c )
+	{
+		float a = length > 0.0f ? axis[ c ] / length : 0.0f;
+
+		endpoints[ 0 ][ c ] =
+		    c < channel_count ? clamp_unorm8( mean[ c ] + a * min_t ) : 255.0f;
+		endpoints[ 1 ][ c ] =
+		    c < channel_count ? clamp_unorm8( mean[ c ] + a * max_t ) : 255.0f;
+	}
+}
+
+// index of nearest palette color for every pixel, four pixels at a time.
+// first of equally near colors wins. returns summed squared error
+static int32_t
+find_nearest_indices( const ft_simd4 lanes[ 4 ][ 4 ],
+                      uint32_t       channel_count,
+                      const int32_t  palette[][ 4 ],
+                      uint32_t       palette_size,
+                      uint32_t       indices[ 16 ] )
+{
+	float error = 0.0f;
+
+	for ( uint32_t g = 0; g < 4; ++g )
+	{
+		ft_simd4 best_error = ft_simd4_splat( FLT_MAX );
+		ft_simd4 best_index = ft_simd4_zero();
+
+		for ( uint32_t i = 0; i < palette_size; ++i )
+		{
+			ft_simd4 e = ft_simd4_zero();
+
+			for ( uint32_t c = 0; c < channel_count; ++c )
+			{
+				ft_simd4 color = ft_simd4_splat( ( float ) palette[ i ][ c ] );
+				ft_simd4 d     = ft_simd4_sub( lanes[ c ][ g ], color );
+				e              = ft_simd4_madd( d, d, e );
+			}
+
+			ft_simd4 closer = ft_simd4_less( e, best_error );
+			best_error      = ft_simd4_select( closer, best_error, e );
+			best_index      = ft_simd4_select( closer,
+			                                   best_index,
+			                                   ft_simd4_splat( ( float ) i ) );
+		}
+
+		float index[ 4 ];
+		ft_simd4_store( index, best_index );
+
+		for ( uint32_t p = 0; p < 4; ++p )
+		{
+			indices[ g * 4 + p ] = ( uint32_t ) index[ p ];
+		}
+
+		// errors are integers well below 2^24, sums stay exact
+		error += lanes_sum( best_error );
+	}
+
+	return ( int32_t ) error;
+}
+
+FT_INLINE uint16_t
+pack_565( const float c[ 4 ] )
+{
+	uint32_t r = ( uint32_t ) ( c[ 0 ] * 31.0f / 255.0f + 0.5f );
+	uint32_t g = ( uint32_t ) ( c[ 1 ] * 63.0f / 255.0f + 0.5f );
+	uint32_t b = ( uint32_t ) ( c[ 2 ] * 31.0f / 255.0f + 0.5f );
+
+	return ( uint16_t ) ( ( r << 11 ) | ( g << 5 ) | b );
+}
+
+FT_INLINE void
+unpack_565( uint16_t c, int32_t rgb[ 3 ] )
+{
+	int32_t r = ( c >> 11 ) & 31;
+	int32_t g = ( c >> 5 ) & 63;
+	int32_t b = c & 31;
+
+	rgb[ 0 ] = ( r << 3 ) | ( r >> 2 );
+	rgb[ 1 ] = ( g << 2 ) | ( g >> 4 );
+	rgb[ 2 ] = ( b << 3 ) | ( b >> 2 );
+}
+
+FT_INLINE void
+write_u16( uint8_t* out, uint16_t value )
+{
+	out[ 0 ] = ( uint8_t ) ( value & 0xff );
+	out[ 1 ] = ( uint8_t ) ( value >> 8 );
+}
+
+FT_INLINE void
+write_bits( uint8_t* out, uint64_t bits, uint32_t byte_count )
+{
+	for ( uint32_t b = 0; b < byte_count; ++b )
+	{
+		out[ b ] = ( uint8_t ) ( bits >> ( b * 8 ) );
+	}
+}
+
+// four color mode only, so block is valid as bc3 color too
+static void
+encode_bc1( const uint8_t block[ 16 ][ 4 ], uint8_t* out )
+{
+	ft_simd4 lanes[ 4 ][ 4 ];
+	load_block_lanes( block, lanes );
+
+	float endpoints[ 2 ][ 4 ];
+	fit_endpoints( lanes, 3, endpoints );
+
+	uint16_t c0 = pack_565( endpoints[ 1 ] );
+	uint16_t c1 = pack_565( endpoints[ 0 ] );
+
+	if ( c0 < c1 )
+	{
+		uint16_t tmp = c0;
+		c0           = c1;
+		c1           = tmp;
+	}
+
+	uint32_t indices = 0;
+
+	if ( c0 != c1 )
+	{
+		int32_t palette[ 4 ][ 4 ];
+		unpack_565( c0, palette[ 0 ] );
+		unpack_565( c1, palette[ 1 ] );
+
+		for ( uint32_t c = 0; c < 3; ++c )
+		{
+			palette[ 2 ][ c ] = ( 2 * palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 3;
+			palette[ 3 ][ c ] = ( palette[ 0 ][ c ] + 2 * palette[ 1 ][ c ] ) / 3;
+		}
+
+		uint32_t nearest[ 16 ];
+		find_nearest_indices( lanes, 3, palette, 4, nearest );
+
+		for ( uint32_t p = 0; p < 16; ++p )
+		{
+			indices |= nearest[ p ] << ( p * 2 );
+		}
+	}
+
+	write_u16( out, c0 );
+	write_u16( out + 2, c1 );
+	write_bits( out + 4, indices, 4 );
+}
+
+// eight value mode with first endpoint greater than second
+static void
+encode_bc4( const uint8_t block[ 16 ][ 4 ], uint32_t channel, uint8_t* out )
+{
+	int32_t min = 255;
+	int32_t max = 0;
+
+	for ( uint32_t p = 0; p < 16; ++p )
+	{
+		min = FT_MIN( min, block[ p ][ channel ] );
+		max = FT_MAX( max, block[ p ][ channel ] );
+	}
+
+	uint64_t indices = 0;
+	int32_t  range   = max - min;
+
+	if ( range > 0 )
+	{
+		for ( uint32_t p = 0; p < 16; ++p )
+		{
+			// t steps from min to max, palette stores max, min, then inner
+			// values from max downwards
+			int32_t  t     = ( ( block[ p ][ channel ] - min ) * 14 + range ) /
+			            ( 2 * range );
+			uint64_t index = t == 7 ? 0 : ( t == 0 ? 1 : 8 - t );
+			indices |= index << ( p * 3 );
+		}
+	}
+
+	out[ 0 ] = ( uint8_t ) max;
+	out[ 1 ] = ( uint8_t ) min;
+	write_bits( out + 2, indices, 6 );
+}
+
+FT_INLINE void
+put_bits( uint64_t bits[ 2 ], uint32_t* offset, uint32_t value, uint32_t count )
+{
+	for ( uint32_t b = 0; b < count; ++b, ++*offset )
+	{
+		bits[ *offset / 64 ] |= ( uint64_t ) ( ( value >> b ) & 1 )
+		                        << ( *offset % 64 );
+	}
+}
+
+FT_INLINE int32_t
+bc7_interpolate( int32_t e0, int32_t e1, int32_t weight )
+{
+	return ( ( 64 - weight ) * e0 + weight * e1 + 32 ) >> 6;
+}
+
+// mode 6, single subset with 7 bit rgba endpoints, p bits and 4 bit indices
+static void
+encode_bc7( const uint8_t block[ 16 ][ 4 ], uint8_t* out )
+{
+	ft_simd4 lanes[ 4 ][ 4 ];
+	load_block_lanes( block, lanes );
+
+	float endpoints[ 2 ][ 4 ];
+	fit_endpoints( lanes, 4, endpoints );
+
+	int32_t  best_error = INT32_MAX;
+	int32_t  best_quantized[ 2 ][ 4 ];
+	uint32_t best_p[ 2 ];
+	uint32_t best_indices[ 16 ];
+
+	for ( uint32_t p_bits = 0; p_bits < 4; ++p_bits )
+	{
+		uint32_t p[ 2 ] = { p_bits & 1, p_bits >> 1 };
+		int32_t  quantized[ 2 ][ 4 ];
+		int32_t  e[ 2 ][ 4 ];
+
+		for ( uint32_t c = 0; c < 4; ++c )
+		{
+			for ( uint32_t en = 0; en < 2; ++en )
+			{
+				int32_t q =
+				    ( int32_t ) ( ( endpoints[ en ][ c ] - p[ en ] ) * 0.5f +
+				                  0.5f );
+				quantized[ en ][ c ] = FT_MIN( FT_MAX( q, 0 ), 127 );
+				e[ en ][ c ]         = ( quantized[ en ][ c ] << 1 ) | p[ en ];
+			}
+		}
+
+		int32_t palette[ 16 ][ 4 ];
+
+		for ( uint32_t i = 0; i < 16; ++i )
+		{
+			for ( uint32_t c = 0; c < 4; ++c )
+			{
+				palette[ i ][ c ] = bc7_interpolate( e[ 0 ][ c ],
+				                                     e[ 1 ][ c ],
+				                                     bc7_weights[ i ] );
+			}
+		}
+
+		uint32_t indices[ 16 ];
+		int32_t  error = find_nearest_indices( lanes, 4, palette, 16, indices );
+
+		if ( error < best_error )
+		{
+			best_error = error;
+			memcpy( best_quantized, quantized, sizeof( quantized ) );
+			memcpy( best_p, p, sizeof( p ) );
+			memcpy( best_indices, indices, sizeof( indices ) );
+		}
+	}
+
+	// anchor index has implicit zero high bit, swap endpoints to satisfy it
+	if ( best_indices[ 0 ] & 8 )
+	{
+		for ( uint32_t c = 0; c < 4; ++c )
+		{
+			int32_t tmp               = best_quantized[ 0 ][ c ];
+			best_quantized[ 0 ][ c ] = best_quantized[ 1 ][ c ];
+			best_quantized[ 1 ][ c ] = tmp;
+		}
+
+		uint32_t tmp = best_p[ 0 ];
+		best_p[ 0 ]  = best_p[ 1 ];
+		best_p[ 1 ]  = tmp;
+
+		for ( uint32_t px = 0; px < 16; ++px )
+		{
+			best_indices[ px ] = 15 - best_indices[ px ];
+		}
+	}
+
+	uint64_t bits[ 2 ] = { 0, 0 };
+	uint32_t offset    = 0;
+
+	put_bits( bits, &offset, 1 << 6, 7 );
+
+	for ( uint32_t c = 0; c < 4; ++c )
+	{
+		put_bits( bits, &offset, best_quantized[ 0 ][ c ], 7 );
+		put_bits( bits, &offset, best_quantized[ 1 ][ c ], 7 );
+	}
+
+	put_bits( bits, &offset, best_p[ 0 ], 1 );
+	put_bits( bits, &offset, best_p[ 1 ], 1 );
+
+	for ( uint32_t px = 0; px < 16; ++px )
+	{
+		put_bits( bits, &offset, best_indices[ px ], px == 0 ? 3 : 4 );
+	}
+
+	FT_ASSERT( offset == 128 );
+
+	write_bits( out, bits[ 0 ], 8 );
+	write_bits( out + 8, bits[ 1 ], 8 );
+}
+
+static void
+compress_block_rows( const struct compress_task* task )
+{
+	uint32_t block_size = ft_format_size_bytes( task->format );
+	uint32_t blocks_x   = ( task->width + 3 ) / 4;
+	uint8_t  block[ 16 ][ 4 ];
+
+	for ( uint32_t by = task->first_row;
+	      by < task->first_row + task->row_count;
+	      ++by )
+	{
+		for ( uint32_t bx = 0; bx < blocks_x; ++bx )
+		{
+			uint8_t* out =
+			    task->blocks + ( ( uint64_t ) by * blocks_x + bx ) * block_size;
+
+			fetch_block( block,
+			             task->pixels,
+			             task->width,
+			             task->height,
+			             bx,
+			             by );
+
+			switch ( task->format )
+			{
+			case FT_FORMAT_DXBC1_RGB_UNORM:
+			case FT_FORMAT_DXBC1_RGB_SRGB: encode_bc1( block, out ); break;
+			case FT_FORMAT_DXBC3_UNORM:
+			case FT_FORMAT_DXBC3_SRGB:
+				encode_bc4( block, 3, out );
+				encode_bc1( block, out + 8 );
+				break;
+			case FT_FORMAT_DXBC4_UNORM: encode_bc4( block, 0, out ); break;
+			case FT_FORMAT_DXBC5_UNORM:
+				encode_bc4( block, 0, out );
+				encode_bc4( block, 1, out + 8 );
+				break;
+			case FT_FORMAT_DXBC7_UNORM:
+			case FT_FORMAT_DXBC7_SRGB: encode_bc7( block, out ); break;
+			default: FT_ASSERT( false && "unsupported block format" ); return;
+			}
+		}
+	}
+}
+
+static void
+compress_task_fun( void* arg )
+{
+	compress_block_rows( arg );
+}
+
+enum ft_format
+ft_get_block_compressed_format( enum ft_texture_type type,
+                                enum ft_format       format )
+{
+	bool srgb = format == FT_FORMAT_R8G8B8A8_SRGB;
+
+	if ( !srgb && format != FT_FORMAT_R8G8B8A8_UNORM )
+	{
+		return FT_FORMAT_UNDEFINED;
+	}
+
+	switch ( type )
+	{
+	case FT_TEXTURE_TYPE_BASE_COLOR:
+		return srgb ? FT_FORMAT_DXBC7_SRGB : FT_FORMAT_DXBC7_UNORM;
+	case FT_TEXTURE_TYPE_NORMAL: return FT_FORMAT_DXBC5_UNORM;
+	case FT_TEXTURE_TYPE_AMBIENT_OCCLUSION: return FT_FORMAT_DXBC4_UNORM;
+	case FT_TEXTURE_TYPE_METAL_ROUGHNESS: return FT_FORMAT_DXBC7_UNORM;
+	case FT_TEXTURE_TYPE_EMISSIVE:
+		return srgb ? FT_FORMAT_DXBC1_RGB_SRGB : FT_FORMAT_DXBC1_RGB_UNORM;
+	default: return FT_FORMAT_UNDEFINED;
+	}
+}
+
+void
+ft_compress_image( const uint8_t* pixels,
+                   uint32_t       width,
+                   uint32_t       height,
+                   enum ft_format format,
+                   void*          blocks )
+{
+	FT_ASSERT( pixels );
+	FT_ASSERT( blocks );
+
+	compress_block_rows( &( struct compress_task ) {
+	    .pixels    = pixels,
+	    .width     = width,
+	    .height    = height,
+	    .format    = format,
+	    .blocks    = blocks,
+	    .first_row = 0,
+	    .row_count = ( height + 3 ) / 4,
+	} );
+}
+
+void
+ft_compress_texture_mips( const struct ft_texture* texture,
+                          uint32_t                 first_mip,
+                          uint32_t                 mip_count,
+                          enum ft_format           format,
+                          void*                    blocks,
+                          struct ft_thread_pool*   pool )
+{
+	FT_ASSERT( texture && texture->data );
+	FT_ASSERT( blocks );
+	FT_ASSERT( first_mip + mip_count <= texture->mip_levels );
+
+	struct ft_texture compressed = *texture;
+	compressed.format            = format;
+
+	uint32_t last_mip   = first_mip + mip_count;
+	uint32_t task_count = 0;
+
+	for ( uint32_t mip = first_mip; mip < last_mip; ++mip )
+	{
+		task_count += ( FT_MAX( texture->height >> mip, 1 ) + 4 *
+		                BLOCK_ROWS_PER_TASK - 1 ) /
+		              ( 4 * BLOCK_ROWS_PER_TASK );
+	}
+
+	struct compress_task* tasks =
+	    malloc( task_count * sizeof( struct compress_task ) );
+	uint32_t             task_index = 0;
+	struct ft_task_group group      = { 0 };
+
+	for ( uint32_t mip = first_mip; mip < last_mip; ++mip )
+	{
+		uint32_t width    = FT_MAX( texture->width >> mip, 1 );
+		uint32_t height   = FT_MAX( texture->height >> mip, 1 );
+		uint32_t blocks_y = ( height + 3 ) / 4;
+
+		for ( uint32_t row = 0; row < blocks_y; row += BLOCK_ROWS_PER_TASK )
+		{
+			struct compress_task* task = &tasks[ task_index++ ];
+
+			task->pixels    = ( const uint8_t* ) texture->data +
+			               ft_texture_mip_offset( texture, mip );
+			task->width     = width;
+			task->height    = height;
+			task->format    = format;
+			task->blocks    = ( uint8_t* ) blocks +
+			               ft_texture_mip_offset( &compressed, mip );
+			task->first_row = row;
+			task->row_count = FT_MIN( BLOCK_ROWS_PER_TASK, blocks_y - row );
+
+			if ( pool )
+			{
+				ft_thread_pool_push_group( pool,
+				                           &group,
+				                           compress_task_fun,
+				                           task );
+			}
+			else
+			{
+				compress_block_rows( task );
+			}
+		}
+	}
+
+	if ( pool )
+	{
+		ft_thread_pool_wait_group( pool, &group );
+	}
+
+	free( tasks );
+}
+
+bool
+ft_compress_texture( struct ft_texture*     texture,
+                     enum ft_format         format,
+                     struct ft_thread_pool* pool )
+{
+	FT_ASSERT( texture );
+
+	if ( texture->mapped )
+	{
+		FT_WARN( "texture of baked model can not be replaced" );
+		return false;
+	}
+
+	if ( texture->data == NULL || format == FT_FORMAT_UNDEFINED ||
+	     ( texture->format != FT_FORMAT_R8G8B8A8_UNORM &&
+	       texture->format != FT_FORMAT_R8G8B8A8_SRGB ) )
+	{
+		return false;
+	}
+
+	struct ft_texture compressed = *texture;
+	compressed.format            = format;
+
+	uint8_t* blocks =
+	    malloc( ft_texture_mip_offset( &compressed, texture->mip_levels ) );
+
+	ft_compress_texture_mips( texture,
+	                          0,
+	                          texture->mip_levels,
+	                          format,
+	                          blocks,
+	                          pool );
+
+	free( texture->data );
+
+	texture->data   = blocks;
+	texture->format = format;
+
+	return true;
+}
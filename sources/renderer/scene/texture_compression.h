@@ -0,0 +1,39 @@
+#pragma once
+
+#include "base/base.h"
+#include "thread/thread_pool.h"
+#include "model_loader.h"
+
+// picks block compressed format for texture of given type stored in format,
+// returns FT_FORMAT_UNDEFINED when texture should stay uncompressed
+FT_API enum ft_format
+ft_get_block_compressed_format( enum ft_texture_type type,
+                                enum ft_format       format );
+
+// encodes rgba8 pixels into blocks, which must hold
+// ft_format_image_size( format, width, height ) bytes
+FT_API void
+ft_compress_image( const uint8_t* pixels,
+                   uint32_t       width,
+                   uint32_t       height,
+                   enum ft_format format,
+                   void*          blocks );
+
+// encodes mip_count levels of rgba8 texture starting at first_mip into
+// blocks, which hold whole mip chain of texture in format. other levels of
+// blocks are left untouched, so chain can be filled in several calls
+FT_API void
+ft_compress_texture_mips( const struct ft_texture* texture,
+                          uint32_t                 first_mip,
+                          uint32_t                 mip_count,
+                          enum ft_format           format,
+                          void*                    blocks,
+                          struct ft_thread_pool*   pool );
+
+// replaces every mip level of texture with blocks of format, rows of blocks
+// are spread over pool when it is not null, calling task may run on same
+// pool
+FT_API bool
+ft_compress_texture( struct ft_texture*     texture,
+                     enum ft_format         format,
+                     struct ft_thread_pool* pool );
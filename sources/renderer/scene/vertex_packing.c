@@ -0,0 +1,443 @@
+#include <math.h>
+#include "vertex_packing.h"
+
+#define TANGENT_SIGN_EPSILON ( 1.0f / 32767.0f )
+
+FT_INLINE uint16_t
+float_to_half( float v )
+{
+	union
+	{
+		float    f;
+		uint32_t u;
+	} bits = { v };
+
+	int32_t s  = ( bits.u >> 16 ) & 0x8000;
+	int32_t em = bits.u & 0x7fffffff;
+
+	// rebias exponent and round to nearest
+	int32_t h = ( em - ( 112 << 23 ) + ( 1 << 12 ) ) >> 13;
+	// flush denormals to zero
+	h = ( em < ( 113 << 23 ) ) ? 0 : h;
+	// overflow to infinity
+	h = ( em >= ( 143 << 23 ) ) ? 0x7c00 : h;
+	// nan
+	h = ( em > ( 255 << 23 ) ) ? 0x7e00 : h;
+
+	return ( uint16_t ) ( s | h );
+}
+
+FT_INLINE int16_t
+float_to_snorm16( float v )
+{
+	v = FT_CLAMP( v, -1.0f, 1.0f );
+	return ( int16_t ) lrintf( v * 32767.0f );
+}
+
+FT_INLINE uint16_t
+float_to_unorm16( float v )
+{
+	v = FT_CLAMP( v, 0.0f, 1.0f );
+	return ( uint16_t ) lrintf( v * 65535.0f );
+}
+
+FT_INLINE void
+octahedral_encode( float2 r, const float* n )
+{
+	float l1 = fabsf( n[ 0 ] ) + fabsf( n[ 1 ] ) + fabsf( n[ 2 ] );
+
+	if ( l1 == 0.0f )
+	{
+		r[ 0 ] = 0.0f;
+		r[ 1 ] = 0.0f;
+		return;
+	}
+
+	float x = n[ 0 ] / l1;
+	float y = n[ 1 ] / l1;
+
+	if ( n[ 2 ] < 0.0f )
+	{
+		float ox = x;
+		x        = ( 1.0f - fabsf( y ) ) * ( x >= 0.0f ? 1.0f : -1.0f );
+		y        = ( 1.0f - fabsf( ox ) ) * ( y >= 0.0f ? 1.0f : -1.0f );
+	}
+
+	r[ 0 ] = x;
+	r[ 1 ] = y;
+}
+
+struct attribute_desc
+{
+	enum ft_vertex_attribute_location location;
+	enum ft_format                    format;
+	uint32_t                          size;
+	uint32_t                          binding;
+	uint32_t                          offset;
+};
+
+FT_INLINE void
+add_attribute( struct attribute_desc*            attributes,
+               uint32_t*                         attribute_count,
+               uint32_t*                         strides,
+               enum ft_vertex_attribute_location location,
+               enum ft_format                    format,
+               uint32_t                          binding )
+{
+	struct attribute_desc* desc = &attributes[ ( *attribute_count )++ ];
+
+	desc->location = location;
+	desc->format   = format;
+	desc->size     = ft_format_size_bytes( format );
+	desc->binding  = binding;
+	desc->offset   = strides[ binding ];
+
+	strides[ binding ] += desc->size;
+}
+
+FT_INLINE uint32_t
+max_joint_index( const struct ft_mesh* mesh )
+{
+	float max_joint = 0.0f;
+
+	for ( uint32_t i = 0; i < mesh->vertex_count * 4; ++i )
+	{
+		max_joint = FT_MAX( max_joint, mesh->joints[ i ] );
+	}
+
+	return ( uint32_t ) max_joint;
+}
+
+FT_INLINE void
+pack_weights( uint8_t* dst, const float* weights )
+{
+	float sum = weights[ 0 ] + weights[ 1 ] + weights[ 2 ] + weights[ 3 ];
+	float k   = sum > 0.0f ? 255.0f / sum : 0.0f;
+
+	int32_t  total   = 0;
+	uint32_t largest = 0;
+
+	for ( uint32_t i = 0; i < 4; ++i )
+	{
+		int32_t w = ( int32_t ) lrintf( weights[ i ] * k );
+		dst[ i ]  = ( uint8_t ) FT_CLAMP( w, 0, 255 );
+		total += dst[ i ];
+
+		if ( weights[ i ] > weights[ largest ] )
+		{
+			largest = i;
+		}
+	}
+
+	if ( sum > 0.0f )
+	{
+		// keep weights summing exactly to one after quantization
+		int32_t fixed = dst[ largest ] + ( 255 - total );
+		dst[ largest ] = ( uint8_t ) FT_CLAMP( fixed, 0, 255 );
+	}
+}
+
+void
+ft_pack_mesh_vertices( struct ft_mesh* mesh, enum ft_model_flags flags )
+{
+	FT_ASSERT( mesh );
+
+	if ( mesh->mapped )
+	{
+		FT_WARN( "mesh of baked model can not be resized" );
+		return;
+	}
+
+	struct ft_vertex_streams* streams = &mesh->packed_vertices;
+	ft_free_packed_vertices( streams );
+
+	if ( mesh->vertex_count == 0 || mesh->positions == NULL )
+	{
+		return;
+	}
+
+	bool split = ( flags & FT_MODEL_SPLIT_POSITION_STREAM ) != 0;
+	bool snorm = ( flags & FT_MODEL_SNORM_POSITIONS ) != 0;
+
+	float3_dup( streams->position_offset, ( float3 ) { 0.0f, 0.0f, 0.0f } );
+	float3_dup( streams->position_scale, ( float3 ) { 1.0f, 1.0f, 1.0f } );
+	float2_dup( streams->texcoord_offset, ( float2 ) { 0.0f, 0.0f } );
+	float2_dup( streams->texcoord_scale, ( float2 ) { 1.0f, 1.0f } );
+
+	if ( snorm )
+	{
+		float3 min;
+		float3 max;
+		float3_dup( min, mesh->positions );
+		float3_dup( max, mesh->positions );
+
+		for ( uint32_t v = 1; v < mesh->vertex_count; ++v )
+		{
+			float3_min( min, min, &mesh->positions[ v * 3 ] );
+			float3_max( max, max, &mesh->positions[ v * 3 ] );
+		}
+
+		for ( uint32_t i = 0; i < 3; ++i )
+		{
+			float extent = ( max[ i ] - min[ i ] ) * 0.5f;
+
+			streams->position_offset[ i ] = ( max[ i ] + min[ i ] ) * 0.5f;
+			streams->position_scale[ i ]  = extent > 0.0f ? extent : 1.0f;
+		}
+	}
+
+	if ( mesh->texcoords )
+	{
+		float2 min;
+		float2 max;
+		float2_dup( min, mesh->texcoords );
+		float2_dup( max, mesh->texcoords );
+
+		for ( uint32_t v = 1; v < mesh->vertex_count; ++v )
+		{
+			float2_min( min, min, &mesh->texcoords[ v * 2 ] );
+			float2_max( max, max, &mesh->texcoords[ v * 2 ] );
+		}
+
+		// texcoords inside unit square are stored as is
+		if ( min[ 0 ] < 0.0f || min[ 1 ] < 0.0f || max[ 0 ] > 1.0f ||
+		     max[ 1 ] > 1.0f )
+		{
+			for ( uint32_t i = 0; i < 2; ++i )
+			{
+				float extent                  = max[ i ] - min[ i ];
+				streams->texcoord_offset[ i ] = min[ i ];
+				streams->texcoord_scale[ i ]  = extent > 0.0f ? extent : 1.0f;
+			}
+		}
+	}
+
+	bool wide_joints =
+	    mesh->joints != NULL && max_joint_index( mesh ) > UINT8_MAX;
+
+	struct attribute_desc attributes[ 6 ];
+	uint32_t              attribute_count = 0;
+	uint32_t              strides[ FT_MAX_VERTEX_STREAM_COUNT ] = { 0, 0 };
+	uint32_t              attribute_binding = split ? 1 : 0;
+
+	add_attribute( attributes,
+	               &attribute_count,
+	               strides,
+	               FT_VERTEX_ATTRIBUTE_LOCATION_POSITION,
+	               snorm ? FT_FORMAT_R16G16B16A16_SNORM
+	                     : FT_FORMAT_R16G16B16A16_SFLOAT,
+	               0 );
+
+	if ( mesh->normals )
+	{
+		add_attribute( attributes,
+		               &attribute_count,
+		               strides,
+		               FT_VERTEX_ATTRIBUTE_LOCATION_NORMAL,
+		               FT_FORMAT_R16G16_SNORM,
+		               attribute_binding );
+	}
+
+	if ( mesh->tangents )
+	{
+		add_attribute( attributes,
+		               &attribute_count,
+		               strides,
+		               FT_VERTEX_ATTRIBUTE_LOCATION_TANGENT,
+		               FT_FORMAT_R16G16_SNORM,
+		               attribute_binding );
+	}
+
+	if ( mesh->texcoords )
+	{
+		add_attribute( attributes,
+		               &attribute_count,
+		               strides,
+		               FT_VERTEX_ATTRIBUTE_LOCATION_TEXCOORD,
+		               FT_FORMAT_R16G16_UNORM,
+		               attribute_binding );
+	}
+
+	if ( mesh->joints )
+	{
+		add_attribute( attributes,
+		               &attribute_count,
+		               strides,
+		               FT_VERTEX_ATTRIBUTE_LOCATION_JOINTS,
+		               wide_joints ? FT_FORMAT_R16G16B16A16_UINT
+		                           : FT_FORMAT_R8G8B8A8_UINT,
+		               attribute_binding );
+	}
+
+	if ( mesh->weights )
+	{
+		add_attribute( attributes,
+		               &attribute_count,
+		               strides,
+		               FT_VERTEX_ATTRIBUTE_LOCATION_WEIGHTS,
+		               FT_FORMAT_R8G8B8A8_UNORM,
+		               attribute_binding );
+	}
+
+	streams->stream_count = ( split && attribute_count > 1 ) ? 2 : 1;
+
+	struct ft_vertex_layout* layout = &streams->layout;
+	memset( layout, 0, sizeof( struct ft_vertex_layout ) );
+
+	for ( uint32_t s = 0; s < streams->stream_count; ++s )
+	{
+		streams->strides[ s ] = strides[ s ];
+		streams->data[ s ]    = malloc( ( uint64_t ) strides[ s ] *
+                                     mesh->vertex_count );
+
+		layout->binding_infos[ s ].binding    = s;
+		layout->binding_infos[ s ].stride     = strides[ s ];
+		layout->binding_infos[ s ].input_rate = FT_VERTEX_INPUT_RATE_VERTEX;
+	}
+	layout->binding_info_count = streams->stream_count;
+
+	for ( uint32_t a = 0; a < attribute_count; ++a )
+	{
+		struct ft_vertex_attribute_info* info = &layout->attribute_infos[ a ];
+
+		info->location = attributes[ a ].location;
+		info->binding  = attributes[ a ].binding;
+		info->format   = attributes[ a ].format;
+		info->offset   = attributes[ a ].offset;
+	}
+	layout->attribute_info_count = attribute_count;
+
+	for ( uint32_t a = 0; a < attribute_count; ++a )
+	{
+		const struct attribute_desc* desc = &attributes[ a ];
+
+		uint32_t stride = strides[ desc->binding ];
+		uint8_t* dst    = streams->data[ desc->binding ] + desc->offset;
+
+		for ( uint32_t v = 0; v < mesh->vertex_count; ++v, dst += stride )
+		{
+			switch ( desc->location )
+			{
+			case FT_VERTEX_ATTRIBUTE_LOCATION_POSITION:
+			{
+				const float* p = &mesh->positions[ v * 3 ];
+				uint16_t     q[ 4 ];
+
+				for ( uint32_t i = 0; i < 3; ++i )
+				{
+					float x = ( p[ i ] - streams->position_offset[ i ] ) /
+					          streams->position_scale[ i ];
+					q[ i ] = snorm ? ( uint16_t ) float_to_snorm16( x )
+					               : float_to_half( x );
+				}
+				q[ 3 ] = snorm ? ( uint16_t ) 32767 : float_to_half( 1.0f );
+
+				memcpy( dst, q, sizeof( q ) );
+				break;
+			}
+			case FT_VERTEX_ATTRIBUTE_LOCATION_NORMAL:
+			{
+				float2 oct;
+				octahedral_encode( oct, &mesh->normals[ v * 3 ] );
+
+				int16_t q[ 2 ] = {
+				    float_to_snorm16( oct[ 0 ] ),
+				    float_to_snorm16( oct[ 1 ] ),
+				};
+
+				memcpy( dst, q, sizeof( q ) );
+				break;
+			}
+			case FT_VERTEX_ATTRIBUTE_LOCATION_TANGENT:
+			{
+				const float* t = &mesh->tangents[ v * 4 ];
+
+				float2 oct;
+				octahedral_encode( oct, t );
+
+				float y = oct[ 1 ] * 0.5f + 0.5f;
+				y = TANGENT_SIGN_EPSILON + y * ( 1.0f - TANGENT_SIGN_EPSILON );
+				y = t[ 3 ] < 0.0f ? -y : y;
+
+				int16_t q[ 2 ] = {
+				    float_to_snorm16( oct[ 0 ] ),
+				    float_to_snorm16( y ),
+				};
+
+				memcpy( dst, q, sizeof( q ) );
+				break;
+			}
+			case FT_VERTEX_ATTRIBUTE_LOCATION_TEXCOORD:
+			{
+				const float* uv = &mesh->texcoords[ v * 2 ];
+
+				uint16_t q[ 2 ];
+				for ( uint32_t i = 0; i < 2; ++i )
+				{
+					q[ i ] = float_to_unorm16(
+					    ( uv[ i ] - streams->texcoord_offset[ i ] ) /
+					    streams->texcoord_scale[ i ] );
+				}
+
+				memcpy( dst, q, sizeof( q ) );
+				break;
+			}
+			case FT_VERTEX_ATTRIBUTE_LOCATION_JOINTS:
+			{
+				const float* j = &mesh->joints[ v * 4 ];
+
+				if ( wide_joints )
+				{
+					uint16_t q[ 4 ];
+					for ( uint32_t i = 0; i < 4; ++i )
+					{
+						q[ i ] = ( uint16_t ) j[ i ];
+					}
+					memcpy( dst, q, sizeof( q ) );
+				}
+				else
+				{
+					for ( uint32_t i = 0; i < 4; ++i )
+					{
+						dst[ i ] = ( uint8_t ) j[ i ];
+					}
+				}
+				break;
+			}
+			case FT_VERTEX_ATTRIBUTE_LOCATION_WEIGHTS:
+			{
+				pack_weights( dst, &mesh->weights[ v * 4 ] );
+				break;
+			}
+			}
+		}
+	}
+
+	if ( flags & FT_MODEL_DISCARD_FLOAT_VERTICES )
+	{
+		ft_safe_free( mesh->positions );
+		ft_safe_free( mesh->normals );
+		ft_safe_free( mesh->tangents );
+		ft_safe_free( mesh->texcoords );
+		ft_safe_free( mesh->joints );
+		ft_safe_free( mesh->weights );
+
+		mesh->positions = NULL;
+		mesh->normals   = NULL;
+		mesh->tangents  = NULL;
+		mesh->texcoords = NULL;
+		mesh->joints    = NULL;
+		mesh->weights   = NULL;
+	}
+}
+
+void
+ft_free_packed_vertices( struct ft_vertex_streams* streams )
+{
+	for ( uint32_t s = 0; s < FT_MAX_VERTEX_STREAM_COUNT; ++s )
+	{
+		ft_safe_free( streams->data[ s ] );
+	}
+
+	memset( streams, 0, sizeof( struct ft_vertex_streams ) );
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "base/base.h"
+#include "model_loader.h"
+
+// packed attribute formats
+// position - half or snorm16 xyz1, dequantized with position offset and scale
+// normal   - octahedral snorm16 xy
+// tangent  - octahedral snorm16 xy, sign of y holds handedness and
+//            y = ( ( abs( y ) - e ) / ( 1 - e ) ) * 2 - 1, e = 1 / 32767
+// texcoord - unorm16 uv, dequantized with texcoord offset and scale
+// joints   - uint8 or uint16 when mesh references more than 256 joints
+// weights  - unorm8 normalized to sum of 255
+FT_API void
+ft_pack_mesh_vertices( struct ft_mesh* mesh, enum ft_model_flags flags );
+
+FT_API void
+ft_free_packed_vertices( struct ft_vertex_streams* streams );
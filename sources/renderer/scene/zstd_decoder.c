@@ -0,0 +1,1244 @@
+#include "zstd_decoder.h"
+
+#define ZSTD_MAGIC              0xFD2FB528u
+#define SKIPPABLE_MAGIC         0x184D2A50u
+#define SKIPPABLE_MAGIC_MASK    0xFFFFFFF0u
+#define MAX_BLOCK_SIZE          ( 128 * 1024 )
+#define MAX_FSE_LOG             9
+#define MAX_FSE_SYMBOLS         53
+#define MAX_HUFFMAN_BITS        11
+#define MAX_HUFFMAN_WEIGHTS     255
+#define HUFFMAN_WEIGHT_LOG      6
+#define LITERAL_LENGTH_CODES    36
+#define MATCH_LENGTH_CODES      53
+#define OFFSET_CODES            32
+#define PREDEFINED_OFFSET_CODES 29
+
+enum block_type
+{
+	BLOCK_TYPE_RAW,
+	BLOCK_TYPE_RLE,
+	BLOCK_TYPE_COMPRESSED,
+	BLOCK_TYPE_RESERVED,
+};
+
+enum literals_type
+{
+	LITERALS_TYPE_RAW,
+	LITERALS_TYPE_RLE,
+	LITERALS_TYPE_COMPRESSED,
+	LITERALS_TYPE_TREELESS,
+};
+
+enum table_mode
+{
+	TABLE_MODE_PREDEFINED,
+	TABLE_MODE_RLE,
+	TABLE_MODE_COMPRESSED,
+	TABLE_MODE_REPEAT,
+};
+
+// order of tables in block and of states in sequence bitstream
+enum sequence_field
+{
+	SEQUENCE_FIELD_LITERAL_LENGTH,
+	SEQUENCE_FIELD_OFFSET,
+	SEQUENCE_FIELD_MATCH_LENGTH,
+	SEQUENCE_FIELD_COUNT,
+};
+
+struct fse_table
+{
+	bool     ready;
+	uint32_t accuracy_log;
+	uint8_t  symbols[ 1 << MAX_FSE_LOG ];
+	uint8_t  bit_counts[ 1 << MAX_FSE_LOG ];
+	uint16_t bases[ 1 << MAX_FSE_LOG ];
+};
+
+struct huffman_table
+{
+	// zero until first compressed literals of frame
+	uint32_t max_bits;
+	uint8_t  symbols[ 1 << MAX_HUFFMAN_BITS ];
+	uint8_t  bit_counts[ 1 << MAX_HUFFMAN_BITS ];
+};
+
+struct sequence_code
+{
+	const int16_t* predefined_counts;
+	uint32_t       predefined_count;
+	uint32_t       predefined_log;
+	uint32_t       max_log;
+	uint32_t       max_symbols;
+};
+
+// tables and repeat offsets carry over between blocks of frame
+struct zstd_frame
+{
+	uint8_t*             dst;
+	uint64_t             dst_size;
+	uint64_t             written;
+	uint64_t             frame_start;
+	struct huffman_table huffman;
+	struct fse_table     tables[ SEQUENCE_FIELD_COUNT ];
+	uint64_t             repeat_offsets[ 3 ];
+	uint8_t              literals[ MAX_BLOCK_SIZE ];
+};
+
+// bitstream read from its end towards start, highest set bit of last byte
+// marks end of stream
+struct backward_bits
+{
+	const uint8_t* data;
+	uint64_t       size;
+	int64_t        position;
+};
+
+struct forward_bits
+{
+	const uint8_t* data;
+	uint64_t       size;
+	uint64_t       position;
+};
+
+static const uint32_t LITERAL_LENGTH_BASES[ LITERAL_LENGTH_CODES ] = {
+	0,   1,   2,    3,    4,    5,    6,    7,     8,     9,     10,    11,
+	12,  13,  14,   15,   16,   18,   20,   22,    24,    28,    32,    40,
+	48,  64,  128,  256,  512,  1024, 2048, 4096,  8192,  16384, 32768, 65536,
+};
+
+static const uint8_t LITERAL_LENGTH_BITS[ LITERAL_LENGTH_CODES ] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0,  1,  1,
+	1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+};
+
+static const uint32_t MATCH_LENGTH_BASES[ MATCH_LENGTH_CODES ] = {
+	3,    4,    5,    6,     7,     8,     9,     10,   11,   12,   13,
+	14,   15,   16,   17,    18,    19,    20,    21,   22,   23,   24,
+	25,   26,   27,   28,    29,    30,    31,    32,   33,   34,   35,
+	37,   39,   41,   43,    47,    51,    59,    67,   83,   99,   131,
+	259,  515,  1027, 2051,  4099,  8195,  16387, 32771, 65539,
+};
+
+static const uint8_t MATCH_LENGTH_BITS[ MATCH_LENGTH_CODES ] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  0,  1,  1,  1,  1,
+	2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+};
+
+// default distributions, -1 is probability below one
+static const int16_t PREDEFINED_LITERAL_LENGTHS[ LITERAL_LENGTH_CODES ] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1,  1,  2,  2,
+	2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1,
+};
+
+static const int16_t PREDEFINED_MATCH_LENGTHS[ MATCH_LENGTH_CODES ] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1,  1,  1,  1,  1,  1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,  1,  1,  1,  1,  1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static const int16_t PREDEFINED_OFFSETS[ PREDEFINED_OFFSET_CODES ] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1,  1,  1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1,
+};
+
+static const struct sequence_code SEQUENCE_CODES[ SEQUENCE_FIELD_COUNT ] = {
+	[SEQUENCE_FIELD_LITERAL_LENGTH] = {
+	    .predefined_counts = PREDEFINED_LITERAL_LENGTHS,
+	    .predefined_count  = LITERAL_LENGTH_CODES,
+	    .predefined_log    = 6,
+	    .max_log           = 9,
+	    .max_symbols       = LITERAL_LENGTH_CODES,
+	},
+	[SEQUENCE_FIELD_OFFSET] = {
+	    .predefined_counts = PREDEFINED_OFFSETS,
+	    .predefined_count  = PREDEFINED_OFFSET_CODES,
+	    .predefined_log    = 5,
+	    .max_log           = 8,
+	    .max_symbols       = OFFSET_CODES,
+	},
+	[SEQUENCE_FIELD_MATCH_LENGTH] = {
+	    .predefined_counts = PREDEFINED_MATCH_LENGTHS,
+	    .predefined_count  = MATCH_LENGTH_CODES,
+	    .predefined_log    = 6,
+	    .max_log           = 9,
+	    .max_symbols       = MATCH_LENGTH_CODES,
+	},
+};
+
+FT_INLINE uint64_t
+read_le( const uint8_t* data, uint32_t count )
+{
+	uint64_t v = 0;
+
+	for ( uint32_t i = 0; i < count; ++i )
+	{
+		v |= ( uint64_t ) data[ i ] << ( 8 * i );
+	}
+
+	return v;
+}
+
+FT_INLINE uint32_t
+highest_bit( uint32_t v )
+{
+	uint32_t r = 0;
+
+	while ( v >>= 1 )
+	{
+		++r;
+	}
+
+	return r;
+}
+
+// at most 32 bits starting at bit position of little endian stream, bits
+// outside of stream read as zeros
+FT_INLINE uint32_t
+peek_bits( const uint8_t* data,
+           uint64_t       size,
+           int64_t        position,
+           uint32_t       count )
+{
+	if ( count == 0 || position + ( int64_t ) count <= 0 )
+	{
+		return 0;
+	}
+
+	uint32_t shift = 0;
+
+	if ( position < 0 )
+	{
+		shift    = ( uint32_t ) -position;
+		count   -= shift;
+		position = 0;
+	}
+
+	uint64_t byte = ( uint64_t ) position >> 3;
+
+	if ( byte >= size )
+	{
+		return 0;
+	}
+
+	uint64_t v = read_le( data + byte, ( uint32_t ) FT_MIN( size - byte, 8 ) );
+	v = ( v >> ( position & 7 ) ) & ( ( 1ull << count ) - 1 );
+
+	return ( uint32_t ) ( v << shift );
+}
+
+static bool
+init_backward_bits( struct backward_bits* bits,
+                    const uint8_t*        data,
+                    uint64_t              size )
+{
+	if ( size == 0 || data[ size - 1 ] == 0 )
+	{
+		return false;
+	}
+
+	bits->data     = data;
+	bits->size     = size;
+	bits->position = ( int64_t ) ( size - 1 ) * 8 +
+	                 highest_bit( data[ size - 1 ] );
+
+	return true;
+}
+
+FT_INLINE uint32_t
+read_backward( struct backward_bits* bits, uint32_t count )
+{
+	bits->position -= count;
+	return peek_bits( bits->data, bits->size, bits->position, count );
+}
+
+FT_INLINE uint32_t
+read_forward( struct forward_bits* bits, uint32_t count )
+{
+	uint32_t v =
+	    peek_bits( bits->data, bits->size, ( int64_t ) bits->position, count );
+	bits->position += count;
+	return v;
+}
+
+// symbols are spread over states, symbols with probability below one take
+// last states
+static bool
+build_fse_table( struct fse_table* table,
+                 const int16_t*    counts,
+                 uint32_t          symbol_count,
+                 uint32_t          accuracy_log )
+{
+	uint32_t size = 1u << accuracy_log;
+	uint32_t high = size;
+	uint16_t next[ MAX_FSE_SYMBOLS ];
+
+	for ( uint32_t s = 0; s < symbol_count; ++s )
+	{
+		if ( counts[ s ] == -1 )
+		{
+			if ( high == 0 )
+			{
+				return false;
+			}
+
+			table->symbols[ --high ] = ( uint8_t ) s;
+			next[ s ]                = 1;
+		}
+		else
+		{
+			next[ s ] = ( uint16_t ) counts[ s ];
+		}
+	}
+
+	uint32_t step     = ( size >> 1 ) + ( size >> 3 ) + 3;
+	uint32_t mask     = size - 1;
+	uint32_t position = 0;
+
+	for ( uint32_t s = 0; s < symbol_count; ++s )
+	{
+		for ( int32_t i = 0; i < counts[ s ]; ++i )
+		{
+			table->symbols[ position ] = ( uint8_t ) s;
+
+			do
+			{
+				position = ( position + step ) & mask;
+			} while ( position >= high );
+		}
+	}
+
+	if ( position != 0 )
+	{
+		return false;
+	}
+
+	for ( uint32_t i = 0; i < size; ++i )
+	{
+		uint32_t state = next[ table->symbols[ i ] ]++;
+		uint32_t bits  = accuracy_log - highest_bit( state );
+
+		table->bit_counts[ i ] = ( uint8_t ) bits;
+		table->bases[ i ]      = ( uint16_t ) ( ( state << bits ) - size );
+	}
+
+	table->accuracy_log = accuracy_log;
+	table->ready        = true;
+
+	return true;
+}
+
+static void
+init_rle_table( struct fse_table* table, uint8_t symbol )
+{
+	table->accuracy_log    = 0;
+	table->symbols[ 0 ]    = symbol;
+	table->bit_counts[ 0 ] = 0;
+	table->bases[ 0 ]      = 0;
+	table->ready           = true;
+}
+
+// probabilities are stored with variable bit count bounded by remaining
+// probability, zero probabilities are followed by repeat flags
+static bool
+read_fse_table( struct fse_table* table,
+                const uint8_t*    src,
+                uint64_t          size,
+                uint32_t          max_log,
+                uint32_t          max_symbols,
+                uint64_t*         consumed )
+{
+	struct forward_bits bits = { .data = src, .size = size };
+
+	uint32_t accuracy_log = read_forward( &bits, 4 ) + 5;
+
+	if ( accuracy_log > max_log )
+	{
+		return false;
+	}
+
+	int16_t  counts[ MAX_FSE_SYMBOLS ];
+	int32_t  remaining    = 1 << accuracy_log;
+	uint32_t symbol_count = 0;
+
+	while ( remaining > 0 && symbol_count < max_symbols )
+	{
+		uint32_t count_bits = highest_bit( ( uint32_t ) remaining + 1 ) + 1;
+		uint32_t value      = read_forward( &bits, count_bits );
+		uint32_t low_mask   = ( 1u << ( count_bits - 1 ) ) - 1;
+		uint32_t threshold =
+		    ( 1u << count_bits ) - 1 - ( ( uint32_t ) remaining + 1 );
+
+		if ( ( value & low_mask ) < threshold )
+		{
+			bits.position--;
+			value &= low_mask;
+		}
+		else if ( value > low_mask )
+		{
+			value -= threshold;
+		}
+
+		int32_t count = ( int32_t ) value - 1;
+		remaining -= count < 0 ? -count : count;
+		counts[ symbol_count++ ] = ( int16_t ) count;
+
+		if ( count == 0 )
+		{
+			uint32_t repeat;
+
+			do
+			{
+				repeat = read_forward( &bits, 2 );
+
+				for ( uint32_t i = 0; i < repeat && symbol_count < max_symbols;
+				      ++i )
+				{
+					counts[ symbol_count++ ] = 0;
+				}
+			} while ( repeat == 3 );
+		}
+	}
+
+	*consumed = ( bits.position + 7 ) / 8;
+
+	if ( remaining != 0 || *consumed > size )
+	{
+		return false;
+	}
+
+	return build_fse_table( table, counts, symbol_count, accuracy_log );
+}
+
+// weights are fse compressed with two interleaved states, stream ends when
+// state update reads past its start
+static bool
+read_fse_weights( const uint8_t* src,
+                  uint64_t       size,
+                  uint8_t*       weights,
+                  uint32_t*      weight_count )
+{
+	struct fse_table table;
+	uint64_t         table_size;
+
+	if ( !read_fse_table( &table,
+	                      src,
+	                      size,
+	                      HUFFMAN_WEIGHT_LOG,
+	                      MAX_HUFFMAN_BITS + 1,
+	                      &table_size ) )
+	{
+		return false;
+	}
+
+	struct backward_bits bits;
+
+	if ( !init_backward_bits( &bits, src + table_size, size - table_size ) )
+	{
+		return false;
+	}
+
+	uint32_t states[ 2 ];
+	states[ 0 ] = read_backward( &bits, table.accuracy_log );
+	states[ 1 ] = read_backward( &bits, table.accuracy_log );
+
+	uint32_t count = 0;
+
+	for ( uint32_t s = 0;; s ^= 1 )
+	{
+		// last weight is implied, so one more than stored ones fits
+		if ( count + 2 > MAX_HUFFMAN_WEIGHTS + 1 )
+		{
+			return false;
+		}
+
+		uint32_t state     = states[ s ];
+		weights[ count++ ] = table.symbols[ state ];
+		states[ s ]        = table.bases[ state ] +
+		              read_backward( &bits, table.bit_counts[ state ] );
+
+		if ( bits.position < 0 )
+		{
+			weights[ count++ ] = table.symbols[ states[ s ^ 1 ] ];
+			break;
+		}
+	}
+
+	*weight_count = count;
+
+	return count <= MAX_HUFFMAN_WEIGHTS;
+}
+
+// weight of last symbol is implied by weights summing to power of two, codes
+// of equal weight take consecutive ranges ordered by symbol
+static bool
+read_huffman_table( struct huffman_table* table,
+                    const uint8_t*        src,
+                    uint64_t              size,
+                    uint64_t*             consumed )
+{
+	if ( size == 0 )
+	{
+		return false;
+	}
+
+	uint8_t  weights[ MAX_HUFFMAN_WEIGHTS + 1 ];
+	uint32_t weight_count = 0;
+	uint32_t header       = src[ 0 ];
+
+	if ( header >= 128 )
+	{
+		weight_count   = header - 127;
+		uint64_t bytes = ( weight_count + 1 ) / 2;
+
+		if ( 1 + bytes > size )
+		{
+			return false;
+		}
+
+		for ( uint32_t i = 0; i < weight_count; ++i )
+		{
+			uint8_t byte  = src[ 1 + i / 2 ];
+			weights[ i ] = i % 2 ? byte & 15 : byte >> 4;
+		}
+
+		*consumed = 1 + bytes;
+	}
+	else
+	{
+		if ( header == 0 || 1 + ( uint64_t ) header > size ||
+		     !read_fse_weights( src + 1, header, weights, &weight_count ) )
+		{
+			return false;
+		}
+
+		*consumed = 1 + header;
+	}
+
+	uint32_t total = 0;
+
+	for ( uint32_t i = 0; i < weight_count; ++i )
+	{
+		if ( weights[ i ] > MAX_HUFFMAN_BITS )
+		{
+			return false;
+		}
+
+		total += weights[ i ] ? 1u << ( weights[ i ] - 1 ) : 0;
+	}
+
+	if ( total == 0 )
+	{
+		return false;
+	}
+
+	uint32_t max_bits = highest_bit( total ) + 1;
+	uint32_t left     = ( 1u << max_bits ) - total;
+
+	if ( max_bits > MAX_HUFFMAN_BITS || ( left & ( left - 1 ) ) != 0 )
+	{
+		return false;
+	}
+
+	weights[ weight_count++ ] = ( uint8_t ) ( highest_bit( left ) + 1 );
+
+	uint32_t starts[ MAX_HUFFMAN_BITS + 1 ] = { 0 };
+
+	for ( uint32_t i = 0; i < weight_count; ++i )
+	{
+		if ( weights[ i ] )
+		{
+			starts[ weights[ i ] ] += 1u << ( weights[ i ] - 1 );
+		}
+	}
+
+	for ( uint32_t w = 1, start = 0; w <= max_bits; ++w )
+	{
+		uint32_t count = starts[ w ];
+		starts[ w ]    = start;
+		start += count;
+	}
+
+	for ( uint32_t i = 0; i < weight_count; ++i )
+	{
+		uint32_t w = weights[ i ];
+
+		if ( w == 0 )
+		{
+			continue;
+		}
+
+		uint32_t length = 1u << ( w - 1 );
+		memset( table->symbols + starts[ w ], ( int ) i, length );
+		memset( table->bit_counts + starts[ w ],
+		        ( int ) ( max_bits + 1 - w ),
+		        length );
+		starts[ w ] += length;
+	}
+
+	table->max_bits = max_bits;
+
+	return true;
+}
+
+// stream must be consumed exactly by count symbols
+static bool
+decode_huffman_stream( const struct huffman_table* table,
+                       const uint8_t*              src,
+                       uint64_t                    size,
+                       uint8_t*                    dst,
+                       uint64_t                    count )
+{
+	struct backward_bits bits;
+
+	if ( !init_backward_bits( &bits, src, size ) )
+	{
+		return false;
+	}
+
+	uint32_t max_bits = table->max_bits;
+
+	for ( uint64_t i = 0; i < count; ++i )
+	{
+		uint32_t v =
+		    peek_bits( src, size, bits.position - max_bits, max_bits );
+		dst[ i ] = table->symbols[ v ];
+		bits.position -= table->bit_counts[ v ];
+	}
+
+	return bits.position == 0;
+}
+
+static bool
+decode_literals( struct zstd_frame* frame,
+                 const uint8_t*     src,
+                 uint64_t           size,
+                 uint64_t*          literal_count,
+                 uint64_t*          consumed )
+{
+	if ( size == 0 )
+	{
+		return false;
+	}
+
+	uint32_t type        = src[ 0 ] & 3;
+	uint32_t size_format = ( src[ 0 ] >> 2 ) & 3;
+
+	if ( type == LITERALS_TYPE_RAW || type == LITERALS_TYPE_RLE )
+	{
+		// size takes 5, 12 or 20 bits after type
+		uint32_t header_size = size_format == 1 ? 2 : size_format == 3 ? 3 : 1;
+
+		if ( header_size >= size )
+		{
+			return false;
+		}
+
+		uint64_t count = header_size == 1
+		                     ? src[ 0 ] >> 3
+		                     : read_le( src, header_size ) >> 4;
+
+		if ( count > MAX_BLOCK_SIZE )
+		{
+			return false;
+		}
+
+		if ( type == LITERALS_TYPE_RAW )
+		{
+			if ( header_size + count > size )
+			{
+				return false;
+			}
+
+			memcpy( frame->literals, src + header_size, count );
+			*consumed = header_size + count;
+		}
+		else
+		{
+			memset( frame->literals, src[ header_size ], count );
+			*consumed = header_size + 1;
+		}
+
+		*literal_count = count;
+
+		return true;
+	}
+
+	// regenerated and compressed sizes take 10, 14 or 18 bits each
+	uint32_t header_size = size_format < 2 ? 3 : size_format + 2;
+	uint32_t size_bits   = size_format < 2 ? 10 : size_format * 4 + 6;
+
+	if ( header_size > size )
+	{
+		return false;
+	}
+
+	uint64_t header          = read_le( src, header_size );
+	uint64_t count           = ( header >> 4 ) & ( ( 1u << size_bits ) - 1 );
+	uint64_t compressed_size = header >> ( 4 + size_bits );
+
+	if ( count > MAX_BLOCK_SIZE || header_size + compressed_size > size )
+	{
+		return false;
+	}
+
+	const uint8_t* data      = src + header_size;
+	uint64_t       remaining = compressed_size;
+
+	// treeless literals reuse table of previous block
+	if ( type == LITERALS_TYPE_COMPRESSED )
+	{
+		uint64_t table_size;
+
+		if ( !read_huffman_table( &frame->huffman,
+		                          data,
+		                          remaining,
+		                          &table_size ) )
+		{
+			return false;
+		}
+
+		data += table_size;
+		remaining -= table_size;
+	}
+	else if ( frame->huffman.max_bits == 0 )
+	{
+		return false;
+	}
+
+	if ( size_format == 0 )
+	{
+		if ( !decode_huffman_stream( &frame->huffman,
+		                             data,
+		                             remaining,
+		                             frame->literals,
+		                             count ) )
+		{
+			return false;
+		}
+	}
+	else
+	{
+		// four streams with jump table of first three sizes, first three
+		// streams hold rounded up quarter of literals
+		uint64_t stream_count = ( count + 3 ) / 4;
+
+		if ( remaining < 6 || count < 3 * stream_count )
+		{
+			return false;
+		}
+
+		uint64_t sizes[ 4 ] = {
+			read_le( data, 2 ),
+			read_le( data + 2, 2 ),
+			read_le( data + 4, 2 ),
+		};
+		uint64_t jumps = sizes[ 0 ] + sizes[ 1 ] + sizes[ 2 ];
+
+		if ( 6 + jumps > remaining )
+		{
+			return false;
+		}
+
+		sizes[ 3 ] = remaining - 6 - jumps;
+
+		const uint8_t* stream = data + 6;
+		uint8_t*       out    = frame->literals;
+
+		for ( uint32_t s = 0; s < 4; ++s )
+		{
+			uint64_t n = s < 3 ? stream_count : count - 3 * stream_count;
+
+			if ( !decode_huffman_stream( &frame->huffman,
+			                             stream,
+			                             sizes[ s ],
+			                             out,
+			                             n ) )
+			{
+				return false;
+			}
+
+			stream += sizes[ s ];
+			out += n;
+		}
+	}
+
+	*literal_count = count;
+	*consumed      = header_size + compressed_size;
+
+	return true;
+}
+
+static bool
+read_sequence_table( struct fse_table*           table,
+                     const struct sequence_code* code,
+                     enum table_mode             mode,
+                     const uint8_t*              src,
+                     uint64_t                    size,
+                     uint64_t*                   consumed )
+{
+	*consumed = 0;
+
+	switch ( mode )
+	{
+	case TABLE_MODE_PREDEFINED:
+	{
+		return build_fse_table( table,
+		                        code->predefined_counts,
+		                        code->predefined_count,
+		                        code->predefined_log );
+	}
+	case TABLE_MODE_RLE:
+	{
+		if ( size == 0 || src[ 0 ] >= code->max_symbols )
+		{
+			return false;
+		}
+
+		init_rle_table( table, src[ 0 ] );
+		*consumed = 1;
+		return true;
+	}
+	case TABLE_MODE_COMPRESSED:
+	{
+		return read_fse_table( table,
+		                       src,
+		                       size,
+		                       code->max_log,
+		                       code->max_symbols,
+		                       consumed );
+	}
+	default: return table->ready;
+	}
+}
+
+// offset values up to three pick repeat offsets, one further when literal
+// length is zero
+static uint64_t
+resolve_offset( uint64_t* repeat_offsets,
+                uint64_t  offset_value,
+                uint64_t  literal_length )
+{
+	if ( offset_value > 3 )
+	{
+		repeat_offsets[ 2 ] = repeat_offsets[ 1 ];
+		repeat_offsets[ 1 ] = repeat_offsets[ 0 ];
+		repeat_offsets[ 0 ] = offset_value - 3;
+		return repeat_offsets[ 0 ];
+	}
+
+	uint32_t index = ( uint32_t ) offset_value - 1 + ( literal_length == 0 );
+
+	if ( index == 0 )
+	{
+		return repeat_offsets[ 0 ];
+	}
+
+	uint64_t offset =
+	    index < 3 ? repeat_offsets[ index ] : repeat_offsets[ 0 ] - 1;
+
+	if ( index > 1 )
+	{
+		repeat_offsets[ 2 ] = repeat_offsets[ 1 ];
+	}
+
+	repeat_offsets[ 1 ] = repeat_offsets[ 0 ];
+	repeat_offsets[ 0 ] = offset;
+
+	return offset;
+}
+
+// copies literals and matches of every sequence into output, literals left
+// after last sequence follow
+static bool
+decode_sequences( struct zstd_frame* frame,
+                  const uint8_t*     src,
+                  uint64_t           size,
+                  uint64_t           literal_count )
+{
+	if ( size == 0 )
+	{
+		return false;
+	}
+
+	uint64_t sequence_count = src[ 0 ];
+	uint64_t header_size    = 1;
+
+	if ( sequence_count == 255 )
+	{
+		if ( size < 3 )
+		{
+			return false;
+		}
+
+		sequence_count = read_le( src + 1, 2 ) + 0x7F00;
+		header_size    = 3;
+	}
+	else if ( sequence_count >= 128 )
+	{
+		if ( size < 2 )
+		{
+			return false;
+		}
+
+		sequence_count = ( ( sequence_count - 128 ) << 8 ) + src[ 1 ];
+		header_size    = 2;
+	}
+
+	const uint8_t* literals = frame->literals;
+	uint8_t*       dst      = frame->dst;
+
+	if ( sequence_count > 0 )
+	{
+		if ( header_size >= size || ( src[ header_size ] & 3 ) != 0 )
+		{
+			return false;
+		}
+
+		uint32_t modes = src[ header_size++ ];
+
+		for ( uint32_t f = 0; f < SEQUENCE_FIELD_COUNT; ++f )
+		{
+			uint64_t table_size;
+
+			if ( !read_sequence_table( &frame->tables[ f ],
+			                           &SEQUENCE_CODES[ f ],
+			                           ( modes >> ( 6 - 2 * f ) ) & 3,
+			                           src + header_size,
+			                           size - header_size,
+			                           &table_size ) )
+			{
+				return false;
+			}
+
+			header_size += table_size;
+		}
+
+		struct backward_bits bits;
+
+		if ( header_size > size ||
+		     !init_backward_bits( &bits,
+		                          src + header_size,
+		                          size - header_size ) )
+		{
+			return false;
+		}
+
+		const struct fse_table* tables = frame->tables;
+		uint32_t                states[ SEQUENCE_FIELD_COUNT ];
+
+		for ( uint32_t f = 0; f < SEQUENCE_FIELD_COUNT; ++f )
+		{
+			states[ f ] = read_backward( &bits, tables[ f ].accuracy_log );
+		}
+
+		for ( uint64_t i = 0; i < sequence_count; ++i )
+		{
+			uint32_t literal_code =
+			    tables[ SEQUENCE_FIELD_LITERAL_LENGTH ]
+			        .symbols[ states[ SEQUENCE_FIELD_LITERAL_LENGTH ] ];
+			uint32_t offset_code =
+			    tables[ SEQUENCE_FIELD_OFFSET ]
+			        .symbols[ states[ SEQUENCE_FIELD_OFFSET ] ];
+			uint32_t match_code =
+			    tables[ SEQUENCE_FIELD_MATCH_LENGTH ]
+			        .symbols[ states[ SEQUENCE_FIELD_MATCH_LENGTH ] ];
+
+			// extra bits are read offset first, states are updated in
+			// table order except after last sequence
+			uint64_t offset_value =
+			    ( 1ull << offset_code ) + read_backward( &bits, offset_code );
+			uint64_t match_length =
+			    MATCH_LENGTH_BASES[ match_code ] +
+			    read_backward( &bits, MATCH_LENGTH_BITS[ match_code ] );
+			uint64_t literal_length =
+			    LITERAL_LENGTH_BASES[ literal_code ] +
+			    read_backward( &bits, LITERAL_LENGTH_BITS[ literal_code ] );
+
+			if ( i + 1 < sequence_count )
+			{
+				uint32_t order[ SEQUENCE_FIELD_COUNT ] = {
+					SEQUENCE_FIELD_LITERAL_LENGTH,
+					SEQUENCE_FIELD_MATCH_LENGTH,
+					SEQUENCE_FIELD_OFFSET,
+				};
+
+				for ( uint32_t k = 0; k < SEQUENCE_FIELD_COUNT; ++k )
+				{
+					const struct fse_table* table = &tables[ order[ k ] ];
+					uint32_t                state = states[ order[ k ] ];
+
+					states[ order[ k ] ] =
+					    table->bases[ state ] +
+					    read_backward( &bits, table->bit_counts[ state ] );
+				}
+			}
+
+			uint64_t literals_left =
+			    literal_count - ( uint64_t ) ( literals - frame->literals );
+
+			if ( literal_length > literals_left ||
+			     literal_length + match_length >
+			         frame->dst_size - frame->written )
+			{
+				return false;
+			}
+
+			memcpy( dst + frame->written, literals, literal_length );
+			literals += literal_length;
+			frame->written += literal_length;
+
+			uint64_t offset = resolve_offset( frame->repeat_offsets,
+			                                  offset_value,
+			                                  literal_length );
+
+			if ( offset == 0 || offset > frame->written - frame->frame_start )
+			{
+				return false;
+			}
+
+			// match may overlap bytes it produces
+			uint8_t*       out   = dst + frame->written;
+			const uint8_t* match = out - offset;
+
+			if ( offset >= match_length )
+			{
+				memcpy( out, match, match_length );
+			}
+			else
+			{
+				for ( uint64_t k = 0; k < match_length; ++k )
+				{
+					out[ k ] = match[ k ];
+				}
+			}
+
+			frame->written += match_length;
+		}
+
+		if ( bits.position != 0 )
+		{
+			return false;
+		}
+	}
+	else if ( header_size != size )
+	{
+		return false;
+	}
+
+	uint64_t tail = literal_count - ( uint64_t ) ( literals - frame->literals );
+
+	if ( tail > frame->dst_size - frame->written )
+	{
+		return false;
+	}
+
+	memcpy( dst + frame->written, literals, tail );
+	frame->written += tail;
+
+	return true;
+}
+
+static bool
+decode_compressed_block( struct zstd_frame* frame,
+                         const uint8_t*     src,
+                         uint64_t           size )
+{
+	uint64_t literal_count;
+	uint64_t literals_size;
+
+	if ( !decode_literals( frame, src, size, &literal_count, &literals_size ) )
+	{
+		return false;
+	}
+
+	return decode_sequences( frame,
+	                         src + literals_size,
+	                         size - literals_size,
+	                         literal_count );
+}
+
+// whole output is window, so window size of header is not needed
+static bool
+decode_frame( struct zstd_frame* frame,
+              const uint8_t*     src,
+              uint64_t           size,
+              uint64_t*          consumed )
+{
+	static const uint32_t DICTIONARY_ID_SIZES[ 4 ] = { 0, 1, 2, 4 };
+	static const uint32_t CONTENT_SIZE_SIZES[ 4 ]  = { 0, 2, 4, 8 };
+
+	if ( size < 5 )
+	{
+		return false;
+	}
+
+	uint32_t descriptor        = src[ 4 ];
+	bool     single_segment    = ( descriptor >> 5 ) & 1;
+	bool     has_checksum      = ( descriptor >> 2 ) & 1;
+	uint32_t dictionary_size   = DICTIONARY_ID_SIZES[ descriptor & 3 ];
+	uint32_t content_size_size = CONTENT_SIZE_SIZES[ descriptor >> 6 ];
+
+	// single segment frames always store content size
+	if ( single_segment && content_size_size == 0 )
+	{
+		content_size_size = 1;
+	}
+
+	uint64_t position = 5 + !single_segment;
+
+	if ( ( descriptor & 8 ) != 0 ||
+	     position + dictionary_size + content_size_size > size )
+	{
+		return false;
+	}
+
+	if ( read_le( src + position, dictionary_size ) != 0 )
+	{
+		FT_WARN( "zstd dictionaries are not supported" );
+		return false;
+	}
+
+	position += dictionary_size;
+
+	uint64_t content_size = read_le( src + position, content_size_size );
+	content_size += content_size_size == 2 ? 256 : 0;
+	position += content_size_size;
+
+	frame->frame_start         = frame->written;
+	frame->huffman.max_bits    = 0;
+	frame->repeat_offsets[ 0 ] = 1;
+	frame->repeat_offsets[ 1 ] = 4;
+	frame->repeat_offsets[ 2 ] = 8;
+
+	for ( uint32_t f = 0; f < SEQUENCE_FIELD_COUNT; ++f )
+	{
+		frame->tables[ f ].ready = false;
+	}
+
+	bool last = false;
+
+	while ( !last )
+	{
+		if ( position + 3 > size )
+		{
+			return false;
+		}
+
+		uint32_t block_header = ( uint32_t ) read_le( src + position, 3 );
+		uint32_t block_size   = block_header >> 3;
+		last                  = block_header & 1;
+		position += 3;
+
+		uint64_t left = frame->dst_size - frame->written;
+
+		switch ( ( block_header >> 1 ) & 3 )
+		{
+		case BLOCK_TYPE_RAW:
+		{
+			if ( block_size > size - position || block_size > left )
+			{
+				return false;
+			}
+
+			memcpy( frame->dst + frame->written, src + position, block_size );
+			frame->written += block_size;
+			position += block_size;
+			break;
+		}
+		case BLOCK_TYPE_RLE:
+		{
+			if ( position >= size || block_size > left )
+			{
+				return false;
+			}
+
+			memset( frame->dst + frame->written, src[ position ], block_size );
+			frame->written += block_size;
+			position += 1;
+			break;
+		}
+		case BLOCK_TYPE_COMPRESSED:
+		{
+			if ( block_size > MAX_BLOCK_SIZE ||
+			     block_size > size - position ||
+			     !decode_compressed_block( frame,
+			                               src + position,
+			                               block_size ) )
+			{
+				return false;
+			}
+
+			position += block_size;
+			break;
+		}
+		default: return false;
+		}
+	}
+
+	// checksum is skipped, stream is validated by exact sizes instead
+	position += has_checksum ? 4 : 0;
+
+	if ( position > size || ( content_size_size != 0 &&
+	                          frame->written - frame->frame_start !=
+	                              content_size ) )
+	{
+		return false;
+	}
+
+	*consumed = position;
+
+	return true;
+}
+
+bool
+ft_decode_zstd( void*          dst,
+                uint64_t       dst_size,
+                const uint8_t* src,
+                uint64_t       size )
+{
+	FT_ASSERT( dst || dst_size == 0 );
+
+	struct zstd_frame* frame = calloc( 1, sizeof( struct zstd_frame ) );
+	frame->dst               = dst;
+	frame->dst_size          = dst_size;
+
+	bool     valid    = true;
+	uint64_t position = 0;
+
+	while ( valid && position < size )
+	{
+		if ( size - position < 4 )
+		{
+			valid = false;
+			break;
+		}
+
+		uint32_t magic = ( uint32_t ) read_le( src + position, 4 );
+
+		if ( ( magic & SKIPPABLE_MAGIC_MASK ) == SKIPPABLE_MAGIC )
+		{
+			valid = size - position >= 8 &&
+			        read_le( src + position + 4, 4 ) <= size - position - 8;
+			position += valid ? 8 + read_le( src + position + 4, 4 ) : 0;
+		}
+		else
+		{
+			uint64_t consumed = 0;
+			valid             = magic == ZSTD_MAGIC &&
+			        decode_frame( frame,
+			                      src + position,
+			                      size - position,
+			                      &consumed );
+			position += consumed;
+		}
+	}
+
+	valid = valid && frame->written == dst_size;
+
+	free( frame );
+
+	return valid;
+}
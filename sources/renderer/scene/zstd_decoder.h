@@ -0,0 +1,13 @@
+#pragma once
+
+#include "base/base.h"
+
+// decodes zstd frames of src into dst, concatenated and skippable frames
+// are allowed. output must fill exactly dst_size bytes. dictionaries are not
+// supported and content checksums are not verified. returns false on
+// malformed or unsupported stream
+FT_API bool
+ft_decode_zstd( void*          dst,
+                uint64_t       dst_size,
+                const uint8_t* src,
+                uint64_t       size );
@@ -13,6 +13,11 @@ struct ft_mutex
 	void* handle;
 };
 
+struct ft_condition_variable
+{
+	void* handle;
+};
+
 typedef uint32_t ( *ft_thread_fun )( void* );
 
 FT_API void
@@ -30,8 +35,31 @@ ft_mutex_create( struct ft_mutex* mtx );
 FT_API void
 ft_mutex_destroy( struct ft_mutex* mtx );
 
+FT_API void
+ft_mutex_lock( struct ft_mutex* mtx );
+
 FT_API bool
 ft_mutex_try_lock( struct ft_mutex* mtx );
 
 FT_API void
 ft_mutex_unlock( struct ft_mutex* mtx );
+
+FT_API void
+ft_condition_variable_create( struct ft_condition_variable* cv );
+
+FT_API void
+ft_condition_variable_destroy( struct ft_condition_variable* cv );
+
+// mutex must be locked, it is released while waiting and locked on return
+FT_API void
+ft_condition_variable_wait( struct ft_condition_variable* cv,
+                            struct ft_mutex*              mtx );
+
+FT_API void
+ft_condition_variable_notify_one( struct ft_condition_variable* cv );
+
+FT_API void
+ft_condition_variable_notify_all( struct ft_condition_variable* cv );
+
+FT_API uint32_t
+ft_get_cpu_count( void );
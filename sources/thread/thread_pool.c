@@ -0,0 +1,201 @@
+#include "thread_pool.h"
+
+struct ft_task
+{
+	ft_task_fun           fun;
+	void*                 arg;
+	struct ft_task_group* group;
+	struct ft_task*       next;
+};
+
+// runs head task with pool mutex held around it, not while it runs
+static void
+run_head_task( struct ft_thread_pool* pool )
+{
+	struct ft_task* task = pool->head;
+	pool->head           = task->next;
+
+	if ( pool->head == NULL )
+	{
+		pool->tail = NULL;
+	}
+
+	ft_mutex_unlock( &pool->mutex );
+
+	task->fun( task->arg );
+
+	ft_mutex_lock( &pool->mutex );
+
+	bool finished = --pool->pending_count == 0;
+
+	if ( task->group && --task->group->pending_count == 0 )
+	{
+		finished = true;
+	}
+
+	if ( finished )
+	{
+		ft_condition_variable_notify_all( &pool->task_finished );
+	}
+
+	free( task );
+}
+
+static uint32_t
+worker_fun( void* arg )
+{
+	struct ft_thread_pool* pool = arg;
+
+	ft_mutex_lock( &pool->mutex );
+
+	for ( ;; )
+	{
+		while ( pool->head == NULL && !pool->stop )
+		{
+			ft_condition_variable_wait( &pool->task_added, &pool->mutex );
+		}
+
+		if ( pool->head == NULL )
+		{
+			break;
+		}
+
+		run_head_task( pool );
+	}
+
+	ft_mutex_unlock( &pool->mutex );
+
+	return 0;
+}
+
+void
+ft_thread_pool_create( struct ft_thread_pool* pool, uint32_t thread_count )
+{
+	FT_ASSERT( pool );
+
+	memset( pool, 0, sizeof( struct ft_thread_pool ) );
+
+	if ( thread_count == 0 )
+	{
+		thread_count = FT_MAX( ft_get_cpu_count(), 2 ) - 1;
+	}
+
+	ft_mutex_create( &pool->mutex );
+	ft_condition_variable_create( &pool->task_added );
+	ft_condition_variable_create( &pool->task_finished );
+
+	pool->thread_count = thread_count;
+	pool->threads      = calloc( thread_count, sizeof( struct ft_thread ) );
+
+	for ( uint32_t i = 0; i < thread_count; ++i )
+	{
+		ft_thread_create( &pool->threads[ i ], worker_fun, pool );
+	}
+}
+
+void
+ft_thread_pool_destroy( struct ft_thread_pool* pool )
+{
+	FT_ASSERT( pool );
+
+	ft_mutex_lock( &pool->mutex );
+	pool->stop = true;
+	ft_condition_variable_notify_all( &pool->task_added );
+	ft_mutex_unlock( &pool->mutex );
+
+	for ( uint32_t i = 0; i < pool->thread_count; ++i )
+	{
+		ft_thread_join( &pool->threads[ i ] );
+		ft_thread_destroy( &pool->threads[ i ] );
+	}
+
+	free( pool->threads );
+	ft_condition_variable_destroy( &pool->task_finished );
+	ft_condition_variable_destroy( &pool->task_added );
+	ft_mutex_destroy( &pool->mutex );
+}
+
+void
+ft_thread_pool_push( struct ft_thread_pool* pool, ft_task_fun fun, void* arg )
+{
+	ft_thread_pool_push_group( pool, NULL, fun, arg );
+}
+
+void
+ft_thread_pool_push_group( struct ft_thread_pool* pool,
+                           struct ft_task_group*  group,
+                           ft_task_fun            fun,
+                           void*                  arg )
+{
+	FT_ASSERT( pool );
+	FT_ASSERT( fun );
+
+	struct ft_task* task = malloc( sizeof( struct ft_task ) );
+	task->fun            = fun;
+	task->arg            = arg;
+	task->group          = group;
+	task->next           = NULL;
+
+	ft_mutex_lock( &pool->mutex );
+
+	if ( group )
+	{
+		group->pending_count++;
+	}
+
+	if ( pool->tail )
+	{
+		pool->tail->next = task;
+	}
+	else
+	{
+		pool->head = task;
+	}
+
+	pool->tail = task;
+	pool->pending_count++;
+
+	ft_condition_variable_notify_one( &pool->task_added );
+	ft_mutex_unlock( &pool->mutex );
+}
+
+void
+ft_thread_pool_wait( struct ft_thread_pool* pool )
+{
+	FT_ASSERT( pool );
+
+	ft_mutex_lock( &pool->mutex );
+
+	while ( pool->pending_count > 0 )
+	{
+		ft_condition_variable_wait( &pool->task_finished, &pool->mutex );
+	}
+
+	ft_mutex_unlock( &pool->mutex );
+}
+
+void
+ft_thread_pool_wait_group( struct ft_thread_pool* pool,
+                           struct ft_task_group*  group )
+{
+	FT_ASSERT( pool );
+	FT_ASSERT( group );
+
+	ft_mutex_lock( &pool->mutex );
+
+	while ( group->pending_count > 0 )
+	{
+		// helping with queued tasks keeps pool from stalling when every
+		// worker waits for tasks queued behind it
+		if ( pool->head )
+		{
+			run_head_task( pool );
+		}
+		else
+		{
+			ft_condition_variable_wait( &pool->task_finished, &pool->mutex );
+		}
+	}
+
+	ft_mutex_unlock( &pool->mutex );
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "base/base.h"
+#include "thread.h"
+
+typedef void ( *ft_task_fun )( void* );
+
+struct ft_task;
+
+// tasks pushed with group can be waited for apart from rest of pool
+struct ft_task_group
+{
+	// queued and running tasks of group
+	uint32_t pending_count;
+};
+
+struct ft_thread_pool
+{
+	uint32_t                     thread_count;
+	struct ft_thread*            threads;
+	struct ft_mutex              mutex;
+	struct ft_condition_variable task_added;
+	struct ft_condition_variable task_finished;
+	struct ft_task*              head;
+	struct ft_task*              tail;
+	// queued and running tasks
+	uint32_t                     pending_count;
+	bool                         stop;
+};
+
+// zero thread count uses one thread per cpu except calling one
+FT_API void
+ft_thread_pool_create( struct ft_thread_pool* pool, uint32_t thread_count );
+
+// finishes queued tasks and joins threads
+FT_API void
+ft_thread_pool_destroy( struct ft_thread_pool* pool );
+
+FT_API void
+ft_thread_pool_push( struct ft_thread_pool* pool, ft_task_fun fun, void* arg );
+
+// group must stay alive until it is waited for
+FT_API void
+ft_thread_pool_push_group( struct ft_thread_pool* pool,
+                           struct ft_task_group*  group,
+                           ft_task_fun            fun,
+                           void*                  arg );
+
+// blocks until every pushed task has finished
+FT_API void
+ft_thread_pool_wait( struct ft_thread_pool* pool );
+
+// runs queued tasks on calling thread until every task of group has
+// finished, so tasks running on pool may wait for tasks they push
+FT_API void
+ft_thread_pool_wait_group( struct ft_thread_pool* pool,
+                           struct ft_task_group*  group );
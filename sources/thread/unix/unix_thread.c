@@ -1,6 +1,7 @@
 #include "thread/thread.h"
 #if FT_PLATFORM_UNIX
 #include <pthread.h>
+#include <unistd.h>
 
 FT_API void
 ft_thread_create( struct ft_thread* thread, ft_thread_fun fun, void* arg )
@@ -45,6 +46,15 @@ ft_mutex_destroy( struct ft_mutex* mtx )
 	free( mtx->handle );
 }
 
+FT_API void
+ft_mutex_lock( struct ft_mutex* mtx )
+{
+	FT_ASSERT( mtx );
+
+	pthread_mutex_t* m = mtx->handle;
+	pthread_mutex_lock( m );
+}
+
 FT_API bool
 ft_mutex_try_lock( struct ft_mutex* mtx )
 {
@@ -63,4 +73,56 @@ ft_mutex_unlock( struct ft_mutex* mtx )
 	pthread_mutex_unlock( m );
 }
 
+FT_API void
+ft_condition_variable_create( struct ft_condition_variable* cv )
+{
+	FT_ASSERT( cv );
+
+	pthread_cond_t* c = malloc( sizeof( pthread_cond_t ) );
+	pthread_cond_init( c, NULL );
+	cv->handle = c;
+}
+
+FT_API void
+ft_condition_variable_destroy( struct ft_condition_variable* cv )
+{
+	FT_ASSERT( cv );
+
+	pthread_cond_destroy( cv->handle );
+	free( cv->handle );
+}
+
+FT_API void
+ft_condition_variable_wait( struct ft_condition_variable* cv,
+                            struct ft_mutex*              mtx )
+{
+	FT_ASSERT( cv );
+	FT_ASSERT( mtx );
+
+	pthread_cond_wait( cv->handle, mtx->handle );
+}
+
+FT_API void
+ft_condition_variable_notify_one( struct ft_condition_variable* cv )
+{
+	FT_ASSERT( cv );
+
+	pthread_cond_signal( cv->handle );
+}
+
+FT_API void
+ft_condition_variable_notify_all( struct ft_condition_variable* cv )
+{
+	FT_ASSERT( cv );
+
+	pthread_cond_broadcast( cv->handle );
+}
+
+FT_API uint32_t
+ft_get_cpu_count( void )
+{
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+	return count > 0 ? ( uint32_t ) count : 1;
+}
+
 #endif
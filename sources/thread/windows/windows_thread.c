@@ -36,7 +36,9 @@ ft_mutex_create( struct ft_mutex* mtx )
 {
 	FT_ASSERT( mtx );
 
-	mtx->handle = CreateMutex( NULL, false, L"mtx" );
+	SRWLOCK* lock = malloc( sizeof( SRWLOCK ) );
+	InitializeSRWLock( lock );
+	mtx->handle = lock;
 }
 
 FT_API void
@@ -44,7 +46,15 @@ ft_mutex_destroy( struct ft_mutex* mtx )
 {
 	FT_ASSERT( mtx );
 
-	CloseHandle( mtx->handle );
+	free( mtx->handle );
+}
+
+FT_API void
+ft_mutex_lock( struct ft_mutex* mtx )
+{
+	FT_ASSERT( mtx );
+
+	AcquireSRWLockExclusive( mtx->handle );
 }
 
 FT_API bool
@@ -52,13 +62,67 @@ ft_mutex_try_lock( struct ft_mutex* mtx )
 {
 	FT_ASSERT( mtx );
 
-	return WaitForSingleObject( mtx->handle, 0 ) == WAIT_OBJECT_0;
+	return TryAcquireSRWLockExclusive( mtx->handle );
 }
 
 FT_API void
 ft_mutex_unlock( struct ft_mutex* mtx )
 {
-	ReleaseMutex( mtx->handle );
+	FT_ASSERT( mtx );
+
+	ReleaseSRWLockExclusive( mtx->handle );
+}
+
+FT_API void
+ft_condition_variable_create( struct ft_condition_variable* cv )
+{
+	FT_ASSERT( cv );
+
+	CONDITION_VARIABLE* c = malloc( sizeof( CONDITION_VARIABLE ) );
+	InitializeConditionVariable( c );
+	cv->handle = c;
+}
+
+FT_API void
+ft_condition_variable_destroy( struct ft_condition_variable* cv )
+{
+	FT_ASSERT( cv );
+
+	free( cv->handle );
+}
+
+FT_API void
+ft_condition_variable_wait( struct ft_condition_variable* cv,
+                            struct ft_mutex*              mtx )
+{
+	FT_ASSERT( cv );
+	FT_ASSERT( mtx );
+
+	SleepConditionVariableSRW( cv->handle, mtx->handle, INFINITE, 0 );
+}
+
+FT_API void
+ft_condition_variable_notify_one( struct ft_condition_variable* cv )
+{
+	FT_ASSERT( cv );
+
+	WakeConditionVariable( cv->handle );
+}
+
+FT_API void
+ft_condition_variable_notify_all( struct ft_condition_variable* cv )
+{
+	FT_ASSERT( cv );
+
+	WakeAllConditionVariable( cv->handle );
+}
+
+FT_API uint32_t
+ft_get_cpu_count( void )
+{
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	return info.dwNumberOfProcessors;
 }
 
 #endif
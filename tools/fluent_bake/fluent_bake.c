@@ -0,0 +1,413 @@
+#include <stdio.h>
+#include <cgltf/cgltf.h>
+#include "base/base.h"
+#include "thread/thread_pool.h"
+#include "renderer/scene/model_loader.h"
+#include "renderer/scene/baked_model.h"
+
+#if FT_PLATFORM_WINDOWS
+#include <windows.h>
+#include <direct.h>
+#include <sys/stat.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#define MAX_PATH_LENGTH 1024
+
+struct bake_job
+{
+	char input[ MAX_PATH_LENGTH ];
+	char output[ MAX_PATH_LENGTH ];
+};
+
+struct baker
+{
+	enum ft_model_flags    load_flags;
+	bool                   force;
+	struct bake_job*       jobs;
+	uint32_t               job_count;
+	uint32_t               job_capacity;
+	// runs bake jobs and every loader stage inside them
+	struct ft_thread_pool* pool;
+	struct ft_mutex        mutex;
+	uint32_t               baked_count;
+	uint32_t               skipped_count;
+	uint32_t               failed_count;
+};
+
+static struct baker baker;
+
+// modification time or zero when file does not exist
+static int64_t
+file_time( const char* path )
+{
+#if FT_PLATFORM_WINDOWS
+	struct _stat64 st;
+	return _stat64( path, &st ) == 0 ? ( int64_t ) st.st_mtime : 0;
+#else
+	struct stat st;
+	return stat( path, &st ) == 0 ? ( int64_t ) st.st_mtime : 0;
+#endif
+}
+
+static bool
+is_directory( const char* path )
+{
+#if FT_PLATFORM_WINDOWS
+	struct _stat64 st;
+	return _stat64( path, &st ) == 0 && ( st.st_mode & _S_IFDIR );
+#else
+	struct stat st;
+	return stat( path, &st ) == 0 && S_ISDIR( st.st_mode );
+#endif
+}
+
+static void
+make_directory( const char* path )
+{
+#if FT_PLATFORM_WINDOWS
+	_mkdir( path );
+#else
+	mkdir( path, 0755 );
+#endif
+}
+
+// creates every missing directory leading to file
+static void
+make_parent_directories( const char* file )
+{
+	char path[ MAX_PATH_LENGTH ];
+	strcpy( path, file );
+
+	for ( char* c = path + 1; *c; ++c )
+	{
+		if ( *c == '/' || *c == '\\' )
+		{
+			char separator = *c;
+			*c             = '\0';
+			make_directory( path );
+			*c = separator;
+		}
+	}
+}
+
+static bool
+has_extension( const char* path, const char* extension )
+{
+	size_t length = strlen( path );
+	size_t ext    = strlen( extension );
+
+	return length > ext && strcmp( path + length - ext, extension ) == 0;
+}
+
+static void
+push_job( const char* input, const char* output )
+{
+	if ( strlen( input ) >= MAX_PATH_LENGTH ||
+	     strlen( output ) + sizeof( ".ftmodel" ) >= MAX_PATH_LENGTH )
+	{
+		printf( "path too long %s\n", input );
+		return;
+	}
+
+	if ( baker.job_count == baker.job_capacity )
+	{
+		baker.job_capacity = FT_MAX( baker.job_capacity * 2, 16 );
+		baker.jobs =
+		    realloc( baker.jobs, baker.job_capacity * sizeof( struct bake_job ) );
+	}
+
+	struct bake_job* job = &baker.jobs[ baker.job_count++ ];
+	strcpy( job->input, input );
+	strcpy( job->output, output );
+
+	// replace source extension
+	char* dot = strrchr( job->output, '.' );
+	strcpy( dot, ".ftmodel" );
+}
+
+static void
+collect_jobs( const char* input, const char* output )
+{
+	if ( !is_directory( input ) )
+	{
+		if ( has_extension( input, ".gltf" ) || has_extension( input, ".glb" ) )
+		{
+			push_job( input, output );
+		}
+
+		return;
+	}
+
+	char child_input[ MAX_PATH_LENGTH ];
+	char child_output[ MAX_PATH_LENGTH ];
+
+#if FT_PLATFORM_WINDOWS
+	char pattern[ MAX_PATH_LENGTH ];
+	snprintf( pattern, sizeof( pattern ), "%s/*", input );
+
+	WIN32_FIND_DATAA entry;
+	HANDLE           find = FindFirstFileA( pattern, &entry );
+
+	if ( find == INVALID_HANDLE_VALUE )
+	{
+		return;
+	}
+
+	do
+	{
+		const char* name = entry.cFileName;
+#else
+	DIR* dir = opendir( input );
+
+	if ( dir == NULL )
+	{
+		return;
+	}
+
+	struct dirent* entry;
+
+	while ( ( entry = readdir( dir ) ) != NULL )
+	{
+		const char* name = entry->d_name;
+#endif
+		if ( strcmp( name, "." ) == 0 || strcmp( name, ".." ) == 0 )
+		{
+			continue;
+		}
+
+		snprintf( child_input, sizeof( child_input ), "%s/%s", input, name );
+		snprintf( child_output, sizeof( child_output ), "%s/%s", output, name );
+		collect_jobs( child_input, child_output );
+#if FT_PLATFORM_WINDOWS
+	} while ( FindNextFileA( find, &entry ) );
+
+	FindClose( find );
+#else
+	}
+
+	closedir( dir );
+#endif
+}
+
+// newest modification time of gltf and external buffers and images it uses
+static int64_t
+source_time( const char* input )
+{
+	int64_t time = file_time( input );
+
+	cgltf_options options = { 0 };
+	cgltf_data*   data    = NULL;
+
+	if ( cgltf_parse_file( &options, input, &data ) != cgltf_result_success )
+	{
+		return time;
+	}
+
+	// relative uris resolve against directory of gltf, either separator
+	// ends it on windows
+	char        directory[ MAX_PATH_LENGTH ];
+	const char* slash     = strrchr( input, '/' );
+	const char* backslash = strrchr( input, '\\' );
+
+	if ( backslash && ( slash == NULL || backslash > slash ) )
+	{
+		slash = backslash;
+	}
+
+	size_t size = slash ? ( size_t ) ( slash - input + 1 ) : 0;
+	memcpy( directory, input, size );
+	directory[ size ] = '\0';
+
+	char path[ MAX_PATH_LENGTH ];
+
+	for ( cgltf_size i = 0; i < data->buffers_count + data->images_count; ++i )
+	{
+		const char* uri = i < data->buffers_count
+		                      ? data->buffers[ i ].uri
+		                      : data->images[ i - data->buffers_count ].uri;
+
+		if ( uri == NULL || strncmp( uri, "data:", 5 ) == 0 )
+		{
+			continue;
+		}
+
+		snprintf( path, sizeof( path ), "%s%s", directory, uri );
+		time = FT_MAX( time, file_time( path ) );
+	}
+
+	cgltf_free( data );
+
+	return time;
+}
+
+static bool
+is_up_to_date( const struct bake_job* job )
+{
+	struct ft_baked_model_header header;
+
+	if ( !ft_read_baked_model_header( job->output, &header ) ||
+	     header.load_flags != ( uint32_t ) baker.load_flags )
+	{
+		return false;
+	}
+
+	return file_time( job->output ) >= source_time( job->input );
+}
+
+static void
+bake_job_fun( void* arg )
+{
+	struct bake_job* job = arg;
+
+	if ( !baker.force && is_up_to_date( job ) )
+	{
+		ft_mutex_lock( &baker.mutex );
+		baker.skipped_count++;
+		ft_mutex_unlock( &baker.mutex );
+		return;
+	}
+
+	// loader stages share pool running bake jobs
+	struct ft_model model =
+	    ft_load_gltf( job->input, baker.load_flags, baker.pool );
+
+	make_parent_directories( job->output );
+
+	bool result = ( model.mesh_count > 0 || model.texture_count > 0 ||
+	                model.animation_count > 0 ) &&
+	              ft_save_baked_model( &model, baker.load_flags, job->output );
+
+	ft_free_gltf( &model );
+
+	ft_mutex_lock( &baker.mutex );
+
+	if ( result )
+	{
+		baker.baked_count++;
+		printf( "baked %s\n", job->output );
+	}
+	else
+	{
+		baker.failed_count++;
+		printf( "failed to bake %s\n", job->input );
+	}
+
+	ft_mutex_unlock( &baker.mutex );
+}
+
+static void
+print_usage( void )
+{
+	printf( "usage: fluent-bake [options] <input> <output>\n"
+	        "input is gltf or glb file or directory scanned recursively\n"
+	        "options:\n"
+	        "  -j <count>   worker thread count\n"
+	        "  -f           bake inputs even if outputs are up to date\n"
+	        "  --lods       generate lod chains\n"
+	        "  --meshlets   generate meshlets\n"
+	        "  --pack       store packed vertices and drop float arrays\n"
+	        "  --mips       generate texture mip chains\n"
+	        "  --compress   store textures in bc formats\n" );
+}
+
+int
+main( int argc, char** argv )
+{
+	baker.load_flags = FT_MODEL_GENERATE_TANGENTS | FT_MODEL_OPTIMIZE_MESHES;
+
+	uint32_t    thread_count = 0;
+	const char* paths[ 2 ];
+	uint32_t    path_count = 0;
+
+	for ( int i = 1; i < argc; ++i )
+	{
+		if ( strcmp( argv[ i ], "-j" ) == 0 && i + 1 < argc )
+		{
+			thread_count = ( uint32_t ) atoi( argv[ ++i ] );
+		}
+		else if ( strcmp( argv[ i ], "-f" ) == 0 )
+		{
+			baker.force = true;
+		}
+		else if ( strcmp( argv[ i ], "--lods" ) == 0 )
+		{
+			baker.load_flags |= FT_MODEL_GENERATE_LODS;
+		}
+		else if ( strcmp( argv[ i ], "--meshlets" ) == 0 )
+		{
+			baker.load_flags |= FT_MODEL_GENERATE_MESHLETS;
+		}
+		else if ( strcmp( argv[ i ], "--mips" ) == 0 )
+		{
+			baker.load_flags |= FT_MODEL_GENERATE_MIPS;
+		}
+		else if ( strcmp( argv[ i ], "--compress" ) == 0 )
+		{
+			baker.load_flags |= FT_MODEL_COMPRESS_TEXTURES;
+		}
+		else if ( strcmp( argv[ i ], "--pack" ) == 0 )
+		{
+			baker.load_flags |= FT_MODEL_PACK_VERTICES |
+			                    FT_MODEL_DISCARD_FLOAT_VERTICES;
+		}
+		else if ( argv[ i ][ 0 ] != '-' && path_count < 2 )
+		{
+			paths[ path_count++ ] = argv[ i ];
+		}
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	if ( path_count != 2 )
+	{
+		print_usage();
+		return 1;
+	}
+
+	if ( is_directory( paths[ 0 ] ) )
+	{
+		collect_jobs( paths[ 0 ], paths[ 1 ] );
+	}
+	else
+	{
+		// single file goes into output directory
+		const char* slash = strrchr( paths[ 0 ], '/' );
+		char        output[ MAX_PATH_LENGTH ];
+		snprintf( output,
+		          sizeof( output ),
+		          "%s/%s",
+		          paths[ 1 ],
+		          slash ? slash + 1 : paths[ 0 ] );
+		collect_jobs( paths[ 0 ], output );
+	}
+
+	ft_mutex_create( &baker.mutex );
+
+	struct ft_thread_pool pool;
+	ft_thread_pool_create( &pool, thread_count );
+	baker.pool = &pool;
+
+	for ( uint32_t j = 0; j < baker.job_count; ++j )
+	{
+		ft_thread_pool_push( &pool, bake_job_fun, &baker.jobs[ j ] );
+	}
+
+	ft_thread_pool_wait( &pool );
+	ft_thread_pool_destroy( &pool );
+	ft_mutex_destroy( &baker.mutex );
+
+	printf( "%u baked, %u up to date, %u failed\n",
+	        baker.baked_count,
+	        baker.skipped_count,
+	        baker.failed_count );
+
+	free( baker.jobs );
+
+	return baker.failed_count > 0 ? 1 : 0;
+}